@@ -1,7 +1,8 @@
 #include "DDPInputCHOP.h"
 #include <cstring>
+#include <cstdlib>
 #include <algorithm>
-#include <errno.h>
+#include <chrono>
 
 using namespace TD;
 
@@ -34,25 +35,40 @@ extern "C"
 
 DDPInputCHOP::DDPInputCHOP(const OP_NodeInfo* info) : myNodeInfo(info)
 {
-    m_socketInitialized = false;
     m_lastPort = 0;
+    m_socketFamily = AF_INET;
+    m_multicastJoined = false;
     m_receivedPixelCount = 0;
+    m_valueBytes = 1;
+    m_receivedDataType = DDP_DATA_TYPE_RGB;
     m_packetsReceived = 0;
     m_bytesReceived = 0;
     m_showStats = false;
     m_lastSourcePort = 0;
-    
-    #ifdef _WIN32
-        m_socket = INVALID_SOCKET;
-        m_wsaInitialized = false;
-    #else
-        m_socket = -1;
-    #endif
+    m_recvBuffer.resize(DDP_RECV_BUFFER_SIZE);
+    m_jitterEnabled = false;
+    m_recordPackets = false;
+    m_streamUsesPush = false;
+    m_capturePending = false;
+    m_captureFast = false;
+    m_captureLoop = true;
+    m_captureSynced = false;
+    m_captureClockOffset = 0.0;
+    m_captureSeconds = 0.0;
+    m_capturePackets = 0;
+    m_captureBytes = 0;
+    m_historyEnabled = false;
+    m_historySinceCook = false;
+    m_historyRead = 0;
+    m_historyDropped = 0;
+    m_historyCount = 0;
 }
 
 DDPInputCHOP::~DDPInputCHOP()
 {
     closeSocket();
+    m_recorder.close();
+    m_gateway.stop();
 }
 
 void DDPInputCHOP::getGeneralInfo(CHOP_GeneralInfo* ginfo, const OP_Inputs* inputs, void* reserved1)
@@ -64,9 +80,9 @@ void DDPInputCHOP::getGeneralInfo(CHOP_GeneralInfo* ginfo, const OP_Inputs* inpu
 
 bool DDPInputCHOP::getOutputInfo(CHOP_OutputInfo* info, const OP_Inputs* inputs, void* reserved1)
 {
-    // 4 status channels + 1 data channel with variable samples
-    info->numChannels = 5;
-    info->numSamples = std::max(1, static_cast<int>(m_receivedPixelData.size()));
+    // 4 status channels + 1 data channel with variable samples + frame age, then the history
+    info->numChannels = 6 + historyChannels(inputs);
+    info->numSamples = std::max(1, static_cast<int>(m_receivedPixelData.size() / m_valueBytes));
     info->sampleRate = 60;
     return true;
 }
@@ -90,12 +106,26 @@ void DDPInputCHOP::getChannelName(int32_t index, OP_String *name, const OP_Input
         case 4:
             name->setString("pixel_data");
             break;
+        case 5:
+            name->setString("frame_age");
+            break;
+        case 6:
+            name->setString("history_frames");
+            break;
         default:
-            name->setString("");
+            name->setString(("history_" + std::to_string(index - 7)).c_str());
             break;
     }
 }
 
+int DDPInputCHOP::historyChannels(const OP_Inputs* inputs)
+{
+    // A count channel, then one channel per frame the ring holds
+    if (strcmp(inputs->getParString("History"), "off") == 0)
+        return 0;
+    return 1 + std::max(1, std::min(inputs->getParInt("Historyframes"), DDP_HISTORY_MAX_FRAMES));
+}
+
 void DDPInputCHOP::setupParameters(OP_ParameterManager* manager, void* reserved1)
 {
     // Port
@@ -122,6 +152,178 @@ void DDPInputCHOP::setupParameters(OP_ParameterManager* manager, void* reserved1
         assert(res == OP_ParAppendResult::Success);
     }
     
+    // Bind Interface (device name such as eth1, or local address; empty = all, IPv4 and IPv6)
+    {
+        OP_StringParameter sp;
+        sp.name = "Bindinterface";
+        sp.label = "Bind Interface";
+        sp.defaultValue = "";
+        OP_ParAppendResult res = manager->appendString(sp);
+        assert(res == OP_ParAppendResult::Success);
+    }
+    
+    // Multicast Group (e.g. 239.255.0.1 or ff15::1, empty = unicast only)
+    {
+        OP_StringParameter sp;
+        sp.name = "Multicastgroup";
+        sp.label = "Multicast Group";
+        sp.defaultValue = "";
+        OP_ParAppendResult res = manager->appendString(sp);
+        assert(res == OP_ParAppendResult::Success);
+    }
+    
+    // Multicast Interface (local IP of the NIC to join on, empty = OS default)
+    {
+        OP_StringParameter sp;
+        sp.name = "Multicastinterface";
+        sp.label = "Multicast Interface";
+        sp.defaultValue = "";
+        OP_ParAppendResult res = manager->appendString(sp);
+        assert(res == OP_ParAppendResult::Success);
+    }
+    
+    // Source (the network, or packets replayed from a capture file)
+    {
+        OP_StringParameter sp;
+        sp.name = "Source";
+        sp.label = "Source";
+        sp.defaultValue = "network";
+        
+        const char* names[] = {"network", "pcap"};
+        const char* labels[] = {"Network", "PCAP File"};
+        
+        OP_ParAppendResult res = manager->appendMenu(sp, 2, names, labels);
+        assert(res == OP_ParAppendResult::Success);
+    }
+    
+    // PCAP File (.pcap or .pcapng; UDP packets sent to Listen Port are replayed)
+    {
+        OP_StringParameter sp;
+        sp.name = "Pcapfile";
+        sp.label = "PCAP File";
+        sp.defaultValue = "";
+        OP_ParAppendResult res = manager->appendFile(sp);
+        assert(res == OP_ParAppendResult::Success);
+    }
+    
+    // PCAP Replay (capture timing, or as fast as possible: one frame per cook)
+    {
+        OP_StringParameter sp;
+        sp.name = "Pcapreplay";
+        sp.label = "PCAP Replay";
+        sp.defaultValue = "capture";
+        
+        const char* names[] = {"capture", "fast"};
+        const char* labels[] = {"Capture Timing", "As Fast As Possible"};
+        
+        OP_ParAppendResult res = manager->appendMenu(sp, 2, names, labels);
+        assert(res == OP_ParAppendResult::Success);
+    }
+    
+    // PCAP Loop
+    {
+        OP_NumericParameter np;
+        np.name = "Pcaploop";
+        np.label = "PCAP Loop";
+        np.defaultValues[0] = 1;
+        OP_ParAppendResult res = manager->appendToggle(np);
+        assert(res == OP_ParAppendResult::Success);
+    }
+    
+    // Jitter Buffer (hold complete frames and release them at their DDP timecode)
+    {
+        OP_NumericParameter np;
+        np.name = "Jitterbuffer";
+        np.label = "Jitter Buffer";
+        np.defaultValues[0] = 0;
+        OP_ParAppendResult res = manager->appendToggle(np);
+        assert(res == OP_ParAppendResult::Success);
+    }
+    
+    // Jitter Delay (added to the estimated presentation time)
+    {
+        OP_NumericParameter np;
+        np.name = "Jitterdelay";
+        np.label = "Jitter Delay (ms)";
+        np.defaultValues[0] = 20.0;
+        np.minSliders[0] = 0.0;
+        np.maxSliders[0] = 200.0;
+        np.minValues[0] = 0.0;
+        np.maxValues[0] = 2000.0;
+        np.clampMins[0] = true;
+        np.clampMaxes[0] = true;
+        OP_ParAppendResult res = manager->appendFloat(np);
+        assert(res == OP_ParAppendResult::Success);
+    }
+    
+    // Interpolate (blend the last two complete frames by arrival time, one frame period behind the sender)
+    {
+        OP_NumericParameter np;
+        np.name = "Interpolate";
+        np.label = "Interpolate";
+        np.defaultValues[0] = 0;
+        OP_ParAppendResult res = manager->appendToggle(np);
+        assert(res == OP_ParAppendResult::Success);
+    }
+    
+    // Hold Time (how long the last frame is held when packets stop, 0 = forever)
+    {
+        OP_NumericParameter np;
+        np.name = "Holdtime";
+        np.label = "Hold Time (s)";
+        np.defaultValues[0] = 0.0;
+        np.minSliders[0] = 0.0;
+        np.maxSliders[0] = 10.0;
+        np.minValues[0] = 0.0;
+        np.clampMins[0] = true;
+        OP_ParAppendResult res = manager->appendFloat(np);
+        assert(res == OP_ParAppendResult::Success);
+    }
+    
+    // Fade Time (from the held frame to black once the hold is over, 0 = cut)
+    {
+        OP_NumericParameter np;
+        np.name = "Fadetime";
+        np.label = "Fade Time (s)";
+        np.defaultValues[0] = 1.0;
+        np.minSliders[0] = 0.0;
+        np.maxSliders[0] = 10.0;
+        np.minValues[0] = 0.0;
+        np.clampMins[0] = true;
+        OP_ParAppendResult res = manager->appendFloat(np);
+        assert(res == OP_ParAppendResult::Success);
+    }
+    
+    // History (extra channels with whole frames, oldest first, so none are lost between cooks)
+    {
+        OP_StringParameter sp;
+        sp.name = "History";
+        sp.label = "History";
+        sp.defaultValue = "off";
+        
+        const char* names[] = {"off", "cook", "ring"};
+        const char* labels[] = {"Off", "Frames Since Last Cook", "Last N Frames"};
+        
+        OP_ParAppendResult res = manager->appendMenu(sp, 3, names, labels);
+        assert(res == OP_ParAppendResult::Success);
+    }
+    
+    // History Frames (channels, and the size of the preallocated ring)
+    {
+        OP_NumericParameter np;
+        np.name = "Historyframes";
+        np.label = "History Frames";
+        np.defaultValues[0] = 8;
+        np.minSliders[0] = 1;
+        np.maxSliders[0] = 64;
+        np.minValues[0] = 1;
+        np.maxValues[0] = DDP_HISTORY_MAX_FRAMES;
+        np.clampMins[0] = true;
+        np.clampMaxes[0] = true;
+        OP_ParAppendResult res = manager->appendInt(np);
+        assert(res == OP_ParAppendResult::Success);
+    }
+    
     // Show Stats Toggle
     {
         OP_NumericParameter np;
@@ -145,6 +347,166 @@ void DDPInputCHOP::setupParameters(OP_ParameterManager* manager, void* reserved1
         OP_ParAppendResult res = manager->appendMenu(sp, 2, names, labels);
         assert(res == OP_ParAppendResult::Success);
     }
+    
+    // Record
+    {
+        OP_NumericParameter np;
+        np.name = "Record";
+        np.label = "Record";
+        np.defaultValues[0] = 0;
+        OP_ParAppendResult res = manager->appendToggle(np);
+        assert(res == OP_ParAppendResult::Success);
+    }
+    
+    // Record File
+    {
+        OP_StringParameter sp;
+        sp.name = "Recordfile";
+        sp.label = "Record File";
+        sp.defaultValue = "ddp_in.ddpr";
+        OP_ParAppendResult res = manager->appendFile(sp);
+        assert(res == OP_ParAppendResult::Success);
+    }
+    
+    // Record Mode (assembled frames or every received packet)
+    {
+        OP_StringParameter sp;
+        sp.name = "Recordmode";
+        sp.label = "Record Mode";
+        sp.defaultValue = "frames";
+        
+        const char* names[] = {"frames", "packets"};
+        const char* labels[] = {"Frames", "Packets"};
+        
+        OP_ParAppendResult res = manager->appendMenu(sp, 2, names, labels);
+        assert(res == OP_ParAppendResult::Success);
+    }
+    
+    // Record Compression
+    {
+        OP_StringParameter sp;
+        sp.name = "Recordcompression";
+        sp.label = "Record Compression";
+        sp.defaultValue = "delta";
+        
+        const char* names[] = {"none", "delta", "lz4", "deltalz4"};
+        const char* labels[] = {"None", "Delta", "LZ4", "Delta + LZ4"};
+        
+        OP_ParAppendResult res = manager->appendMenu(sp, 4, names, labels);
+        assert(res == OP_ParAppendResult::Success);
+    }
+    
+    // Gateway (forward complete frames to legacy DMX fixtures)
+    {
+        OP_StringParameter sp;
+        sp.name = "Gateway";
+        sp.label = "Gateway";
+        sp.defaultValue = "off";
+        
+        const char* names[] = {"off", "sacn", "artnet"};
+        const char* labels[] = {"Off", "sACN (E1.31)", "Art-Net"};
+        
+        OP_ParAppendResult res = manager->appendMenu(sp, 3, names, labels);
+        assert(res == OP_ParAppendResult::Success);
+    }
+    
+    // Gateway Address (empty = sACN multicast per universe, Art-Net broadcast)
+    {
+        OP_StringParameter sp;
+        sp.name = "Gatewayaddress";
+        sp.label = "Gateway Address";
+        sp.defaultValue = "";
+        OP_ParAppendResult res = manager->appendString(sp);
+        assert(res == OP_ParAppendResult::Success);
+    }
+    
+    // Gateway Port (0 = 5568 for sACN, 6454 for Art-Net)
+    {
+        OP_NumericParameter np;
+        np.name = "Gatewayport";
+        np.label = "Gateway Port";
+        np.defaultValues[0] = 0;
+        np.minSliders[0] = 0;
+        np.maxSliders[0] = 65535;
+        np.minValues[0] = 0;
+        np.maxValues[0] = 65535;
+        np.clampMins[0] = true;
+        np.clampMaxes[0] = true;
+        OP_ParAppendResult res = manager->appendInt(np);
+        assert(res == OP_ParAppendResult::Success);
+    }
+    
+    // Gateway Universe (first of the consecutive universes)
+    {
+        OP_NumericParameter np;
+        np.name = "Gatewayuniverse";
+        np.label = "Gateway Universe";
+        np.defaultValues[0] = 1;
+        np.minSliders[0] = 0;
+        np.maxSliders[0] = 100;
+        np.minValues[0] = 0;
+        np.maxValues[0] = DDP_SACN_MAX_UNIVERSE;
+        np.clampMins[0] = true;
+        np.clampMaxes[0] = true;
+        OP_ParAppendResult res = manager->appendInt(np);
+        assert(res == OP_ParAppendResult::Success);
+    }
+    
+    // Gateway Universes (how many consecutive universes)
+    {
+        OP_NumericParameter np;
+        np.name = "Gatewayuniverses";
+        np.label = "Gateway Universes";
+        np.defaultValues[0] = 1;
+        np.minSliders[0] = 1;
+        np.maxSliders[0] = 64;
+        np.minValues[0] = 1;
+        np.maxValues[0] = DDP_GATEWAY_MAX_UNIVERSES;
+        np.clampMins[0] = true;
+        np.clampMaxes[0] = true;
+        OP_ParAppendResult res = manager->appendInt(np);
+        assert(res == OP_ParAppendResult::Success);
+    }
+    
+    // Gateway Channels (per universe; 510 = 170 RGB pixels)
+    {
+        OP_NumericParameter np;
+        np.name = "Gatewaychannels";
+        np.label = "Gateway Channels";
+        np.defaultValues[0] = 510;
+        np.minSliders[0] = 1;
+        np.maxSliders[0] = DDP_DMX_CHANNELS;
+        np.minValues[0] = 1;
+        np.maxValues[0] = DDP_DMX_CHANNELS;
+        np.clampMins[0] = true;
+        np.clampMaxes[0] = true;
+        OP_ParAppendResult res = manager->appendInt(np);
+        assert(res == OP_ParAppendResult::Success);
+    }
+    
+    // Gateway Offset (DDP byte offset of the first universe's first channel)
+    {
+        OP_NumericParameter np;
+        np.name = "Gatewayoffset";
+        np.label = "Gateway Offset";
+        np.defaultValues[0] = 0;
+        np.minSliders[0] = 0;
+        np.maxSliders[0] = 10000;
+        np.minValues[0] = 0;
+        np.clampMins[0] = true;
+        OP_ParAppendResult res = manager->appendInt(np);
+        assert(res == OP_ParAppendResult::Success);
+    }
+    
+    // Gateway DAT (rows of offset, length, universe, channel; replaces the consecutive universes)
+    {
+        OP_StringParameter sp;
+        sp.name = "Gatewaydat";
+        sp.label = "Gateway DAT";
+        sp.defaultValue = "";
+        OP_ParAppendResult res = manager->appendDAT(sp);
+        assert(res == OP_ParAppendResult::Success);
+    }
 }
 
 void DDPInputCHOP::execute(CHOP_Output* output, const OP_Inputs* inputs, void* reserved1)
@@ -155,6 +517,23 @@ void DDPInputCHOP::execute(CHOP_Output* output, const OP_Inputs* inputs, void* r
     bool showStats = inputs->getParInt("Showstats") != 0;
     const char* valueRange = inputs->getParString("Valuerange");
     bool normalizedOutput = (strcmp(valueRange, "0-1") == 0);
+    std::string multicastGroup = inputs->getParString("Multicastgroup");
+    std::string multicastInterface = inputs->getParString("Multicastinterface");
+    std::string bindInterface = inputs->getParString("Bindinterface");
+    bool fromCapture = strcmp(inputs->getParString("Source"), "pcap") == 0;
+    bool jitterEnabled = inputs->getParInt("Jitterbuffer") != 0;
+    m_jitterBuffer.setDelay(inputs->getParDouble("Jitterdelay") / 1000.0);
+    m_smoothSettings.interpolate = inputs->getParInt("Interpolate") != 0;
+    m_smoothSettings.holdTime = inputs->getParDouble("Holdtime");
+    m_smoothSettings.fadeTime = inputs->getParDouble("Fadetime");
+    
+    if (jitterEnabled != m_jitterEnabled)
+    {
+        m_jitterBuffer.clear();
+        m_assemblyBuffer.clear();
+        m_smoother.clear();
+        m_jitterEnabled = jitterEnabled;
+    }
     
     // Reset stats when toggling
     if (showStats != m_showStats)
@@ -166,10 +545,14 @@ void DDPInputCHOP::execute(CHOP_Output* output, const OP_Inputs* inputs, void* r
     
     if (!enabled)
     {
-        if (m_socketInitialized)
+        if (m_socket.isOpen())
         {
             closeSocket();
         }
+        m_capture.close();
+        m_captureFile.clear();
+        m_gateway.stop();
+        m_gatewaySource.clear();
         // Clear output channels
         output->channels[0][0] = 0.0f;
         output->channels[1][0] = 0.0f;
@@ -178,79 +561,104 @@ void DDPInputCHOP::execute(CHOP_Output* output, const OP_Inputs* inputs, void* r
         return;
     }
     
-    // Check if port changed
-    if (m_lastPort != port && m_socketInitialized)
+    // Check if the source, port, bound interface or multicast membership changed
+    if ((fromCapture || m_lastPort != port || m_multicastGroup != multicastGroup ||
+         m_multicastInterface != multicastInterface || m_bindInterface != bindInterface) && m_socket.isOpen())
     {
         closeSocket();
     }
     m_lastPort = port;
+    m_bindInterface = bindInterface;
+    m_multicastGroup = multicastGroup;
+    m_multicastInterface = multicastInterface;
     
-    // Initialize socket if needed
-    if (!m_socketInitialized)
+    updateRecording(inputs);
+    updateHistory(inputs);
+    updateGateway(inputs);
+    
+    if (fromCapture)
     {
-        initializeSocket();
-        
-        // Bind to receive port
-        struct sockaddr_in bindAddr;
-        memset(&bindAddr, 0, sizeof(bindAddr));
-        bindAddr.sin_family = AF_INET;
-        bindAddr.sin_port = htons(port);
-        bindAddr.sin_addr.s_addr = INADDR_ANY;
+        updateCapture(inputs);
+    }
+    else
+    {
+        m_capture.close();
+        m_captureFile.clear();
         
-        if (bind(m_socket, (struct sockaddr*)&bindAddr, sizeof(bindAddr)) < 0)
+        // Initialize socket if needed
+        if (!m_socket.isOpen() && !openListener(port))
         {
-            #ifdef _WIN32
-                m_lastError = "bind failed: " + std::to_string(WSAGetLastError());
-            #else
-                m_lastError = "bind failed: " + std::string(strerror(errno));
-            #endif
-            closeSocket();
             output->channels[0][0] = 0.0f;
             return;
         }
-        
-        // Set socket to non-blocking
-        #ifdef _WIN32
-            u_long mode = 1;
-            ioctlsocket(m_socket, FIONBIO, &mode);
-        #else
-            int flags = fcntl(m_socket, F_GETFL, 0);
-            fcntl(m_socket, F_SETFL, flags | O_NONBLOCK);
-        #endif
     }
     
-    // Receive and parse DDP packets
+    // Receive (or replay) and parse DDP packets
     receiveData();
     
+    // Present the buffered frames that are due, oldest first, so history and the gateway see each one
+    double now = ddp::JitterBuffer::steadyNowSeconds();
+    double presentTime = now;
+    while (m_jitterEnabled && m_jitterBuffer.release(now, m_receivedPixelData, presentTime))
+    {
+        m_receivedPixelCount = static_cast<int32_t>(m_receivedPixelData.size() / m_valueBytes / 3);
+        frameCompleted(presentTime);
+    }
+    m_smoothWeights = m_smoother.weights(now, m_smoothSettings);
+    
     // Output status channels
     output->channels[0][0] = enabled ? 1.0f : 0.0f;
     output->channels[1][0] = static_cast<float>(m_packetsReceived);
     output->channels[2][0] = static_cast<float>(m_bytesReceived / 1024.0);
     output->channels[3][0] = static_cast<float>(m_receivedPixelCount);
+    std::fill(output->channels[5], output->channels[5] + output->numSamples, static_cast<float>(m_smoothWeights.age));
     
     // Output received pixel data
     if (m_receivedPixelData.size() > 0)
+        outputPixelData(output, normalizedOutput);
+    if (m_historyEnabled)
+        outputHistory(output, normalizedOutput);
+}
+
+void DDPInputCHOP::frameCompleted(double arrivalTime)
+{
+    m_smoother.push(m_receivedPixelData, arrivalTime, m_smoothSettings.interpolate);
+    if (m_historyEnabled)
+        m_history.push(m_receivedPixelData.data(), m_receivedPixelData.size(), arrivalTime);
+    if (m_gateway.isRunning())
+        m_gateway.submit(m_receivedPixelData.data(), m_receivedPixelData.size());
+}
+
+void DDPInputCHOP::outputPixelData(CHOP_Output* output, bool normalizedOutput)
+{
+    // Unsmoothed: as 0-1 range, or 0-255 (default)
+    const ddp::SmoothWeights& weights = m_smoothWeights;
+    if (!weights.blended && weights.fade == 1.0f)
     {
-        int numSamples = static_cast<int>(m_receivedPixelData.size());
-        for (int i = 0; i < numSamples && i < output->numSamples; i++)
-        {
-            if (normalizedOutput)
-            {
-                // Output as 0-1 range
-                output->channels[4][i] = m_receivedPixelData[i] / 255.0f;
-            }
-            else
-            {
-                // Output as 0-255 range (default)
-                output->channels[4][i] = static_cast<float>(m_receivedPixelData[i]);
-            }
-        }
+        size_t numSamples = std::min(m_receivedPixelData.size() / m_valueBytes, static_cast<size_t>(output->numSamples));
+        if (m_valueBytes == 2)
+            ddp::convertBE16ToSamples(m_receivedPixelData.data(), numSamples, normalizedOutput, output->channels[4]);
+        else
+            ddp::convertBytesToSamples(m_receivedPixelData.data(), numSamples, normalizedOutput, output->channels[4]);
+        return;
     }
+    
+    // Interpolated frames come from the smoother's pair, a held frame fades where it is
+    const std::vector<uint8_t>& current = weights.blended ? m_smoother.currentFrame() : m_receivedPixelData;
+    const uint8_t* previous = weights.blended ? m_smoother.previousFrame().data() : nullptr;
+    float scale;
+    if (m_valueBytes == 2)
+        scale = normalizedOutput ? 1.0f / 65535.0f : 1.0f / 257.0f;
+    else
+        scale = normalizedOutput ? 1.0f / 255.0f : 1.0f;
+    size_t numSamples = std::min(current.size() / m_valueBytes, static_cast<size_t>(output->numSamples));
+    ddp::blendSamples(previous, current.data(), numSamples, m_valueBytes, weights.previous * scale,
+                      weights.current * scale, output->channels[4]);
 }
 
 int32_t DDPInputCHOP::getNumInfoCHOPChans(void* reserved1)
 {
-    return 3;
+    return 12;
 }
 
 void DDPInputCHOP::getInfoCHOPChan(int32_t index, OP_InfoCHOPChan* chan, void* reserved1)
@@ -269,12 +677,48 @@ void DDPInputCHOP::getInfoCHOPChan(int32_t index, OP_InfoCHOPChan* chan, void* r
             chan->name->setString("pixel_count");
             chan->value = static_cast<float>(m_receivedPixelCount);
             break;
+        case 3:
+            chan->name->setString("jitter_queue");
+            chan->value = static_cast<float>(m_jitterBuffer.queued());
+            break;
+        case 4:
+            chan->name->setString("frames_dropped");
+            chan->value = static_cast<float>(m_jitterBuffer.framesDropped());
+            break;
+        case 5:
+            chan->name->setString("frames_skipped");
+            chan->value = static_cast<float>(m_jitterBuffer.framesLate());
+            break;
+        case 6:
+            chan->name->setString("frame_age");
+            chan->value = static_cast<float>(m_smoothWeights.age);
+            break;
+        case 7:
+            chan->name->setString("frame_period");
+            chan->value = static_cast<float>(m_smoother.period());
+            break;
+        case 8:
+            chan->name->setString("history_frames");
+            chan->value = static_cast<float>(m_historyCount);
+            break;
+        case 9:
+            chan->name->setString("history_dropped");
+            chan->value = static_cast<float>(m_historyDropped);
+            break;
+        case 10:
+            chan->name->setString("gateway_frames");
+            chan->value = static_cast<float>(m_gateway.framesSent());
+            break;
+        case 11:
+            chan->name->setString("gateway_packets");
+            chan->value = static_cast<float>(m_gateway.packetsSent());
+            break;
     }
 }
 
 bool DDPInputCHOP::getInfoDATSize(OP_InfoDATSize* infoSize, void* reserved1)
 {
-    infoSize->rows = 6;
+    infoSize->rows = 16;
     infoSize->cols = 2;
     infoSize->byColumn = false;
     return true;
@@ -316,186 +760,521 @@ void DDPInputCHOP::getInfoDATEntries(int32_t index, int32_t nEntries,
         entries->values[0]->setString("Last Error");
         entries->values[1]->setString(m_lastError.c_str());
     }
+    else if (index == 6)
+    {
+        entries->values[0]->setString("Multicast Group");
+        entries->values[1]->setString(m_multicastJoined ? m_multicastGroup.c_str() : "");
+    }
+    else if (index == 7)
+    {
+        entries->values[0]->setString("Bind Interface");
+        std::string binding = m_bindInterface.empty() ? "any" : m_bindInterface;
+        if (m_socket.isOpen())
+            binding += (m_socketFamily == AF_INET6) ? " (IPv6 dual-stack)" : " (IPv4)";
+        entries->values[1]->setString(binding.c_str());
+    }
+    else if (index == 8)
+    {
+        entries->values[0]->setString("Recording");
+        std::string recording = m_recorder.isOpen() ? m_recorder.path() : "off";
+        if (m_recorder.isOpen() && !m_recorder.lastError().empty())
+            recording += " (" + m_recorder.lastError() + ")";
+        entries->values[1]->setString(recording.c_str());
+    }
+    else if (index == 9)
+    {
+        entries->values[0]->setString("Recorded");
+        entries->values[1]->setString(m_recorder.summary().c_str());
+    }
+    else if (index == 10)
+    {
+        entries->values[0]->setString("Source");
+        std::string source = "network";
+        if (m_capture.isOpen())
+            source = m_capture.path() + (m_capture.isPcapNg() ? " (pcapng)" : " (pcap)");
+        entries->values[1]->setString(source.c_str());
+    }
+    else if (index == 11)
+    {
+        // Read + decode + assemble throughput, i.e. the parser speed over a real capture
+        entries->values[0]->setString("Capture Replay");
+        std::string replay;
+        if (m_capture.isOpen())
+        {
+            char text[160];
+            double seconds = std::max(m_captureSeconds, 1e-9);
+            snprintf(text, sizeof(text), "%lld packets (%lld skipped), %.0f packets/s, %.1f MB/s",
+                     static_cast<long long>(m_capturePackets),
+                     static_cast<long long>(m_capture.packetsSkipped()),
+                     m_capturePackets / seconds, m_captureBytes / seconds / 1e6);
+            replay = text;
+        }
+        entries->values[1]->setString(replay.c_str());
+    }
+    else if (index == 12)
+    {
+        entries->values[0]->setString("Bit Depth");
+        entries->values[1]->setString(m_valueBytes == 2 ? "16-bit" : "8-bit");
+    }
+    else if (index == 13)
+    {
+        entries->values[0]->setString("Smoothing");
+        entries->values[1]->setString(smoothingSummary().c_str());
+    }
+    else if (index == 14)
+    {
+        entries->values[0]->setString("History");
+        entries->values[1]->setString(historySummary().c_str());
+    }
+    else if (index == 15)
+    {
+        entries->values[0]->setString("Gateway");
+        entries->values[1]->setString(m_gateway.summary().c_str());
+    }
 }
 
-void DDPInputCHOP::initializeSocket()
+std::string DDPInputCHOP::smoothingSummary() const
 {
-    #ifdef _WIN32
-        if (!m_wsaInitialized)
-        {
-            WSADATA wsaData;
-            int result = WSAStartup(MAKEWORD(2, 2), &wsaData);
-            if (result != 0)
-            {
-                m_lastError = "WSAStartup failed: " + std::to_string(result);
-                return;
-            }
-            m_wsaInitialized = true;
-        }
-        
-        m_socket = socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
-        if (m_socket == INVALID_SOCKET)
+    char text[160];
+    std::string summary;
+    if (m_smoothSettings.interpolate)
+    {
+        snprintf(text, sizeof(text), "interpolate, %.1f ms frames", m_smoother.period() * 1000.0);
+        summary = text;
+    }
+    if (m_smoothSettings.holdTime > 0.0)
+    {
+        snprintf(text, sizeof(text), "hold %.2f s, fade %.2f s", m_smoothSettings.holdTime, m_smoothSettings.fadeTime);
+        summary += (summary.empty() ? "" : ", ") + std::string(text);
+        if (m_smoothWeights.fade < 1.0f)
         {
-            m_lastError = "socket creation failed: " + std::to_string(WSAGetLastError());
-            return;
+            snprintf(text, sizeof(text), " (%s)", m_smoothWeights.fade > 0.0f ? "fading" : "black");
+            summary += text;
         }
-    #else
-        m_socket = socket(AF_INET, SOCK_DGRAM, 0);
-        if (m_socket < 0)
+    }
+    return summary.empty() ? "off" : summary;
+}
+
+bool DDPInputCHOP::openListener(int port)
+{
+    // Pick the address family: a multicast group or bind address decides it,
+    // otherwise listen dual-stack and fall back to IPv4 where IPv6 is unavailable
+    struct sockaddr_storage probe;
+    socklen_t probeLen;
+    int family = AF_INET6;
+    if (!m_multicastGroup.empty() && ddp::parseAddress(m_multicastGroup, port, probe, probeLen))
+        family = probe.ss_family;
+    else if (!m_bindInterface.empty() && ddp::parseAddress(m_bindInterface, port, probe, probeLen))
+        family = probe.ss_family;
+    
+    bool opened = m_socket.open(family);
+    if (!opened && family == AF_INET6 && m_multicastGroup.empty() && m_bindInterface.empty())
+    {
+        family = AF_INET;
+        opened = m_socket.open(family);
+    }
+    if (!opened)
+    {
+        m_lastError = m_socket.lastError();
+        return false;
+    }
+    m_socketFamily = family;
+    
+    // Allow several receivers on this host to share the port (needed for multicast)
+    m_socket.setReuseAddress();
+    
+    // Device or local address binding ignores traffic arriving on other NICs (e.g. the management network)
+    if (!m_socket.bindTo(m_bindInterface, port))
+    {
+        m_lastError = m_socket.lastError();
+        closeSocket();
+        return false;
+    }
+    
+    if (!m_multicastGroup.empty())
+    {
+        if (!m_socket.joinGroup(m_multicastGroup, m_multicastInterface))
         {
-            m_lastError = "socket creation failed: " + std::string(strerror(errno));
-            return;
+            m_lastError = m_socket.lastError();
+            closeSocket();
+            return false;
         }
-    #endif
+        m_multicastJoined = true;
+    }
+    
+    // Enlarge the kernel receive buffer so jumbo frames arriving between cooks are not dropped
+    m_socket.setReceiveBuffer(DDP_SOCKET_RCVBUF);
+    m_socket.setNonBlocking(true);
     
-    m_socketInitialized = true;
     m_lastError = "";
+    return true;
 }
 
 void DDPInputCHOP::closeSocket()
 {
-    if (m_socketInitialized)
-    {
-        #ifdef _WIN32
-            closesocket(m_socket);
-            m_socket = INVALID_SOCKET;
-        #else
-            close(m_socket);
-            m_socket = -1;
-        #endif
-        
-        m_socketInitialized = false;
-    }
-    
-    #ifdef _WIN32
-        if (m_wsaInitialized)
-        {
-            WSACleanup();
-            m_wsaInitialized = false;
-        }
-    #endif
+    // Group membership is dropped by the OS when the socket closes
+    m_multicastJoined = false;
+    m_socket.close();
 }
 
 void DDPInputCHOP::receiveData()
 {
-    if (!m_socketInitialized)
-        return;
+    bool recordFrames = m_recorder.isOpen() && !m_recordPackets;
+    bool unpushedData = false;
     
-    uint8_t buffer[2048];
-    struct sockaddr_in sourceAddr;
-    socklen_t sourceAddrLen = sizeof(sourceAddr);
-    
-    // Receive all available packets (non-blocking)
-    while (true)
+    if (m_capture.isOpen())
     {
-        #ifdef _WIN32
-            int bytesReceived = recvfrom(m_socket, (char*)buffer, sizeof(buffer), 0,
-                                        (struct sockaddr*)&sourceAddr, &sourceAddrLen);
-            if (bytesReceived == SOCKET_ERROR)
-            {
-                int err = WSAGetLastError();
-                if (err == WSAEWOULDBLOCK)
-                    break;
-                m_lastError = "recvfrom failed: " + std::to_string(err);
-                break;
-            }
-        #else
-            ssize_t bytesReceived = recvfrom(m_socket, buffer, sizeof(buffer), 0,
-                                            (struct sockaddr*)&sourceAddr, &sourceAddrLen);
-            if (bytesReceived < 0)
-            {
-                if (errno == EWOULDBLOCK || errno == EAGAIN)
-                    break;
-                m_lastError = "recvfrom failed: " + std::string(strerror(errno));
-                break;
-            }
-        #endif
-        
-        if (bytesReceived < DDP_HEADER_SIZE)
-            continue;
-        
-        // Parse DDP packet
-        uint32_t offset;
-        uint16_t dataLen;
-        const uint8_t* pixelData;
+        replayCapture(recordFrames, unpushedData);
+    }
+    else if (m_socket.isOpen())
+    {
+        uint8_t* buffer = m_recvBuffer.data();
+        struct sockaddr_storage sourceAddr;
         
-        if (parseDDPPacket(buffer, bytesReceived, offset, dataLen, pixelData))
+        // Receive all available packets (non-blocking)
+        while (true)
         {
-            // Update stats
-            if (m_showStats)
-            {
-                m_packetsReceived++;
-                m_bytesReceived += bytesReceived;
-            }
-            
-            // Store source IP
-            char sourceIP[INET_ADDRSTRLEN];
-            inet_ntop(AF_INET, &sourceAddr.sin_addr, sourceIP, INET_ADDRSTRLEN);
-            m_lastSourceIP = sourceIP;
-            m_lastSourcePort = ntohs(sourceAddr.sin_port);
-            
-            // Resize buffer if needed
-            size_t requiredSize = offset + dataLen;
-            if (m_receivedPixelData.size() < requiredSize)
+            bool wouldBlock = false;
+            int bytesReceived = m_socket.recvFrom(buffer, m_recvBuffer.size(), sourceAddr, wouldBlock);
+            if (bytesReceived < 0)
             {
-                m_receivedPixelData.resize(requiredSize, 0);
+                if (!wouldBlock)
+                    m_lastError = m_socket.lastError();
+                break;
             }
-            
-            // Copy pixel data
-            std::memcpy(m_receivedPixelData.data() + offset, pixelData, dataLen);
-            
-            // Update pixel count
-            m_receivedPixelCount = static_cast<int32_t>(m_receivedPixelData.size() / 3);
-            
-            m_lastError = "";
+            processPacket(buffer, static_cast<size_t>(bytesReceived), sourceAddr, recordFrames, unpushedData);
         }
     }
+    
+    // Without the jitter buffer, a cook's worth of data from a sender without PUSH counts as one frame
+    if (unpushedData && !m_streamUsesPush && !m_jitterEnabled)
+        frameCompleted(ddp::JitterBuffer::steadyNowSeconds());
+    
+    // Senders without PUSH (Auto Push off) get one recorded frame per cook that received data
+    if (recordFrames && unpushedData && !m_streamUsesPush)
+    {
+        const std::vector<uint8_t>& frame = m_jitterEnabled ? m_assemblyBuffer : m_receivedPixelData;
+        m_recorder.writeFrame(frame.data(), frame.size(), false, 0, m_receivedDataType);
+    }
 }
 
-bool DDPInputCHOP::parseDDPPacket(const uint8_t* buffer, size_t length,
-                                   uint32_t& offset, uint16_t& dataLen,
-                                   const uint8_t*& pixelData)
+bool DDPInputCHOP::processPacket(const uint8_t* data, size_t length, const struct sockaddr_storage& source,
+                                 bool recordFrames, bool& unpushedData)
 {
-    if (length < DDP_HEADER_SIZE)
+    // Parse DDP packet
+    ddp::PacketHeader header;
+    const uint8_t* pixelData = nullptr;
+    if (!ddp::unpackHeader(data, length, header, pixelData))
         return false;
     
-    uint8_t flags = buffer[0];
-    uint8_t dataType = buffer[2];
-    uint8_t destID = buffer[3];
+    // Packet recordings keep everything the sender put on the wire
+    if (m_recorder.isOpen() && m_recordPackets)
+        m_recorder.writePacket(data, length, nullptr, 0);
     
-    // Check version
-    if ((flags & DDP_FLAGS1_VER) != DDP_FLAGS1_VER1)
+    // Only process display data with 8 or 16 bits per value
+    if (header.destId != DDP_ID_DISPLAY || !ddp::isPixelDataType(header.dataType))
         return false;
     
-    // Only process display data
-    if (destID != DDP_ID_DISPLAY)
-        return false;
+    // A sender switching bit depth starts a new frame, the old bytes mean nothing now
+    size_t valueBytes = static_cast<size_t>(ddp::bitsPerElement(header.dataType) / 8);
+    if (valueBytes != m_valueBytes)
+    {
+        m_valueBytes = valueBytes;
+        m_receivedPixelData.clear();
+        m_assemblyBuffer.clear();
+        m_jitterBuffer.clear();
+        m_smoother.clear();
+        clearHistory();
+    }
+    m_receivedDataType = header.dataType;
+    
+    // Update stats
+    if (m_showStats)
+    {
+        m_packetsReceived++;
+        m_bytesReceived += static_cast<int64_t>(length);
+    }
     
-    // Only support RGB
-    if (dataType != DDP_DATA_TYPE_RGB)
+    // Store source IP
+    m_lastSourceIP = ddp::formatAddress(reinterpret_cast<const struct sockaddr*>(&source), &m_lastSourcePort);
+    
+    // With the jitter buffer on, packets build a frame that is only shown at its presentation time
+    std::vector<uint8_t>& target = m_jitterEnabled ? m_assemblyBuffer : m_receivedPixelData;
+    if (!ddp::assemblePayload(target, header.offset, pixelData, header.length))
+    {
+        m_lastError = "Packet offset " + std::to_string(header.offset) + " exceeds the maximum frame size";
         return false;
+    }
     
-    // Extract offset (big-endian)
-    offset = (static_cast<uint32_t>(buffer[4]) << 24) |
-             (static_cast<uint32_t>(buffer[5]) << 16) |
-             (static_cast<uint32_t>(buffer[6]) << 8) |
-             static_cast<uint32_t>(buffer[7]);
+    if (m_jitterEnabled)
+    {
+        if (header.isPush())
+            m_jitterBuffer.push(m_assemblyBuffer, header.hasTimecode(), header.timecode,
+                                ddp::JitterBuffer::steadyNowSeconds());
+    }
+    else
+    {
+        // Update pixel count
+        m_receivedPixelCount = static_cast<int32_t>(m_receivedPixelData.size() / m_valueBytes / 3);
+    }
     
-    // Extract data length (big-endian)
-    dataLen = (static_cast<uint16_t>(buffer[8]) << 8) |
-              static_cast<uint16_t>(buffer[9]);
+    m_lastError = "";
     
-    // Validate
-    if (dataLen > length - DDP_HEADER_SIZE)
+    // Frame recordings take the frame as it stands when the sender pushes it
+    if (!header.isPush())
+    {
+        unpushedData = true;
         return false;
+    }
+    m_streamUsesPush = true;
+    unpushedData = false;
+    if (!m_jitterEnabled)
+        frameCompleted(ddp::JitterBuffer::steadyNowSeconds());
+    if (recordFrames)
+        m_recorder.writeFrame(target.data(), target.size(), header.hasTimecode(), header.timecode, header.dataType);
+    return true;
+}
+
+void DDPInputCHOP::updateCapture(const OP_Inputs* inputs)
+{
+    m_captureFast = strcmp(inputs->getParString("Pcapreplay"), "fast") == 0;
+    m_captureLoop = inputs->getParInt("Pcaploop") != 0;
     
-    if (dataLen > DDP_MAX_DATALEN)
-        return false;
+    std::string file = inputs->getParFilePath("Pcapfile");
+    if (file == m_captureFile)
+        return;
     
-    pixelData = buffer + DDP_HEADER_SIZE;
+    // A new file starts over, a failed open is retried only after a change
+    m_capture.close();
+    m_captureFile = file;
+    m_capturePending = false;
+    m_captureSynced = false;
+    m_captureSeconds = 0.0;
+    m_capturePackets = 0;
+    m_captureBytes = 0;
     
-    return true;
+    if (file.empty())
+    {
+        m_lastError = "PCAP File is empty";
+        return;
+    }
+    if (!m_capture.open(file))
+        m_lastError = m_capture.lastError();
+}
+
+void DDPInputCHOP::replayCapture(bool recordFrames, bool& unpushedData)
+{
+    typedef std::chrono::steady_clock Clock;
+    Clock::time_point start = Clock::now();
+    double now = ddp::JitterBuffer::steadyNowSeconds();
+    bool rewound = false;
+    int64_t delivered = 0;
+    
+    while (true)
+    {
+        if (!m_capturePending)
+        {
+            if (!m_capture.next(m_capturePacket, m_lastPort))
+            {
+                if (!m_capture.lastError().empty())
+                    m_lastError = m_capture.lastError();
+                
+                // At most one wrap per cook, so a capture without DDP traffic cannot spin
+                if (!m_captureLoop || rewound || !m_capture.rewind())
+                    break;
+                rewound = true;
+                m_captureSynced = false;
+                continue;
+            }
+            m_capturePending = true;
+        }
+        
+        // Capture timing: the first packet plays now, the rest keep their spacing
+        if (!m_captureFast)
+        {
+            if (!m_captureSynced)
+            {
+                m_captureClockOffset = now - m_capturePacket.timestamp;
+                m_captureSynced = true;
+            }
+            if (m_capturePacket.timestamp + m_captureClockOffset > now)
+                break;
+        }
+        m_capturePending = false;
+        
+        m_capturePackets++;
+        m_captureBytes += static_cast<int64_t>(m_capturePacket.length);
+        bool pushed = processPacket(m_capturePacket.payload, m_capturePacket.length, m_capturePacket.source,
+                                    recordFrames, unpushedData);
+        
+        // As fast as possible: one frame per cook
+        if (m_captureFast && (pushed || ++delivered >= DDP_PCAP_FAST_MAX_PACKETS))
+            break;
+    }
+    
+    m_captureSeconds += std::chrono::duration<double>(Clock::now() - start).count();
+}
+
+void DDPInputCHOP::updateHistory(const OP_Inputs* inputs)
+{
+    const char* mode = inputs->getParString("History");
+    bool enabled = strcmp(mode, "off") != 0;
+    bool sinceCook = strcmp(mode, "cook") == 0;
+    size_t capacity = static_cast<size_t>(historyChannels(inputs) - 1);
+    
+    // The ring is allocated here, never per frame; any change starts the history over
+    if (!enabled)
+    {
+        if (m_historyEnabled)
+            m_history.reset(1);
+    }
+    else if (!m_historyEnabled || sinceCook != m_historySinceCook || capacity != m_history.capacity())
+    {
+        m_history.reset(capacity);
+        m_historyRead = 0;
+        m_historyDropped = 0;
+    }
+    m_historyEnabled = enabled;
+    m_historySinceCook = sinceCook;
+    if (!enabled)
+        m_historyCount = 0;
 }
 
+void DDPInputCHOP::clearHistory()
+{
+    m_history.clear();
+    m_historyRead = 0;
+}
 
+void DDPInputCHOP::outputHistory(CHOP_Output* output, bool normalizedOutput)
+{
+    // Since the last cook: the frames pushed since then that the ring still holds
+    size_t held = m_history.size();
+    size_t count = held;
+    if (m_historySinceCook)
+    {
+        int64_t fresh = m_history.pushed() - m_historyRead;
+        if (fresh > static_cast<int64_t>(held))
+            m_historyDropped += fresh - static_cast<int64_t>(held);
+        count = static_cast<size_t>(std::min<int64_t>(fresh, static_cast<int64_t>(held)));
+    }
+    m_historyRead = m_history.pushed();
+    m_historyCount = count;
+    output->channels[6][0] = static_cast<float>(count);
+    
+    // Oldest first, unused channels are zero
+    size_t numSamples = static_cast<size_t>(output->numSamples);
+    size_t channels = std::min(m_history.capacity(), static_cast<size_t>(output->numChannels - 7));
+    for (size_t c = 0; c < channels; c++)
+    {
+        float* dst = output->channels[7 + c];
+        size_t filled = 0;
+        if (c < count)
+        {
+            size_t index = held - count + c;
+            filled = std::min(m_history.frameBytes(index) / m_valueBytes, numSamples);
+            if (m_valueBytes == 2)
+                ddp::convertBE16ToSamples(m_history.frame(index), filled, normalizedOutput, dst);
+            else
+                ddp::convertBytesToSamples(m_history.frame(index), filled, normalizedOutput, dst);
+        }
+        std::fill(dst + filled, dst + numSamples, 0.0f);
+    }
+}
+
+std::string DDPInputCHOP::historySummary() const
+{
+    if (!m_historyEnabled)
+        return "off";
+    char text[160];
+    if (m_historySinceCook)
+        snprintf(text, sizeof(text), "since last cook: %zu frames, %lld dropped", m_historyCount,
+                 static_cast<long long>(m_historyDropped));
+    else
+        snprintf(text, sizeof(text), "last %zu frames: %zu held", m_history.capacity(), m_historyCount);
+    return text;
+}
+
+void DDPInputCHOP::updateGateway(const OP_Inputs* inputs)
+{
+    const char* mode = inputs->getParString("Gateway");
+    if (strcmp(mode, "off") == 0)
+    {
+        m_gateway.stop();
+        m_gatewaySource.clear();
+        return;
+    }
+    
+    // Restarted when the DAT cooks or any parameter changes; a failed start is retried only after a change
+    const OP_DATInput* dat = inputs->getParDAT("Gatewaydat");
+    std::string address = inputs->getParString("Gatewayaddress");
+    int port = inputs->getParInt("Gatewayport");
+    int universe = inputs->getParInt("Gatewayuniverse");
+    int universes = inputs->getParInt("Gatewayuniverses");
+    int channels = inputs->getParInt("Gatewaychannels");
+    int offset = inputs->getParInt("Gatewayoffset");
+    std::string source = std::string(mode) + "|" + address + "|" + std::to_string(port) + "|" +
+                         std::to_string(universe) + "|" + std::to_string(universes) + "|" + std::to_string(channels) +
+                         "|" + std::to_string(offset) + "|" + (dat ? dat->opPath : "") + ":" +
+                         std::to_string(dat ? dat->totalCooks : 0);
+    if (source == m_gatewaySource)
+        return;
+    m_gatewaySource = source;
+    m_gateway.stop();
+    
+    std::vector<ddp::UniverseMap> maps;
+    if (dat)
+    {
+        ddp::UniverseTableParser parser;
+        std::vector<const char*> cells;
+        ddp::UniverseMap map;
+        for (int32_t row = 0; row < dat->numRows; row++)
+        {
+            cells.resize(static_cast<size_t>(dat->numCols));
+            for (int32_t col = 0; col < dat->numCols; col++)
+                cells[col] = dat->getCell(row, col);
+            if (parser.parseRow(cells.data(), dat->numCols, map))
+                maps.push_back(map);
+        }
+    }
+    else
+    {
+        ddp::consecutiveUniverses(static_cast<uint32_t>(offset), static_cast<uint16_t>(universe), universes, channels,
+                                  maps);
+    }
+    
+    ddp::DmxProtocol protocol = strcmp(mode, "artnet") == 0 ? ddp::DmxProtocol::ArtNet : ddp::DmxProtocol::Sacn;
+    if (!m_gateway.start(protocol, address, port, maps))
+        m_lastError = m_gateway.lastError();
+}
 
+void DDPInputCHOP::updateRecording(const OP_Inputs* inputs)
+{
+    if (inputs->getParInt("Record") == 0)
+    {
+        m_recorder.close();
+        m_recordTarget.clear();
+        return;
+    }
+    
+    std::string file = inputs->getParFilePath("Recordfile");
+    std::string mode = inputs->getParString("Recordmode");
+    std::string compression = inputs->getParString("Recordcompression");
+    
+    // Changing any setting starts a new file; a failed open is retried only after a change
+    std::string target = file + "|" + mode + "|" + compression;
+    if (target == m_recordTarget)
+        return;
+    
+    m_recorder.close();
+    m_recordTarget = target;
+    m_recordPackets = (mode == "packets");
+    
+    if (file.empty())
+    {
+        m_lastError = "Record File is empty";
+        return;
+    }
+    if (!m_recorder.open(file, ddp::recordCompressionFromName(compression)))
+        m_lastError = m_recorder.lastError();
+}
@@ -1,14 +1,16 @@
 #ifndef __DDPInputCHOP__
 #define __DDPInputCHOP__
 
-// Must include winsock2 before Windows.h to avoid conflicts
-#ifdef _WIN32
-    #define WIN32_LEAN_AND_MEAN
-    #define NOMINMAX  // Prevent Windows from defining min/max macros
-    #include <winsock2.h>
-    #include <ws2tcpip.h>
-    #pragma comment(lib, "ws2_32.lib")
-#endif
+// Shared DDP core (must come before Windows.h, it pulls in winsock2)
+#include "DDPProtocol.h"
+#include "DDPSocket.h"
+#include "DDPFrameAssembler.h"
+#include "DDPFrameSmoother.h"
+#include "DDPFrameRing.h"
+#include "DDPGateway.h"
+#include "DDPPixelConvert.h"
+#include "DDPRecording.h"
+#include "DDPPcap.h"
 
 #include "CHOP_CPlusPlusBase.h"
 #include <vector>
@@ -16,29 +18,13 @@
 
 using namespace TD;
 
-#ifndef _WIN32
-    #include <sys/socket.h>
-    #include <netinet/in.h>
-    #include <arpa/inet.h>
-    #include <unistd.h>
-    #include <fcntl.h>
-#endif
-
-// DDP Protocol Constants
-#define DDP_PORT 4048
-#define DDP_HEADER_SIZE 10
-#define DDP_MAX_DATALEN (480 * 3)
-
-// DDP Flags
-#define DDP_FLAGS1_VER     0xC0
-#define DDP_FLAGS1_VER1    0x40
-#define DDP_FLAGS1_PUSH    0x01
-
-// DDP IDs
-#define DDP_ID_DISPLAY  1
+// Receive buffer: senders may use jumbo payloads up to the UDP datagram limit
+#define DDP_RECV_BUFFER_SIZE  65536
+#define DDP_SOCKET_RCVBUF     (4 * 1024 * 1024)  // absorb bursts of large frames between cooks
 
-// DDP Data Types
-#define DDP_DATA_TYPE_RGB  0x01
+// As-fast-as-possible capture replay stops a cook at the first PUSH, or after
+// this many packets when the capture has none
+#define DDP_PCAP_FAST_MAX_PACKETS 100000
 
 class DDPInputCHOP : public CHOP_CPlusPlusBase
 {
@@ -62,33 +48,100 @@ public:
 
 private:
     // Socket management
-    void initializeSocket();
     void closeSocket();
+    bool openListener(int port);
     
     // Receive and parse
     void receiveData();
-    bool parseDDPPacket(const uint8_t* buffer, size_t length, 
-                        uint32_t& offset, uint16_t& dataLen, 
-                        const uint8_t*& pixelData);
+    bool processPacket(const uint8_t* data, size_t length, const struct sockaddr_storage& source,
+                       bool recordFrames, bool& unpushedData);
+    
+    // A complete frame is in m_receivedPixelData: smoothing and history take it
+    void frameCompleted(double arrivalTime);
+    
+    // Pixel data channel, smoothed (Interpolate / Hold Time / Fade Time)
+    void outputPixelData(CHOP_Output* output, bool normalizedOutput);
+    std::string smoothingSummary() const;
+    
+    // Frame history channels (History / History Frames)
+    static int historyChannels(const OP_Inputs* inputs);
+    void updateHistory(const OP_Inputs* inputs);
+    void clearHistory();
+    void outputHistory(CHOP_Output* output, bool normalizedOutput);
+    std::string historySummary() const;
+    
+    // Capture replay (Source = PCAP File / PCAP Replay / PCAP Loop)
+    void updateCapture(const OP_Inputs* inputs);
+    void replayCapture(bool recordFrames, bool& unpushedData);
+    
+    // Recording (Record / Record File / Record Mode / Record Compression)
+    void updateRecording(const OP_Inputs* inputs);
+    
+    // Art-Net / sACN forwarding (Gateway and the Gateway parameters)
+    void updateGateway(const OP_Inputs* inputs);
     
     // Socket members
-    #ifdef _WIN32
-        SOCKET m_socket;
-        bool m_wsaInitialized;
-    #else
-        int m_socket;
-    #endif
-    
-    bool m_socketInitialized;
+    ddp::UdpSocket m_socket;
     int m_lastPort;
+    int m_socketFamily;
+    std::string m_bindInterface;   // device name or local address, empty = all (dual-stack)
+    
+    // Multicast membership (empty group = unicast/broadcast only)
+    std::string m_multicastGroup;
+    std::string m_multicastInterface;
+    bool m_multicastJoined;
     
     // Received data
+    std::vector<uint8_t> m_recvBuffer;
     std::vector<uint8_t> m_receivedPixelData;
     int32_t m_receivedPixelCount;
+    size_t m_valueBytes;           // 1, or 2 for a stream with a 16-bit data type (big-endian)
+    uint8_t m_receivedDataType;    // type byte of the last display packet, kept with recorded frames
     int64_t m_packetsReceived;
     int64_t m_bytesReceived;
     bool m_showStats;
     
+    // Jitter buffer: frames are assembled until PUSH, then held until their presentation time
+    bool m_jitterEnabled;
+    std::vector<uint8_t> m_assemblyBuffer;
+    ddp::JitterBuffer m_jitterBuffer;
+    
+    // Smoothing of the output: interpolation between the last two complete frames, hold then fade
+    ddp::FrameSmoother m_smoother;
+    ddp::SmoothSettings m_smoothSettings;
+    ddp::SmoothWeights m_smoothWeights;   // as of the last cook
+    
+    // History of complete frames: the last N, or those received since the last cook
+    ddp::FrameRing m_history;
+    bool m_historyEnabled;
+    bool m_historySinceCook;
+    int64_t m_historyRead;         // m_history.pushed() at the last cook
+    int64_t m_historyDropped;      // frames overwritten before a cook output them
+    size_t m_historyCount;         // frames output by the last cook
+    
+    // Recording of received packets or assembled frames
+    ddp::RecordingWriter m_recorder;
+    std::string m_recordTarget;    // settings of the last open attempt, empty when not recording
+    bool m_recordPackets;
+    bool m_streamUsesPush;         // sender marks frame ends, record on PUSH instead of per cook
+    
+    // Complete frames forwarded as DMX universes from the gateway's sender thread
+    ddp::DmxGateway m_gateway;
+    std::string m_gatewaySource;   // settings of the last start attempt, empty when off
+    
+    // Capture file used as the packet source in place of the socket
+    ddp::PcapReader m_capture;
+    std::string m_captureFile;
+    ddp::CapturedPacket m_capturePacket;  // read ahead, waiting for its replay time
+    bool m_capturePending;
+    bool m_captureFast;            // as fast as possible instead of capture timing
+    bool m_captureLoop;
+    bool m_captureSynced;          // m_captureClockOffset maps capture time to the steady clock
+    double m_captureClockOffset;
+    double m_captureSeconds;       // time spent reading and parsing, for the throughput figures
+    int64_t m_capturePackets;
+    int64_t m_captureBytes;
+    
     // Source tracking
     std::string m_lastSourceIP;
     uint16_t m_lastSourcePort;
@@ -1,9 +1,9 @@
 #include "DDPOutputCHOP.h"
 #include <cstring>
+#include <cstdlib>
 #include <algorithm>
-#include <cmath>
 #include <chrono>
-#include <errno.h>
+#include <cmath>
 
 using namespace TD;
 
@@ -17,7 +17,7 @@ extern "C"
         info->customOPInfo.opLabel->setString("DDP Out");
         info->customOPInfo.authorName->setString("Glen Wilde");
         info->customOPInfo.authorEmail->setString("Glen.w.wilde@gmail.com");
-        info->customOPInfo.minInputs = 1;
+        info->customOPInfo.minInputs = 0;  // no input needed while playing back a recording
         info->customOPInfo.maxInputs = 1;
         
         // Ensure the node cooks on startup (important for output nodes)
@@ -37,9 +37,7 @@ extern "C"
 
 DDPOutputCHOP::DDPOutputCHOP(const OP_NodeInfo* info) : myNodeInfo(info)
 {
-    m_socketInitialized = false;
     m_needsReinitialize = false;
-    m_sequenceNumber = 0;
     m_packetsSent = 0;
     m_bytesSent = 0;
     m_lastChannelCount = 0;
@@ -47,22 +45,59 @@ DDPOutputCHOP::DDPOutputCHOP(const OP_NodeInfo* info) : myNodeInfo(info)
     m_lastPort = 0;
     m_showStats = false;
     m_isDiscovering = false;
+    m_recordPackets = false;
+    m_playbackTime = 0.0;
+    m_playbackLastTick = -1.0;
+    m_playbackCursor = 0;
+    m_seekRequested = false;
     m_lastFrameTime = 0.0;
-    
-    #ifdef _WIN32
-        m_socket = INVALID_SOCKET;
-        m_wsaInitialized = false;
-    #else
-        m_socket = -1;
-    #endif
+    m_payloadSize = DDP_MAX_DATALEN;
+    m_interfaceMTU = 0;
+    m_lastCheckedPayload = 0;
+    m_multicastTTL = 1;
+    m_multicastLoop = false;
+    m_multicastConfigured = false;
+    m_timecodeEnabled = false;
+    m_frameTimecode = 0;
+    m_lutValid = false;
+    m_pendingTopId = UINT32_MAX;
+    m_layoutActive = false;
+    m_rangesActive = false;
+    m_colorOrders.assign(1, ddp::ColorOrder());
+    m_transportsActive = false;
+    m_transportMulticast = false;
+    m_bytesPerPixel = 3;
+    ddp::makeSacnCid(m_sacnCid);
+    std::fill(m_transportPackets, m_transportPackets + 3, 0);
+    m_calibrations.assign(1, ddp::CalibrationSettings());
+    m_calibrationInputs = 3;
+    m_calibrationActive = false;
+    m_linearLUTValid = false;
+    m_powerLimit = false;
+    std::fill(m_channelCurrent, m_channelCurrent + DDP_POWER_CHANNELS, 20.0f);
+    m_limiterRelease = 0.5;
+    m_powerTime = -1.0;
+    m_downloadWaitMs = 0.0;
+    m_dither = false;
+    m_bitDepth = 8;
+    m_dataType = DDP_DATA_TYPE_RGB;
     
     memset(&m_destAddr, 0, sizeof(m_destAddr));
-    memset(&m_broadcastAddr, 0, sizeof(m_broadcastAddr));
+    m_destAddrLen = 0;
+    m_redundancy = ddp::Redundancy::Off;
+    memset(&m_secondaryAddr, 0, sizeof(m_secondaryAddr));
+    m_secondaryAddrLen = 0;
+    m_healthInterval = 1.0;
+    m_healthTimeout = 3.0;
+    m_socketFamily = AF_INET;
+    m_destIsHostname = false;
 }
 
 DDPOutputCHOP::~DDPOutputCHOP()
 {
     closeSocket();
+    m_recorder.close();
+    m_pcapMirror.close();
 }
 
 void DDPOutputCHOP::getGeneralInfo(CHOP_GeneralInfo* ginfo, const OP_Inputs* inputs, void* reserved1)
@@ -109,7 +144,7 @@ void DDPOutputCHOP::setupParameters(OP_ParameterManager* manager, void* reserved
     {
         OP_StringParameter sp;
         sp.name = "Ipaddress";
-        sp.label = "IP Address";
+        sp.label = "IP Address / Hostname";
         sp.defaultValue = "127.0.0.1";
         OP_ParAppendResult res = manager->appendString(sp);
         assert(res == OP_ParAppendResult::Success);
@@ -129,6 +164,98 @@ void DDPOutputCHOP::setupParameters(OP_ParameterManager* manager, void* reserved
         assert(res == OP_ParAppendResult::Success);
     }
     
+    // Bind Interface (device name such as eth1, or local source address; empty = any)
+    {
+        OP_StringParameter sp;
+        sp.name = "Bindinterface";
+        sp.label = "Bind Interface";
+        sp.defaultValue = "";
+        OP_ParAppendResult res = manager->appendString(sp);
+        assert(res == OP_ParAppendResult::Success);
+    }
+    
+    // Redundancy: a secondary leg on another network, sent to as well or held in standby
+    {
+        OP_StringParameter sp;
+        sp.name = "Redundancy";
+        sp.label = "Redundancy";
+        sp.defaultValue = "off";
+        
+        const char* names[] = {"off", "both", "standby"};
+        const char* labels[] = {"Off", "Send to Both", "Active / Standby"};
+        
+        OP_ParAppendResult res = manager->appendMenu(sp, 3, names, labels);
+        assert(res == OP_ParAppendResult::Success);
+    }
+    
+    // Secondary Address (IP or hostname of the backup leg's controller)
+    {
+        OP_StringParameter sp;
+        sp.name = "Secondaryaddress";
+        sp.label = "Secondary Address";
+        sp.defaultValue = "";
+        OP_ParAppendResult res = manager->appendString(sp);
+        assert(res == OP_ParAppendResult::Success);
+    }
+    
+    // Secondary Port (0 = Port)
+    {
+        OP_NumericParameter np;
+        np.name = "Secondaryport";
+        np.label = "Secondary Port";
+        np.defaultValues[0] = 0;
+        np.minSliders[0] = 0;
+        np.maxSliders[0] = 65535;
+        np.minValues[0] = 0;
+        np.maxValues[0] = 65535;
+        np.clampMins[0] = true;
+        np.clampMaxes[0] = true;
+        OP_ParAppendResult res = manager->appendInt(np);
+        assert(res == OP_ParAppendResult::Success);
+    }
+    
+    // Secondary Interface (device name or local address of the backup network, empty = any)
+    {
+        OP_StringParameter sp;
+        sp.name = "Secondaryinterface";
+        sp.label = "Secondary Interface";
+        sp.defaultValue = "";
+        OP_ParAppendResult res = manager->appendString(sp);
+        assert(res == OP_ParAppendResult::Success);
+    }
+    
+    // Health Check Interval: seconds between STATUS queries to each leg's controller
+    {
+        OP_NumericParameter np;
+        np.name = "Healthinterval";
+        np.label = "Health Check Interval (s)";
+        np.defaultValues[0] = 1.0;
+        np.minSliders[0] = 0.1;
+        np.maxSliders[0] = 10.0;
+        np.minValues[0] = 0.01;
+        np.maxValues[0] = 60.0;
+        np.clampMins[0] = true;
+        np.clampMaxes[0] = true;
+        OP_ParAppendResult res = manager->appendFloat(np);
+        assert(res == OP_ParAppendResult::Success);
+    }
+    
+    // Health Timeout: a leg without a reply for this long has failed
+    {
+        OP_NumericParameter np;
+        np.name = "Healthtimeout";
+        np.label = "Health Timeout (s)";
+        np.defaultValues[0] = 3.0;
+        np.minSliders[0] = 0.5;
+        np.maxSliders[0] = 30.0;
+        np.minValues[0] = 0.01;
+        np.maxValues[0] = 300.0;
+        np.clampMins[0] = true;
+        np.clampMaxes[0] = true;
+        OP_ParAppendResult res = manager->appendFloat(np);
+        assert(res == OP_ParAppendResult::Success);
+    }
+    
     // Enable Output
     {
         OP_NumericParameter np;
@@ -186,6 +313,165 @@ void DDPOutputCHOP::setupParameters(OP_ParameterManager* manager, void* reserved
         assert(res == OP_ParAppendResult::Success);
     }
     
+    // Color Order (channel order the controller expects, e.g. GRB or GRBW)
+    {
+        OP_StringParameter sp;
+        sp.name = "Colororder";
+        sp.label = "Color Order";
+        sp.defaultValue = "RGB";
+        
+        const char* names[] = {"RGB", "RBG", "GRB", "GBR", "BRG", "BGR", "RGBW", "GRBW", "BRGW", "WRGB"};
+        const char* labels[] = {"RGB", "RBG", "GRB", "GBR", "BRG", "BGR", "RGBW", "GRBW", "BRGW", "WRGB"};
+        
+        OP_ParAppendResult res = manager->appendStringMenu(sp, 10, names, labels);
+        assert(res == OP_ParAppendResult::Success);
+    }
+    
+    // Ranges DAT (blocks of pixels with their own settings: name, start, count, order)
+    {
+        OP_StringParameter sp;
+        sp.name = "Rangesdat";
+        sp.label = "Ranges DAT";
+        sp.defaultValue = "";
+        OP_ParAppendResult res = manager->appendDAT(sp);
+        assert(res == OP_ParAppendResult::Success);
+    }
+    
+    // Color Matrix (3x3, row-major, applied to linear RGB before gamma)
+    {
+        OP_StringParameter sp;
+        sp.name = "Colormatrix";
+        sp.label = "Color Matrix";
+        sp.defaultValue = "1 0 0 0 1 0 0 0 1";
+        OP_ParAppendResult res = manager->appendString(sp);
+        assert(res == OP_ParAppendResult::Success);
+    }
+    
+    // Gain (per channel R, G, B, W, after the matrix)
+    {
+        OP_NumericParameter np;
+        np.name = "Gain";
+        np.label = "Gain";
+        for (int i = 0; i < 4; i++)
+        {
+            np.defaultValues[i] = 1.0;
+            np.minSliders[i] = 0.0;
+            np.maxSliders[i] = 2.0;
+            np.minValues[i] = -DDP_CAL_MAX_COEFFICIENT;
+            np.maxValues[i] = DDP_CAL_MAX_COEFFICIENT;
+            np.clampMins[i] = true;
+            np.clampMaxes[i] = true;
+        }
+        OP_ParAppendResult res = manager->appendFloat(np, 4);
+        assert(res == OP_ParAppendResult::Success);
+    }
+    
+    // Offset (per channel R, G, B, W, in 0-1 units, e.g. to lift the black level)
+    {
+        OP_NumericParameter np;
+        np.name = "Offset";
+        np.label = "Offset";
+        for (int i = 0; i < 4; i++)
+        {
+            np.defaultValues[i] = 0.0;
+            np.minSliders[i] = -0.1;
+            np.maxSliders[i] = 0.1;
+            np.minValues[i] = -DDP_CAL_MAX_COEFFICIENT;
+            np.maxValues[i] = DDP_CAL_MAX_COEFFICIENT;
+            np.clampMins[i] = true;
+            np.clampMaxes[i] = true;
+        }
+        OP_ParAppendResult res = manager->appendFloat(np, 4);
+        assert(res == OP_ParAppendResult::Success);
+    }
+    
+    // White Extraction (share of min(R, G, B) moved to the W channel, RGB input with 4 channels per pixel)
+    {
+        OP_NumericParameter np;
+        np.name = "Whiteextraction";
+        np.label = "White Extraction";
+        np.defaultValues[0] = 0.0;
+        np.minSliders[0] = 0.0;
+        np.maxSliders[0] = 1.0;
+        np.minValues[0] = 0.0;
+        np.maxValues[0] = 1.0;
+        np.clampMins[0] = true;
+        np.clampMaxes[0] = true;
+        OP_ParAppendResult res = manager->appendFloat(np);
+        assert(res == OP_ParAppendResult::Success);
+    }
+    
+    // Power Limit (estimate the current each range draws and scale it down past its budget)
+    {
+        OP_NumericParameter np;
+        np.name = "Powerlimit";
+        np.label = "Power Limit";
+        np.defaultValues[0] = 0;
+        OP_ParAppendResult res = manager->appendToggle(np);
+        assert(res == OP_ParAppendResult::Success);
+    }
+    
+    // Channel Current (mA each of R, G, B, W draws at full, 20 for a WS2812 class LED)
+    {
+        OP_NumericParameter np;
+        np.name = "Channelcurrent";
+        np.label = "Channel Current (mA)";
+        for (int i = 0; i < DDP_POWER_CHANNELS; i++)
+        {
+            np.defaultValues[i] = 20.0;
+            np.minSliders[i] = 0.0;
+            np.maxSliders[i] = 60.0;
+            np.minValues[i] = 0.0;
+            np.clampMins[i] = true;
+        }
+        OP_ParAppendResult res = manager->appendFloat(np, DDP_POWER_CHANNELS);
+        assert(res == OP_ParAppendResult::Success);
+    }
+    
+    // Power Budget (amps per range and for the pixels outside them, 0 = no limit)
+    {
+        OP_NumericParameter np;
+        np.name = "Powerbudget";
+        np.label = "Power Budget (A)";
+        np.defaultValues[0] = 0.0;
+        np.minSliders[0] = 0.0;
+        np.maxSliders[0] = 60.0;
+        np.minValues[0] = 0.0;
+        np.clampMins[0] = true;
+        OP_ParAppendResult res = manager->appendFloat(np);
+        assert(res == OP_ParAppendResult::Success);
+    }
+    
+    // Limiter Release (seconds to recover after the content drops below the budget)
+    {
+        OP_NumericParameter np;
+        np.name = "Limiterrelease";
+        np.label = "Limiter Release (s)";
+        np.defaultValues[0] = 0.5;
+        np.minSliders[0] = 0.0;
+        np.maxSliders[0] = 5.0;
+        np.minValues[0] = 0.0;
+        np.clampMins[0] = true;
+        OP_ParAppendResult res = manager->appendFloat(np);
+        assert(res == OP_ParAppendResult::Success);
+    }
+    
+    // Max Payload (bytes of pixel data per packet, jumbo frames need a larger MTU)
+    {
+        OP_NumericParameter np;
+        np.name = "Maxpayload";
+        np.label = "Max Payload Bytes";
+        np.defaultValues[0] = DDP_MAX_DATALEN;
+        np.minSliders[0] = 120.0;
+        np.maxSliders[0] = 8952.0; // whole pixels at 3, 4, 6 and 8 bytes, fits a 9000 MTU with timecode
+        np.minValues[0] = 1.0;
+        np.maxValues[0] = DDP_MAX_DATALEN_LIMIT;
+        np.clampMins[0] = true;
+        np.clampMaxes[0] = true;
+        OP_ParAppendResult res = manager->appendInt(np);
+        assert(res == OP_ParAppendResult::Success);
+    }
+    
     // Auto Push (for single device vs multi-device sync)
     {
         OP_NumericParameter np;
@@ -196,6 +482,72 @@ void DDPOutputCHOP::setupParameters(OP_ParameterManager* manager, void* reserved
         assert(res == OP_ParAppendResult::Success);
     }
     
+    // Multicast TTL (only used when IP Address is a multicast group)
+    {
+        OP_NumericParameter np;
+        np.name = "Multicastttl";
+        np.label = "Multicast TTL";
+        np.defaultValues[0] = 1; // stay on the local network
+        np.minSliders[0] = 1;
+        np.maxSliders[0] = 32;
+        np.minValues[0] = 1;
+        np.maxValues[0] = 255;
+        np.clampMins[0] = true;
+        np.clampMaxes[0] = true;
+        OP_ParAppendResult res = manager->appendInt(np);
+        assert(res == OP_ParAppendResult::Success);
+    }
+    
+    // Multicast Loopback (deliver our own multicast to receivers on this machine)
+    {
+        OP_NumericParameter np;
+        np.name = "Multicastloop";
+        np.label = "Multicast Loopback";
+        np.defaultValues[0] = 0;
+        OP_ParAppendResult res = manager->appendToggle(np);
+        assert(res == OP_ParAppendResult::Success);
+    }
+    
+    // Multicast Interface (local IP of the NIC to send the group on, empty = OS default)
+    {
+        OP_StringParameter sp;
+        sp.name = "Multicastinterface";
+        sp.label = "Multicast Interface";
+        sp.defaultValue = "";
+        OP_ParAppendResult res = manager->appendString(sp);
+        assert(res == OP_ParAppendResult::Success);
+    }
+    
+    // Timecode source (sets DDP_FLAGS1_TIME and appends a 4 byte timecode to every packet)
+    {
+        OP_StringParameter sp;
+        sp.name = "Timecode";
+        sp.label = "Timecode";
+        sp.defaultValue = "off";
+        
+        const char* names[] = {"off", "timeline", "clock"};
+        const char* labels[] = {"Off", "Timeline", "Steady Clock"};
+        
+        OP_ParAppendResult res = manager->appendMenu(sp, 3, names, labels);
+        assert(res == OP_ParAppendResult::Success);
+    }
+    
+    // Presentation Delay (added to the timecode so receivers can buffer network jitter)
+    {
+        OP_NumericParameter np;
+        np.name = "Presentationdelay";
+        np.label = "Presentation Delay (ms)";
+        np.defaultValues[0] = 0.0;
+        np.minSliders[0] = 0.0;
+        np.maxSliders[0] = 200.0;
+        np.minValues[0] = 0.0;
+        np.maxValues[0] = 5000.0;
+        np.clampMins[0] = true;
+        np.clampMaxes[0] = true;
+        OP_ParAppendResult res = manager->appendFloat(np);
+        assert(res == OP_ParAppendResult::Success);
+    }
+    
     // Show Stats Toggle
     {
         OP_NumericParameter np;
@@ -220,6 +572,34 @@ void DDPOutputCHOP::setupParameters(OP_ParameterManager* manager, void* reserved
         assert(res == OP_ParAppendResult::Success);
     }
     
+    // Dither (16-bit conversion, remainders carried to the next frame per byte)
+    {
+        OP_StringParameter sp;
+        sp.name = "Dither";
+        sp.label = "Dither";
+        sp.defaultValue = "off";
+        
+        const char* names[] = {"off", "temporal"};
+        const char* labels[] = {"Off", "Temporal (16-bit)"};
+        
+        OP_ParAppendResult res = manager->appendMenu(sp, 2, names, labels);
+        assert(res == OP_ParAppendResult::Success);
+    }
+    
+    // Bit Depth (16-bit sends big-endian values with the 16-bit DDP data type)
+    {
+        OP_StringParameter sp;
+        sp.name = "Bitdepth";
+        sp.label = "Bit Depth";
+        sp.defaultValue = "8";
+        
+        const char* names[] = {"8", "16"};
+        const char* labels[] = {"8-bit", "16-bit"};
+        
+        OP_ParAppendResult res = manager->appendMenu(sp, 2, names, labels);
+        assert(res == OP_ParAppendResult::Success);
+    }
+    
     // Max FPS
     {
         OP_NumericParameter np;
@@ -236,362 +616,1534 @@ void DDPOutputCHOP::setupParameters(OP_ParameterManager* manager, void* reserved
         assert(res == OP_ParAppendResult::Success);
     }
     
-    // Discover Devices Button
-    {
-        OP_NumericParameter np;
-        np.name = "Discover";
-        np.label = "Discover Devices";
-        OP_ParAppendResult res = manager->appendPulse(np);
-        assert(res == OP_ParAppendResult::Success);
-    }
+    // Layout Width / Height (matrix of input pixels, 0 = keep the input order)
+    {
+        OP_NumericParameter np;
+        np.name = "Layoutsize";
+        np.label = "Layout Width/Height";
+        np.defaultValues[0] = 0.0;
+        np.defaultValues[1] = 0.0;
+        for (int i = 0; i < 2; i++)
+        {
+            np.minSliders[i] = 0.0;
+            np.maxSliders[i] = 256.0;
+            np.minValues[i] = 0.0;
+            np.clampMins[i] = true;
+        }
+        OP_ParAppendResult res = manager->appendInt(np, 2);
+        assert(res == OP_ParAppendResult::Success);
+    }
+    
+    // Layout Direction (the strip runs along rows or up/down columns)
+    {
+        OP_StringParameter sp;
+        sp.name = "Layoutdirection";
+        sp.label = "Layout Direction";
+        sp.defaultValue = "rows";
+        
+        const char* names[] = {"rows", "columns"};
+        const char* labels[] = {"Rows", "Columns"};
+        
+        OP_ParAppendResult res = manager->appendMenu(sp, 2, names, labels);
+        assert(res == OP_ParAppendResult::Success);
+    }
+    
+    // Serpentine (every other row or column runs back)
+    {
+        OP_NumericParameter np;
+        np.name = "Layoutserpentine";
+        np.label = "Serpentine";
+        np.defaultValues[0] = 0;
+        OP_ParAppendResult res = manager->appendToggle(np);
+        assert(res == OP_ParAppendResult::Success);
+    }
+    
+    // Start Corner (where the first LED of the strip sits)
+    {
+        OP_StringParameter sp;
+        sp.name = "Layoutstart";
+        sp.label = "Start Corner";
+        sp.defaultValue = "bottomleft";
+        
+        const char* names[] = {"bottomleft", "bottomright", "topleft", "topright"};
+        const char* labels[] = {"Bottom Left", "Bottom Right", "Top Left", "Top Right"};
+        
+        OP_ParAppendResult res = manager->appendMenu(sp, 4, names, labels);
+        assert(res == OP_ParAppendResult::Success);
+    }
+    
+    // Layout Segments DAT (one run per row: forward/reverse/skip/dummy, count)
+    {
+        OP_StringParameter sp;
+        sp.name = "Layoutsegments";
+        sp.label = "Layout Segments DAT";
+        sp.defaultValue = "";
+        OP_ParAppendResult res = manager->appendDAT(sp);
+        assert(res == OP_ParAppendResult::Success);
+    }
+    
+    // TOP (sampled through the pixel map instead of reading the input CHOP)
+    {
+        OP_StringParameter sp;
+        sp.name = "Top";
+        sp.label = "TOP";
+        sp.defaultValue = "";
+        OP_ParAppendResult res = manager->appendTOP(sp);
+        assert(res == OP_ParAppendResult::Success);
+    }
+    
+    // Pixel Map DAT (one LED per row: x, y)
+    {
+        OP_StringParameter sp;
+        sp.name = "Pixelmapdat";
+        sp.label = "Pixel Map DAT";
+        sp.defaultValue = "";
+        OP_ParAppendResult res = manager->appendDAT(sp);
+        assert(res == OP_ParAppendResult::Success);
+    }
+    
+    // Pixel Map File (one LED per line: x y), used when no DAT is set
+    {
+        OP_StringParameter sp;
+        sp.name = "Pixelmapfile";
+        sp.label = "Pixel Map File";
+        sp.defaultValue = "";
+        OP_ParAppendResult res = manager->appendFile(sp);
+        assert(res == OP_ParAppendResult::Success);
+    }
+    
+    // Map Units (texel coordinates from the bottom-left, or 0-1 UV)
+    {
+        OP_StringParameter sp;
+        sp.name = "Pixelmapunits";
+        sp.label = "Map Units";
+        sp.defaultValue = "pixels";
+        
+        const char* names[] = {"pixels", "uv"};
+        const char* labels[] = {"Pixels", "UV"};
+        
+        OP_ParAppendResult res = manager->appendMenu(sp, 2, names, labels);
+        assert(res == OP_ParAppendResult::Success);
+    }
+    
+    // TOP Latency
+    {
+        OP_StringParameter sp;
+        sp.name = "Toplatency";
+        sp.label = "TOP Latency";
+        sp.defaultValue = "pipelined";
+        
+        const char* names[] = {"pipelined", "immediate"};
+        const char* labels[] = {"One Frame (no stall)", "Same Frame (stalls)"};
+        
+        OP_ParAppendResult res = manager->appendMenu(sp, 2, names, labels);
+        assert(res == OP_ParAppendResult::Success);
+    }
+    
+    // Record (tap on what is sent)
+    {
+        OP_NumericParameter np;
+        np.name = "Record";
+        np.label = "Record";
+        np.defaultValues[0] = 0;
+        OP_ParAppendResult res = manager->appendToggle(np);
+        assert(res == OP_ParAppendResult::Success);
+    }
+    
+    // Record File
+    {
+        OP_StringParameter sp;
+        sp.name = "Recordfile";
+        sp.label = "Record File";
+        sp.defaultValue = "ddp_out.ddpr";
+        OP_ParAppendResult res = manager->appendFile(sp);
+        assert(res == OP_ParAppendResult::Success);
+    }
+    
+    // Record Mode (converted frames or every sent packet)
+    {
+        OP_StringParameter sp;
+        sp.name = "Recordmode";
+        sp.label = "Record Mode";
+        sp.defaultValue = "frames";
+        
+        const char* names[] = {"frames", "packets"};
+        const char* labels[] = {"Frames", "Packets"};
+        
+        OP_ParAppendResult res = manager->appendMenu(sp, 2, names, labels);
+        assert(res == OP_ParAppendResult::Success);
+    }
+    
+    // Record Compression
+    {
+        OP_StringParameter sp;
+        sp.name = "Recordcompression";
+        sp.label = "Record Compression";
+        sp.defaultValue = "delta";
+        
+        const char* names[] = {"none", "delta", "lz4", "deltalz4"};
+        const char* labels[] = {"None", "Delta", "LZ4", "Delta + LZ4"};
+        
+        OP_ParAppendResult res = manager->appendMenu(sp, 4, names, labels);
+        assert(res == OP_ParAppendResult::Success);
+    }
+    
+    // Mirror to PCAP (copy of every sent packet, readable by Wireshark and DDP In)
+    {
+        OP_NumericParameter np;
+        np.name = "Pcapmirror";
+        np.label = "Mirror to PCAP";
+        np.defaultValues[0] = 0;
+        OP_ParAppendResult res = manager->appendToggle(np);
+        assert(res == OP_ParAppendResult::Success);
+    }
+    
+    // PCAP File
+    {
+        OP_StringParameter sp;
+        sp.name = "Pcapfile";
+        sp.label = "PCAP File";
+        sp.defaultValue = "ddp_out.pcap";
+        OP_ParAppendResult res = manager->appendFile(sp);
+        assert(res == OP_ParAppendResult::Success);
+    }
+    
+    // Playback
+    {
+        OP_NumericParameter np;
+        np.name = "Playback";
+        np.label = "Playback";
+        np.defaultValues[0] = 0;
+        OP_ParAppendResult res = manager->appendToggle(np);
+        assert(res == OP_ParAppendResult::Success);
+    }
+    
+    // Playback File
+    {
+        OP_StringParameter sp;
+        sp.name = "Playbackfile";
+        sp.label = "Playback File";
+        sp.defaultValue = "";
+        OP_ParAppendResult res = manager->appendFile(sp);
+        assert(res == OP_ParAppendResult::Success);
+    }
+    
+    // Playback Rate (1 = recorded timing)
+    {
+        OP_NumericParameter np;
+        np.name = "Playbackrate";
+        np.label = "Playback Rate";
+        np.defaultValues[0] = 1.0;
+        np.minSliders[0] = 0.0;
+        np.maxSliders[0] = 4.0;
+        np.minValues[0] = 0.0;
+        np.clampMins[0] = true;
+        OP_ParAppendResult res = manager->appendFloat(np);
+        assert(res == OP_ParAppendResult::Success);
+    }
+    
+    // Playback Loop
+    {
+        OP_NumericParameter np;
+        np.name = "Playbackloop";
+        np.label = "Loop";
+        np.defaultValues[0] = 1;
+        OP_ParAppendResult res = manager->appendToggle(np);
+        assert(res == OP_ParAppendResult::Success);
+    }
+    
+    // Seek Time (seconds into the recording, applied by Seek)
+    {
+        OP_NumericParameter np;
+        np.name = "Seektime";
+        np.label = "Seek Time (s)";
+        np.defaultValues[0] = 0.0;
+        np.minSliders[0] = 0.0;
+        np.maxSliders[0] = 600.0;
+        np.minValues[0] = 0.0;
+        np.clampMins[0] = true;
+        OP_ParAppendResult res = manager->appendFloat(np);
+        assert(res == OP_ParAppendResult::Success);
+    }
+    
+    // Seek
+    {
+        OP_NumericParameter np;
+        np.name = "Seek";
+        np.label = "Seek";
+        OP_ParAppendResult res = manager->appendPulse(np);
+        assert(res == OP_ParAppendResult::Success);
+    }
+    
+    // Discover Devices Button
+    {
+        OP_NumericParameter np;
+        np.name = "Discover";
+        np.label = "Discover Devices";
+        OP_ParAppendResult res = manager->appendPulse(np);
+        assert(res == OP_ParAppendResult::Success);
+    }
+}
+
+void DDPOutputCHOP::pulsePressed(const char* name, void* reserved1)
+{
+    if (strcmp(name, "Discover") == 0)
+    {
+        discoverDevices();
+    }
+    else if (strcmp(name, "Seek") == 0)
+    {
+        // Applied on the next cook, where the Seek Time parameter can be read
+        m_seekRequested = true;
+    }
+}
+
+void DDPOutputCHOP::initializeSocket()
+{
+    if (m_socket.isOpen())
+        return;
+    
+    // The socket family follows the destination, IPv6 sockets are dual-stack
+    m_socketFamily = (m_destAddr.ss_family == AF_INET6) ? AF_INET6 : AF_INET;
+    
+    if (!m_socket.open(m_socketFamily))
+    {
+        m_lastError = m_socket.lastError();
+        return;
+    }
+    
+    // Enable address reuse (allows binding even if port is in use) and broadcast
+    m_socket.setReuseAddress();
+    m_socket.setBroadcast(true);
+    
+    // Bind to the chosen interface/source address (or any) on an ephemeral port,
+    // the same socket also receives discovery replies
+    if (!m_socket.bindTo(m_bindInterface, 0))
+    {
+        m_lastError = m_socket.lastError();
+        m_socket.close();
+        return;
+    }
+    
+    m_lastError = "Socket initialized successfully";
+}
+
+bool DDPOutputCHOP::resolveDestination(const char* ipAddress, int port)
+{
+    // Literal addresses need no lookup
+    m_destIsHostname = false;
+    if (ddp::parseAddress(ipAddress, port, m_destAddr, m_destAddrLen))
+        return true;
+    
+    if (ipAddress[0] == '\0')
+    {
+        m_lastError = "No IP address or hostname set";
+        return false;
+    }
+    
+    // Hostnames come from the background resolver's cache, never from a blocking lookup here
+    m_destIsHostname = true;
+    if (!m_resolver.lookup(ipAddress, m_destAddr, m_destAddrLen))
+    {
+        m_lastError = m_resolver.getStatus();
+        return false;
+    }
+    
+    ddp::setPort(m_destAddr, port);
+    return true;
+}
+
+void DDPOutputCHOP::closeSocket()
+{
+    m_socket.close();
+    m_secondarySocket.close();
+    m_secondarySource.clear();
+}
+
+void DDPOutputCHOP::sendDDPData(const std::vector<uint8_t>& pixelData, size_t maxPayload, bool autoPush)
+{
+    if (!m_socket.isOpen() || pixelData.empty() || maxPayload == 0)
+        return;
+    
+    ddp::SegmentOptions options;
+    options.maxPayload = maxPayload;
+    options.dataType = m_dataType;
+    options.pushOnLast = autoPush;   // only push on the last packet of the frame
+    options.timecode = m_timecodeEnabled;
+    options.timecodeValue = m_frameTimecode;
+    
+    // Packets reference the frame buffer directly and go out in one batch.
+    // Ranges with a transport of their own are left out of the output's stream.
+    updateTransports(pixelData.size());
+    size_t packetCount = m_transportsActive
+        ? m_segmenter.segment(pixelData.data(), m_ddpSpans.data(), m_ddpSpans.size(), options)
+        : m_segmenter.segment(pixelData.data(), pixelData.size(), options);
+    
+    int64_t bytesSent = 0;
+    size_t packetsSent = sendToLegs(m_segmenter.slices().data(), packetCount, bytesSent);
+    
+    if (m_recorder.isOpen())
+        recordSent(pixelData, packetCount);
+    
+    if (m_pcapMirror.isOpen())
+        mirrorSlices(m_segmenter.slices().data(), packetCount, m_destAddr);
+    
+    if (m_transportsActive)
+        packetsSent += sendTransports(pixelData, options, bytesSent);
+    
+    if (m_showStats)
+    {
+        m_packetsSent += static_cast<int64_t>(packetsSent);
+        m_bytesSent += bytesSent;
+    }
+}
+
+size_t DDPOutputCHOP::sendToLegs(const ddp::SendSlice* slices, size_t count, int64_t& bytesSent,
+                                 const struct sockaddr_storage* dest, socklen_t destLength)
+{
+    // Both legs send the same slices: the frame is converted and cut once
+    bool redundant = m_redundancy != ddp::Redundancy::Off && m_secondarySocket.isOpen();
+    bool sendBoth = redundant && m_redundancy == ddp::Redundancy::Both;
+    bool useLeg[2] = { !redundant || sendBoth || m_legSelector.active() == 0,
+                       redundant && (sendBoth || m_legSelector.active() == 1) };
+    ddp::UdpSocket* sockets[2] = { &m_socket, &m_secondarySocket };
+    const struct sockaddr_storage* dests[2] = { &m_destAddr, &m_secondaryAddr };
+    socklen_t destLengths[2] = { m_destAddrLen, m_secondaryAddrLen };
+    if (dest)
+    {
+        dests[0] = dests[1] = dest;
+        destLengths[0] = destLengths[1] = destLength;
+    }
+    
+    size_t packetsSent = 0;
+    for (int leg = 0; leg < 2; leg++)
+    {
+        // A range address of the other family cannot go out on that leg's socket
+        if (!useLeg[leg] || (dest && dest->ss_family != sockets[leg]->family()))
+            continue;
+        int64_t legBytes = 0;
+        size_t sent = sockets[leg]->sendSlices(slices, count, *dests[leg], destLengths[leg], legBytes);
+        if (sent < count)
+        {
+            m_lastError = sockets[leg]->lastError();
+            m_legs[leg].sendErrors += static_cast<int64_t>(count - sent);
+        }
+        m_legs[leg].packetsSent += static_cast<int64_t>(sent);
+        m_legs[leg].bytesSent += legBytes;
+        packetsSent += sent;
+        bytesSent += legBytes;
+    }
+    return packetsSent;
+}
+
+void DDPOutputCHOP::updateRedundancy(const OP_Inputs* inputs)
+{
+    ddp::Redundancy redundancy = ddp::redundancyFromName(inputs->getParString("Redundancy"));
+    m_healthInterval = inputs->getParDouble("Healthinterval");
+    m_healthTimeout = inputs->getParDouble("Healthtimeout");
+    const char* address = inputs->getParString("Secondaryaddress");
+    int port = inputs->getParInt("Secondaryport");
+    const char* bindInterface = inputs->getParString("Secondaryinterface");
+    int multicastTTL = inputs->getParInt("Multicastttl");
+    bool multicastLoop = inputs->getParInt("Multicastloop") != 0;
+    if (port == 0)
+        port = m_lastPort;
+    
+    // Switching modes starts the counts and the health checks over
+    double now = std::chrono::duration<double>(std::chrono::steady_clock::now().time_since_epoch()).count();
+    if (redundancy != m_redundancy)
+    {
+        m_redundancy = redundancy;
+        m_legs[0] = OutputLeg();
+        m_legs[1] = OutputLeg();
+        m_legs[0].health.reset(now);
+        m_legs[1].health.reset(now);
+        m_legSelector.reset();
+    }
+    if (redundancy == ddp::Redundancy::Off || address[0] == '\0')
+    {
+        m_secondarySocket.close();
+        m_secondarySource.clear();
+        m_secondaryStatus = "no Secondary Address";
+        return;
+    }
+    
+    // Hostnames come from the secondary's own background resolver
+    struct sockaddr_storage dest;
+    socklen_t destLength = 0;
+    if (!ddp::parseAddress(address, port, dest, destLength))
+    {
+        if (!m_secondaryResolver.lookup(address, dest, destLength))
+        {
+            m_secondarySocket.close();
+            m_secondarySource.clear();
+            m_secondaryStatus = m_secondaryResolver.getStatus();
+            return;
+        }
+        ddp::setPort(dest, port);
+    }
+    
+    // TTL and loopback only matter, and only reopen the socket, for a group:
+    // the leg's own, or the sACN groups of the ranges it also carries
+    bool multicast = ddp::isMulticast(dest) || m_transportMulticast;
+    std::string source = ddp::formatAddress(reinterpret_cast<const struct sockaddr*>(&dest)) + ":" +
+                         std::to_string(port) + ":" + bindInterface + ":" +
+                         (multicast ? std::to_string(multicastTTL) + ":" + std::to_string(multicastLoop) : "-");
+    if (source == m_secondarySource)
+        return;
+    m_secondarySource = source;
+    m_secondarySocket.close();
+    m_secondaryAddr = dest;
+    m_secondaryAddrLen = destLength;
+    m_legs[1].health.reset(now);
+    
+    // Set up like the primary socket, on the secondary network's interface
+    bool opened = m_secondarySocket.open(dest.ss_family == AF_INET6 ? AF_INET6 : AF_INET);
+    if (opened)
+    {
+        m_secondarySocket.setReuseAddress();
+        m_secondarySocket.setBroadcast(true);
+        opened = m_secondarySocket.bindTo(bindInterface, 0);
+    }
+    if (opened && multicast)
+    {
+        // Groups leave on the secondary network's NIC. IPv4 names it by
+        // address; a device name has already pinned the socket to it.
+        std::string multicastInterface = bindInterface;
+        struct sockaddr_storage local;
+        socklen_t localLength = 0;
+        if (dest.ss_family == AF_INET && !ddp::parseAddress(multicastInterface, 0, local, localLength))
+            multicastInterface.clear();
+        opened = m_secondarySocket.configureMulticastSend(multicastTTL, multicastLoop, multicastInterface);
+    }
+    if (!opened)
+    {
+        m_secondaryStatus = m_secondarySocket.lastError();
+        m_lastError = "Secondary leg: " + m_secondaryStatus;
+        m_secondarySocket.close();
+    }
+}
+
+void DDPOutputCHOP::checkLegHealth()
+{
+    if (m_redundancy == ddp::Redundancy::Off || !m_secondarySocket.isOpen())
+        return;
+    
+    double now = std::chrono::duration<double>(std::chrono::steady_clock::now().time_since_epoch()).count();
+    ddp::UdpSocket* sockets[2] = { &m_socket, &m_secondarySocket };
+    const struct sockaddr_storage* dests[2] = { &m_destAddr, &m_secondaryAddr };
+    socklen_t destLengths[2] = { m_destAddrLen, m_secondaryAddrLen };
+    
+    for (int leg = 0; leg < 2; leg++)
+    {
+        // Controllers answer a group or broadcast from their own address, so
+        // any of them counts there; checked once per destination
+        OutputLeg& state = m_legs[leg];
+        std::string dest = ddp::formatAddress(reinterpret_cast<const struct sockaddr*>(dests[leg]));
+        if (dest != state.replyDest)
+        {
+            state.replyDest = dest;
+            state.anyReplier = ddp::isMulticast(*dests[leg]) || ddp::isBroadcast(*dests[leg]);
+        }
+        
+        // Only STATUS replies count, read without waiting so the cook never blocks
+        uint8_t buffer[2048];
+        for (int i = 0; i < 64 && sockets[leg]->waitReadable(0); i++)
+        {
+            struct sockaddr_storage from;
+            bool wouldBlock = false;
+            int received = sockets[leg]->recvFrom(buffer, sizeof(buffer), from, wouldBlock);
+            if (received <= 0)
+                break;
+            ddp::PacketHeader header;
+            const uint8_t* payload = nullptr;
+            if (!ddp::unpackHeader(buffer, static_cast<size_t>(received), header, payload) ||
+                (header.flags & DDP_FLAGS1_REPLY) == 0 || header.destId != DDP_ID_STATUS)
+                continue;
+            if (state.anyReplier || ddp::sameHost(from, *dests[leg]))
+                state.health.replied(now);
+        }
+        
+        if (state.health.queryDue(now, m_healthInterval))
+            sendStatusQuery(*sockets[leg], *dests[leg], destLengths[leg]);
+    }
+    
+    if (m_redundancy == ddp::Redundancy::Standby)
+        m_legSelector.select(m_legs[0].health.healthy(now, m_healthTimeout),
+                             m_legs[1].health.healthy(now, m_healthTimeout));
+}
+
+void DDPOutputCHOP::sendStatusQuery(ddp::UdpSocket& socket, const struct sockaddr_storage& dest, socklen_t destLength)
+{
+    // Header only, like the discovery query, but sent to the leg's own port
+    ddp::PacketHeader query;
+    query.flags = DDP_FLAGS1_VER1 | DDP_FLAGS1_QUERY;
+    query.dataType = 0x00;
+    query.destId = DDP_ID_STATUS;
+    
+    uint8_t packet[DDP_HEADER_SIZE];
+    size_t packetSize = ddp::packHeader(query, packet);
+    socket.sendTo(packet, packetSize, dest, destLength);
+}
+
+std::string DDPOutputCHOP::legSummary(int leg) const
+{
+    // "10.0.0.5, healthy (reply 0.4 s ago), 1200 packets, 1.7 MB, 0 errors"
+    bool open = leg == 0 ? m_socket.isOpen() : m_secondarySocket.isOpen();
+    if (leg == 1 && m_redundancy != ddp::Redundancy::Off && !open)
+        return m_secondaryStatus;
+    if (m_redundancy == ddp::Redundancy::Off || !open)
+        return "off";
+    
+    const OutputLeg& state = m_legs[leg];
+    const struct sockaddr_storage& dest = leg == 0 ? m_destAddr : m_secondaryAddr;
+    double now = std::chrono::duration<double>(std::chrono::steady_clock::now().time_since_epoch()).count();
+    char text[192];
+    snprintf(text, sizeof(text), "%s, %s (reply %.1f s ago), %lld packets, %.1f MB, %lld errors",
+             ddp::formatAddress(reinterpret_cast<const struct sockaddr*>(&dest)).c_str(),
+             state.health.healthy(now, m_healthTimeout) ? "healthy" : "failed", state.health.sinceReply(now),
+             static_cast<long long>(state.packetsSent), state.bytesSent / (1024.0 * 1024.0),
+             static_cast<long long>(state.sendErrors));
+    return text;
+}
+
+void DDPOutputCHOP::recordSent(const std::vector<uint8_t>& pixelData, size_t packetCount)
+{
+    if (!m_recordPackets)
+    {
+        m_recorder.writeFrame(pixelData.data(), pixelData.size(), m_timecodeEnabled, m_frameTimecode, m_dataType);
+        return;
+    }
+    
+    const std::vector<ddp::SendSlice>& slices = m_segmenter.slices();
+    for (size_t i = 0; i < packetCount; i++)
+        m_recorder.writePacket(slices[i].header, slices[i].headerLength, slices[i].payload, slices[i].payloadLength);
+}
+
+void DDPOutputCHOP::updatePcapMirror(const OP_Inputs* inputs)
+{
+    std::string file = inputs->getParInt("Pcapmirror") != 0 ? inputs->getParFilePath("Pcapfile") : "";
+    if (file == m_pcapMirrorFile)
+        return;
+    
+    // A new file is started on every change, a failed open is retried only after a change
+    m_pcapMirror.close();
+    m_pcapMirrorFile = file;
+    if (!file.empty() && !m_pcapMirror.open(file))
+        m_lastError = m_pcapMirror.lastError();
+}
+
+void DDPOutputCHOP::mirrorSlices(const ddp::SendSlice* slices, size_t count, const struct sockaddr_storage& dest)
+{
+    // Written as sent from the socket's bound address, stamped with the wall clock
+    struct sockaddr_storage source;
+    m_socket.localAddress(source);
+    double now = std::chrono::duration<double>(std::chrono::system_clock::now().time_since_epoch()).count();
+    
+    for (size_t i = 0; i < count; i++)
+    {
+        if (!m_pcapMirror.writeDatagram(source, dest, slices[i].header, slices[i].headerLength,
+                                        slices[i].payload, slices[i].payloadLength, now))
+        {
+            m_lastError = m_pcapMirror.lastError();
+            break;
+        }
+    }
+}
+
+void DDPOutputCHOP::updateTransports(size_t frameBytes)
+{
+    // Replanned when the ranges, the frame size or the port change
+    std::string source = m_rangesSource + ":" + std::to_string(frameBytes) + ":" + std::to_string(m_bytesPerPixel) +
+                         ":" + std::to_string(m_lastPort) + ":" + std::to_string(m_socketFamily);
+    if (source == m_transportSource)
+        return;
+    m_transportSource = source;
+    m_transports.clear();
+    m_transportsActive = false;
+    m_transportMulticast = false;
+    
+    std::vector<ddp::TransportRoute> routes;
+    std::string error;
+    bool valid = ddp::planTransports(m_ranges, frameBytes, m_bytesPerPixel, routes, m_ddpSpans, error);
+    
+    m_transports.resize(routes.size());
+    for (size_t i = 0; valid && i < routes.size(); i++)
+    {
+        RangeTransport& transport = m_transports[i];
+        transport.route = routes[i];
+        const ddp::TransportRoute& route = transport.route;
+        
+        // DDP defaults to the output's port, sACN and Art-Net to their own. An empty
+        // address is one multicast group per sACN universe, or Art-Net broadcast.
+        int port = route.port != 0 ? route.port : m_lastPort;
+        std::string address = route.address;
+        if (route.transport != ddp::Transport::Ddp)
+        {
+            bool artNet = route.transport == ddp::Transport::ArtNet;
+            if (route.port == 0)
+                port = artNet ? DDP_ARTNET_PORT : DDP_SACN_PORT;
+            transport.dmxSegmenter.setUniverses(artNet ? ddp::DmxProtocol::ArtNet : ddp::DmxProtocol::Sacn,
+                                                route.universes, DDP_TRANSPORT_SACN_NAME, m_sacnCid);
+            if (address.empty() && artNet)
+                address = "255.255.255.255";
+        }
+        
+        std::vector<std::string> hosts(1, address);
+        if (address.empty())
+        {
+            hosts.clear();
+            for (const ddp::UniverseMap& map : route.universes)
+                hosts.push_back(ddp::sacnMulticastGroup(map.universe));
+            m_transportMulticast = m_transportMulticast || !hosts.empty();
+        }
+        transport.dests.resize(hosts.size());
+        transport.destLengths.resize(hosts.size());
+        for (size_t h = 0; valid && h < hosts.size(); h++)
+        {
+            if (!ddp::parseAddress(hosts[h], port, transport.dests[h], transport.destLengths[h]))
+            {
+                error = "Range '" + route.name + "': address '" + hosts[h] + "' is not an IP address";
+                valid = false;
+            }
+            else if (transport.dests[h].ss_family != m_socketFamily)
+            {
+                error = "Range '" + route.name + "': " + hosts[h] + " is not reachable from the output's " +
+                        (m_socketFamily == AF_INET6 ? "IPv6" : "IPv4") + " socket";
+                valid = false;
+            }
+        }
+    }
+    
+    if (!valid)
+    {
+        // Everything goes to the output's own stream until the ranges are fixed
+        m_lastError = error;
+        m_transports.clear();
+        m_transportMulticast = false;
+        m_ddpSpans.assign(1, ddp::ByteSpan{ 0, frameBytes });
+        return;
+    }
+    m_transportsActive = !m_transports.empty();
+}
+
+size_t DDPOutputCHOP::sendTransports(const std::vector<uint8_t>& pixelData, const ddp::SegmentOptions& options,
+                                     int64_t& bytesSent)
+{
+    size_t packetsSent = 0;
+    for (RangeTransport& transport : m_transports)
+    {
+        const ddp::TransportRoute& route = transport.route;
+        const ddp::SendSlice* slices = nullptr;
+        size_t packetCount = 0;
+        if (route.transport == ddp::Transport::Ddp)
+        {
+            // A frame of its own for the range's controller, from offset 0
+            packetCount = transport.ddpSegmenter.segment(pixelData.data() + route.bytes.offset, route.bytes.length, options);
+            slices = transport.ddpSegmenter.slices().data();
+        }
+        else
+        {
+            packetCount = transport.dmxSegmenter.segment(pixelData.data(), pixelData.size());
+            slices = transport.dmxSegmenter.slices().data();
+        }
+        
+        // One batch per destination: the whole range, or each universe's multicast group
+        size_t batch = transport.dests.size() > 1 ? 1 : packetCount;
+        size_t sent = 0;
+        for (size_t i = 0; i < packetCount; i += batch)
+        {
+            size_t dest = std::min(i, transport.dests.size() - 1);
+            size_t count = std::min(batch, packetCount - i);
+            sent += sendToLegs(slices + i, count, bytesSent, &transport.dests[dest], transport.destLengths[dest]);
+            if (m_pcapMirror.isOpen())
+                mirrorSlices(slices + i, count, transport.dests[dest]);
+        }
+        m_transportPackets[static_cast<int>(route.transport)] += static_cast<int64_t>(sent);
+        packetsSent += sent;
+    }
+    return packetsSent;
+}
+
+std::string DDPOutputCHOP::transportSummary() const
+{
+    if (!m_transportsActive)
+        return "off";
+    
+    // "sACN 2 ranges (6 universes), Art-Net 1 range (1 universe), DDP 1 range"
+    std::string summary;
+    const ddp::Transport order[] = { ddp::Transport::Sacn, ddp::Transport::ArtNet, ddp::Transport::Ddp };
+    for (ddp::Transport kind : order)
+    {
+        size_t ranges = 0, universes = 0;
+        for (const RangeTransport& transport : m_transports)
+        {
+            if (transport.route.transport != kind)
+                continue;
+            ranges++;
+            universes += transport.route.universes.size();
+        }
+        if (ranges == 0)
+            continue;
+        summary += (summary.empty() ? "" : ", ") + std::string(ddp::transportName(kind)) + " " +
+                   std::to_string(ranges) + (ranges == 1 ? " range" : " ranges");
+        if (kind != ddp::Transport::Ddp)
+            summary += " (" + std::to_string(universes) + (universes == 1 ? " universe)" : " universes)");
+    }
+    return summary;
+}
+
+void DDPOutputCHOP::playRecording(const OP_Inputs* inputs, bool autoPush)
+{
+    std::string file = inputs->getParFilePath("Playbackfile");
+    if (file != m_playbackFile)
+    {
+        m_player.close();
+        m_playbackFile = file;
+        m_playbackTime = 0.0;
+        m_playbackCursor = 0;
+        if (!file.empty() && !m_player.open(file))
+            m_lastError = m_player.lastError();
+    }
+    if (!m_player.isOpen() || m_player.recordCount() == 0)
+        return;
+    
+    // Start at the first record rather than the moment recording was armed
+    double first = static_cast<double>(m_player.timestampUs(0));
+    if (m_playbackTime < first)
+        m_playbackTime = first;
+    
+    // Advance the play head by wall time scaled by the rate
+    double rate = std::max(0.0, inputs->getParDouble("Playbackrate"));
+    double now = std::chrono::duration<double>(std::chrono::steady_clock::now().time_since_epoch()).count();
+    if (m_playbackLastTick >= 0.0)
+        m_playbackTime += (now - m_playbackLastTick) * 1e6 * rate;
+    m_playbackLastTick = now;
+    
+    size_t target = 0;
+    double duration = static_cast<double>(m_player.durationUs());
+    if (m_seekRequested)
+    {
+        m_seekRequested = false;
+        m_playbackTime = std::min(duration, first + inputs->getParDouble("Seektime") * 1e6);
+        m_player.findRecord(static_cast<uint64_t>(m_playbackTime), m_playbackCursor);
+    }
+    else if (m_playbackTime > duration)
+    {
+        if (inputs->getParInt("Playbackloop") != 0 && duration > first)
+        {
+            m_playbackTime = first + std::fmod(m_playbackTime - first, duration - first);
+            m_playbackCursor = 0;
+        }
+        else
+        {
+            m_playbackTime = duration;
+        }
+    }
+    
+    if (!m_player.findRecord(static_cast<uint64_t>(m_playbackTime), target) || target < m_playbackCursor)
+        return;
+    
+    // Packets due since the last cook go out as recorded; of the frames due,
+    // only the newest is sent (the ones in between are decoded but skipped)
+    size_t lastFrame = SIZE_MAX;
+    for (size_t i = m_playbackCursor; i <= target; i++)
+    {
+        if (m_player.recordType(i) == DDP_REC_TYPE_FRAME)
+        {
+            lastFrame = i;
+            continue;
+        }
+        
+        // Sent one at a time: an LZ4 packet is only valid until the next read
+        ddp::SendSlice slice = {};
+        if (m_player.readPacket(i, slice.header, slice.headerLength) && slice.headerLength > 0)
+        {
+            int64_t bytesSent = 0;
+            size_t packetsSent = sendToLegs(&slice, 1, bytesSent);
+            if (m_pcapMirror.isOpen())
+                mirrorSlices(&slice, 1, m_destAddr);
+            if (m_showStats)
+            {
+                m_packetsSent += static_cast<int64_t>(packetsSent);
+                m_bytesSent += bytesSent;
+            }
+        }
+    }
+    m_playbackCursor = target + 1;
+    
+    if (lastFrame != SIZE_MAX)
+    {
+        if (!m_player.readFrame(lastFrame, m_playbackFrame))
+        {
+            m_lastError = m_player.lastError();
+            return;
+        }
+        
+        // Frames go out with the data type they were recorded with; legacy type
+        // bytes don't name a pixel size, so Channels Per Pixel still applies to them
+        uint8_t recordedType = m_player.dataType(lastFrame);
+        if (recordedType != 0 && ddp::isPixelDataType(recordedType))
+        {
+            int channels = ddp::elementsPerPixel(recordedType);
+            if (channels == 0)
+                channels = inputs->getParInt("Channelsperpixel");
+            m_dataType = recordedType;
+            m_bitDepth = ddp::bitsPerElement(recordedType);
+            int bytesPerPixel = channels * m_bitDepth / 8;
+            m_bytesPerPixel = static_cast<size_t>(std::max(1, bytesPerPixel));
+            m_payloadSize = effectivePayloadSize(inputs->getParInt("Maxpayload"), bytesPerPixel);
+            checkPayloadAgainstMTU(m_payloadSize);
+        }
+        m_lastChannelCount = static_cast<int32_t>(m_playbackFrame.size() / std::max(1, m_bitDepth / 8));
+        m_lastPixelCount = static_cast<int32_t>(m_playbackFrame.size() / m_bytesPerPixel);
+        
+        // Stamped for when it goes out now, like a live frame
+        if (m_timecodeEnabled)
+            m_frameTimecode = computeTimecode(inputs, inputs->getParDouble("Presentationdelay"));
+        sendDDPData(m_playbackFrame, m_payloadSize, autoPush);
+    }
+}
+
+void DDPOutputCHOP::updateRecording(const OP_Inputs* inputs)
+{
+    if (inputs->getParInt("Record") == 0)
+    {
+        m_recorder.close();
+        m_recordTarget.clear();
+        return;
+    }
+    
+    std::string file = inputs->getParFilePath("Recordfile");
+    std::string mode = inputs->getParString("Recordmode");
+    std::string compression = inputs->getParString("Recordcompression");
+    
+    // Changing any setting starts a new file; a failed open is retried only after a change
+    std::string target = file + "|" + mode + "|" + compression;
+    if (target == m_recordTarget)
+        return;
+    
+    m_recorder.close();
+    m_recordTarget = target;
+    m_recordPackets = (mode == "packets");
+    
+    if (file.empty())
+    {
+        m_lastError = "Record File is empty";
+        return;
+    }
+    if (!m_recorder.open(file, ddp::recordCompressionFromName(compression)))
+        m_lastError = m_recorder.lastError();
+}
+
+void DDPOutputCHOP::sendPushPacket()
+{
+    if (!m_socket.isOpen())
+        return;
+    
+    // Create a PUSH packet with no data (just header)
+    m_segmenter.control(DDP_FLAGS1_PUSH, DDP_ID_DISPLAY);
+    
+    int64_t bytesSent = 0;
+    size_t packetsSent = sendToLegs(m_segmenter.slices().data(), 1, bytesSent);
+    
+    if (packetsSent > 0 && m_showStats)
+    {
+        m_packetsSent += static_cast<int64_t>(packetsSent);
+        m_bytesSent += bytesSent;
+    }
+}
+
+void DDPOutputCHOP::configureMulticast(int ttl, bool loopback, const char* interfaceAddress)
+{
+    if (!m_socket.isOpen())
+        return;
+    
+    // Only touch the socket when something changed since the last cook
+    if (m_multicastConfigured && m_multicastTTL == ttl && m_multicastLoop == loopback &&
+        m_multicastInterface == interfaceAddress)
+        return;
+    
+    m_multicastTTL = ttl;
+    m_multicastLoop = loopback;
+    m_multicastInterface = interfaceAddress;
+    m_multicastConfigured = true;
+    
+    if (!m_socket.configureMulticastSend(ttl, loopback, m_multicastInterface))
+        m_lastError = m_socket.lastError();
+}
+
+uint32_t DDPOutputCHOP::computeTimecode(const OP_Inputs* inputs, double presentationDelayMs) const
+{
+    double seconds = 0.0;
+    const OP_TimeInfo* timeInfo = inputs->getTimeInfo();
+    
+    if (timeInfo && timeInfo->rate > 0.0 && strcmp(inputs->getParString("Timecode"), "timeline") == 0)
+    {
+        // Timeline position of this cook
+        seconds = timeInfo->frame / timeInfo->rate;
+    }
+    else
+    {
+        // Monotonic clock, unaffected by timeline jumps or wall clock changes
+        auto now = std::chrono::steady_clock::now().time_since_epoch();
+        seconds = std::chrono::duration<double>(now).count();
+    }
+    
+    seconds += presentationDelayMs / 1000.0;
+    
+    // 16.16 fixed point, wraps every 65536 seconds
+    return static_cast<uint32_t>(static_cast<uint64_t>(seconds * 65536.0) & 0xFFFFFFFFu);
+}
+
+size_t DDPOutputCHOP::effectivePayloadSize(int requestedPayload, int bytesPerPixel) const
+{
+    int payloadLimit = static_cast<int>(DDP_UDP_MAX_PAYLOAD - headerSize());
+    size_t payload = static_cast<size_t>(std::max(1, std::min(requestedPayload, payloadLimit)));
+    
+    // Keep pixels whole within a packet so receivers never see a split pixel
+    if (bytesPerPixel > 1 && payload >= static_cast<size_t>(bytesPerPixel))
+        payload -= payload % static_cast<size_t>(bytesPerPixel);
+    
+    return payload;
+}
+
+void DDPOutputCHOP::checkPayloadAgainstMTU(size_t payloadSize)
+{
+    if (payloadSize == m_lastCheckedPayload)
+        return;
+    m_lastCheckedPayload = payloadSize;
+    
+    if (m_interfaceMTU <= 0)
+        return;
+    
+    size_t ipOverhead = (m_socketFamily == AF_INET6) ? DDP_IPV6_UDP_OVERHEAD : DDP_IPV4_UDP_OVERHEAD;
+    size_t packetSize = payloadSize + headerSize() + ipOverhead;
+    if (packetSize > static_cast<size_t>(m_interfaceMTU))
+    {
+        m_lastError = "Payload " + std::to_string(payloadSize) + " bytes exceeds interface MTU " +
+                      std::to_string(m_interfaceMTU) + ", packets will be IP fragmented";
+    }
+}
+
+void DDPOutputCHOP::processInterleavedChannels(const OP_CHOPInput* chopInput, 
+                                                 float gamma, float brightness,
+                                                 bool normalizedInput, int channelsPerPixel,
+                                                 std::vector<uint8_t>& pixelData)
+{
+    // Like DMX Out CHOP: expects 1 channel with consecutive samples
+    // Works with any data: RGB, RGBW, or any channel count per pixel
+    // Examples: r0,g0,b0,r1,g1,b1... or r0,g0,b0,w0,r1,g1,b1,w1...
+    if (chopInput->numChannels < 1)
+    {
+        pixelData.clear();
+        return;
+    }
+    
+    ddp::ConvertSettings settings;
+    settings.gamma = gamma;
+    settings.brightness = brightness;  // brightness is 0-1, so this scales 0-255 input down proportionally
+    settings.normalizedInput = normalizedInput;
+    settings.wideOutput = m_bitDepth == 16;
+    
+    // A layout or color orders rearrange whole pixels while converting, and
+    // dithering, 16-bit output and calibration go through the same blocks (a
+    // trailing partial pixel is dropped)
+    if ((m_layoutActive || m_rangesActive || m_dither || settings.wideOutput || m_calibrationActive || m_powerLimit) &&
+        channelsPerPixel > 0)
+    {
+        const float* src = chopInput->getChannelData(0);
+        const int inputChannels = m_calibrationActive ? m_calibrationInputs : channelsPerPixel;
+        size_t sourcePixels = static_cast<size_t>(chopInput->numSamples) / inputChannels;
+        if (m_layoutActive)
+            m_layout.compile(m_layoutSettings, sourcePixels);
+        size_t wirePixels = m_layoutActive ? m_layout.size() : sourcePixels;
+        updateConvertPlan(sourcePixels, wirePixels);
+        
+        const size_t valueBytes = settings.wideOutput ? 2 : 1;
+        pixelData.resize(wirePixels * static_cast<size_t>(channelsPerPixel) * valueBytes);
+        uint8_t* error = m_dither ? ditherState(pixelData.size()) : nullptr;
+        const ddp::CalibrationKernel* kernels = nullptr;
+        if (m_calibrationActive)
+        {
+            compileKernels(brightness, normalizedInput ? 1.0f : 1.0f / 255.0f, inputChannels, channelsPerPixel);
+            kernels = m_kernels.data();
+        }
+        ddp::RangePower* power = nullptr;
+        if (m_powerLimit)
+        {
+            startMetering();
+            power = m_power.data();
+        }
+        if (m_layoutActive && m_layout.runs().empty())
+        {
+            // Scattered layout: the plan pieces are spans of the index table
+            for (const ddp::LayoutRun& span : m_convertPlan)
+            {
+                size_t offset = static_cast<size_t>(span.source) * channelsPerPixel;
+                ddp::convertGathered(src, m_layout.indices() + span.source, span.count, channelsPerPixel, settings,
+                                     pixelData.data() + offset * valueBytes, &m_colorOrders[span.order],
+                                     error ? error + offset : nullptr, kernels ? &kernels[span.order] : nullptr,
+                                     power ? &power[span.order] : nullptr);
+            }
+        }
+        else
+        {
+            ddp::convertRuns(src, m_convertPlan.data(), m_convertPlan.size(), channelsPerPixel, settings,
+                             pixelData.data(), m_colorOrders.data(), error, kernels, power);
+        }
+        if (m_powerLimit)
+            finishMetering(channelsPerPixel, settings.wideOutput ? 65535.0 : m_dither ? 255.0 * 256.0 : 255.0);
+        return;
+    }
+    
+    pixelData.resize(static_cast<size_t>(chopInput->numSamples));
+    ddp::convertSamples(chopInput->getChannelData(0), pixelData.size(), settings, pixelData.data());
 }
 
-void DDPOutputCHOP::pulsePressed(const char* name, void* reserved1)
+void DDPOutputCHOP::updateConvertPlan(size_t sourcePixels, size_t wirePixels)
 {
-    if (strcmp(name, "Discover") == 0)
+    std::string key = (m_layoutActive ? m_layoutSettings.key() : std::string("-")) + "/" +
+                      std::to_string(sourcePixels) + "/" + m_rangesSource;
+    if (key == m_convertPlanKey)
+        return;
+    m_convertPlanKey = key;
+    
+    // Layout runs, or one run over every pixel (for a scattered layout the
+    // "source" of that run is the position in the index table)
+    std::vector<ddp::LayoutRun> runs;
+    if (m_layoutActive && !m_layout.runs().empty())
     {
-        discoverDevices();
+        runs = m_layout.runs();
+    }
+    else if (wirePixels > 0)
+    {
+        ddp::LayoutRun all;
+        all.source = 0;
+        all.count = static_cast<uint32_t>(wirePixels);
+        all.step = 1;
+        all.order = 0;
+        runs.push_back(all);
     }
+    ddp::splitRuns(runs, m_ranges, wirePixels, m_convertPlan);
 }
 
-void DDPOutputCHOP::initializeSocket()
+void DDPOutputCHOP::updateRanges(const OP_Inputs* inputs, int channelsPerPixel)
 {
-    if (m_socketInitialized)
+    // Reparsed when the DAT cooks or the order / channel count changes
+    const OP_DATInput* dat = inputs->getParDAT("Rangesdat");
+    const char* order = inputs->getParString("Colororder");
+    std::string source = std::string(dat ? dat->opPath : "") + ":" + std::to_string(dat ? dat->totalCooks : 0) +
+                         ":" + order + ":" + std::to_string(channelsPerPixel);
+    if (source == m_rangesSource)
         return;
+    m_rangesSource = source;
+    m_ranges.clear();
+    m_colorOrders.assign(1, ddp::ColorOrder());
     
-    #ifdef _WIN32
-    if (!m_wsaInitialized)
+    std::string error;
+    bool valid = ddp::parseColorOrder(order, channelsPerPixel, m_colorOrders[0], error);
+    if (dat && valid)
     {
-        WSADATA wsaData;
-        int result = WSAStartup(MAKEWORD(2, 2), &wsaData);
-        if (result != 0)
+        ddp::RangeTableParser parser;
+        std::vector<const char*> cells;
+        ddp::PixelRange range;
+        for (int32_t row = 0; row < dat->numRows; row++)
         {
-            m_lastError = "WSAStartup failed";
-            return;
+            cells.resize(static_cast<size_t>(dat->numCols));
+            for (int32_t col = 0; col < dat->numCols; col++)
+                cells[col] = dat->getCell(row, col);
+            if (parser.parseRow(cells.data(), dat->numCols, range))
+                m_ranges.push_back(range);
+        }
+        valid = ddp::sortRanges(m_ranges, error);
+        
+        // An empty order inherits the output's
+        for (size_t i = 0; valid && i < m_ranges.size(); i++)
+        {
+            m_colorOrders.push_back(m_colorOrders[0]);
+            if (!m_ranges[i].order.empty())
+                valid = ddp::parseColorOrder(m_ranges[i].order.c_str(), channelsPerPixel, m_colorOrders.back(), error);
         }
-        m_wsaInitialized = true;
     }
-    
-    m_socket = socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
-    if (m_socket == INVALID_SOCKET)
+    if (!valid)
     {
-        m_lastError = "Socket creation failed";
-        return;
+        m_lastError = error;
+        m_ranges.clear();
+        m_colorOrders.assign(1, ddp::ColorOrder());
     }
     
-    // Enable address reuse (allows binding even if port is in use)
-    BOOL reuseAddr = TRUE;
-    setsockopt(m_socket, SOL_SOCKET, SO_REUSEADDR, (char*)&reuseAddr, sizeof(reuseAddr));
-    
-    // Enable broadcast
-    BOOL broadcastEnable = TRUE;
-    setsockopt(m_socket, SOL_SOCKET, SO_BROADCAST, (char*)&broadcastEnable, sizeof(broadcastEnable));
-    
-    // Bind to any local address on DDP port to receive broadcast responses
-    struct sockaddr_in localAddr;
-    memset(&localAddr, 0, sizeof(localAddr));
-    localAddr.sin_family = AF_INET;
-    localAddr.sin_addr.s_addr = INADDR_ANY;
-    localAddr.sin_port = htons(0);  // Use ephemeral port for sending, but we'll listen on this socket
-    
-    if (bind(m_socket, (struct sockaddr*)&localAddr, sizeof(localAddr)) == SOCKET_ERROR)
+    m_rangesActive = false;
+    for (const ddp::ColorOrder& colorOrder : m_colorOrders)
+        m_rangesActive = m_rangesActive || !colorOrder.isIdentity(channelsPerPixel);
+}
+
+void DDPOutputCHOP::updateCalibration(const OP_Inputs* inputs, int channelsPerPixel)
+{
+    // Reparsed when the ranges or any of the parameters change
+    const char* matrix = inputs->getParString("Colormatrix");
+    ddp::CalibrationSettings output;
+    for (int c = 0; c < 4; c++)
     {
-        m_lastError = "Socket bind failed";
-        closesocket(m_socket);
-        m_socket = INVALID_SOCKET;
-        return;
+        output.gain[c] = static_cast<float>(inputs->getParDouble("Gain", c));
+        output.offset[c] = static_cast<float>(inputs->getParDouble("Offset", c));
     }
+    output.white = static_cast<float>(inputs->getParDouble("Whiteextraction"));
     
-    #else
-    m_socket = socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
-    if (m_socket < 0)
-    {
-        int error = errno;
-        m_lastError = "Socket creation failed, errno " + std::to_string(error) + ": " + strerror(error);
+    std::string source = m_rangesSource + ":" + matrix;
+    for (int c = 0; c < 4; c++)
+        source += ":" + std::to_string(output.gain[c]) + "/" + std::to_string(output.offset[c]);
+    source += ":" + std::to_string(output.white);
+    if (source == m_calibrationSource)
         return;
+    m_calibrationSource = source;
+    
+    // An empty column inherits the output's value
+    std::string error;
+    bool valid = ddp::parseCalibrationValues(matrix, output.matrix, 9, false, error) &&
+                 ddp::validateCalibration(output, error);
+    m_calibrations.assign(1, output);
+    for (size_t i = 0; valid && i < m_ranges.size(); i++)
+    {
+        const ddp::PixelRange& range = m_ranges[i];
+        ddp::CalibrationSettings settings = output;
+        valid = ddp::parseCalibrationValues(range.matrix.c_str(), settings.matrix, 9, false, error) &&
+                ddp::parseCalibrationValues(range.gain.c_str(), settings.gain, 4, true, error) &&
+                ddp::parseCalibrationValues(range.offset.c_str(), settings.offset, 4, true, error) &&
+                ddp::parseCalibrationValues(range.white.c_str(), &settings.white, 1, false, error) &&
+                ddp::validateCalibration(settings, error);
+        m_calibrations.push_back(settings);
     }
     
-    // Enable address reuse (allows binding even if port is in use)
-    int reuseAddr = 1;
-    setsockopt(m_socket, SOL_SOCKET, SO_REUSEADDR, &reuseAddr, sizeof(reuseAddr));
-    
-    // Enable broadcast
-    int broadcastEnable = 1;
-    setsockopt(m_socket, SOL_SOCKET, SO_BROADCAST, &broadcastEnable, sizeof(broadcastEnable));
-    
-    // Bind to any local address on DDP port to receive broadcast responses
-    struct sockaddr_in localAddr;
-    memset(&localAddr, 0, sizeof(localAddr));
-    localAddr.sin_family = AF_INET;
-    localAddr.sin_addr.s_addr = INADDR_ANY;
-    localAddr.sin_port = htons(0);  // Use ephemeral port for sending, but we'll listen on this socket
-    
-    if (bind(m_socket, (struct sockaddr*)&localAddr, sizeof(localAddr)) < 0)
+    bool calibrated = false;
+    bool extractsWhite = false;
+    for (const ddp::CalibrationSettings& settings : m_calibrations)
     {
-        int error = errno;
-        m_lastError = "Socket bind failed, errno " + std::to_string(error) + ": " + strerror(error);
-        close(m_socket);
-        m_socket = -1;
-        return;
+        calibrated = calibrated || !settings.isIdentity();
+        extractsWhite = extractsWhite || settings.white > 0.0f;
+    }
+    if (valid && calibrated && channelsPerPixel < 3)
+    {
+        error = "Calibration needs at least 3 channels per pixel";
+        valid = false;
+    }
+    if (valid && extractsWhite && channelsPerPixel != 4)
+    {
+        error = "White Extraction needs 4 channels per pixel";
+        valid = false;
+    }
+    if (!valid)
+    {
+        m_lastError = error;
+        m_calibrations.assign(m_ranges.size() + 1, ddp::CalibrationSettings());
+        calibrated = extractsWhite = false;
     }
-    #endif
     
-    m_socketInitialized = true;
-    m_lastError = "Socket initialized successfully";
+    // With white extraction the input is RGB and W is made from it
+    m_calibrationActive = calibrated;
+    m_calibrationInputs = extractsWhite ? 3 : channelsPerPixel;
 }
 
-void DDPOutputCHOP::closeSocket()
+void DDPOutputCHOP::compileKernels(float brightness, float inputScale, int inputChannels, int channelsPerPixel)
+{
+    m_kernels.resize(m_calibrations.size());
+    for (size_t i = 0; i < m_calibrations.size(); i++)
+        ddp::compileCalibration(m_calibrations[i], brightness, inputScale, inputChannels, channelsPerPixel, m_kernels[i]);
+}
+
+void DDPOutputCHOP::updatePower(const OP_Inputs* inputs)
 {
-    if (m_socketInitialized)
+    bool enabled = inputs->getParInt("Powerlimit") != 0;
+    if (enabled != m_powerLimit)
     {
-        #ifdef _WIN32
-            closesocket(m_socket);
-            if (m_wsaInitialized)
+        // A fresh start: no scale left over from the last time it was on
+        m_limiters.clear();
+        m_powerTime = -1.0;
+    }
+    m_powerLimit = enabled;
+    if (!m_powerLimit)
+        return;
+    for (int c = 0; c < DDP_POWER_CHANNELS; c++)
+        m_channelCurrent[c] = static_cast<float>(inputs->getParDouble("Channelcurrent", c));
+    m_limiterRelease = inputs->getParDouble("Limiterrelease");
+    
+    // Budgets are reread when the ranges or Power Budget change; an empty cell is the output's
+    double budget = inputs->getParDouble("Powerbudget");
+    std::string source = m_rangesSource + ":" + std::to_string(budget);
+    if (source != m_powerSource)
+    {
+        m_powerSource = source;
+        m_budgets.assign(1, budget);
+        m_powerNames.assign(1, "power");
+        for (size_t i = 0; i < m_ranges.size(); i++)
+        {
+            const ddp::PixelRange& range = m_ranges[i];
+            double rangeBudget = budget;
+            if (!range.budget.empty())
             {
-                WSACleanup();
-                m_wsaInitialized = false;
+                char* end = nullptr;
+                rangeBudget = strtod(range.budget.c_str(), &end);
+                if (end == range.budget.c_str() || !(rangeBudget >= 0.0))
+                {
+                    m_lastError = "Budget '" + range.budget + "' of range " + std::to_string(i + 1) +
+                                  " must be amps, 0 or more";
+                    rangeBudget = budget;
+                }
             }
-        #else
-            close(m_socket);
-        #endif
-        
-        m_socketInitialized = false;
+            m_budgets.push_back(rangeBudget);
+            
+            // Info CHOP channel names only take letters, digits and underscores
+            std::string name = range.name.empty() ? std::to_string(i + 1) : range.name;
+            for (char& character : name)
+            {
+                if (!isalnum(static_cast<unsigned char>(character)))
+                    character = '_';
+            }
+            m_powerNames.push_back("power_" + name);
+        }
     }
+    
+    if (m_limiters.size() != m_budgets.size())
+        m_limiters.assign(m_budgets.size(), ddp::PowerLimiter());
+    m_power.resize(m_budgets.size());
+    m_estimatedAmps.resize(m_budgets.size(), 0.0);
+    m_limitedAmps.resize(m_budgets.size(), 0.0);
 }
 
-void DDPOutputCHOP::createDDPPacket(const uint8_t* pixelData, size_t dataLength, 
-                                     size_t offset, bool pushFlag, std::vector<uint8_t>& packet)
+void DDPOutputCHOP::startMetering()
 {
-    packet.resize(DDP_HEADER_SIZE + dataLength);
-    
-    // Byte 0: Flags (Version 1, optional PUSH flag)
-    packet[0] = DDP_FLAGS1_VER1;
-    if (pushFlag)
-        packet[0] |= DDP_FLAGS1_PUSH;
-    
-    // Byte 1: Sequence number (lower 4 bits)
-    packet[1] = m_sequenceNumber & 0x0F;
-    
-    // Byte 2: Data type (RGB - most common, receiver determines actual format)
-    packet[2] = DDP_DATA_TYPE_RGB;
-    
-    // Byte 3: Destination ID (Display)
-    packet[3] = DDP_ID_DISPLAY;
-    
-    // Bytes 4-7: Data offset (32-bit big-endian)
-    uint32_t offset32 = static_cast<uint32_t>(offset);
-    packet[4] = (offset32 >> 24) & 0xFF;
-    packet[5] = (offset32 >> 16) & 0xFF;
-    packet[6] = (offset32 >> 8) & 0xFF;
-    packet[7] = offset32 & 0xFF;
-    
-    // Bytes 8-9: Data length (16-bit big-endian)
-    uint16_t length16 = static_cast<uint16_t>(dataLength);
-    packet[8] = (length16 >> 8) & 0xFF;
-    packet[9] = length16 & 0xFF;
-    
-    // Copy pixel data
-    std::memcpy(&packet[DDP_HEADER_SIZE], pixelData, dataLength);
-    
-    // Increment sequence number (wraps at 16)
-    m_sequenceNumber = (m_sequenceNumber + 1) & 0x0F;
+    for (size_t i = 0; i < m_power.size(); i++)
+    {
+        m_power[i].reset();
+        m_power[i].scale = m_limiters[i].fixedScale();
+    }
 }
 
-void DDPOutputCHOP::sendDDPData(const std::vector<uint8_t>& pixelData)
+void DDPOutputCHOP::finishMetering(int channelsPerPixel, double fullScale)
 {
-    if (!m_socketInitialized || pixelData.empty())
-        return;
-    
-    size_t totalBytes = pixelData.size();
-    size_t bytesSent = 0;
-    
-    // Determine if this is the last packet for auto-push
-    bool autoPush = true; // Will be set from parameter in execute()
+    double now = std::chrono::duration<double>(std::chrono::steady_clock::now().time_since_epoch()).count();
+    double elapsed = m_powerTime < 0.0 ? 0.0 : now - m_powerTime;
+    m_powerTime = now;
     
-    while (bytesSent < totalBytes)
+    // The meter counts wire positions, so the channel currents follow the color order
+    const int counted = std::min(channelsPerPixel, DDP_POWER_CHANNELS);
+    for (size_t i = 0; i < m_power.size(); i++)
     {
-        size_t bytesRemaining = totalBytes - bytesSent;
-        size_t bytesInPacket = std::min(bytesRemaining, static_cast<size_t>(DDP_MAX_DATALEN));
-        
-        // Only push on last packet if auto-push is enabled
-        bool isLastPacket = (bytesSent + bytesInPacket >= totalBytes);
-        bool pushFlag = autoPush && isLastPacket;
-        
-        std::vector<uint8_t> packet;
-        createDDPPacket(&pixelData[bytesSent], bytesInPacket, bytesSent, pushFlag, packet);
-        
-        int sendResult = sendto(m_socket, 
-                               reinterpret_cast<const char*>(packet.data()), 
-                               static_cast<int>(packet.size()), 
-                               0,
-                               reinterpret_cast<struct sockaddr*>(&m_destAddr), 
-                               sizeof(m_destAddr));
-        
-        if (sendResult > 0 && m_showStats)
+        const ddp::ColorOrder& order = m_colorOrders[i];
+        const bool ordered = channelsPerPixel <= DDP_MAX_ORDER_CHANNELS;
+        float milliamps[DDP_POWER_CHANNELS] = { 0.0f, 0.0f, 0.0f, 0.0f };
+        for (int c = 0; c < counted; c++)
         {
-            m_packetsSent++;
-            m_bytesSent += sendResult;
-        }
-        else if (sendResult < 0)
-        {
-            #ifdef _WIN32
-                int error = WSAGetLastError();
-                m_lastError = "Send failed with error: " + std::to_string(error);
-            #else
-                int error = errno;
-                m_lastError = "Send failed with errno " + std::to_string(error) + ": " + strerror(error);
-            #endif
+            int channel = ordered ? order.map[c] : c;
+            milliamps[c] = channel < DDP_POWER_CHANNELS ? m_channelCurrent[channel] : 0.0f;
         }
         
-        bytesSent += bytesInPacket;
+        // The sums are taken before the scale, so the estimate is what the content asks for
+        m_estimatedAmps[i] = ddp::estimateAmps(m_power[i], milliamps, fullScale);
+        m_limitedAmps[i] = m_estimatedAmps[i] * m_power[i].scale / DDP_POWER_SCALE_ONE;
+        m_limiters[i].update(m_estimatedAmps[i], m_budgets[i], elapsed, m_limiterRelease);
     }
 }
 
-void DDPOutputCHOP::sendPushPacket()
+void DDPOutputCHOP::updateLayout(const OP_Inputs* inputs)
 {
-    if (!m_socketInitialized)
+    int width = 0, height = 0;
+    inputs->getParInt2("Layoutsize", width, height);
+    const OP_DATInput* dat = inputs->getParDAT("Layoutsegments");
+    m_layoutActive = (width > 0 && height > 0) || dat;
+    if (!m_layoutActive)
         return;
     
-    // Create a PUSH packet with no data (just header)
-    std::vector<uint8_t> packet(DDP_HEADER_SIZE);
-    
-    packet[0] = DDP_FLAGS1_VER1 | DDP_FLAGS1_PUSH;
-    packet[1] = m_sequenceNumber & 0x0F;
-    packet[2] = DDP_DATA_TYPE_RGB;
-    packet[3] = DDP_ID_DISPLAY;
-    packet[4] = 0;
-    packet[5] = 0;
-    packet[6] = 0;
-    packet[7] = 0;
-    packet[8] = 0;  // Zero length
-    packet[9] = 0;
-    
-    // Send to unicast address (for single device or as trigger)
-    int sendResult = sendto(m_socket,
-                           reinterpret_cast<const char*>(packet.data()),
-                           static_cast<int>(packet.size()),
-                           0,
-                           reinterpret_cast<struct sockaddr*>(&m_destAddr),
-                           sizeof(m_destAddr));
-    
-    if (sendResult > 0 && m_showStats)
+    // Settings are cheap to read each cook; the table itself only rebuilds
+    // when their key or the input size changes
+    const char* start = inputs->getParString("Layoutstart");
+    m_layoutSettings.width = static_cast<uint32_t>(std::max(width, 0));
+    m_layoutSettings.height = static_cast<uint32_t>(std::max(height, 0));
+    m_layoutSettings.columns = strcmp(inputs->getParString("Layoutdirection"), "columns") == 0;
+    m_layoutSettings.serpentine = inputs->getParInt("Layoutserpentine") != 0;
+    m_layoutSettings.start = strcmp(start, "bottomright") == 0 ? ddp::LayoutCorner::BottomRight
+                           : strcmp(start, "topleft") == 0     ? ddp::LayoutCorner::TopLeft
+                           : strcmp(start, "topright") == 0    ? ddp::LayoutCorner::TopRight
+                                                               : ddp::LayoutCorner::BottomLeft;
+    
+    std::string source = dat ? std::string(dat->opPath) + ":" + std::to_string(dat->totalCooks) : "";
+    if (source == m_layoutSource)
+        return;
+    m_layoutSource = source;
+    m_layoutSettings.segments.clear();
+    ddp::LayoutSegment segment;
+    for (int32_t row = 0; dat && row < dat->numRows && dat->numCols >= 2; row++)
     {
-        m_packetsSent++;
-        m_bytesSent += sendResult;
+        if (ddp::parseLayoutSegment(dat->getCell(row, 0), dat->getCell(row, 1), segment))
+            m_layoutSettings.segments.push_back(segment);
     }
-    
-    m_sequenceNumber = (m_sequenceNumber + 1) & 0x0F;
 }
 
-uint8_t DDPOutputCHOP::floatToUint8(float value, bool normalizedInput)
+void DDPOutputCHOP::updatePixelMap(const OP_Inputs* inputs)
 {
-    if (normalizedInput)
+    // A DAT reloads whenever it cooks, a file when its path changes
+    const OP_DATInput* dat = inputs->getParDAT("Pixelmapdat");
+    std::string file = inputs->getParFilePath("Pixelmapfile");
+    std::string units = inputs->getParString("Pixelmapunits");
+    std::string source = dat ? std::string("dat:") + dat->opPath + ":" + std::to_string(dat->totalCooks)
+                             : "file:" + file;
+    source += ":" + units;
+    if (source == m_pixelMapSource)
+        return;
+    m_pixelMapSource = source;
+    
+    std::vector<ddp::MapPoint> points;
+    if (dat)
     {
-        // Input is 0-1 range, convert to 0-255
-        value = std::max(0.0f, std::min(1.0f, value));
-        return static_cast<uint8_t>(value * 255.0f);
+        ddp::MapPoint point;
+        for (int32_t row = 0; row < dat->numRows && dat->numCols >= 2; row++)
+        {
+            if (ddp::parseMapCells(dat->getCell(row, 0), dat->getCell(row, 1), point))
+                points.push_back(point);
+        }
     }
-    else
+    else if (!file.empty())
     {
-        // Input is 0-255 range, just clamp and convert
-        value = std::max(0.0f, std::min(255.0f, value));
-        return static_cast<uint8_t>(value);
+        std::string error;
+        if (!ddp::loadMapFile(file, points, error))
+            m_lastError = error;
     }
+    m_pixelMap.setPoints(points, units == "uv" ? ddp::MapUnits::UV : ddp::MapUnits::Pixels);
 }
 
-float DDPOutputCHOP::applyGamma(float value, float gamma, bool normalizedInput)
-{
-    if (gamma == 1.0f)
-        return value;
-    
-    // Normalize to 0-1 for gamma calculation if input is 0-255
-    if (!normalizedInput)
-        value = value / 255.0f;
-    
-    // Clamp input
-    value = std::max(0.0f, std::min(1.0f, value));
-    
-    // Apply gamma correction
-    value = std::pow(value, 1.0f / gamma);
-    
-    // Convert back to 0-255 if input was 0-255
-    if (!normalizedInput)
-        value = value * 255.0f;
-    
-    return value;
-}
-
-void DDPOutputCHOP::processInterleavedChannels(const OP_CHOPInput* chopInput, 
-                                                 float gamma, float brightness,
-                                                 bool normalizedInput,
-                                                 std::vector<uint8_t>& pixelData)
+bool DDPOutputCHOP::sampleTOP(const OP_TOPInput* top, const ddp::ConvertSettings& settings,
+                              int channelsPerPixel, bool pipelined)
 {
-    // Like DMX Out CHOP: expects 1 channel with consecutive samples
-    // Works with any data: RGB, RGBW, or any channel count per pixel
-    // Examples: r0,g0,b0,r1,g1,b1... or r0,g0,b0,w0,r1,g1,b1,w1...
-    if (chopInput->numChannels < 1)
-        return;
+    if (m_pixelMap.size() == 0)
+    {
+        m_lastError = "TOP needs a Pixel Map DAT or Pixel Map File";
+        m_pendingDownload.release();
+        return false;
+    }
     
-    const float* channelData = chopInput->getChannelData(0);
-    int numSamples = chopInput->numSamples;
+    // Pipelined: this cook's download is started and the previous cook's is
+    // consumed, so the GPU readback overlaps a frame instead of stalling the cook.
+    // A download of another TOP is never sent.
+    OP_SmartRef<OP_TOPDownloadResult> download;
+    if (pipelined && m_pendingTopId == top->opId)
+        download = std::move(m_pendingDownload);
+    m_pendingDownload.release();
+    
+    // 8-bit BGRA is what GPUs hand back without a conversion pass
+    OP_TOPInputDownloadOptions options;
+    options.pixelFormat = OP_PixelFormat::BGRA8Fixed;
+    OP_SmartRef<OP_TOPDownloadResult> started = top->downloadTexture(options, nullptr);
+    m_pendingTopId = top->opId;
+    if (!started)
+    {
+        m_lastError = std::string("Cannot download ") + top->opPath;
+        return false;
+    }
+    if (pipelined)
+        m_pendingDownload = std::move(started);
+    else
+        download = std::move(started);
+    
+    // First cook of the pipeline: nothing downloaded yet
+    if (!download)
+        return false;
+    
+    uint32_t width = download->textureDesc.width;
+    uint32_t height = download->textureDesc.height;
+    auto waitStart = std::chrono::steady_clock::now();
+    const uint8_t* texture = static_cast<const uint8_t*>(download->getData());
+    m_downloadWaitMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - waitStart).count();
+    if (!texture || download->size < static_cast<uint64_t>(width) * height * 4)
+    {
+        m_lastError = std::string("Cannot download ") + top->opPath;
+        return false;
+    }
     
-    pixelData.reserve(numSamples);
+    if (!m_lutValid || settings.gamma != m_lutSettings.gamma || settings.brightness != m_lutSettings.brightness ||
+        settings.wideOutput != m_lutSettings.wideOutput)
+    {
+        ddp::buildByteLUT(settings, m_byteLUT);
+        ddp::buildLevelLUT(settings, m_levelLUT);
+        m_lutSettings = settings;
+        m_lutValid = true;
+    }
     
-    for (int i = 0; i < numSamples; i++)
+    m_pixelMap.compile(width, height);
+    m_pixelData.resize(m_pixelMap.size() * static_cast<size_t>(channelsPerPixel));
+    if (m_rangesActive || m_calibrationActive || m_powerLimit)
+        updateConvertPlan(m_pixelMap.size(), m_pixelMap.size());
+    
+    // 16-bit levels when they are dithered or sent wide
+    const bool levels = m_dither || settings.wideOutput;
+    if (levels)
+        m_levels.resize(m_pixelData.size());
+    
+    // Color orders and the power meter ride along with the sampling: each
+    // point is sampled into its wire order, and each block is metered and
+    // limited by the previous frame's scale as soon as it is written
+    if (m_powerLimit)
+        startMetering();
+    if (m_calibrationActive)
     {
-        float value = channelData[i];
-        
-        // Apply brightness (scale appropriately based on input range)
-        if (normalizedInput)
-            value *= brightness;
-        else
-            value *= brightness; // brightness is 0-1, so this scales 0-255 down proportionally
-        
-        // Apply gamma correction
-        value = applyGamma(value, gamma, normalizedInput);
+        if (!m_linearLUTValid || settings.gamma != m_linearLUTSettings.gamma ||
+            settings.wideOutput != m_linearLUTSettings.wideOutput)
+        {
+            ddp::buildLinearLUT(settings, m_linearLUT);
+            ddp::buildLinearLUT(settings, m_linearLevelLUT);
+            m_linearLUTSettings = settings;
+            m_linearLUTValid = true;
+        }
         
-        // Convert to 8-bit
-        pixelData.push_back(floatToUint8(value, normalizedInput));
+        // Texels are RGBA: alpha is the W input unless W is extracted from RGB
+        compileKernels(settings.brightness, 1.0f / 255.0f, m_calibrationInputs == 3 ? 3 : 4, channelsPerPixel);
     }
-}
-
-void DDPOutputCHOP::processSequentialChannels(const OP_CHOPInput* chopInput,
-                                                float gamma, float brightness,
-                                                bool normalizedInput,
-                                                std::vector<uint8_t>& pixelData)
-{
-    // Sequential: separate channels with multiple samples
-    // Works with any channel count (RGB, RGBW, or custom)
-    // Channel 0 = all reds, Channel 1 = all greens, etc.
-    int numChannels = chopInput->numChannels;
-    int numSamples = chopInput->numSamples;
-    
-    if (numChannels < 1)
-        return;
-    
-    pixelData.reserve(numSamples * numChannels);
-    
-    // Interleave all channels
-    for (int sample = 0; sample < numSamples; sample++)
+    if (m_rangesActive || m_calibrationActive || m_powerLimit)
     {
-        for (int channel = 0; channel < numChannels; channel++)
+        for (const ddp::LayoutRun& span : m_convertPlan)
         {
-            const float* channelData = chopInput->getChannelData(channel);
-            float value = channelData[sample];
-            
-            // Apply brightness (scale appropriately based on input range)
-            if (normalizedInput)
-                value *= brightness;
+            size_t offset = static_cast<size_t>(span.source) * channelsPerPixel;
+            const ddp::ColorOrder* order = &m_colorOrders[span.order];
+            ddp::RangePower* power = m_powerLimit ? &m_power[span.order] : nullptr;
+            if (m_calibrationActive && levels)
+                m_pixelMap.sampleCalibrated(texture, span.source, span.count, m_kernels[span.order], m_linearLevelLUT,
+                                            channelsPerPixel, m_levels.data() + offset, order, power);
+            else if (m_calibrationActive)
+                m_pixelMap.sampleCalibrated(texture, span.source, span.count, m_kernels[span.order], m_linearLUT,
+                                            channelsPerPixel, m_pixelData.data() + offset, order, power);
+            else if (levels)
+                m_pixelMap.sampleBGRA8(texture, span.source, span.count, m_levelLUT, channelsPerPixel,
+                                       m_levels.data() + offset, order, power);
             else
-                value *= brightness; // brightness is 0-1, so this scales 0-255 down proportionally
-            
-            // Apply gamma correction
-            value = applyGamma(value, gamma, normalizedInput);
-            
-            // Convert to 8-bit
-            pixelData.push_back(floatToUint8(value, normalizedInput));
+                m_pixelMap.sampleBGRA8(texture, span.source, span.count, m_byteLUT, channelsPerPixel,
+                                       m_pixelData.data() + offset, order, power);
         }
     }
+    else if (levels)
+        m_pixelMap.sampleBGRA8(texture, m_levelLUT, channelsPerPixel, m_levels.data());
+    else
+        m_pixelMap.sampleBGRA8(texture, m_byteLUT, channelsPerPixel, m_pixelData.data());
+    if (m_powerLimit)
+        finishMetering(channelsPerPixel, settings.wideOutput ? 65535.0 : m_dither ? 255.0 * 256.0 : 255.0);
+    
+    if (settings.wideOutput)
+    {
+        m_pixelData.resize(m_levels.size() * 2);
+        ddp::storeBE16(m_levels.data(), m_levels.size(), m_pixelData.data());
+    }
+    else if (m_dither)
+        ddp::ditherLevels(m_levels.data(), m_levels.size(), ditherState(m_pixelData.size()), m_pixelData.data());
+    return true;
+}
+
+uint8_t* DDPOutputCHOP::ditherState(size_t bytes)
+{
+    // A new frame size starts over from the staggered pattern
+    if (m_ditherError.size() != bytes)
+    {
+        m_ditherError.resize(bytes);
+        ddp::seedDitherError(m_ditherError.data(), bytes);
+    }
+    return m_ditherError.data();
 }
 
 void DDPOutputCHOP::execute(CHOP_Output* output, const OP_Inputs* inputs, void* reserved1)
@@ -603,11 +2155,24 @@ void DDPOutputCHOP::execute(CHOP_Output* output, const OP_Inputs* inputs, void*
     float gamma = static_cast<float>(inputs->getParDouble("Gamma"));
     float brightness = static_cast<float>(inputs->getParDouble("Brightness"));
     int channelsPerPixel = inputs->getParInt("Channelsperpixel");
+    int maxPayload = inputs->getParInt("Maxpayload");
+    int multicastTTL = inputs->getParInt("Multicastttl");
+    bool multicastLoop = inputs->getParInt("Multicastloop") != 0;
+    const char* multicastInterface = inputs->getParString("Multicastinterface");
+    const char* bindInterface = inputs->getParString("Bindinterface");
+    bool timecodeEnabled = strcmp(inputs->getParString("Timecode"), "off") != 0;
+    double presentationDelay = inputs->getParDouble("Presentationdelay");
     bool autoPush = inputs->getParInt("Autopush") != 0;
     bool showStats = inputs->getParInt("Showstats") != 0;
     double maxFPS = inputs->getParDouble("Maxfps");
     const char* valueRange = inputs->getParString("Valuerange");
     bool normalizedInput = (strcmp(valueRange, "0-1") == 0);
+    m_bitDepth = strcmp(inputs->getParString("Bitdepth"), "16") == 0 ? 16 : 8;
+    m_dataType = ddp::pixelDataType(channelsPerPixel, m_bitDepth);
+    const int valueBytes = m_bitDepth / 8;
+    
+    // 16-bit output has the precision dithering would recover
+    m_dither = m_bitDepth == 8 && strcmp(inputs->getParString("Dither"), "temporal") == 0;
     
     // Reset stats when toggling
     if (showStats != m_showStats)
@@ -626,42 +2191,101 @@ void DDPOutputCHOP::execute(CHOP_Output* output, const OP_Inputs* inputs, void*
     
     if (!enabled)
     {
-        if (m_socketInitialized)
+        if (m_socket.isOpen())
         {
             closeSocket();
         }
         return;
     }
     
-    // Check if we need to reinitialize socket (IP or port changed)
+    updateRecording(inputs);
+    updatePcapMirror(inputs);
+    
+    // Check if we need to reinitialize socket (IP, port or bound interface changed)
     bool needsReinit = false;
-    if (m_lastIPAddress != ipAddress || m_lastPort != port)
+    if (m_lastIPAddress != ipAddress || m_lastPort != port || m_lastBindInterface != bindInterface)
     {
         needsReinit = true;
         m_lastIPAddress = ipAddress;
         m_lastPort = port;
+        m_lastBindInterface = bindInterface;
+        m_bindInterface = bindInterface;
+    }
+    
+    // A refreshed hostname lookup may have moved the destination (DHCP, mDNS), follow it
+    if (!needsReinit && m_socket.isOpen() && m_destIsHostname)
+    {
+        struct sockaddr_storage current;
+        socklen_t currentLen = 0;
+        if (m_resolver.lookup(ipAddress, current, currentLen))
+            needsReinit = !ddp::sameHost(current, m_destAddr);
     }
     
-    if (needsReinit && m_socketInitialized)
+    if (needsReinit && m_socket.isOpen())
     {
         closeSocket();
     }
     
     // Initialize socket if needed
-    if (!m_socketInitialized)
+    if (!m_socket.isOpen())
     {
+        // Setup destination address first, it decides between an IPv4 and IPv6 socket
+        if (!resolveDestination(ipAddress, port))
+            return;
+        
         initializeSocket();
+        if (!m_socket.isOpen())
+            return;
         
-        // Setup destination address
-        memset(&m_destAddr, 0, sizeof(m_destAddr));
-        m_destAddr.sin_family = AF_INET;
-        m_destAddr.sin_port = htons(port);
-        inet_pton(AF_INET, ipAddress, &m_destAddr.sin_addr);
+        // Re-evaluate the payload against the MTU of the interface we now route through
+        m_interfaceMTU = ddp::queryInterfaceMTU(m_destAddr, m_bindInterface);
+        m_lastCheckedPayload = 0;
+        m_multicastConfigured = false;
+    }
+    
+    // One transmission reaches every receiver that joined the group
+    if (isMulticastDestination() || m_transportMulticast)
+    {
+        configureMulticast(multicastTTL, multicastLoop, multicastInterface);
+    }
+    
+    // The secondary leg follows the primary socket; health checks run every cook
+    updateRedundancy(inputs);
+    checkLegHealth();
+    
+    if (timecodeEnabled != m_timecodeEnabled)
+    {
+        m_timecodeEnabled = timecodeEnabled;
+        m_lastCheckedPayload = 0; // header size changed
+    }
+    
+    m_payloadSize = effectivePayloadSize(maxPayload, channelsPerPixel * valueBytes);
+    m_bytesPerPixel = static_cast<size_t>(std::max(1, channelsPerPixel * valueBytes));
+    checkPayloadAgainstMTU(m_payloadSize);
+    
+    // A recording replaces the input CHOP entirely
+    if (inputs->getParInt("Playback") != 0)
+    {
+        m_pendingDownload.release();
+        playRecording(inputs, autoPush);
+        return;
     }
+    m_playbackLastTick = -1.0;
     
-    // Get input CHOP
+    // A TOP takes over from the input CHOP
+    const OP_TOPInput* top = inputs->getParTOP("Top");
     const OP_CHOPInput* chopInput = inputs->getInputCHOP(0);
-    if (!chopInput || chopInput->numChannels == 0)
+    if (top)
+    {
+        updatePixelMap(inputs);
+        updateRanges(inputs, channelsPerPixel);
+        updateCalibration(inputs, channelsPerPixel);
+        updatePower(inputs);
+        m_layoutActive = false;    // the map rows are already in wire order
+    }
+    else
+        m_pendingDownload.release();
+    if (!top && (!chopInput || chopInput->numChannels == 0))
         return;
     
     // Check FPS limit
@@ -670,26 +2294,46 @@ void DDPOutputCHOP::execute(CHOP_Output* output, const OP_Inputs* inputs, void*
         return; // Skip this frame to maintain target FPS
     }
     
-    // Process channel data (expects 1 channel with samples)
-    // Like DMX Out: agnostic to format (RGB, RGBW, or any channel count)
-    // Examples: r0,g0,b0,r1,g1,b1... or r0,g0,b0,w0,r1,g1,b1,w1...
-    std::vector<uint8_t> pixelData;
-    processInterleavedChannels(chopInput, gamma, brightness, normalizedInput, pixelData);
+    if (top)
+    {
+        ddp::ConvertSettings settings;
+        settings.gamma = gamma;
+        settings.brightness = brightness;
+        settings.wideOutput = m_bitDepth == 16;
+        bool pipelined = strcmp(inputs->getParString("Toplatency"), "immediate") != 0;
+        if (!sampleTOP(top, settings, channelsPerPixel, pipelined))
+            return;
+    }
+    else
+    {
+        // Process channel data (expects 1 channel with samples)
+        // Like DMX Out: agnostic to format (RGB, RGBW, or any channel count)
+        // Examples: r0,g0,b0,r1,g1,b1... or r0,g0,b0,w0,r1,g1,b1,w1...
+        updateLayout(inputs);
+        updateRanges(inputs, channelsPerPixel);
+        updateCalibration(inputs, channelsPerPixel);
+        updatePower(inputs);
+        processInterleavedChannels(chopInput, gamma, brightness, normalizedInput, channelsPerPixel, m_pixelData);
+    }
     
     // Update channel and pixel counts
-    m_lastChannelCount = static_cast<int32_t>(pixelData.size());
+    m_lastChannelCount = static_cast<int32_t>(m_pixelData.size() / valueBytes);
     m_lastPixelCount = (channelsPerPixel > 0) ? (m_lastChannelCount / channelsPerPixel) : 0;
     
     // Send DDP packets if we have data
-    if (!pixelData.empty())
+    if (!m_pixelData.empty())
     {
-        sendDDPData(pixelData);
+        if (m_timecodeEnabled)
+            m_frameTimecode = computeTimecode(inputs, presentationDelay);
+        
+        sendDDPData(m_pixelData, m_payloadSize, autoPush);
     }
 }
 
 int32_t DDPOutputCHOP::getNumInfoCHOPChans(void* reserved1)
 {
-    return 4;
+    // Estimated and limited amps per range with Power Limit on
+    return 15 + (m_powerLimit ? 2 * static_cast<int32_t>(m_estimatedAmps.size()) : 0);
 }
 
 void DDPOutputCHOP::getInfoCHOPChan(int32_t index, OP_InfoCHOPChan* chan, void* reserved1)
@@ -712,12 +2356,65 @@ void DDPOutputCHOP::getInfoCHOPChan(int32_t index, OP_InfoCHOPChan* chan, void*
             chan->name->setString("pixel_count");
             chan->value = static_cast<float>(m_lastPixelCount);
             break;
+        case 4:
+            chan->name->setString("playback_time");
+            chan->value = static_cast<float>(m_playbackTime / 1e6);
+            break;
+        case 5:
+            chan->name->setString("playback_length");
+            chan->value = static_cast<float>(m_player.durationUs() / 1e6);
+            break;
+        case 6:
+            chan->name->setString("download_wait_ms");
+            chan->value = static_cast<float>(m_downloadWaitMs);
+            break;
+        case 7:
+            chan->name->setString("sacn_packets");
+            chan->value = static_cast<float>(m_transportPackets[static_cast<int>(ddp::Transport::Sacn)]);
+            break;
+        case 8:
+            chan->name->setString("artnet_packets");
+            chan->value = static_cast<float>(m_transportPackets[static_cast<int>(ddp::Transport::ArtNet)]);
+            break;
+        case 9:
+        case 10:
+            chan->name->setString(index == 9 ? "primary_packets" : "secondary_packets");
+            chan->value = static_cast<float>(m_legs[index - 9].packetsSent);
+            break;
+        case 11:
+        case 12:
+        {
+            double now = std::chrono::duration<double>(std::chrono::steady_clock::now().time_since_epoch()).count();
+            bool open = index == 11 ? m_socket.isOpen() : m_secondarySocket.isOpen();
+            chan->name->setString(index == 11 ? "primary_healthy" : "secondary_healthy");
+            chan->value = m_redundancy != ddp::Redundancy::Off && open &&
+                          m_legs[index - 11].health.healthy(now, m_healthTimeout) ? 1.0f : 0.0f;
+            break;
+        }
+        case 13:
+            chan->name->setString("active_leg");
+            chan->value = static_cast<float>(m_legSelector.active());
+            break;
+        case 14:
+            chan->name->setString("failovers");
+            chan->value = static_cast<float>(m_legSelector.failovers());
+            break;
+        default:
+        {
+            size_t range = static_cast<size_t>(index - 15) / 2;
+            if (range >= m_estimatedAmps.size() || range >= m_powerNames.size())
+                break;
+            bool limited = (index - 15) % 2 == 1;
+            chan->name->setString((m_powerNames[range] + (limited ? "_limited_amps" : "_amps")).c_str());
+            chan->value = static_cast<float>(limited ? m_limitedAmps[range] : m_estimatedAmps[range]);
+            break;
+        }
     }
 }
 
 bool DDPOutputCHOP::getInfoDATSize(OP_InfoDATSize* infoSize, void* reserved1)
 {
-    infoSize->rows = 7 + static_cast<int32_t>(m_discoveredDevices.size());
+    infoSize->rows = 26 + static_cast<int32_t>(m_discoveredDevices.size());
     infoSize->cols = 2;
     infoSize->byColumn = false;
     return true;
@@ -749,7 +2446,10 @@ void DDPOutputCHOP::getInfoDATEntries(int32_t index, int32_t nEntries,
     else if (index == 4)
     {
         entries->values[0]->setString("IP Address");
-        entries->values[1]->setString(m_lastIPAddress.c_str());
+        std::string destination = m_lastIPAddress;
+        if (m_socket.isOpen() && isMulticastDestination())
+            destination += " (multicast, TTL " + std::to_string(m_multicastTTL) + ")";
+        entries->values[1]->setString(destination.c_str());
     }
     else if (index == 5)
     {
@@ -757,13 +2457,177 @@ void DDPOutputCHOP::getInfoDATEntries(int32_t index, int32_t nEntries,
         entries->values[1]->setString(m_lastError.c_str());
     }
     else if (index == 6)
+    {
+        entries->values[0]->setString("Max Payload");
+        entries->values[1]->setString(std::to_string(m_payloadSize).c_str());
+    }
+    else if (index == 7)
+    {
+        entries->values[0]->setString("Interface MTU");
+        entries->values[1]->setString(m_interfaceMTU > 0 ? std::to_string(m_interfaceMTU).c_str() : "unknown");
+    }
+    else if (index == 8)
+    {
+        entries->values[0]->setString("Bind Interface");
+        entries->values[1]->setString(m_bindInterface.empty() ? "any" : m_bindInterface.c_str());
+    }
+    else if (index == 9)
+    {
+        entries->values[0]->setString("Resolved Address");
+        std::string resolved = m_destIsHostname ? m_resolver.getResolvedAddress()
+                                                : (m_destAddrLen > 0 ? ddp::formatAddress(reinterpret_cast<const struct sockaddr*>(&m_destAddr)) : "");
+        entries->values[1]->setString(resolved.c_str());
+    }
+    else if (index == 10)
+    {
+        entries->values[0]->setString("Resolve Time (ms)");
+        std::string latency = m_destIsHostname ? std::to_string(m_resolver.getLastLatencyMs()) : "0";
+        entries->values[1]->setString(latency.c_str());
+    }
+    else if (index == 11)
     {
         entries->values[0]->setString("Devices Found");
         entries->values[1]->setString(std::to_string(m_discoveredDevices.size()).c_str());
     }
-    else if (index >= 7 && index < 7 + static_cast<int32_t>(m_discoveredDevices.size()))
+    else if (index == 12)
+    {
+        entries->values[0]->setString("Recording");
+        std::string recording = m_recorder.isOpen() ? m_recorder.path() : "off";
+        if (m_recorder.isOpen() && !m_recorder.lastError().empty())
+            recording += " (" + m_recorder.lastError() + ")";
+        entries->values[1]->setString(recording.c_str());
+    }
+    else if (index == 13)
+    {
+        entries->values[0]->setString("Recorded");
+        entries->values[1]->setString(m_recorder.summary().c_str());
+    }
+    else if (index == 14)
+    {
+        entries->values[0]->setString("Playback");
+        std::string playback = "off";
+        if (m_player.isOpen())
+        {
+            char position[96];
+            snprintf(position, sizeof(position), " (%.1f / %.1f s, %zu records)",
+                     m_playbackTime / 1e6, m_player.durationUs() / 1e6, m_player.recordCount());
+            playback = m_player.path() + position;
+        }
+        entries->values[1]->setString(playback.c_str());
+    }
+    else if (index == 15)
+    {
+        entries->values[0]->setString("PCAP Mirror");
+        std::string mirror = "off";
+        if (m_pcapMirror.isOpen())
+            mirror = m_pcapMirror.path() + " (" + std::to_string(m_pcapMirror.packetsWritten()) + " packets)";
+        entries->values[1]->setString(mirror.c_str());
+    }
+    else if (index == 16)
+    {
+        entries->values[0]->setString("Pixel Map");
+        std::string map = "off";
+        if (m_pixelMap.size() > 0)
+        {
+            map = std::to_string(m_pixelMap.size()) + " points";
+            if (m_pixelMap.pointsOutside() > 0)
+                map += ", " + std::to_string(m_pixelMap.pointsOutside()) + " outside the TOP";
+        }
+        entries->values[1]->setString(map.c_str());
+    }
+    else if (index == 17)
+    {
+        entries->values[0]->setString("Layout");
+        std::string layout = "off";
+        if (m_layoutActive)
+        {
+            layout = std::to_string(m_layout.size()) + " pixels";
+            if (m_layout.blanks() > 0 || m_layout.skipped() > 0)
+                layout += " (" + std::to_string(m_layout.blanks()) + " blank, " + std::to_string(m_layout.skipped()) + " skipped)";
+        }
+        entries->values[1]->setString(layout.c_str());
+    }
+    else if (index == 18)
+    {
+        entries->values[0]->setString("Ranges");
+        std::string ranges = std::to_string(m_ranges.size()) + (m_ranges.size() == 1 ? " range" : " ranges");
+        if (m_ranges.empty())
+            ranges = m_rangesActive ? "color order only" : "off";
+        entries->values[1]->setString(ranges.c_str());
+    }
+    else if (index == 19)
     {
-        int deviceIdx = index - 7;
+        entries->values[0]->setString("Data Type");
+        char type[32];
+        snprintf(type, sizeof(type), "0x%02X (%d-bit)", m_dataType, m_bitDepth);
+        entries->values[1]->setString(type);
+    }
+    else if (index == 20)
+    {
+        entries->values[0]->setString("Calibration");
+        std::string calibration = "off";
+        if (m_calibrationActive)
+        {
+            size_t ranges = 0;
+            bool extractsWhite = false;
+            for (size_t i = 0; i < m_calibrations.size(); i++)
+            {
+                ranges += i > 0 && !m_calibrations[i].isIdentity() ? 1 : 0;
+                extractsWhite = extractsWhite || m_calibrations[i].white > 0.0f;
+            }
+            calibration = m_calibrations[0].isIdentity() ? "" : "output";
+            if (ranges > 0)
+                calibration += (calibration.empty() ? "" : " + ") + std::to_string(ranges) + (ranges == 1 ? " range" : " ranges");
+            if (extractsWhite)
+                calibration += ", white from RGB";
+        }
+        entries->values[1]->setString(calibration.c_str());
+    }
+    else if (index == 21)
+    {
+        entries->values[0]->setString("Power");
+        std::string power = "off";
+        if (m_powerLimit)
+        {
+            double estimated = 0.0, limited = 0.0;
+            for (size_t i = 0; i < m_estimatedAmps.size(); i++)
+            {
+                estimated += m_estimatedAmps[i];
+                limited += m_limitedAmps[i];
+            }
+            char amps[64];
+            snprintf(amps, sizeof(amps), "%.2f A estimated, %.2f A sent", estimated, limited);
+            power = amps;
+        }
+        entries->values[1]->setString(power.c_str());
+    }
+    else if (index == 22)
+    {
+        entries->values[0]->setString("Transports");
+        entries->values[1]->setString(transportSummary().c_str());
+    }
+    else if (index == 23)
+    {
+        entries->values[0]->setString("Redundancy");
+        std::string redundancy = "off";
+        if (m_redundancy == ddp::Redundancy::Both)
+            redundancy = "send to both";
+        else if (m_redundancy == ddp::Redundancy::Standby)
+        {
+            int64_t failovers = m_legSelector.failovers();
+            redundancy = std::string("standby, ") + (m_legSelector.active() == 0 ? "primary" : "secondary") +
+                         " active, " + std::to_string(failovers) + (failovers == 1 ? " failover" : " failovers");
+        }
+        entries->values[1]->setString(redundancy.c_str());
+    }
+    else if (index == 24 || index == 25)
+    {
+        entries->values[0]->setString(index == 24 ? "Primary Leg" : "Secondary Leg");
+        entries->values[1]->setString(legSummary(index - 24).c_str());
+    }
+    else if (index >= 26 && index < 26 + static_cast<int32_t>(m_discoveredDevices.size()))
+    {
+        int deviceIdx = index - 26;
         entries->values[0]->setString(("Device " + std::to_string(deviceIdx + 1)).c_str());
         entries->values[1]->setString(m_discoveredDevices[deviceIdx].c_str());
     }
@@ -771,64 +2635,47 @@ void DDPOutputCHOP::getInfoDATEntries(int32_t index, int32_t nEntries,
 
 void DDPOutputCHOP::sendQueryPacket()
 {
-    if (!m_socketInitialized)
+    if (!m_socket.isOpen())
         return;
     
-    // Create DDP STATUS query packet
-    std::vector<uint8_t> packet(10);
+    // Create DDP STATUS query packet (sequence 0, no data)
+    ddp::PacketHeader query;
+    query.flags = DDP_FLAGS1_VER1 | DDP_FLAGS1_QUERY;
+    query.dataType = 0x00;                // Data type (ignored for query)
+    query.destId = DDP_ID_STATUS;         // STATUS destination (251)
     
-    // Header
-    packet[0] = DDP_FLAGS1_VER1 | 0x02;  // VER1 + QUERY flag
-    packet[1] = 0;                        // Sequence 0
-    packet[2] = 0x00;                     // Data type (ignored for query)
-    packet[3] = DDP_ID_STATUS;            // STATUS destination (251)
-    packet[4] = 0;                        // Offset (all zeros)
-    packet[5] = 0;
-    packet[6] = 0;
-    packet[7] = 0;
-    packet[8] = 0;                        // Length = 0
-    packet[9] = 0;
+    uint8_t packet[DDP_HEADER_SIZE];
+    size_t packetSize = ddp::packHeader(query, packet);
     
     // Enable broadcast on socket
-    int broadcastEnable = 1;
-    #ifdef _WIN32
-        setsockopt(m_socket, SOL_SOCKET, SO_BROADCAST, (const char*)&broadcastEnable, sizeof(broadcastEnable));
-    #else
-        setsockopt(m_socket, SOL_SOCKET, SO_BROADCAST, &broadcastEnable, sizeof(broadcastEnable));
-    #endif
-    
-    // Send to broadcast address (255.255.255.255)
-    struct sockaddr_in broadcastAddr;
-    memset(&broadcastAddr, 0, sizeof(broadcastAddr));
-    broadcastAddr.sin_family = AF_INET;
-    broadcastAddr.sin_port = htons(DDP_PORT);
-    broadcastAddr.sin_addr.s_addr = htonl(INADDR_BROADCAST);
-    
-    sendto(m_socket, 
-           reinterpret_cast<const char*>(packet.data()), 
-           static_cast<int>(packet.size()), 
-           0,
-           reinterpret_cast<struct sockaddr*>(&broadcastAddr), 
-           sizeof(broadcastAddr));
+    m_socket.setBroadcast(true);
     
-    // Also try sending to the configured destination (if it's set)
-    if (m_destAddr.sin_addr.s_addr != 0)
+    // Send to broadcast address (255.255.255.255), IPv6 has no broadcast so
+    // dual-stack sockets only query the configured destination
+    if (m_socketFamily == AF_INET)
     {
-        struct sockaddr_in targetAddr = m_destAddr;
-        targetAddr.sin_port = htons(DDP_PORT);
+        struct sockaddr_storage broadcastAddr;
+        memset(&broadcastAddr, 0, sizeof(broadcastAddr));
+        struct sockaddr_in* v4 = reinterpret_cast<struct sockaddr_in*>(&broadcastAddr);
+        v4->sin_family = AF_INET;
+        v4->sin_port = htons(DDP_PORT);
+        v4->sin_addr.s_addr = htonl(INADDR_BROADCAST);
         
-        sendto(m_socket, 
-               reinterpret_cast<const char*>(packet.data()), 
-               static_cast<int>(packet.size()), 
-               0,
-               reinterpret_cast<struct sockaddr*>(&targetAddr), 
-               sizeof(targetAddr));
+        m_socket.sendTo(packet, packetSize, broadcastAddr, sizeof(struct sockaddr_in));
+    }
+    
+    // Also try sending to the configured destination (if it's set)
+    if (m_destAddrLen > 0)
+    {
+        struct sockaddr_storage targetAddr = m_destAddr;
+        ddp::setPort(targetAddr, DDP_PORT);
+        m_socket.sendTo(packet, packetSize, targetAddr, m_destAddrLen);
     }
 }
 
 void DDPOutputCHOP::discoverDevices()
 {
-    if (!m_socketInitialized)
+    if (!m_socket.isOpen())
     {
         m_lastError = "Socket not initialized. Enable output first.";
         return;
@@ -852,54 +2699,35 @@ void DDPOutputCHOP::discoverDevices()
     }
     
     // Set socket to non-blocking temporarily
-    #ifdef _WIN32
-        u_long mode = 1;  // 1 = non-blocking
-        ioctlsocket(m_socket, FIONBIO, &mode);
-    #else
-        int sockFlags = fcntl(m_socket, F_GETFL, 0);
-        fcntl(m_socket, F_SETFL, sockFlags | O_NONBLOCK);
-    #endif
+    m_socket.setNonBlocking(true);
     
     // Listen for responses for ~500ms (longer timeout for FPP)
     char buffer[2048];
-    struct sockaddr_in responseAddr;
-    
-    #ifdef _WIN32
-        int addrLen = sizeof(responseAddr);
-    #else
-        socklen_t addrLen = sizeof(responseAddr);
-    #endif
+    struct sockaddr_storage responseAddr;
     
     // Try to receive responses (non-blocking)
     int packetsReceived = 0;
     for (int i = 0; i < 50; i++)  // 50 attempts with ~10ms between = 500ms total
     {
-        #ifdef _WIN32
-            addrLen = sizeof(responseAddr);
-        #else
-            addrLen = sizeof(responseAddr);
-        #endif
-        
-        int received = recvfrom(m_socket, buffer, sizeof(buffer), 0,
-                               reinterpret_cast<struct sockaddr*>(&responseAddr),
-                               &addrLen);
+        bool wouldBlock = false;
+        int received = m_socket.recvFrom(buffer, sizeof(buffer), responseAddr, wouldBlock);
         
         if (received > 0)
         {
             packetsReceived++;
             
             // Get IP address regardless of packet content
-            char ipStr[INET_ADDRSTRLEN];
-            inet_ntop(AF_INET, &responseAddr.sin_addr, ipStr, INET_ADDRSTRLEN);
+            uint16_t responsePort = 0;
+            std::string ipStr = ddp::formatAddress(reinterpret_cast<struct sockaddr*>(&responseAddr), &responsePort);
             
             // Store discovered device - be very permissive
             // Accept ANY UDP response on ANY port as a potential DDP device
-            std::string deviceInfo = std::string(ipStr);
+            std::string deviceInfo = ipStr;
             
             // Add port if not standard DDP port
-            if (ntohs(responseAddr.sin_port) != DDP_PORT)
+            if (responsePort != DDP_PORT)
             {
-                deviceInfo += ":" + std::to_string(ntohs(responseAddr.sin_port));
+                deviceInfo += ":" + std::to_string(responsePort);
             }
             
             // Check for duplicates
@@ -931,13 +2759,7 @@ void DDPOutputCHOP::discoverDevices()
     m_lastError = "Discovery scan complete. Received " + std::to_string(packetsReceived) + " packets";
     
     // Restore blocking mode
-    #ifdef _WIN32
-        mode = 0;  // 0 = blocking
-        ioctlsocket(m_socket, FIONBIO, &mode);
-    #else
-        sockFlags = fcntl(m_socket, F_GETFL, 0);
-        fcntl(m_socket, F_SETFL, sockFlags & ~O_NONBLOCK);
-    #endif
+    m_socket.setNonBlocking(false);
     
     m_isDiscovering = false;
     
@@ -1,14 +1,22 @@
 #ifndef __DDPOutputCHOP__
 #define __DDPOutputCHOP__
 
-// Must include winsock2 before Windows.h to avoid conflicts
-#ifdef _WIN32
-    #define WIN32_LEAN_AND_MEAN
-    #define NOMINMAX  // Prevent Windows from defining min/max macros
-    #include <winsock2.h>
-    #include <ws2tcpip.h>
-    #pragma comment(lib, "ws2_32.lib")
-#endif
+// Shared DDP core (must come before Windows.h, it pulls in winsock2)
+#include "DDPProtocol.h"
+#include "DDPSocket.h"
+#include "DDPFrameSegmenter.h"
+#include "DDPTransport.h"
+#include "DDPPixelConvert.h"
+#include "DDPLayout.h"
+#include "DDPRanges.h"
+#include "DDPCalibration.h"
+#include "DDPPower.h"
+#include "DDPPixelMap.h"
+#include "DDPRecording.h"
+#include "DDPPlayback.h"
+#include "DDPPcap.h"
+#include "DDPRedundancy.h"
+#include "HostResolver.h"
 
 #include "CHOP_CPlusPlusBase.h"
 #include <vector>
@@ -17,38 +25,9 @@
 using namespace TD;
 
 #ifndef _WIN32
-    #include <sys/socket.h>
-    #include <netinet/in.h>
-    #include <arpa/inet.h>
     #include <unistd.h>
-    #include <fcntl.h>
 #endif
 
-// DDP Protocol Constants (from official spec: http://www.3waylabs.com/ddp/)
-#define DDP_PORT 4048
-#define DDP_HEADER_SIZE 10
-#define DDP_MAX_DATALEN (480 * 3)  // 1440 bytes - official spec recommendation
-#define DDP_MAX_PIXELS_PER_PACKET 480
-
-// DDP Flags (Byte 0)
-#define DDP_FLAGS1_VER     0xC0  // Version mask
-#define DDP_FLAGS1_VER1    0x40  // Version 1
-#define DDP_FLAGS1_PUSH    0x01  // Push flag - display data now (sync)
-#define DDP_FLAGS1_QUERY   0x02  // Query request
-#define DDP_FLAGS1_REPLY   0x04  // Reply to query  
-#define DDP_FLAGS1_STORAGE 0x08  // Use local storage
-#define DDP_FLAGS1_TIME    0x10  // Timecode field present
-
-// DDP IDs
-#define DDP_ID_DISPLAY  1    // Display data
-#define DDP_ID_CONFIG   250  // Configuration
-#define DDP_ID_STATUS   251  // Status/discovery
-
-// DDP Data Types
-#define DDP_DATA_TYPE_RGB  0x01
-#define DDP_DATA_TYPE_HSL  0x02
-#define DDP_DATA_TYPE_RGBW 0x03
-
 class DDPOutputCHOP : public CHOP_CPlusPlusBase
 {
 public:
@@ -74,43 +53,99 @@ private:
     // Socket management
     void initializeSocket();
     void closeSocket();
+    bool resolveDestination(const char* ipAddress, int port);
     
-    // DDP packet creation and sending
-    void createDDPPacket(const uint8_t* pixelData, size_t dataLength, 
-                         size_t offset, bool pushFlag, std::vector<uint8_t>& packet);
-    void sendDDPData(const std::vector<uint8_t>& pixelData);
+    // DDP packet sending
+    void sendDDPData(const std::vector<uint8_t>& pixelData, size_t maxPayload, bool autoPush);
     void sendPushPacket();
     
+    // Redundancy (Redundancy / Secondary Address / Port / Interface / Health Check
+    // Interval / Health Timeout): the same slices go to one or both legs
+    void updateRedundancy(const OP_Inputs* inputs);
+    void checkLegHealth();
+    void sendStatusQuery(ddp::UdpSocket& socket, const struct sockaddr_storage& dest, socklen_t destLength);
+    // To each active leg's own controller, or with 'dest' to that address from each leg's socket
+    size_t sendToLegs(const ddp::SendSlice* slices, size_t count, int64_t& bytesSent,
+                      const struct sockaddr_storage* dest = nullptr, socklen_t destLength = 0);
+    std::string legSummary(int leg) const;
+    
+    // Recording tap on the send path (Record / Record File / Record Mode / Record Compression)
+    void updateRecording(const OP_Inputs* inputs);
+    void recordSent(const std::vector<uint8_t>& pixelData, size_t packetCount);
+    
+    // Copy of the sent packets in a pcap file (Mirror to PCAP / PCAP File)
+    void updatePcapMirror(const OP_Inputs* inputs);
+    void mirrorSlices(const ddp::SendSlice* slices, size_t count, const struct sockaddr_storage& dest);
+    
+    // Ranges sent with a protocol or to an address of their own (protocol /
+    // address / universe / channels columns of the Ranges DAT)
+    void updateTransports(size_t frameBytes);
+    size_t sendTransports(const std::vector<uint8_t>& pixelData, const ddp::SegmentOptions& options,
+                          int64_t& bytesSent);
+    std::string transportSummary() const;
+    
+    // Playback of a recording in place of the input CHOP
+    void playRecording(const OP_Inputs* inputs, bool autoPush);
+    
     // Data processing
     void processInterleavedChannels(const OP_CHOPInput* chopInput, 
                                      float gamma, float brightness,
-                                     bool normalizedInput,
+                                     bool normalizedInput, int channelsPerPixel,
                                      std::vector<uint8_t>& pixelData);
-    void processSequentialChannels(const OP_CHOPInput* chopInput,
-                                    float gamma, float brightness,
-                                    bool normalizedInput,
-                                    std::vector<uint8_t>& pixelData);
     
-    // Helper functions
-    uint8_t floatToUint8(float value, bool normalizedInput);
-    float applyGamma(float value, float gamma, bool normalizedInput);
+    // LED layout (Layout Width/Height / Direction / Serpentine / Start Corner / Segments DAT)
+    void updateLayout(const OP_Inputs* inputs);
+    
+    // Color Order / Ranges DAT, and the runs they split the frame into
+    void updateRanges(const OP_Inputs* inputs, int channelsPerPixel);
+    void updateConvertPlan(size_t sourcePixels, size_t wirePixels);
+    
+    // Color Matrix / Gain / Offset / White Extraction and the calibration columns of the Ranges DAT
+    void updateCalibration(const OP_Inputs* inputs, int channelsPerPixel);
+    void compileKernels(float brightness, float inputScale, int inputChannels, int channelsPerPixel);
+    
+    // Power Limit: budgets per range, the scales the next conversion applies,
+    // and the estimate of what it drew afterwards
+    void updatePower(const OP_Inputs* inputs);
+    void startMetering();
+    void finishMetering(int channelsPerPixel, double fullScale);
+    
+    // Pixel mapping: a TOP sampled straight into the output bytes
+    void updatePixelMap(const OP_Inputs* inputs);
+    bool sampleTOP(const OP_TOPInput* top, const ddp::ConvertSettings& settings,
+                   int channelsPerPixel, bool pipelined);
+    
+    // Dither: per-byte remainders for a frame of 'bytes', reseeded when the size changes
+    uint8_t* ditherState(size_t bytes);
+    
+    // Timecode
+    uint32_t computeTimecode(const OP_Inputs* inputs, double presentationDelayMs) const;
+    size_t headerSize() const { return ddp::headerSize(m_timecodeEnabled); }
+    
+    // Payload sizing
+    size_t effectivePayloadSize(int requestedPayload, int bytesPerPixel) const;
+    void checkPayloadAgainstMTU(size_t payloadSize);
+    
+    // Multicast
+    bool isMulticastDestination() const { return ddp::isMulticast(m_destAddr); }
+    void configureMulticast(int ttl, bool loopback, const char* interfaceAddress);
     
     // Socket members
-    #ifdef _WIN32
-        SOCKET m_socket;
-        bool m_wsaInitialized;
-    #else
-        int m_socket;
-    #endif
-    
-    struct sockaddr_in m_destAddr;
-    struct sockaddr_in m_broadcastAddr;
-    bool m_socketInitialized;
+    ddp::UdpSocket m_socket;
+    ddp::FrameSegmenter m_segmenter;     // header + payload slices, sent in one batch
+    
+    struct sockaddr_storage m_destAddr;  // IPv4 or IPv6 destination
+    socklen_t m_destAddrLen;
+    int m_socketFamily;
+    std::string m_bindInterface;         // device name or local address, empty = any
+    std::string m_lastBindInterface;
+    ddp::HostResolver m_resolver;        // hostnames are resolved off the cook thread
+    bool m_destIsHostname;
     bool m_needsReinitialize;
     bool m_showStats;
     
     // DDP state
-    uint8_t m_sequenceNumber;
+    std::vector<uint8_t> m_pixelData;    // converted frame, reused between cooks
     int64_t m_packetsSent;
     int64_t m_bytesSent;
     int32_t m_lastChannelCount;
@@ -119,6 +154,142 @@ private:
     std::string m_lastIPAddress;
     int m_lastPort;
     
+    // Payload / MTU state
+    size_t m_payloadSize;
+    int m_interfaceMTU;      // 0 = unknown
+    size_t m_lastCheckedPayload;
+    
+    // Secondary leg: its own socket and destination, with health and send
+    // counts per leg (0 = primary, 1 = secondary)
+    struct OutputLeg
+    {
+        ddp::LegHealth health;
+        int64_t packetsSent = 0;
+        int64_t bytesSent = 0;
+        int64_t sendErrors = 0;
+        std::string replyDest;          // destination 'anyReplier' was worked out for
+        bool anyReplier = false;        // multicast / broadcast: replies come from any host
+    };
+    ddp::Redundancy m_redundancy;
+    ddp::UdpSocket m_secondarySocket;
+    struct sockaddr_storage m_secondaryAddr;
+    socklen_t m_secondaryAddrLen;
+    std::string m_secondarySource;       // destination and interface the socket was opened for
+    std::string m_secondaryStatus;       // why the secondary socket is not open
+    ddp::HostResolver m_secondaryResolver;
+    OutputLeg m_legs[2];
+    ddp::LegSelector m_legSelector;
+    double m_healthInterval;
+    double m_healthTimeout;
+    
+    // Multicast state (applied when the destination is a multicast group)
+    int m_multicastTTL;
+    bool m_multicastLoop;
+    std::string m_multicastInterface;
+    bool m_multicastConfigured;
+    
+    // Timecode state (DDP_FLAGS1_TIME)
+    bool m_timecodeEnabled;
+    uint32_t m_frameTimecode;
+    
+    // LED layout: wire order -> input pixel, compiled once per layout and input size
+    ddp::LedLayout m_layout;
+    ddp::LayoutSettings m_layoutSettings;
+    std::string m_layoutSource;          // segments DAT path and cook count they were read at
+    bool m_layoutActive;
+    
+    // Ranges and color orders: m_colorOrders[0] is the output's, [i + 1] the one of m_ranges[i]
+    std::vector<ddp::PixelRange> m_ranges;
+    std::vector<ddp::ColorOrder> m_colorOrders;
+    std::string m_rangesSource;          // DAT, cook count, order and channel count they were read with
+    bool m_rangesActive;                 // some pixels are not sent in input channel order
+    std::vector<ddp::LayoutRun> m_convertPlan;   // wire-order runs, split at range boundaries
+    std::string m_convertPlanKey;
+    
+    // Transports: the output's own DDP stream sends m_ddpSpans of the frame,
+    // each range in m_transports is cut from the same buffer by its own encoder
+    struct RangeTransport
+    {
+        ddp::TransportRoute route;
+        ddp::FrameSegmenter ddpSegmenter;
+        ddp::DmxSegmenter dmxSegmenter;
+        std::vector<struct sockaddr_storage> dests;  // one per universe for sACN multicast, else one
+        std::vector<socklen_t> destLengths;
+    };
+    std::vector<RangeTransport> m_transports;
+    std::vector<ddp::ByteSpan> m_ddpSpans;
+    std::string m_transportSource;       // ranges, frame size and port they were planned for
+    bool m_transportsActive;
+    bool m_transportMulticast;           // some range goes to sACN multicast groups
+    size_t m_bytesPerPixel;              // on the wire, set every cook
+    uint8_t m_sacnCid[DDP_SACN_CID_SIZE];
+    int64_t m_transportPackets[3];       // sent, indexed by ddp::Transport
+    
+    // Calibration, indexed like m_colorOrders; the kernels are recompiled every
+    // cook since they fold in the brightness and input scale
+    std::vector<ddp::CalibrationSettings> m_calibrations;
+    std::vector<ddp::CalibrationKernel> m_kernels;
+    std::string m_calibrationSource;     // ranges and parameter values they were read with
+    int m_calibrationInputs;             // input channels per pixel, 3 when extracting white
+    bool m_calibrationActive;
+    
+    // Power limiting, indexed like m_colorOrders
+    bool m_powerLimit;
+    float m_channelCurrent[DDP_POWER_CHANNELS];  // mA of R, G, B, W at full
+    double m_limiterRelease;
+    std::vector<ddp::RangePower> m_power;
+    std::vector<ddp::PowerLimiter> m_limiters;
+    std::vector<double> m_budgets;       // amps, 0 = unlimited
+    std::vector<double> m_estimatedAmps; // last frame without the limiter
+    std::vector<double> m_limitedAmps;   // last frame as sent
+    std::vector<std::string> m_powerNames;   // Info CHOP channel prefixes
+    std::string m_powerSource;           // ranges and Power Budget the budgets were read with
+    double m_powerTime;                  // steady clock seconds of the last metered frame, < 0 = none
+    
+    // Pixel map (TOP / Pixel Map DAT / Pixel Map File / Map Units)
+    ddp::PixelMap m_pixelMap;
+    std::string m_pixelMapSource;        // what the loaded points came from, reloads on change
+    uint8_t m_byteLUT[256];              // gamma/brightness for 8-bit texels
+    uint16_t m_levelLUT[256];            // the same at 16 bits, for dithering
+    ddp::ConvertSettings m_lutSettings;
+    bool m_lutValid;
+    uint8_t m_linearLUT[DDP_CAL_LUT_SIZE];        // gamma over calibrated linear values
+    uint16_t m_linearLevelLUT[DDP_CAL_LUT_SIZE];  // the same at 16 bits
+    ddp::ConvertSettings m_linearLUTSettings;
+    bool m_linearLUTValid;
+    
+    // TOP readback (TOP Latency): the download started last cook, consumed this cook
+    OP_SmartRef<OP_TOPDownloadResult> m_pendingDownload;
+    uint32_t m_pendingTopId;             // opId of the last TOP downloaded
+    double m_downloadWaitMs;             // time getData() blocked on the last frame
+    
+    // Temporal dithering (Dither): what each output byte still owes, carried between frames
+    bool m_dither;
+    std::vector<uint8_t> m_ditherError;
+    std::vector<uint16_t> m_levels;      // 16-bit frame of a TOP before it is dithered or sent wide
+    
+    // Bit Depth: 8 or 16 bits per value on the wire, and the data type byte that says which
+    int m_bitDepth;
+    uint8_t m_dataType;
+    
+    // Recording of sent frames or packets
+    ddp::RecordingWriter m_recorder;
+    std::string m_recordTarget;    // settings of the last open attempt, empty when not recording
+    bool m_recordPackets;
+    
+    // Sent packets mirrored to a pcap file
+    ddp::PcapWriter m_pcapMirror;
+    std::string m_pcapMirrorFile;  // file of the last open attempt, empty when off
+    
+    // Playback (memory-mapped .ddpr, streamed at the recorded timing scaled by Playback Rate)
+    ddp::RecordingReader m_player;
+    std::string m_playbackFile;
+    double m_playbackTime;         // position in the recording, microseconds
+    double m_playbackLastTick;     // steady clock seconds of the previous cook, < 0 = stopped
+    size_t m_playbackCursor;       // next record to send
+    bool m_seekRequested;
+    std::vector<uint8_t> m_playbackFrame;
+    
     // Device discovery
     std::vector<std::string> m_discoveredDevices;
     bool m_isDiscovering;
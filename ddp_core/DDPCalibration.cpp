@@ -0,0 +1,128 @@
+#include "DDPCalibration.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+
+namespace ddp
+{
+
+namespace
+{
+    const float kIdentity[9] = { 1.0f, 0.0f, 0.0f, 0.0f, 1.0f, 0.0f, 0.0f, 0.0f, 1.0f };
+
+    int32_t toFixed(float value)
+    {
+        return static_cast<int32_t>(std::lround(value * (1 << DDP_CAL_FRACTION_BITS)));
+    }
+}
+
+CalibrationSettings::CalibrationSettings()
+{
+    std::copy(kIdentity, kIdentity + 9, matrix);
+    std::fill(gain, gain + 4, 1.0f);
+    std::fill(offset, offset + 4, 0.0f);
+    white = 0.0f;
+}
+
+bool CalibrationSettings::isIdentity() const
+{
+    for (int i = 0; i < 9; i++)
+    {
+        if (matrix[i] != kIdentity[i])
+            return false;
+    }
+    for (int i = 0; i < 4; i++)
+    {
+        if (gain[i] != 1.0f || offset[i] != 0.0f)
+            return false;
+    }
+    return white == 0.0f;
+}
+
+bool parseCalibrationValues(const char* text, float* values, int count, bool broadcast, std::string& error)
+{
+    float parsed[9];
+    int found = 0;
+    const char* p = text ? text : "";
+    while (true)
+    {
+        while (*p == ' ' || *p == '\t' || *p == ',' || *p == ';')
+            p++;
+        if (*p == '\0')
+            break;
+        char* end = nullptr;
+        float value = strtof(p, &end);
+        if (end == p || found == count || !std::isfinite(value))
+        {
+            error = std::string("'") + text + "' must be " + std::to_string(count) + " numbers" +
+                    (broadcast ? " or one" : "");
+            return false;
+        }
+        parsed[found++] = value;
+        p = end;
+    }
+
+    if (found == 0)
+        return true;
+    if (found == 1 && broadcast)
+    {
+        std::fill(values, values + count, parsed[0]);
+        return true;
+    }
+    if (found != count)
+    {
+        error = std::string("'") + text + "' must be " + std::to_string(count) + " numbers" +
+                (broadcast ? " or one" : "");
+        return false;
+    }
+    std::copy(parsed, parsed + count, values);
+    return true;
+}
+
+bool validateCalibration(const CalibrationSettings& settings, std::string& error)
+{
+    auto inRange = [](float value) { return std::fabs(value) <= DDP_CAL_MAX_COEFFICIENT; };
+    if (!std::all_of(settings.matrix, settings.matrix + 9, inRange) ||
+        !std::all_of(settings.gain, settings.gain + 4, inRange) ||
+        !std::all_of(settings.offset, settings.offset + 4, inRange))
+    {
+        error = "Calibration values must be between -4 and 4";
+        return false;
+    }
+    if (!(settings.white >= 0.0f && settings.white <= 1.0f))
+    {
+        error = "White extraction must be between 0 and 1";
+        return false;
+    }
+    return true;
+}
+
+void compileCalibration(const CalibrationSettings& settings, float brightness, float inputScale,
+                        int inputChannels, int outputChannels, CalibrationKernel& kernel)
+{
+    kernel.active = !settings.isIdentity() || inputChannels != outputChannels;
+    kernel.inputChannels = inputChannels;
+
+    // Brightness is the master fader, so it scales the offsets too
+    for (int row = 0; row < 3; row++)
+    {
+        for (int column = 0; column < 3; column++)
+        {
+            float coefficient = brightness * settings.gain[row] * settings.matrix[row * 3 + column];
+            kernel.matrix[row][column] = coefficient * inputScale;
+            kernel.qMatrix[row][column] = toFixed(coefficient * DDP_CAL_LINEAR_ONE / 255.0f);
+        }
+    }
+    for (int c = 0; c < 4; c++)
+    {
+        kernel.offset[c] = brightness * settings.offset[c];
+        kernel.qOffset[c] = toFixed(kernel.offset[c] * DDP_CAL_LINEAR_ONE);
+    }
+    kernel.whiteGain = brightness * settings.gain[3] * inputScale;
+    kernel.qWhiteGain = toFixed(brightness * settings.gain[3] * DDP_CAL_LINEAR_ONE / 255.0f);
+    kernel.extraScale = brightness * inputScale;
+    kernel.white = settings.white;
+    kernel.qWhite = toFixed(settings.white);
+}
+
+}
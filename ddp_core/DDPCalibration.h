@@ -0,0 +1,71 @@
+#ifndef __DDPCalibration__
+#define __DDPCalibration__
+
+#include <cstdint>
+#include <string>
+
+// Fixed-point format of calibrated TOP sampling: coefficients carry 12
+// fractional bits and linear values index a gamma table of DDP_CAL_LUT_SIZE
+// entries (see buildLinearLUT()). 1.0 is 16 steps per 8-bit texel value, so
+// an uncalibrated texel lands exactly on its own level.
+#define DDP_CAL_FRACTION_BITS 12
+#define DDP_CAL_LUT_SIZE 4096
+#define DDP_CAL_LINEAR_ONE 4080
+
+// Largest matrix entry, gain or offset magnitude, keeps the fixed-point sums inside 32 bits
+#define DDP_CAL_MAX_COEFFICIENT 4.0f
+
+namespace ddp
+{
+
+// Color calibration of a fixture batch, applied to linear 0-1 values before
+// gamma: rgb' = gain * (matrix * rgb) + offset, then 'white' of min(r', g', b')
+// moves from R, G and B to the W channel
+struct CalibrationSettings
+{
+    float matrix[9];    // row-major: the rows give R', G', B'
+    float gain[4];      // R, G, B, W
+    float offset[4];    // R, G, B, W, in 0-1 units
+    float white;        // 0 = no white extraction
+
+    CalibrationSettings();
+    bool isIdentity() const;
+};
+
+// Whitespace or comma separated numbers. 'count' of them, or with 'broadcast'
+// a single one that fills all 'count'. Empty text leaves 'values' as they are.
+bool parseCalibrationValues(const char* text, float* values, int count, bool broadcast, std::string& error);
+
+// Range checks shared by the parameters and the Ranges DAT columns
+bool validateCalibration(const CalibrationSettings& settings, std::string& error);
+
+// Settings folded with brightness and the input scale, once per cook, so the
+// kernels do one multiply-add per coefficient
+struct CalibrationKernel
+{
+    bool active = false;        // false: convert as if uncalibrated
+    int inputChannels = 3;      // 3 with white extraction: RGB in, RGBW out
+
+    // CHOP samples (float)
+    float matrix[3][3];
+    float offset[4];
+    float whiteGain;            // input W channel, when there is one
+    float extraScale;           // channels past W
+    float white;
+
+    // 8-bit texels -> linear table indices (DDP_CAL_FRACTION_BITS fixed point)
+    int32_t qMatrix[3][3];
+    int32_t qOffset[4];
+    int32_t qWhiteGain;
+    int32_t qWhite;
+};
+
+// 'inputScale' is one input unit in 0-1 terms (1 for 0-1 samples, 1/255 for
+// 0-255). The kernel is active when the settings are not the identity or the
+// input and output channel counts differ.
+void compileCalibration(const CalibrationSettings& settings, float brightness, float inputScale,
+                        int inputChannels, int outputChannels, CalibrationKernel& kernel);
+
+}
+
+#endif
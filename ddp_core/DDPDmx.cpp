@@ -0,0 +1,296 @@
+#include "DDPDmx.h"
+#include <algorithm>
+#include <cctype>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+
+namespace ddp
+{
+
+namespace
+{
+    const uint8_t kSacnIdentifier[12] = { 'A', 'S', 'C', '-', 'E', '1', '.', '1', '7', 0, 0, 0 };
+
+    void writeFlagsLength(uint8_t* p, size_t length)
+    {
+        p[0] = static_cast<uint8_t>(0x70 | ((length >> 8) & 0x0F));
+        p[1] = static_cast<uint8_t>(length & 0xFF);
+    }
+
+    void writeBE16(uint8_t* p, uint16_t value)
+    {
+        p[0] = static_cast<uint8_t>(value >> 8);
+        p[1] = static_cast<uint8_t>(value & 0xFF);
+    }
+
+    std::string trimmedLower(const char* cell)
+    {
+        std::string text;
+        for (const char* p = cell ? cell : ""; *p; p++)
+        {
+            if (!isspace(static_cast<unsigned char>(*p)))
+                text += static_cast<char>(tolower(static_cast<unsigned char>(*p)));
+        }
+        return text;
+    }
+
+    // Where the header keeps the sequence number
+    size_t sequenceOffset(DmxProtocol protocol)
+    {
+        return protocol == DmxProtocol::ArtNet ? 12 : 111;
+    }
+
+    bool parseNumber(const char* cell, long& value)
+    {
+        if (!cell)
+            return false;
+        char* end = nullptr;
+        long number = strtol(cell, &end, 10);
+        if (end == cell || number < 0)
+            return false;
+        value = number;
+        return true;
+    }
+}
+
+size_t writeArtDmxHeader(uint8_t* header, uint16_t universe, uint8_t sequence, uint16_t slots)
+{
+    memcpy(header, "Art-Net", 8);
+    header[8] = 0x00;       // OpDmx 0x5000, little-endian
+    header[9] = 0x50;
+    header[10] = 0;         // protocol version 14
+    header[11] = 14;
+    header[12] = sequence;
+    header[13] = 0;         // physical port
+    header[14] = static_cast<uint8_t>(universe & 0xFF);            // SubUni
+    header[15] = static_cast<uint8_t>((universe >> 8) & 0x7F);     // Net
+    writeBE16(header + 16, slots);
+    return DDP_ARTNET_HEADER_SIZE;
+}
+
+size_t writeSacnHeader(uint8_t* header, const uint8_t cid[DDP_SACN_CID_SIZE], const std::string& sourceName,
+                       uint8_t priority, uint16_t universe, uint8_t sequence, uint16_t slots)
+{
+    size_t total = DDP_SACN_HEADER_SIZE + slots;
+    memset(header, 0, DDP_SACN_HEADER_SIZE);
+
+    // Root layer
+    writeBE16(header, 0x0010);                  // preamble size
+    memcpy(header + 4, kSacnIdentifier, sizeof(kSacnIdentifier));
+    writeFlagsLength(header + 16, total - 16);
+    header[21] = 0x04;                          // VECTOR_ROOT_E131_DATA
+    memcpy(header + 22, cid, DDP_SACN_CID_SIZE);
+
+    // Framing layer
+    writeFlagsLength(header + 38, total - 38);
+    header[43] = 0x02;                          // VECTOR_E131_DATA_PACKET
+    memcpy(header + 44, sourceName.data(), std::min<size_t>(sourceName.size(), DDP_SACN_NAME_SIZE - 1));
+    header[108] = priority;
+    header[111] = sequence;
+    writeBE16(header + 113, universe);
+
+    // DMP layer: one property array starting with the DMX start code
+    writeFlagsLength(header + 115, total - 115);
+    header[117] = 0x02;                         // VECTOR_DMP_SET_PROPERTY
+    header[118] = 0xA1;
+    writeBE16(header + 121, 0x0001);            // address increment
+    writeBE16(header + 123, static_cast<uint16_t>(slots + 1));
+    header[125] = 0x00;                         // start code
+    return DDP_SACN_HEADER_SIZE;
+}
+
+uint16_t dmxSlotCount(DmxProtocol protocol, size_t slots)
+{
+    slots = std::min<size_t>(slots, DDP_DMX_CHANNELS);
+    if (protocol == DmxProtocol::ArtNet)
+        slots = std::max<size_t>(2, slots + (slots & 1));
+    return static_cast<uint16_t>(slots);
+}
+
+std::string sacnMulticastGroup(uint16_t universe)
+{
+    return "239.255." + std::to_string(universe >> 8) + "." + std::to_string(universe & 0xFF);
+}
+
+void makeSacnCid(uint8_t cid[DDP_SACN_CID_SIZE])
+{
+    std::random_device device;
+    for (int i = 0; i < DDP_SACN_CID_SIZE; i++)
+        cid[i] = static_cast<uint8_t>(device());
+    cid[6] = static_cast<uint8_t>((cid[6] & 0x0F) | 0x40);
+    cid[8] = static_cast<uint8_t>((cid[8] & 0x3F) | 0x80);
+}
+
+UniverseTableParser::UniverseTableParser()
+{
+    m_offset = 0;
+    m_length = 1;
+    m_universe = 2;
+    m_channel = 3;
+}
+
+bool UniverseTableParser::parseRow(const char* const* cells, int numCells, UniverseMap& map)
+{
+    // A row naming an "offset" column is the header
+    for (int i = 0; i < numCells; i++)
+    {
+        if (trimmedLower(cells[i]) != "offset")
+            continue;
+        m_offset = m_length = m_universe = m_channel = -1;
+        for (int j = 0; j < numCells; j++)
+        {
+            std::string name = trimmedLower(cells[j]);
+            if (name == "offset")
+                m_offset = j;
+            else if (name == "length")
+                m_length = j;
+            else if (name == "universe")
+                m_universe = j;
+            else if (name == "channel")
+                m_channel = j;
+        }
+        return false;
+    }
+
+    auto cell = [cells, numCells](int index) -> const char* {
+        return index >= 0 && index < numCells ? cells[index] : nullptr;
+    };
+    long offset, length, universe;
+    if (!parseNumber(cell(m_offset), offset) || !parseNumber(cell(m_length), length) ||
+        !parseNumber(cell(m_universe), universe))
+        return false;
+    long channel = 1;
+    parseNumber(cell(m_channel), channel);
+
+    // Out of range values are kept large enough for validateUniverses() to report
+    map.offset = static_cast<uint32_t>(std::min<long>(offset, 0x7FFFFFFF));
+    map.length = static_cast<uint32_t>(std::min<long>(length, 0xFFFF));
+    map.universe = static_cast<uint16_t>(std::min<long>(universe, 0xFFFF));
+    map.channel = static_cast<uint16_t>(std::min<long>(channel, 0xFFFF));
+    return true;
+}
+
+void consecutiveUniverses(uint32_t offset, uint16_t firstUniverse, int count, int channels,
+                          std::vector<UniverseMap>& universes)
+{
+    universes.clear();
+    for (int i = 0; i < count; i++)
+    {
+        UniverseMap map;
+        map.offset = offset + static_cast<uint32_t>(i * channels);
+        map.length = static_cast<uint32_t>(channels);
+        map.universe = static_cast<uint16_t>(firstUniverse + i);
+        universes.push_back(map);
+    }
+}
+
+bool validateUniverses(std::vector<UniverseMap>& universes, DmxProtocol protocol, std::string& error)
+{
+    std::stable_sort(universes.begin(), universes.end(),
+                     [](const UniverseMap& a, const UniverseMap& b) { return a.universe < b.universe; });
+    uint16_t first = protocol == DmxProtocol::ArtNet ? 0 : 1;
+    uint16_t last = protocol == DmxProtocol::ArtNet ? DDP_ARTNET_MAX_UNIVERSE : DDP_SACN_MAX_UNIVERSE;
+    for (size_t i = 0; i < universes.size(); i++)
+    {
+        const UniverseMap& map = universes[i];
+        std::string name = "Universe " + std::to_string(map.universe);
+        if (map.universe < first || map.universe > last)
+        {
+            error = name + " is outside " + std::to_string(first) + "-" + std::to_string(last);
+            return false;
+        }
+        if (i > 0 && universes[i - 1].universe == map.universe)
+        {
+            error = name + " is mapped twice";
+            return false;
+        }
+        if (map.channel < 1 || map.length < 1 || map.channel - 1 + map.length > DDP_DMX_CHANNELS)
+        {
+            error = name + ": channels " + std::to_string(map.channel) + "+" + std::to_string(map.length) +
+                    " do not fit in 512";
+            return false;
+        }
+    }
+    return true;
+}
+
+DmxSegmenter::DmxSegmenter()
+{
+    m_protocol = DmxProtocol::Sacn;
+    m_stride = 0;
+    m_extent = 0;
+    m_padded = 0;
+}
+
+void DmxSegmenter::setUniverses(DmxProtocol protocol, const std::vector<UniverseMap>& universes,
+                                const std::string& sourceName, const uint8_t cid[DDP_SACN_CID_SIZE])
+{
+    m_protocol = protocol;
+    m_universes = universes;
+    m_stride = dmxHeaderSize(protocol) + DDP_DMX_CHANNELS;
+    m_packets.assign(m_universes.size() * m_stride, 0);
+    m_sequences.assign(m_universes.size(), 0);
+    m_slices.reserve(m_universes.size());
+    m_extent = 0;
+    for (size_t i = 0; i < m_universes.size(); i++)
+    {
+        const UniverseMap& map = m_universes[i];
+        uint8_t* packet = m_packets.data() + i * m_stride;
+        uint16_t slots = dmxSlotCount(protocol, map.channel - 1u + map.length);
+        if (protocol == DmxProtocol::ArtNet)
+            writeArtDmxHeader(packet, map.universe, 0, slots);
+        else
+            writeSacnHeader(packet, cid, sourceName, DDP_SACN_PRIORITY, map.universe, 0, slots);
+        m_extent = std::max(m_extent, static_cast<size_t>(map.offset) + map.length);
+    }
+}
+
+size_t DmxSegmenter::segment(const uint8_t* frame, size_t length)
+{
+    m_slices.clear();
+    m_padded = 0;
+    if (!frame)
+        length = 0;
+    
+    size_t headerSize = dmxHeaderSize(m_protocol);
+    size_t sequenceAt = sequenceOffset(m_protocol);
+    for (size_t i = 0; i < m_universes.size(); i++)
+    {
+        const UniverseMap& map = m_universes[i];
+        size_t lead = map.channel - 1u;
+        size_t available = length > map.offset ? std::min<size_t>(map.length, length - map.offset) : 0;
+        size_t slots = dmxSlotCount(m_protocol, lead + map.length);
+        
+        // Art-Net skips sequence 0, which means "not sequenced"
+        uint8_t sequence = ++m_sequences[i];
+        if (m_protocol == DmxProtocol::ArtNet && sequence == 0)
+            sequence = m_sequences[i] = 1;
+        uint8_t* packet = m_packets.data() + i * m_stride;
+        packet[sequenceAt] = sequence;
+        
+        SendSlice slice;
+        slice.header = packet;
+        if (available == map.length && slots == lead + map.length)
+        {
+            slice.headerLength = headerSize + lead;
+            slice.payload = frame + map.offset;
+            slice.payloadLength = map.length;
+        }
+        else
+        {
+            uint8_t* data = packet + headerSize + lead;
+            if (available > 0)
+                memcpy(data, frame + map.offset, available);
+            memset(data + available, 0, slots - lead - available);
+            slice.headerLength = headerSize + slots;
+            slice.payload = nullptr;
+            slice.payloadLength = 0;
+            m_padded++;
+        }
+        m_slices.push_back(slice);
+    }
+    return m_slices.size();
+}
+
+}
@@ -0,0 +1,131 @@
+#ifndef __DDPDmx__
+#define __DDPDmx__
+
+#include "DDPSocket.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// DMX over IP: Art-Net (ArtDmx) and sACN (ANSI E1.31) data packets
+#define DDP_ARTNET_PORT         6454
+#define DDP_SACN_PORT           5568
+#define DDP_DMX_CHANNELS        512
+#define DDP_ARTNET_HEADER_SIZE  18
+#define DDP_SACN_HEADER_SIZE    126      // root, framing and DMP layers up to the start code
+#define DDP_ARTNET_MAX_UNIVERSE 32767    // 15-bit port address
+#define DDP_SACN_MAX_UNIVERSE   63999
+#define DDP_SACN_PRIORITY       100
+#define DDP_SACN_CID_SIZE       16
+#define DDP_SACN_NAME_SIZE      64
+
+namespace ddp
+{
+
+enum class DmxProtocol
+{
+    ArtNet,
+    Sacn
+};
+
+// Headers are written in front of 'slots' DMX channels, which the caller
+// sends as the payload. Returns the header length.
+size_t writeArtDmxHeader(uint8_t* header, uint16_t universe, uint8_t sequence, uint16_t slots);
+size_t writeSacnHeader(uint8_t* header, const uint8_t cid[DDP_SACN_CID_SIZE], const std::string& sourceName,
+                       uint8_t priority, uint16_t universe, uint8_t sequence, uint16_t slots);
+
+inline size_t dmxHeaderSize(DmxProtocol protocol)
+{
+    return protocol == DmxProtocol::ArtNet ? DDP_ARTNET_HEADER_SIZE : DDP_SACN_HEADER_SIZE;
+}
+
+// Channels actually sent for 'slots' channels of data: Art-Net wants an even
+// count of at least 2, so odd counts get a zero channel appended
+uint16_t dmxSlotCount(DmxProtocol protocol, size_t slots);
+
+// "239.255.<hi>.<lo>", the sACN multicast group of a universe
+std::string sacnMulticastGroup(uint16_t universe);
+
+// Random version 4 UUID, the sACN component identifier of a sender
+void makeSacnCid(uint8_t cid[DDP_SACN_CID_SIZE]);
+
+// DDP frame bytes [offset, offset + length) sent to 'universe' from DMX
+// channel 'channel' (1-based) on
+struct UniverseMap
+{
+    uint32_t offset = 0;
+    uint32_t length = 0;
+    uint16_t universe = 0;
+    uint16_t channel = 1;
+};
+
+// Reads the rows of a universe DAT. A header row naming the columns (offset,
+// length, universe, channel, in any order) may come first; without one the
+// columns are in that order. An empty channel is 1.
+class UniverseTableParser
+{
+public:
+    UniverseTableParser();
+
+    // False for the header and for rows without an offset, length and universe
+    bool parseRow(const char* const* cells, int numCells, UniverseMap& map);
+
+private:
+    int m_offset;   // column indices, -1 = not in the table
+    int m_length;
+    int m_universe;
+    int m_channel;
+};
+
+// 'count' universes from 'firstUniverse' on, 'channels' channels each, taking
+// consecutive frame bytes from 'offset'
+void consecutiveUniverses(uint32_t offset, uint16_t firstUniverse, int count, int channels,
+                          std::vector<UniverseMap>& universes);
+
+// Sorts by universe. Errors: a universe mapped twice, a universe out of the
+// protocol's range, or channels past 512.
+bool validateUniverses(std::vector<UniverseMap>& universes, DmxProtocol protocol, std::string& error);
+
+// Cuts a frame into one packet per universe, the DMX counterpart of
+// FrameSegmenter. Headers are built once per mapping and only the sequence
+// changes per frame. A universe whose channels are all in the frame is a
+// header + slice of the frame, without a copy; universes cut short by the
+// frame, or that need Art-Net's even length, are padded in their own buffer.
+class DmxSegmenter
+{
+public:
+    DmxSegmenter();
+
+    // Expects validated universes. Sequences restart; 'sourceName' and 'cid'
+    // are only used by sACN.
+    void setUniverses(DmxProtocol protocol, const std::vector<UniverseMap>& universes,
+                      const std::string& sourceName, const uint8_t cid[DDP_SACN_CID_SIZE]);
+
+    // Build the slices for 'frame'. Returns the number of packets.
+    size_t segment(const uint8_t* frame, size_t length);
+
+    const std::vector<SendSlice>& slices() const { return m_slices; }
+    const std::vector<UniverseMap>& universes() const { return m_universes; }
+    DmxProtocol protocol() const { return m_protocol; }
+
+    // Frame bytes the universes read
+    size_t extent() const { return m_extent; }
+
+    // Packets of the last segment() that had to be padded
+    size_t padded() const { return m_padded; }
+
+private:
+    DmxProtocol m_protocol;
+    std::vector<UniverseMap> m_universes;
+    std::vector<uint8_t> m_packets;         // per universe: header, leading zero channels, room for padding
+    size_t m_stride;
+    std::vector<uint8_t> m_sequences;
+    size_t m_extent;
+    size_t m_padded;
+    std::vector<SendSlice> m_slices;
+};
+
+}
+
+#endif
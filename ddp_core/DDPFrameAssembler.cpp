@@ -0,0 +1,126 @@
+#include "DDPFrameAssembler.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include <iterator>
+
+namespace ddp
+{
+
+bool assemblePayload(std::vector<uint8_t>& frame, uint32_t offset, const uint8_t* data, size_t length)
+{
+    size_t requiredSize = static_cast<size_t>(offset) + length;
+    if (requiredSize > DDP_MAX_FRAME_BYTES)
+        return false;
+    
+    if (frame.size() < requiredSize)
+        frame.resize(requiredSize, 0);
+    
+    if (length > 0)
+        std::memcpy(frame.data() + offset, data, length);
+    return true;
+}
+
+JitterBuffer::JitterBuffer()
+{
+    m_delay = 0.0;
+    m_clockOffsetValid = false;
+    m_clockOffset = 0.0;
+    m_lastOffsetUpdate = 0.0;
+    m_lastTimecode = 0;
+    m_timecodeEpoch = 0;
+    m_framesDropped = 0;
+    m_framesLate = 0;
+}
+
+double JitterBuffer::steadyNowSeconds()
+{
+    auto now = std::chrono::steady_clock::now().time_since_epoch();
+    return std::chrono::duration<double>(now).count();
+}
+
+double JitterBuffer::timecodeToLocalTime(uint32_t timecode, double arrivalTime)
+{
+    // Unwrap the 32-bit timecode (wraps every 65536 seconds)
+    if (m_clockOffsetValid && timecode < m_lastTimecode && (m_lastTimecode - timecode) > 0x80000000u)
+        m_timecodeEpoch++;
+    m_lastTimecode = timecode;
+    
+    double senderTime = static_cast<double>(m_timecodeEpoch) * 65536.0 + timecode / 65536.0;
+    double offset = arrivalTime - senderTime;
+    
+    // The smallest observed (arrival - sender) difference is the least delayed packet,
+    // so track the minimum and let it relax slowly to follow clock drift.
+    // A large jump means the sender clock or timeline was reset: start over.
+    if (!m_clockOffsetValid || std::abs(offset - m_clockOffset) > DDP_CLOCK_RESYNC_SEC)
+    {
+        m_clockOffset = offset;
+        m_clockOffsetValid = true;
+    }
+    else
+    {
+        double elapsed = arrivalTime - m_lastOffsetUpdate;
+        m_clockOffset = std::min(offset, m_clockOffset + elapsed * DDP_CLOCK_DRIFT_PER_SEC);
+    }
+    m_lastOffsetUpdate = arrivalTime;
+    
+    return senderTime + m_clockOffset;
+}
+
+void JitterBuffer::push(const std::vector<uint8_t>& frameData, bool hasTimecode, uint32_t timecode, double arrivalTime)
+{
+    double presentTime = (hasTimecode ? timecodeToLocalTime(timecode, arrivalTime) : arrivalTime) + m_delay;
+    
+    if (m_queue.size() >= DDP_JITTER_MAX_FRAMES)
+    {
+        m_spareFrames.push_back(std::move(m_queue.front().data));
+        m_queue.pop_front();
+        m_framesDropped++;
+    }
+    
+    // Reuse storage from frames that were already presented
+    Frame frame;
+    if (!m_spareFrames.empty())
+    {
+        frame.data = std::move(m_spareFrames.back());
+        m_spareFrames.pop_back();
+    }
+    frame.data.assign(frameData.begin(), frameData.end());
+    frame.presentTime = presentTime;
+    
+    // Keep the queue ordered by presentation time (out-of-order arrival is rare, so scan from the back)
+    auto it = m_queue.end();
+    while (it != m_queue.begin() && std::prev(it)->presentTime > presentTime)
+        --it;
+    m_queue.insert(it, std::move(frame));
+}
+
+bool JitterBuffer::release(double now, std::vector<uint8_t>& out, double& presentTime)
+{
+    if (m_queue.empty() || m_queue.front().presentTime > now)
+        return false;
+    
+    m_spareFrames.push_back(std::move(out));
+    out = std::move(m_queue.front().data);
+    presentTime = m_queue.front().presentTime;
+    m_queue.pop_front();
+    
+    // Only the newest due frame is shown; this one is superseded when another is due too
+    if (!m_queue.empty() && m_queue.front().presentTime <= now)
+        m_framesLate++;
+    return true;
+}
+
+void JitterBuffer::clear()
+{
+    while (!m_queue.empty())
+    {
+        m_spareFrames.push_back(std::move(m_queue.front().data));
+        m_queue.pop_front();
+    }
+    m_clockOffsetValid = false;
+    m_timecodeEpoch = 0;
+}
+
+}
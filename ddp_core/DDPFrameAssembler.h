@@ -0,0 +1,67 @@
+#ifndef __DDPFrameAssembler__
+#define __DDPFrameAssembler__
+
+#include "DDPProtocol.h"
+#include <deque>
+#include <vector>
+
+// Timecode / jitter buffer
+#define DDP_JITTER_MAX_FRAMES   16   // frames held before the oldest is dropped
+#define DDP_CLOCK_RESYNC_SEC    1.0  // sender clock jump that forces a new offset estimate
+#define DDP_CLOCK_DRIFT_PER_SEC 0.0005  // how fast the offset estimate may relax upwards
+
+namespace ddp
+{
+
+// Copy one packet's payload to its offset in 'frame', growing the frame as
+// needed. Offsets past DDP_MAX_FRAME_BYTES are rejected.
+bool assemblePayload(std::vector<uint8_t>& frame, uint32_t offset, const uint8_t* data, size_t length);
+
+// Completed frames are held until their presentation time: the sender timecode
+// mapped onto the local clock (or the arrival time) plus a fixed delay.
+class JitterBuffer
+{
+public:
+    JitterBuffer();
+
+    void setDelay(double seconds) { m_delay = seconds; }
+
+    // Queue a completed frame (copied into recycled storage)
+    void push(const std::vector<uint8_t>& frame, bool hasTimecode, uint32_t timecode, double arrivalTime);
+
+    // Swap the oldest due frame into 'out' with its presentation time. Call until it
+    // returns false: every due frame comes out in order and the last one is shown.
+    bool release(double now, std::vector<uint8_t>& out, double& presentTime);
+
+    void clear();
+
+    size_t queued() const { return m_queue.size(); }
+    int64_t framesDropped() const { return m_framesDropped; }
+    int64_t framesLate() const { return m_framesLate; }
+
+    static double steadyNowSeconds();
+
+private:
+    struct Frame
+    {
+        std::vector<uint8_t> data;
+        double presentTime;
+    };
+
+    double timecodeToLocalTime(uint32_t timecode, double arrivalTime);
+
+    double m_delay;                                // seconds
+    std::deque<Frame> m_queue;
+    std::vector<std::vector<uint8_t>> m_spareFrames; // recycled frame storage
+    bool m_clockOffsetValid;
+    double m_clockOffset;                          // local steady time - sender time (seconds)
+    double m_lastOffsetUpdate;
+    uint32_t m_lastTimecode;
+    int64_t m_timecodeEpoch;                       // number of 65536 s wraps seen
+    int64_t m_framesDropped;
+    int64_t m_framesLate;
+};
+
+}
+
+#endif
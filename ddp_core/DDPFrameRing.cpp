@@ -0,0 +1,70 @@
+#include "DDPFrameRing.h"
+#include <algorithm>
+#include <cstring>
+
+namespace ddp
+{
+
+FrameRing::FrameRing()
+{
+    m_capacity = 1;
+    m_slotBytes = 0;
+    m_next = 0;
+    m_size = 0;
+    m_pushed = 0;
+    m_bytes.assign(m_capacity, 0);
+    m_arrival.assign(m_capacity, 0.0);
+}
+
+void FrameRing::reset(size_t capacity)
+{
+    m_capacity = std::max<size_t>(1, std::min<size_t>(capacity, DDP_HISTORY_MAX_FRAMES));
+    m_bytes.assign(m_capacity, 0);
+    m_arrival.assign(m_capacity, 0.0);
+    m_storage.assign(m_capacity * m_slotBytes, 0);
+    clear();
+}
+
+void FrameRing::clear()
+{
+    m_next = 0;
+    m_size = 0;
+    m_pushed = 0;
+}
+
+void FrameRing::push(const uint8_t* frame, size_t bytes, double arrivalTime)
+{
+    // A bigger frame means a new stream layout: resize once, the old frames go
+    if (bytes > m_slotBytes)
+    {
+        m_slotBytes = bytes;
+        m_storage.assign(m_capacity * m_slotBytes, 0);
+        m_next = 0;
+        m_size = 0;
+    }
+
+    if (bytes > 0)
+        std::memcpy(m_storage.data() + m_next * m_slotBytes, frame, bytes);
+    m_bytes[m_next] = bytes;
+    m_arrival[m_next] = arrivalTime;
+    m_next = (m_next + 1) % m_capacity;
+    m_size = std::min(m_size + 1, m_capacity);
+    m_pushed++;
+}
+
+const uint8_t* FrameRing::frame(size_t i) const
+{
+    return m_storage.data() + slot(i) * m_slotBytes;
+}
+
+size_t FrameRing::frameBytes(size_t i) const
+{
+    return m_bytes[slot(i)];
+}
+
+double FrameRing::arrivalTime(size_t i) const
+{
+    return m_arrival[slot(i)];
+}
+
+}
@@ -0,0 +1,53 @@
+#ifndef __DDPFrameRing__
+#define __DDPFrameRing__
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Most frames a history ring may hold
+#define DDP_HISTORY_MAX_FRAMES 256
+
+namespace ddp
+{
+
+// The last 'capacity' complete frames with their arrival times, in one
+// preallocated block of equal slots. Pushing copies into the oldest slot; the
+// block is only reallocated when the capacity changes or a frame outgrows the
+// slots, which starts the history over.
+class FrameRing
+{
+public:
+    FrameRing();
+
+    // Empties the ring; 'capacity' is clamped to 1..DDP_HISTORY_MAX_FRAMES
+    void reset(size_t capacity);
+    void clear();
+
+    void push(const uint8_t* frame, size_t bytes, double arrivalTime);
+
+    size_t capacity() const { return m_capacity; }
+    size_t size() const { return m_size; }      // frames held
+    int64_t pushed() const { return m_pushed; }  // frames pushed since reset()/clear()
+
+    // i = 0 is the oldest frame held, size() - 1 the newest
+    const uint8_t* frame(size_t i) const;
+    size_t frameBytes(size_t i) const;
+    double arrivalTime(size_t i) const;
+
+private:
+    size_t slot(size_t i) const { return (m_next + m_capacity - m_size + i) % m_capacity; }
+
+    std::vector<uint8_t> m_storage;     // m_capacity slots of m_slotBytes
+    std::vector<size_t> m_bytes;
+    std::vector<double> m_arrival;
+    size_t m_capacity;
+    size_t m_slotBytes;
+    size_t m_next;                      // slot the next frame goes to
+    size_t m_size;
+    int64_t m_pushed;
+};
+
+}
+
+#endif
@@ -0,0 +1,107 @@
+#include "DDPFrameSegmenter.h"
+#include <algorithm>
+#include <cstring>
+
+namespace ddp
+{
+
+uint8_t FrameSegmenter::nextSequence()
+{
+    uint8_t sequence = m_sequence;
+    m_sequence = (m_sequence + 1) & 0x0F;
+    return sequence;
+}
+
+size_t FrameSegmenter::segment(const uint8_t* frame, size_t length, const SegmentOptions& options)
+{
+    ByteSpan span = { 0, length };
+    return segment(frame, &span, 1, options);
+}
+
+size_t FrameSegmenter::segment(const uint8_t* frame, const ByteSpan* spans, size_t count, const SegmentOptions& options)
+{
+    m_slices.clear();
+    if (!frame || options.maxPayload == 0)
+        return 0;
+    
+    size_t maxPayload = std::min(options.maxPayload, static_cast<size_t>(DDP_MAX_DATALEN_LIMIT));
+    size_t packetCount = 0;
+    for (size_t s = 0; s < count; s++)
+        packetCount += (spans[s].length + maxPayload - 1) / maxPayload;
+    if (packetCount == 0)
+        return 0;
+    
+    // Size header storage up front so slice pointers stay valid
+    if (m_headers.size() < packetCount)
+        m_headers.resize(packetCount);
+    m_slices.reserve(packetCount);
+    
+    PacketHeader header;
+    header.dataType = options.dataType;
+    header.destId = options.destId;
+    header.timecode = options.timecodeValue;
+    
+    size_t packet = 0;
+    for (size_t s = 0; s < count; s++)
+    {
+        size_t position = spans[s].offset;
+        size_t end = spans[s].offset + spans[s].length;
+        while (position < end)
+        {
+            size_t bytesInPacket = std::min(end - position, maxPayload);
+            bool isLastPacket = (packet + 1 == packetCount);
+            
+            header.flags = DDP_FLAGS1_VER1;
+            if (options.pushOnLast && isLastPacket)
+                header.flags |= DDP_FLAGS1_PUSH;
+            if (options.timecode)
+                header.flags |= DDP_FLAGS1_TIME;
+            header.sequence = nextSequence();
+            header.offset = options.baseOffset + static_cast<uint32_t>(position);
+            header.length = static_cast<uint16_t>(bytesInPacket);
+            
+            SendSlice slice;
+            slice.header = m_headers[packet].data();
+            slice.headerLength = packHeader(header, m_headers[packet].data());
+            slice.payload = frame + position;
+            slice.payloadLength = bytesInPacket;
+            m_slices.push_back(slice);
+            
+            position += bytesInPacket;
+            packet++;
+        }
+    }
+    
+    return packetCount;
+}
+
+size_t FrameSegmenter::control(uint8_t flags, uint8_t destId, uint8_t dataType)
+{
+    m_slices.clear();
+    if (m_headers.empty())
+        m_headers.resize(1);
+    
+    PacketHeader header;
+    header.flags = DDP_FLAGS1_VER1 | flags;
+    header.sequence = nextSequence();
+    header.dataType = dataType;
+    header.destId = destId;
+    
+    SendSlice slice;
+    slice.header = m_headers[0].data();
+    slice.headerLength = packHeader(header, m_headers[0].data());
+    slice.payload = nullptr;
+    slice.payloadLength = 0;
+    m_slices.push_back(slice);
+    return 1;
+}
+
+void FrameSegmenter::flatten(const SendSlice& slice, std::vector<uint8_t>& packet)
+{
+    packet.resize(slice.headerLength + slice.payloadLength);
+    std::memcpy(packet.data(), slice.header, slice.headerLength);
+    if (slice.payloadLength > 0)
+        std::memcpy(packet.data() + slice.headerLength, slice.payload, slice.payloadLength);
+}
+
+}
@@ -0,0 +1,68 @@
+#ifndef __DDPFrameSegmenter__
+#define __DDPFrameSegmenter__
+
+#include "DDPProtocol.h"
+#include "DDPSocket.h"
+#include <array>
+#include <vector>
+
+namespace ddp
+{
+
+// How one frame is cut into DDP packets
+struct SegmentOptions
+{
+    size_t maxPayload = DDP_MAX_DATALEN;
+    uint8_t dataType = DDP_DATA_TYPE_RGB;
+    uint8_t destId = DDP_ID_DISPLAY;
+    uint32_t baseOffset = 0;       // byte offset of frame[0] on the receiver
+    bool pushOnLast = true;        // set PUSH on the final packet of the frame
+    bool timecode = false;         // append the TIME field to every packet
+    uint32_t timecodeValue = 0;    // 16.16 seconds, same for every packet of a frame
+};
+
+// Bytes [offset, offset + length) of a frame
+struct ByteSpan
+{
+    size_t offset;
+    size_t length;
+};
+
+// Splits a frame into header + payload slices. Payload pointers reference the
+// caller's frame buffer (no copy), headers live in storage reused between frames.
+class FrameSegmenter
+{
+public:
+    FrameSegmenter() : m_sequence(0) {}
+
+    // Build the slices for 'frame'. Returns the number of packets.
+    size_t segment(const uint8_t* frame, size_t length, const SegmentOptions& options);
+
+    // Only the spans of 'frame' (ascending, not overlapping), each at its own
+    // offset on the receiver; PUSH goes on the last packet of the last span
+    size_t segment(const uint8_t* frame, const ByteSpan* spans, size_t count, const SegmentOptions& options);
+
+    // Header-only packet (e.g. a standalone PUSH or a STATUS query)
+    size_t control(uint8_t flags, uint8_t destId, uint8_t dataType = DDP_DATA_TYPE_RGB);
+
+    const std::vector<SendSlice>& slices() const { return m_slices; }
+
+    // Sequence number of the next packet (lower 4 bits, wraps at 16)
+    uint8_t sequence() const { return m_sequence; }
+
+    // Copy one slice into a contiguous datagram (for capture/recording taps)
+    static void flatten(const SendSlice& slice, std::vector<uint8_t>& packet);
+
+private:
+    typedef std::array<uint8_t, DDP_MAX_HEADER_SIZE> HeaderBytes;
+
+    uint8_t nextSequence();
+
+    uint8_t m_sequence;
+    std::vector<HeaderBytes> m_headers;
+    std::vector<SendSlice> m_slices;
+};
+
+}
+
+#endif
@@ -0,0 +1,117 @@
+#include "DDPFrameSmoother.h"
+#include <algorithm>
+
+namespace ddp
+{
+
+FrameSmoother::FrameSmoother()
+{
+    clear();
+}
+
+void FrameSmoother::clear()
+{
+    m_newest = 0;
+    m_frames = 0;
+    m_kept[0] = m_kept[1] = false;
+    m_arrival[0] = m_arrival[1] = 0.0;
+    m_period = 0.0;
+}
+
+void FrameSmoother::push(const std::vector<uint8_t>& frame, double arrivalTime, bool keepFrame)
+{
+    // Another frame within the same read replaces the newest, the pair stays
+    if (m_frames > 0 && arrivalTime - m_arrival[m_newest] < DDP_SMOOTH_MIN_INTERVAL)
+    {
+        if (keepFrame)
+            m_buffers[m_newest].assign(frame.begin(), frame.end());
+        m_kept[m_newest] = keepFrame;
+        return;
+    }
+
+    if (m_frames > 0)
+    {
+        double interval = arrivalTime - m_arrival[m_newest];
+        if (interval > DDP_SMOOTH_MAX_INTERVAL)
+            m_period = 0.0;
+        else if (m_period == 0.0)
+            m_period = interval;
+        else
+            m_period += DDP_SMOOTH_PERIOD_WEIGHT * (interval - m_period);
+    }
+
+    // The older buffer (and its capacity) takes the new frame
+    m_newest ^= 1;
+    if (keepFrame)
+        m_buffers[m_newest].assign(frame.begin(), frame.end());
+    m_kept[m_newest] = keepFrame;
+    m_arrival[m_newest] = arrivalTime;
+    m_frames = std::min(m_frames + 1, 2);
+}
+
+double FrameSmoother::age(double now) const
+{
+    return m_frames > 0 ? std::max(0.0, now - m_arrival[m_newest]) : 0.0;
+}
+
+SmoothWeights FrameSmoother::weights(double now, const SmoothSettings& settings) const
+{
+    SmoothWeights weights;
+    weights.age = age(now);
+
+    if (m_frames > 0 && settings.holdTime > 0.0 && weights.age > settings.holdTime)
+    {
+        double fading = weights.age - settings.holdTime;
+        weights.fade = settings.fadeTime > 0.0 ?
+            static_cast<float>(std::max(0.0, 1.0 - fading / settings.fadeTime)) : 0.0f;
+    }
+
+    // One frame period behind the sender: the newest frame is reached as the next one is due
+    float position = 1.0f;
+    if (settings.interpolate && m_frames == 2 && m_kept[0] && m_kept[1] && m_period > 0.0 &&
+        m_buffers[0].size() == m_buffers[1].size())
+    {
+        position = static_cast<float>(std::min(1.0, weights.age / m_period));
+        weights.blended = true;
+    }
+
+    weights.previous = (1.0f - position) * weights.fade;
+    weights.current = position * weights.fade;
+    return weights;
+}
+
+void blendSamples(const uint8_t* previous, const uint8_t* current, size_t count, size_t valueBytes,
+                  float previousWeight, float currentWeight, float* dst)
+{
+    if (valueBytes == 2)
+    {
+        if (previousWeight == 0.0f)
+        {
+            for (size_t i = 0; i < count; i++)
+                dst[i] = static_cast<float>((current[2 * i] << 8) | current[2 * i + 1]) * currentWeight;
+        }
+        else
+        {
+            for (size_t i = 0; i < count; i++)
+            {
+                float a = static_cast<float>((previous[2 * i] << 8) | previous[2 * i + 1]);
+                float b = static_cast<float>((current[2 * i] << 8) | current[2 * i + 1]);
+                dst[i] = a * previousWeight + b * currentWeight;
+            }
+        }
+        return;
+    }
+
+    if (previousWeight == 0.0f)
+    {
+        for (size_t i = 0; i < count; i++)
+            dst[i] = current[i] * currentWeight;
+    }
+    else
+    {
+        for (size_t i = 0; i < count; i++)
+            dst[i] = previous[i] * previousWeight + current[i] * currentWeight;
+    }
+}
+
+}
@@ -0,0 +1,81 @@
+#ifndef __DDPFrameSmoother__
+#define __DDPFrameSmoother__
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Frames closer together than this replace the newest one instead of
+// becoming a new pair (several PUSHes read in one cook)
+#define DDP_SMOOTH_MIN_INTERVAL 0.001
+
+// A gap longer than this starts the stream over: no interpolation across it
+#define DDP_SMOOTH_MAX_INTERVAL 1.0
+
+// Weight of a new interval in the frame period estimate
+#define DDP_SMOOTH_PERIOD_WEIGHT 0.25
+
+namespace ddp
+{
+
+// Receive-side smoothing (Interpolate / Hold Time / Fade Time)
+struct SmoothSettings
+{
+    bool interpolate = false;  // blend the last two complete frames by arrival time
+    double holdTime = 0.0;     // seconds before a stale frame fades, 0 = hold forever
+    double fadeTime = 0.0;     // seconds from full to black once the hold is over
+};
+
+// How the next output is made from the two buffered frames
+struct SmoothWeights
+{
+    float previous = 0.0f;     // weight of the older frame, 0 when not interpolating
+    float current = 1.0f;      // weight of the newest frame
+    float fade = 1.0f;         // hold-then-fade gain, already folded into both weights
+    bool blended = false;      // made from the buffered pair, not the caller's frame
+    double age = 0.0;          // seconds since the newest frame arrived
+};
+
+// The last two complete frames and their arrival times, double buffered: a
+// new frame is copied into the older buffer, which then becomes the newest.
+// Frames are only copied when interpolation needs them; otherwise just the
+// arrival times are kept and the caller renders from its own frame.
+class FrameSmoother
+{
+public:
+    FrameSmoother();
+
+    void push(const std::vector<uint8_t>& frame, double arrivalTime, bool keepFrame);
+
+    // Linear blend position from (now - newest arrival) / frame period, and the fade gain
+    SmoothWeights weights(double now, const SmoothSettings& settings) const;
+
+    bool hasFrame() const { return m_frames > 0; }
+    double age(double now) const;
+    double period() const { return m_period; }
+
+    // Valid after push() with keepFrame
+    const std::vector<uint8_t>& previousFrame() const { return m_buffers[m_newest ^ 1]; }
+    const std::vector<uint8_t>& currentFrame() const { return m_buffers[m_newest]; }
+
+    void clear();
+
+private:
+    std::vector<uint8_t> m_buffers[2];
+    int m_newest;
+    int m_frames;                  // complete frames seen since clear(), stops counting at 2
+    bool m_kept[2];                // the buffer holds the frame of its arrival time
+    double m_arrival[2];
+    double m_period;               // smoothed arrival interval, 0 = unknown
+};
+
+// previous * previousWeight + current * currentWeight -> CHOP samples, for
+// 'count' 8-bit or big-endian 16-bit values. The weights carry the sample
+// scale (1/255 for 0-1 output from bytes, and so on); 'previous' is only read
+// when previousWeight is not 0.
+void blendSamples(const uint8_t* previous, const uint8_t* current, size_t count, size_t valueBytes,
+                  float previousWeight, float currentWeight, float* dst);
+
+}
+
+#endif
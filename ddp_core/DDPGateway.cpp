@@ -0,0 +1,188 @@
+#include "DDPGateway.h"
+#include <algorithm>
+#include <cstring>
+
+namespace ddp
+{
+
+DmxGateway::DmxGateway()
+{
+    m_protocol = DmxProtocol::Sacn;
+    m_multicast = false;
+    m_hasPending = false;
+    m_stop = false;
+    m_running = false;
+    m_framesSent = 0;
+    m_framesReplaced = 0;
+    m_packetsSent = 0;
+    m_packetsPadded = 0;
+    makeSacnCid(m_cid);
+}
+
+DmxGateway::~DmxGateway()
+{
+    stop();
+}
+
+bool DmxGateway::start(DmxProtocol protocol, const std::string& address, int port,
+                       std::vector<UniverseMap> universes)
+{
+    stop();
+    m_protocol = protocol;
+    m_multicast = protocol == DmxProtocol::Sacn && address.empty();
+    m_framesSent = 0;
+    m_framesReplaced = 0;
+    m_packetsSent = 0;
+    m_packetsPadded = 0;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_lastError.clear();
+    }
+    std::string error;
+    if (!validateUniverses(universes, protocol, error))
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_lastError = error;
+        return false;
+    }
+    if (port == 0)
+        port = protocol == DmxProtocol::ArtNet ? DDP_ARTNET_PORT : DDP_SACN_PORT;
+
+    // Art-Net without an address is broadcast, sACN is multicast per universe
+    std::string host = address.empty() && protocol == DmxProtocol::ArtNet ? "255.255.255.255" : address;
+    struct sockaddr_storage dest;
+    memset(&dest, 0, sizeof(dest));
+    socklen_t destLength = 0;
+    if (!m_multicast && !parseAddress(host, port, dest, destLength))
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_lastError = "Gateway Address '" + address + "' is not an IP address";
+        return false;
+    }
+    m_destination = m_multicast ? "multicast" : formatAddress(reinterpret_cast<const struct sockaddr*>(&dest));
+
+    if (universes.size() > DDP_GATEWAY_MAX_UNIVERSES)
+        universes.resize(DDP_GATEWAY_MAX_UNIVERSES);
+    m_segmenter.setUniverses(protocol, universes, DDP_GATEWAY_SACN_NAME, m_cid);
+    m_dests.assign(m_multicast ? universes.size() : 1, dest);
+    m_destLengths.assign(m_dests.size(), destLength);
+    for (size_t i = 0; m_multicast && i < universes.size(); i++)
+        parseAddress(sacnMulticastGroup(universes[i].universe), port, m_dests[i], m_destLengths[i]);
+
+    bool opened = m_socket.open(m_multicast ? AF_INET : dest.ss_family);
+    if (opened && protocol == DmxProtocol::ArtNet && address.empty())
+        opened = m_socket.setBroadcast(true);
+    if (opened && m_multicast)
+        opened = m_socket.configureMulticastSend(1, true, "");
+    if (!opened)
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_lastError = m_socket.lastError();
+        m_socket.close();
+        return false;
+    }
+
+    m_hasPending = false;
+    m_stop = false;
+    m_running = true;
+    m_thread = std::thread(&DmxGateway::senderLoop, this);
+    return true;
+}
+
+void DmxGateway::stop()
+{
+    if (!m_running)
+        return;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stop = true;
+    }
+    m_wake.notify_all();
+    if (m_thread.joinable())
+        m_thread.join();
+    m_socket.close();
+    m_running = false;
+}
+
+void DmxGateway::submit(const uint8_t* frame, size_t length)
+{
+    if (!m_running)
+        return;
+    {
+        // Only the bytes some universe reads; assign() reuses the capacity
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_pending.assign(frame, frame + std::min(length, m_segmenter.extent()));
+        if (m_hasPending)
+            m_framesReplaced++;
+        m_hasPending = true;
+    }
+    m_wake.notify_one();
+}
+
+void DmxGateway::senderLoop()
+{
+    std::unique_lock<std::mutex> lock(m_mutex);
+    while (true)
+    {
+        m_wake.wait(lock, [this] { return m_stop || m_hasPending; });
+        if (!m_hasPending)
+            break;
+
+        // Swap buffers so submit() never waits for the sends
+        m_sending.swap(m_pending);
+        m_hasPending = false;
+        lock.unlock();
+        sendFrame(m_sending);
+        lock.lock();
+    }
+}
+
+void DmxGateway::sendFrame(const std::vector<uint8_t>& frame)
+{
+    size_t packetCount = m_segmenter.segment(frame.data(), frame.size());
+    const std::vector<SendSlice>& slices = m_segmenter.slices();
+
+    // One batch to a single destination, one send per group for multicast
+    int64_t bytesSent = 0;
+    size_t sent = 0;
+    if (m_multicast)
+    {
+        for (size_t i = 0; i < packetCount; i++)
+            sent += m_socket.sendSlices(&slices[i], 1, m_dests[i], m_destLengths[i], bytesSent);
+    }
+    else if (packetCount > 0)
+    {
+        sent = m_socket.sendSlices(slices.data(), packetCount, m_dests[0], m_destLengths[0], bytesSent);
+    }
+
+    if (sent < packetCount)
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_lastError = m_socket.lastError();
+    }
+    m_packetsSent += static_cast<int64_t>(sent);
+    m_packetsPadded += static_cast<int64_t>(m_segmenter.padded());
+    m_framesSent++;
+}
+
+std::string DmxGateway::lastError() const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_lastError;
+}
+
+std::string DmxGateway::summary() const
+{
+    if (!m_running)
+        return lastError().empty() ? "off" : "failed: " + lastError();
+    std::string text = std::string(m_protocol == DmxProtocol::ArtNet ? "Art-Net" : "sACN") + " to " + m_destination +
+                       ", " + std::to_string(m_segmenter.universes().size()) + " universes: " +
+                       std::to_string(m_framesSent) + " frames, " + std::to_string(m_packetsSent) + " packets (" +
+                       std::to_string(m_packetsPadded) + " padded), " + std::to_string(m_framesReplaced) + " replaced";
+    std::string error = lastError();
+    if (!error.empty())
+        text += " (" + error + ")";
+    return text;
+}
+
+}
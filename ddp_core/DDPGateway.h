@@ -0,0 +1,91 @@
+#ifndef __DDPGateway__
+#define __DDPGateway__
+
+#include "DDPDmx.h"
+#include "DDPSocket.h"
+
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Most universes one gateway forwards
+#define DDP_GATEWAY_MAX_UNIVERSES 512
+
+// Source name in the sACN packets of the DDP In gateway
+#define DDP_GATEWAY_SACN_NAME "TouchDesigner DDP In"
+
+namespace ddp
+{
+
+// Forwards complete DDP frames as Art-Net or sACN universes from a sender
+// thread. submit() only copies the mapped bytes and wakes the thread, so it
+// is safe to call from a cook; a frame still waiting is replaced by the next.
+// The packets are cut by a DmxSegmenter and sent with UdpSocket::sendSlices().
+class DmxGateway
+{
+public:
+    DmxGateway();
+    ~DmxGateway();
+
+    DmxGateway(const DmxGateway&) = delete;
+    DmxGateway& operator=(const DmxGateway&) = delete;
+
+    // Opens the socket and starts the sender thread. An empty 'address' sends
+    // sACN to each universe's multicast group and Art-Net to the broadcast
+    // address; 'port' 0 is the protocol's own. Fails on universes that do not
+    // pass validateUniverses(); the reason is in lastError() and summary().
+    bool start(DmxProtocol protocol, const std::string& address, int port, std::vector<UniverseMap> universes);
+
+    // Sends what is pending, then stops the thread and closes the socket
+    void stop();
+
+    bool isRunning() const { return m_running; }
+
+    void submit(const uint8_t* frame, size_t length);
+
+    int64_t framesSent() const { return m_framesSent; }
+    int64_t framesReplaced() const { return m_framesReplaced; }
+    int64_t packetsSent() const { return m_packetsSent; }
+    int64_t packetsPadded() const { return m_packetsPadded; }
+    std::string lastError() const;
+
+    // "Art-Net to 10.0.0.20, 4 universes: N frames, N packets (N padded), N replaced"
+    std::string summary() const;
+
+private:
+    void senderLoop();
+    void sendFrame(const std::vector<uint8_t>& frame);
+
+    DmxProtocol m_protocol;
+    std::string m_destination;              // for the summary
+    std::vector<struct sockaddr_storage> m_dests;   // one per universe when multicast, else one
+    std::vector<socklen_t> m_destLengths;
+    bool m_multicast;
+    uint8_t m_cid[DDP_SACN_CID_SIZE];
+    UdpSocket m_socket;
+
+    // Sender thread state
+    DmxSegmenter m_segmenter;
+    std::vector<uint8_t> m_sending;
+
+    mutable std::mutex m_mutex;
+    std::condition_variable m_wake;
+    std::vector<uint8_t> m_pending;         // guarded by m_mutex
+    bool m_hasPending;
+    bool m_stop;
+    std::string m_lastError;
+    std::thread m_thread;
+    bool m_running;
+
+    std::atomic<int64_t> m_framesSent;
+    std::atomic<int64_t> m_framesReplaced;
+    std::atomic<int64_t> m_packetsSent;
+    std::atomic<int64_t> m_packetsPadded;
+};
+
+}
+
+#endif
@@ -0,0 +1,194 @@
+#include "DDPLayout.h"
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+
+namespace ddp
+{
+
+namespace
+{
+    const char* skipSeparators(const char* text)
+    {
+        while (*text == ' ' || *text == '\t' || *text == ',' || *text == ';')
+            text++;
+        return text;
+    }
+
+    bool startsWith(const char* text, const char* word)
+    {
+        size_t length = strlen(word);
+        if (strncmp(text, word, length) != 0)
+            return false;
+        char next = text[length];
+        return next == '\0' || next == ' ' || next == '\t' || next == ',' || next == ';';
+    }
+}
+
+bool parseLayoutSegment(const char* mode, const char* count, LayoutSegment& segment)
+{
+    if (!mode || !count)
+        return false;
+    mode = skipSeparators(mode);
+    if (startsWith(mode, "forward"))
+        segment.kind = LayoutSegment::Kind::Forward;
+    else if (startsWith(mode, "reverse"))
+        segment.kind = LayoutSegment::Kind::Reverse;
+    else if (startsWith(mode, "skip"))
+        segment.kind = LayoutSegment::Kind::Skip;
+    else if (startsWith(mode, "dummy"))
+        segment.kind = LayoutSegment::Kind::Dummy;
+    else
+        return false;
+
+    count = skipSeparators(count);
+    char* end = nullptr;
+    long value = strtol(count, &end, 10);
+    if (end == count || value < 0)
+        return false;
+    segment.count = static_cast<uint32_t>(std::min<long>(value, DDP_LAYOUT_MAX_PIXELS));
+    return true;
+}
+
+std::string LayoutSettings::key() const
+{
+    std::string key = std::to_string(width) + "x" + std::to_string(height);
+    key += columns ? "c" : "r";
+    key += serpentine ? "s" : "l";
+    key += std::to_string(static_cast<int>(start));
+    for (const LayoutSegment& segment : segments)
+        key += ":" + std::to_string(static_cast<int>(segment.kind)) + "/" + std::to_string(segment.count);
+    return key;
+}
+
+LedLayout::LedLayout()
+{
+    m_sourcePixels = 0;
+    m_blanks = 0;
+    m_skipped = 0;
+}
+
+void LedLayout::compile(const LayoutSettings& settings, size_t sourcePixels)
+{
+    std::string key = settings.key();
+    if (key == m_key && sourcePixels == m_sourcePixels)
+        return;
+    m_key = key;
+    m_sourcePixels = sourcePixels;
+
+    // Matrix order: walk the runs from the start corner, then append any
+    // source pixels the matrix does not cover
+    std::vector<uint32_t> order;
+    const uint64_t cells = std::min<uint64_t>(static_cast<uint64_t>(settings.width) * settings.height,
+                                              DDP_LAYOUT_MAX_PIXELS);
+    const size_t source = std::min<size_t>(sourcePixels, DDP_LAYOUT_MAX_PIXELS);
+    order.reserve(std::max<size_t>(static_cast<size_t>(cells), source));
+    if (cells > 0)
+    {
+        const uint32_t width = settings.width;
+        const uint32_t height = settings.height;
+        const uint32_t runLength = settings.columns ? height : width;
+        const bool fromRight = settings.start == LayoutCorner::BottomRight || settings.start == LayoutCorner::TopRight;
+        const bool fromTop = settings.start == LayoutCorner::TopLeft || settings.start == LayoutCorner::TopRight;
+        for (uint64_t k = 0; k < cells; k++)
+        {
+            uint32_t run = static_cast<uint32_t>(k / runLength);
+            uint32_t position = static_cast<uint32_t>(k % runLength);
+            if (settings.serpentine && (run & 1))
+                position = runLength - 1 - position;
+
+            uint32_t x = settings.columns ? run : position;
+            uint32_t y = settings.columns ? position : run;
+            if (fromRight)
+                x = width - 1 - x;
+            if (fromTop)
+                y = height - 1 - y;
+
+            uint64_t index = static_cast<uint64_t>(y) * width + x;
+            order.push_back(index < source ? static_cast<uint32_t>(index) : DDP_LAYOUT_BLANK);
+        }
+    }
+    for (size_t i = static_cast<size_t>(cells); i < source; i++)
+        order.push_back(static_cast<uint32_t>(i));
+
+    // Segments consume the matrix order from the front
+    m_indices.clear();
+    m_skipped = 0;
+    size_t cursor = 0;
+    auto take = [&order, &cursor](size_t offset) {
+        size_t position = cursor + offset;
+        return position < order.size() ? order[position] : DDP_LAYOUT_BLANK;
+    };
+    for (const LayoutSegment& segment : settings.segments)
+    {
+        size_t room = DDP_LAYOUT_MAX_PIXELS - m_indices.size();
+        size_t count = segment.count;
+        switch (segment.kind)
+        {
+            case LayoutSegment::Kind::Forward:
+                count = std::min(count, room);
+                for (size_t i = 0; i < count; i++)
+                    m_indices.push_back(take(i));
+                cursor += count;
+                break;
+            case LayoutSegment::Kind::Reverse:
+                count = std::min(count, room);
+                for (size_t i = count; i > 0; i--)
+                    m_indices.push_back(take(i - 1));
+                cursor += count;
+                break;
+            case LayoutSegment::Kind::Skip:
+                for (size_t i = 0; i < count; i++)
+                    m_skipped += take(i) != DDP_LAYOUT_BLANK ? 1 : 0;
+                cursor += count;
+                break;
+            case LayoutSegment::Kind::Dummy:
+                m_indices.insert(m_indices.end(), std::min(count, room), DDP_LAYOUT_BLANK);
+                break;
+        }
+    }
+    for (; cursor < order.size() && m_indices.size() < DDP_LAYOUT_MAX_PIXELS; cursor++)
+        m_indices.push_back(order[cursor]);
+
+    m_blanks = static_cast<size_t>(std::count(m_indices.begin(), m_indices.end(), DDP_LAYOUT_BLANK));
+    buildRuns();
+}
+
+void LedLayout::buildRuns()
+{
+    m_runs.clear();
+    size_t i = 0;
+    while (i < m_indices.size())
+    {
+        LayoutRun run;
+        run.source = m_indices[i];
+        run.count = 1;
+        run.order = 0;
+        run.step = run.source == DDP_LAYOUT_BLANK ? 0 : 1;
+        if (run.step != 0 && i + 1 < m_indices.size() && m_indices[i + 1] != DDP_LAYOUT_BLANK &&
+            m_indices[i + 1] + 1 == run.source)
+            run.step = -1;
+        while (i + run.count < m_indices.size())
+        {
+            // A reversed run ends at source pixel 0
+            if (run.step < 0 && run.count > run.source)
+                break;
+            uint32_t next = m_indices[i + run.count];
+            uint32_t expected = run.step == 0 ? DDP_LAYOUT_BLANK
+                              : run.source + static_cast<uint32_t>(run.step) * run.count;
+            if (next != expected)
+                break;
+            run.count++;
+        }
+        if (run.step < 0)
+            run.source -= run.count - 1;
+        i += run.count;
+        m_runs.push_back(run);
+    }
+
+    // Short runs cost more in per-run overhead than the index gather
+    if (m_runs.size() * 8 > m_indices.size())
+        m_runs.clear();
+}
+
+}
@@ -0,0 +1,102 @@
+#ifndef __DDPLayout__
+#define __DDPLayout__
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Gather table entry for a pixel that has no source (sent black)
+#define DDP_LAYOUT_BLANK 0xFFFFFFFFu
+
+// Upper bound on the compiled table, so a typo in a segment count cannot
+// allocate gigabytes
+#define DDP_LAYOUT_MAX_PIXELS (1u << 24)
+
+namespace ddp
+{
+
+enum class LayoutCorner
+{
+    BottomLeft,
+    BottomRight,
+    TopLeft,
+    TopRight
+};
+
+// One run of the physical strip, in wire order
+struct LayoutSegment
+{
+    enum class Kind
+    {
+        Forward,    // the next 'count' pixels as they are
+        Reverse,    // the next 'count' pixels, last one first
+        Skip,       // the next 'count' pixels are not wired, drop them
+        Dummy       // 'count' black pixels that take no source pixel
+    };
+    Kind kind;
+    uint32_t count;
+};
+
+// A "mode count" row ("reverse 30", "dummy,2"); false for headers and blank rows
+bool parseLayoutSegment(const char* mode, const char* count, LayoutSegment& segment);
+
+struct LayoutSettings
+{
+    // Matrix of source pixels numbered row by row from the bottom-left, like
+    // a TOP converted to a CHOP. 0 x 0 keeps the source order.
+    uint32_t width = 0;
+    uint32_t height = 0;
+    bool columns = false;       // the strip runs up/down columns instead of along rows
+    bool serpentine = false;    // every other row (or column) runs back the other way
+    LayoutCorner start = LayoutCorner::BottomLeft;
+
+    // Applied to the matrix order; pixels after the last segment follow unchanged
+    std::vector<LayoutSegment> segments;
+
+    // Cache key: two settings with the same key compile to the same table
+    std::string key() const;
+};
+
+// Consecutive wire pixels that read a contiguous block of source pixels,
+// forwards or backwards, or are all blank
+struct LayoutRun
+{
+    uint32_t source;    // first source pixel read (the lowest one for a reversed run)
+    uint32_t count;
+    int32_t step;       // +1 forward, -1 reversed, 0 blank
+    uint16_t order;     // color order of the run (see convertRuns())
+};
+
+// Wire order -> source pixel index, compiled once per layout and source size
+// so reordering happens inside the conversion pass (see convertGathered())
+class LedLayout
+{
+public:
+    LedLayout();
+
+    // Rebuild when the settings or the source pixel count differ from the last call
+    void compile(const LayoutSettings& settings, size_t sourcePixels);
+
+    const uint32_t* indices() const { return m_indices.data(); }
+    size_t size() const { return m_indices.size(); }    // pixels on the wire
+    size_t blanks() const { return m_blanks; }          // dummies and matrix cells past the source
+    size_t skipped() const { return m_skipped; }
+
+    // The same table as runs; empty when the order is too scattered for runs to pay off
+    const std::vector<LayoutRun>& runs() const { return m_runs; }
+
+private:
+    void buildRuns();
+
+    std::vector<uint32_t> m_indices;
+    std::vector<LayoutRun> m_runs;
+    std::string m_key;
+    size_t m_sourcePixels;
+    size_t m_blanks;
+    size_t m_skipped;
+};
+
+}
+
+#endif
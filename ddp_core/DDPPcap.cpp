@@ -0,0 +1,675 @@
+#include "DDPPcap.h"
+#include <algorithm>
+#include <cerrno>
+#include <cmath>
+#include <cstring>
+
+// Larger records or blocks are taken as corruption rather than allocated
+#define DDP_PCAP_MAX_RECORD (16 * 1024 * 1024)
+
+#define DDP_PCAPNG_IDB 0x00000001u
+#define DDP_PCAPNG_SPB 0x00000003u
+#define DDP_PCAPNG_EPB 0x00000006u
+#define DDP_PCAPNG_OPT_TSRESOL 9
+
+#define DDP_ETHERTYPE_IPV4 0x0800
+#define DDP_ETHERTYPE_IPV6 0x86DD
+#define DDP_IP_PROTO_UDP   17
+
+namespace ddp
+{
+
+namespace
+{
+    uint16_t readBE16(const uint8_t* p)
+    {
+        return static_cast<uint16_t>((p[0] << 8) | p[1]);
+    }
+
+    void writeBE16(uint8_t* p, uint16_t v)
+    {
+        p[0] = static_cast<uint8_t>(v >> 8);
+        p[1] = static_cast<uint8_t>(v);
+    }
+
+    void writeLE32(uint8_t* p, uint32_t v)
+    {
+        for (int i = 0; i < 4; i++)
+            p[i] = static_cast<uint8_t>(v >> (8 * i));
+    }
+
+    uint16_t portOf(const struct sockaddr_storage& addr)
+    {
+        if (addr.ss_family == AF_INET)
+            return ntohs(reinterpret_cast<const struct sockaddr_in*>(&addr)->sin_port);
+        if (addr.ss_family == AF_INET6)
+            return ntohs(reinterpret_cast<const struct sockaddr_in6*>(&addr)->sin6_port);
+        return 0;
+    }
+
+    // Ones' complement sum used by the IPv4 header and UDP checksums
+    uint32_t checksumAdd(uint32_t sum, const uint8_t* data, size_t length)
+    {
+        for (size_t i = 0; i + 1 < length; i += 2)
+            sum += readBE16(data + i);
+        if (length & 1)
+            sum += static_cast<uint32_t>(data[length - 1]) << 8;
+        return sum;
+    }
+
+    uint16_t checksumFinish(uint32_t sum)
+    {
+        while (sum >> 16)
+            sum = (sum & 0xFFFF) + (sum >> 16);
+        return static_cast<uint16_t>(~sum);
+    }
+
+    bool decodeUdp(const uint8_t* p, size_t length, CapturedPacket& packet)
+    {
+        if (length < 8)
+            return false;
+        size_t udpLength = readBE16(p + 4);
+        size_t available = length - 8;
+        if (udpLength >= 8 && udpLength - 8 < available)
+            available = udpLength - 8;    // drop Ethernet padding
+        packet.destPort = readBE16(p + 2);
+        setPort(packet.source, readBE16(p));
+        packet.payload = p + 8;
+        packet.length = available;
+        return true;
+    }
+
+    bool decodeIPv4(const uint8_t* p, size_t length, CapturedPacket& packet)
+    {
+        if (length < 20)
+            return false;
+        size_t headerLength = static_cast<size_t>(p[0] & 0x0F) * 4;
+        size_t totalLength = readBE16(p + 2);
+        if (headerLength < 20 || headerLength > length || p[9] != DDP_IP_PROTO_UDP)
+            return false;
+        if ((readBE16(p + 6) & 0x3FFF) != 0)
+            return false;    // fragment (more fragments bit or an offset), not reassembled
+        if (totalLength >= headerLength && totalLength < length)
+            length = totalLength;
+
+        memset(&packet.source, 0, sizeof(packet.source));
+        struct sockaddr_in* source = reinterpret_cast<struct sockaddr_in*>(&packet.source);
+        source->sin_family = AF_INET;
+        memcpy(&source->sin_addr, p + 12, 4);
+        return decodeUdp(p + headerLength, length - headerLength, packet);
+    }
+
+    bool decodeIPv6(const uint8_t* p, size_t length, CapturedPacket& packet)
+    {
+        if (length < 40)
+            return false;
+        size_t payloadLength = readBE16(p + 4);
+        if (payloadLength > 0 && 40 + payloadLength < length)
+            length = 40 + payloadLength;
+
+        // Walk hop-by-hop, routing and destination option headers
+        uint8_t nextHeader = p[6];
+        size_t offset = 40;
+        while (nextHeader == 0 || nextHeader == 43 || nextHeader == 60)
+        {
+            if (offset + 8 > length)
+                return false;
+            nextHeader = p[offset];
+            offset += (static_cast<size_t>(p[offset + 1]) + 1) * 8;
+        }
+        if (nextHeader != DDP_IP_PROTO_UDP || offset > length)
+            return false;
+
+        memset(&packet.source, 0, sizeof(packet.source));
+        struct sockaddr_in6* source = reinterpret_cast<struct sockaddr_in6*>(&packet.source);
+        source->sin6_family = AF_INET6;
+        memcpy(&source->sin6_addr, p + 8, 16);
+        return decodeUdp(p + offset, length - offset, packet);
+    }
+
+    bool decodeIP(const uint8_t* p, size_t length, CapturedPacket& packet)
+    {
+        if (length < 1)
+            return false;
+        if ((p[0] >> 4) == 4)
+            return decodeIPv4(p, length, packet);
+        if ((p[0] >> 4) == 6)
+            return decodeIPv6(p, length, packet);
+        return false;
+    }
+
+    bool decodeEtherType(uint16_t etherType, const uint8_t* p, size_t length, CapturedPacket& packet)
+    {
+        if (etherType == DDP_ETHERTYPE_IPV4)
+            return decodeIPv4(p, length, packet);
+        if (etherType == DDP_ETHERTYPE_IPV6)
+            return decodeIPv6(p, length, packet);
+        return false;
+    }
+
+    bool decodeLink(int linkType, const uint8_t* p, size_t length, CapturedPacket& packet)
+    {
+        switch (linkType)
+        {
+            case DDP_LINKTYPE_NULL:
+            case DDP_LINKTYPE_LOOP:
+                // 4-byte address family in either byte order, the IP version says the same
+                return length > 4 && decodeIP(p + 4, length - 4, packet);
+            case DDP_LINKTYPE_RAW:
+            case DDP_LINKTYPE_RAW_OLD:
+            case DDP_LINKTYPE_IPV4:
+            case DDP_LINKTYPE_IPV6:
+                return decodeIP(p, length, packet);
+            case DDP_LINKTYPE_ETHERNET:
+            {
+                if (length < 14)
+                    return false;
+                size_t offset = 14;
+                uint16_t etherType = readBE16(p + 12);
+                while (etherType == 0x8100 || etherType == 0x88A8 || etherType == 0x9100)
+                {
+                    if (offset + 4 > length)
+                        return false;
+                    etherType = readBE16(p + offset + 2);
+                    offset += 4;
+                }
+                return decodeEtherType(etherType, p + offset, length - offset, packet);
+            }
+            case DDP_LINKTYPE_LINUX_SLL:
+                return length >= 16 && decodeEtherType(readBE16(p + 14), p + 16, length - 16, packet);
+            case DDP_LINKTYPE_LINUX_SLL2:
+                return length >= 20 && decodeEtherType(readBE16(p), p + 20, length - 20, packet);
+        }
+        return false;
+    }
+}
+
+// PcapReader
+
+PcapReader::PcapReader()
+{
+    m_file = nullptr;
+    m_pcapng = false;
+    m_bigEndian = false;
+    m_linkType = DDP_LINKTYPE_ETHERNET;
+    m_tickSeconds = 1e-6;
+    m_lastTimestamp = 0.0;
+    m_packetsRead = 0;
+    m_packetsSkipped = 0;
+    m_bytesRead = 0;
+}
+
+PcapReader::~PcapReader()
+{
+    close();
+}
+
+bool PcapReader::open(const std::string& path)
+{
+    close();
+    m_path = path;
+
+    m_file = fopen(path.c_str(), "rb");
+    if (!m_file)
+    {
+        m_lastError = "Cannot open " + path + ": " + strerror(errno);
+        return false;
+    }
+    if (!readHeader())
+    {
+        std::string error = m_lastError;
+        close();
+        m_lastError = error;
+        return false;
+    }
+
+    m_lastError = "";
+    return true;
+}
+
+void PcapReader::close()
+{
+    if (m_file)
+        fclose(m_file);
+    m_file = nullptr;
+    m_interfaces.clear();
+    m_packetsRead = 0;
+    m_packetsSkipped = 0;
+    m_bytesRead = 0;
+}
+
+bool PcapReader::rewind()
+{
+    if (!m_file)
+        return false;
+    if (fseek(m_file, 0, SEEK_SET) != 0)
+    {
+        m_lastError = "Cannot rewind " + m_path;
+        return false;
+    }
+    m_interfaces.clear();
+    m_lastTimestamp = 0.0;
+    return readHeader();
+}
+
+uint16_t PcapReader::get16(const uint8_t* p) const
+{
+    return m_bigEndian ? readBE16(p) : static_cast<uint16_t>(p[0] | (p[1] << 8));
+}
+
+uint32_t PcapReader::get32(const uint8_t* p) const
+{
+    if (m_bigEndian)
+        return (static_cast<uint32_t>(p[0]) << 24) | (static_cast<uint32_t>(p[1]) << 16) |
+               (static_cast<uint32_t>(p[2]) << 8) | p[3];
+    return (static_cast<uint32_t>(p[3]) << 24) | (static_cast<uint32_t>(p[2]) << 16) |
+           (static_cast<uint32_t>(p[1]) << 8) | p[0];
+}
+
+bool PcapReader::readExact(void* buffer, size_t length)
+{
+    if (fread(buffer, 1, length, m_file) != length)
+        return false;
+    m_bytesRead += static_cast<int64_t>(length);
+    return true;
+}
+
+bool PcapReader::readHeader()
+{
+    uint8_t magic[4];
+    if (!readExact(magic, sizeof(magic)))
+    {
+        m_lastError = m_path + " is not a capture file";
+        return false;
+    }
+
+    // pcapng starts with a section header block; its byte order is read with the block
+    m_bigEndian = false;
+    if (get32(magic) == DDP_PCAPNG_SHB)
+    {
+        m_pcapng = true;
+        if (fseek(m_file, 0, SEEK_SET) != 0)
+            return false;
+        m_bytesRead -= static_cast<int64_t>(sizeof(magic));
+        return true;
+    }
+
+    m_pcapng = false;
+    uint32_t value = get32(magic);
+    if (value != DDP_PCAP_MAGIC_US && value != DDP_PCAP_MAGIC_NS)
+    {
+        m_bigEndian = true;
+        value = get32(magic);
+    }
+    if (value != DDP_PCAP_MAGIC_US && value != DDP_PCAP_MAGIC_NS)
+    {
+        m_lastError = m_path + " is not a pcap or pcapng file";
+        return false;
+    }
+    m_tickSeconds = (value == DDP_PCAP_MAGIC_NS) ? 1e-9 : 1e-6;
+
+    // version, thiszone, sigfigs, snaplen, link type
+    uint8_t header[20];
+    if (!readExact(header, sizeof(header)))
+    {
+        m_lastError = m_path + " is truncated";
+        return false;
+    }
+    m_linkType = static_cast<int>(get32(header + 16) & 0xFFFF);
+    return true;
+}
+
+bool PcapReader::readFrame(const uint8_t*& frame, size_t& length, int& linkType, double& timestamp)
+{
+    if (!m_pcapng)
+        return readPcapRecord(frame, length, linkType, timestamp);
+
+    bool isPacket = false;
+    while (!isPacket)
+    {
+        if (!readPcapNgBlock(frame, length, linkType, timestamp, isPacket))
+            return false;
+    }
+    return true;
+}
+
+bool PcapReader::readPcapRecord(const uint8_t*& frame, size_t& length, int& linkType, double& timestamp)
+{
+    uint8_t header[16];
+    if (!readExact(header, sizeof(header)))
+        return false;
+
+    uint32_t captured = get32(header + 8);
+    if (captured > DDP_PCAP_MAX_RECORD)
+    {
+        m_lastError = "Corrupt record in " + m_path;
+        return false;
+    }
+    if (m_buffer.size() < captured)
+        m_buffer.resize(captured);
+    if (!readExact(m_buffer.data(), captured))
+        return false;
+
+    frame = m_buffer.data();
+    length = captured;
+    linkType = m_linkType;
+    timestamp = get32(header) + get32(header + 4) * m_tickSeconds;
+    return true;
+}
+
+bool PcapReader::readPcapNgBlock(const uint8_t*& frame, size_t& length, int& linkType, double& timestamp,
+                                 bool& isPacket)
+{
+    isPacket = false;
+
+    uint8_t header[8];
+    if (!readExact(header, sizeof(header)))
+        return false;
+
+    // A section header switches byte order and starts a new interface list
+    uint32_t type = get32(header);
+    if (type == DDP_PCAPNG_SHB)
+    {
+        uint8_t order[4];
+        if (!readExact(order, sizeof(order)))
+            return false;
+        m_bigEndian = false;
+        if (get32(order) != DDP_PCAPNG_BYTE_ORDER)
+            m_bigEndian = true;
+        if (get32(order) != DDP_PCAPNG_BYTE_ORDER)
+        {
+            m_lastError = m_path + " has a corrupt section header";
+            return false;
+        }
+        m_interfaces.clear();
+
+        uint32_t blockLength = get32(header + 4);
+        if (blockLength < 28 || blockLength > DDP_PCAP_MAX_RECORD || (blockLength & 3))
+        {
+            m_lastError = m_path + " has a corrupt section header";
+            return false;
+        }
+        if (m_buffer.size() < blockLength)
+            m_buffer.resize(blockLength);
+        return readExact(m_buffer.data(), blockLength - 12);
+    }
+
+    uint32_t blockLength = get32(header + 4);
+    if (blockLength < 12 || blockLength > DDP_PCAP_MAX_RECORD || (blockLength & 3))
+    {
+        m_lastError = "Corrupt block in " + m_path;
+        return false;
+    }
+    if (m_buffer.size() < blockLength)
+        m_buffer.resize(blockLength);
+    if (!readExact(m_buffer.data(), blockLength - 8))
+        return false;
+
+    const uint8_t* body = m_buffer.data();
+    size_t bodyLength = blockLength - 12;    // without the trailing length copy
+
+    if (type == DDP_PCAPNG_IDB)
+    {
+        addInterface(body, bodyLength);
+    }
+    else if (type == DDP_PCAPNG_EPB && bodyLength >= 20)
+    {
+        uint32_t interfaceId = get32(body);
+        uint32_t captured = get32(body + 12);
+        if (interfaceId >= m_interfaces.size() || captured > bodyLength - 20)
+            return true;    // skipped, not fatal
+        const Interface& iface = m_interfaces[interfaceId];
+        double ticks = static_cast<double>((static_cast<uint64_t>(get32(body + 4)) << 32) | get32(body + 8));
+        m_lastTimestamp = ticks * iface.tickSeconds;
+
+        frame = body + 20;
+        length = captured;
+        linkType = iface.linkType;
+        timestamp = m_lastTimestamp;
+        isPacket = true;
+    }
+    else if (type == DDP_PCAPNG_SPB && bodyLength >= 4 && !m_interfaces.empty())
+    {
+        // No timestamp: keep the previous one so capture-timing replay does not stall
+        frame = body + 4;
+        length = std::min(static_cast<size_t>(get32(body)), bodyLength - 4);
+        linkType = m_interfaces[0].linkType;
+        timestamp = m_lastTimestamp;
+        isPacket = true;
+    }
+    return true;
+}
+
+void PcapReader::addInterface(const uint8_t* body, size_t bodyLength)
+{
+    Interface iface;
+    iface.linkType = -1;
+    iface.tickSeconds = 1e-6;
+    if (bodyLength >= 8)
+    {
+        iface.linkType = get16(body);
+
+        // Options: code, length, value padded to 32 bits
+        size_t offset = 8;
+        while (offset + 4 <= bodyLength)
+        {
+            uint16_t code = get16(body + offset);
+            uint16_t optionLength = get16(body + offset + 2);
+            offset += 4;
+            if (code == 0 || offset + optionLength > bodyLength)
+                break;
+            if (code == DDP_PCAPNG_OPT_TSRESOL && optionLength >= 1)
+            {
+                uint8_t resolution = body[offset];
+                iface.tickSeconds = (resolution & 0x80) ? std::ldexp(1.0, -(resolution & 0x7F))
+                                                        : std::pow(10.0, -static_cast<double>(resolution));
+            }
+            offset += (optionLength + 3u) & ~3u;
+        }
+    }
+    m_interfaces.push_back(iface);
+}
+
+bool PcapReader::next(CapturedPacket& packet, int port)
+{
+    if (!m_file)
+        return false;
+
+    const uint8_t* frame = nullptr;
+    size_t length = 0;
+    int linkType = 0;
+    double timestamp = 0.0;
+    while (readFrame(frame, length, linkType, timestamp))
+    {
+        if (decodeLink(linkType, frame, length, packet) && (port == 0 || packet.destPort == port))
+        {
+            packet.timestamp = timestamp;
+            m_packetsRead++;
+            return true;
+        }
+        m_packetsSkipped++;
+    }
+    return false;
+}
+
+// PcapWriter
+
+PcapWriter::PcapWriter()
+{
+    m_file = nullptr;
+    m_packetsWritten = 0;
+}
+
+PcapWriter::~PcapWriter()
+{
+    close();
+}
+
+bool PcapWriter::open(const std::string& path)
+{
+    close();
+    m_path = path;
+    m_packetsWritten = 0;
+
+    m_file = fopen(path.c_str(), "wb");
+    if (!m_file)
+    {
+        m_lastError = "Cannot create " + path + ": " + strerror(errno);
+        return false;
+    }
+
+    // Little-endian microsecond pcap, version 2.4, raw IP link
+    uint8_t header[24] = {};
+    writeLE32(header, DDP_PCAP_MAGIC_US);
+    header[4] = 2;
+    header[6] = 4;
+    writeLE32(header + 16, DDP_PCAP_SNAPLEN);
+    writeLE32(header + 20, DDP_LINKTYPE_RAW);
+    if (fwrite(header, 1, sizeof(header), m_file) != sizeof(header))
+    {
+        m_lastError = "Cannot write " + path + ": " + strerror(errno);
+        close();
+        return false;
+    }
+
+    m_lastError = "";
+    return true;
+}
+
+void PcapWriter::close()
+{
+    if (m_file)
+        fclose(m_file);
+    m_file = nullptr;
+}
+
+bool PcapWriter::writeDatagram(const struct sockaddr_storage& source, const struct sockaddr_storage& dest,
+                               const uint8_t* part1, size_t length1, const uint8_t* part2, size_t length2,
+                               double timestamp)
+{
+    if (!m_file)
+        return false;
+
+    // IPv4-mapped destinations (dual-stack sockets) are written as IPv4
+    uint8_t destAddr[16] = {};
+    uint8_t sourceAddr[16] = {};
+    bool ipv4 = true;
+    if (dest.ss_family == AF_INET)
+    {
+        memcpy(destAddr, &reinterpret_cast<const struct sockaddr_in*>(&dest)->sin_addr, 4);
+    }
+    else
+    {
+        const uint8_t* addr = reinterpret_cast<const uint8_t*>(&reinterpret_cast<const struct sockaddr_in6*>(&dest)->sin6_addr);
+        static const uint8_t mappedPrefix[12] = {0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0xFF, 0xFF};
+        ipv4 = memcmp(addr, mappedPrefix, 12) == 0;
+        memcpy(destAddr, ipv4 ? addr + 12 : addr, ipv4 ? 4 : 16);
+    }
+    if (source.ss_family == AF_INET && ipv4)
+    {
+        memcpy(sourceAddr, &reinterpret_cast<const struct sockaddr_in*>(&source)->sin_addr, 4);
+    }
+    else if (source.ss_family == AF_INET6)
+    {
+        const uint8_t* addr = reinterpret_cast<const uint8_t*>(&reinterpret_cast<const struct sockaddr_in6*>(&source)->sin6_addr);
+        if (!ipv4)
+            memcpy(sourceAddr, addr, 16);
+        else if (addr[10] == 0xFF && addr[11] == 0xFF)
+            memcpy(sourceAddr, addr + 12, 4);
+    }
+    uint16_t sourcePort = portOf(source);
+    uint16_t destPort = portOf(dest);
+
+    size_t ipHeaderLength = ipv4 ? 20 : 40;
+    size_t udpLength = 8 + length1 + length2;
+    if (udpLength > 65535 - (ipv4 ? ipHeaderLength : 0))
+    {
+        m_lastError = "Datagram too large for pcap";
+        return false;
+    }
+    size_t packetLength = ipHeaderLength + udpLength;
+
+    m_scratch.resize(16 + ipHeaderLength + 8);
+    uint8_t* record = m_scratch.data();
+    uint8_t* ip = record + 16;
+    uint8_t* udp = ip + ipHeaderLength;
+    memset(ip, 0, ipHeaderLength);
+
+    // Pseudo-header part of the UDP checksum
+    uint32_t sum = 0;
+    if (ipv4)
+    {
+        ip[0] = 0x45;
+        writeBE16(ip + 2, static_cast<uint16_t>(packetLength));
+        writeBE16(ip + 4, static_cast<uint16_t>(m_packetsWritten));
+        writeBE16(ip + 6, 0x4000);    // don't fragment
+        ip[8] = 64;
+        ip[9] = DDP_IP_PROTO_UDP;
+        memcpy(ip + 12, sourceAddr, 4);
+        memcpy(ip + 16, destAddr, 4);
+        writeBE16(ip + 10, checksumFinish(checksumAdd(0, ip, 20)));
+        sum = checksumAdd(sum, ip + 12, 8);
+    }
+    else
+    {
+        ip[0] = 0x60;
+        writeBE16(ip + 4, static_cast<uint16_t>(udpLength));
+        ip[6] = DDP_IP_PROTO_UDP;
+        ip[7] = 64;
+        memcpy(ip + 8, sourceAddr, 16);
+        memcpy(ip + 24, destAddr, 16);
+        sum = checksumAdd(sum, ip + 8, 32);
+    }
+    sum += DDP_IP_PROTO_UDP + static_cast<uint32_t>(udpLength);
+
+    writeBE16(udp, sourcePort);
+    writeBE16(udp + 2, destPort);
+    writeBE16(udp + 4, static_cast<uint16_t>(udpLength));
+    writeBE16(udp + 6, 0);
+    sum = checksumAdd(sum, udp, 8);
+
+    // Odd-length first parts shift the byte pairing of the second
+    if (length1 & 1)
+    {
+        m_scratch.insert(m_scratch.end(), part1, part1 + length1);
+        m_scratch.insert(m_scratch.end(), part2, part2 + length2);
+        sum = checksumAdd(sum, m_scratch.data() + 16 + ipHeaderLength + 8, length1 + length2);
+    }
+    else
+    {
+        sum = checksumAdd(sum, part1, length1);
+        if (length2 > 0)
+            sum = checksumAdd(sum, part2, length2);
+    }
+    uint16_t checksum = checksumFinish(sum);
+    udp = m_scratch.data() + 16 + ipHeaderLength;
+    writeBE16(udp + 6, checksum == 0 ? 0xFFFF : checksum);
+
+    double seconds = std::floor(timestamp);
+    record = m_scratch.data();
+    writeLE32(record, static_cast<uint32_t>(seconds));
+    writeLE32(record + 4, static_cast<uint32_t>((timestamp - seconds) * 1e6));
+    writeLE32(record + 8, static_cast<uint32_t>(packetLength));
+    writeLE32(record + 12, static_cast<uint32_t>(packetLength));
+
+    bool ok;
+    if (m_scratch.size() > 16 + ipHeaderLength + 8)
+    {
+        ok = fwrite(m_scratch.data(), 1, m_scratch.size(), m_file) == m_scratch.size();
+    }
+    else
+    {
+        ok = fwrite(m_scratch.data(), 1, m_scratch.size(), m_file) == m_scratch.size() &&
+             (length1 == 0 || fwrite(part1, 1, length1, m_file) == length1) &&
+             (length2 == 0 || fwrite(part2, 1, length2, m_file) == length2);
+    }
+    if (!ok)
+    {
+        m_lastError = "Cannot write " + m_path + ": " + strerror(errno);
+        return false;
+    }
+    m_packetsWritten++;
+    return true;
+}
+
+}
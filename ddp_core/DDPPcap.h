@@ -0,0 +1,143 @@
+#ifndef __DDPPcap__
+#define __DDPPcap__
+
+// DDPSocket.h first: it pulls in winsock2 before anything includes Windows.h
+#include "DDPSocket.h"
+
+#include <cstdio>
+#include <string>
+#include <vector>
+
+// Packet capture files: classic libpcap (.pcap, micro- or nanosecond, either
+// byte order) and pcapng are read; classic pcap is written.
+#define DDP_PCAP_MAGIC_US      0xA1B2C3D4u
+#define DDP_PCAP_MAGIC_NS      0xA1B23C4Du
+#define DDP_PCAPNG_SHB         0x0A0D0D0Au
+#define DDP_PCAPNG_BYTE_ORDER  0x1A2B3C4Du
+#define DDP_PCAP_SNAPLEN       65535
+
+// Link types understood by the reader (LINKTYPE_* values)
+#define DDP_LINKTYPE_NULL      0
+#define DDP_LINKTYPE_ETHERNET  1
+#define DDP_LINKTYPE_RAW_OLD   12    // raw IP on some BSDs
+#define DDP_LINKTYPE_RAW       101
+#define DDP_LINKTYPE_LOOP      108
+#define DDP_LINKTYPE_LINUX_SLL 113
+#define DDP_LINKTYPE_IPV4      228
+#define DDP_LINKTYPE_IPV6      229
+#define DDP_LINKTYPE_LINUX_SLL2 276
+
+namespace ddp
+{
+
+// One UDP datagram pulled out of a capture
+struct CapturedPacket
+{
+    double timestamp = 0.0;              // seconds since the Unix epoch
+    const uint8_t* payload = nullptr;    // UDP payload, valid until the next read
+    size_t length = 0;
+    struct sockaddr_storage source = {}; // sender address and port
+    uint16_t destPort = 0;
+};
+
+// Streams UDP datagrams out of a .pcap or .pcapng file. Ethernet (with VLAN
+// tags), Linux cooked, BSD loopback and raw IP links carrying IPv4 or IPv6 are
+// decoded; everything else, IP fragments included, is counted and skipped.
+class PcapReader
+{
+public:
+    PcapReader();
+    ~PcapReader();
+
+    PcapReader(const PcapReader&) = delete;
+    PcapReader& operator=(const PcapReader&) = delete;
+
+    bool open(const std::string& path);
+    void close();
+
+    // Start over from the first packet
+    bool rewind();
+
+    bool isOpen() const { return m_file != nullptr; }
+    const std::string& path() const { return m_path; }
+    const std::string& lastError() const { return m_lastError; }
+    bool isPcapNg() const { return m_pcapng; }
+
+    // Next UDP datagram sent to 'port' (0 = any port). Returns false at the
+    // end of the file, or on a read error (see lastError()).
+    bool next(CapturedPacket& packet, int port = 0);
+
+    int64_t packetsRead() const { return m_packetsRead; }     // UDP datagrams returned
+    int64_t packetsSkipped() const { return m_packetsSkipped; } // other traffic
+    int64_t bytesRead() const { return m_bytesRead; }         // capture file bytes consumed
+
+private:
+    struct Interface
+    {
+        int linkType;
+        double tickSeconds;    // timestamp resolution
+    };
+
+    bool readHeader();
+    bool readFrame(const uint8_t*& frame, size_t& length, int& linkType, double& timestamp);
+    bool readPcapRecord(const uint8_t*& frame, size_t& length, int& linkType, double& timestamp);
+    bool readPcapNgBlock(const uint8_t*& frame, size_t& length, int& linkType, double& timestamp, bool& isPacket);
+    void addInterface(const uint8_t* body, size_t bodyLength);
+    bool readExact(void* buffer, size_t length);
+    uint16_t get16(const uint8_t* p) const;
+    uint32_t get32(const uint8_t* p) const;
+
+    std::string m_path;
+    std::string m_lastError;
+    FILE* m_file;
+    bool m_pcapng;
+    bool m_bigEndian;          // byte order of the current file or section
+    int m_linkType;            // classic pcap only
+    double m_tickSeconds;      // classic pcap only
+    double m_lastTimestamp;    // simple packet blocks carry none
+    std::vector<Interface> m_interfaces;
+    std::vector<uint8_t> m_buffer;
+
+    int64_t m_packetsRead;
+    int64_t m_packetsSkipped;
+    int64_t m_bytesRead;
+};
+
+// Writes UDP datagrams to a classic pcap file as raw IPv4/IPv6 packets
+// (LINKTYPE_RAW), with IP and UDP headers synthesized from the addresses, so
+// Wireshark's DDP dissector and tcpdump read them like a live capture.
+class PcapWriter
+{
+public:
+    PcapWriter();
+    ~PcapWriter();
+
+    PcapWriter(const PcapWriter&) = delete;
+    PcapWriter& operator=(const PcapWriter&) = delete;
+
+    // Create (or truncate) 'path' and write the file header
+    bool open(const std::string& path);
+    void close();
+
+    bool isOpen() const { return m_file != nullptr; }
+    const std::string& path() const { return m_path; }
+    const std::string& lastError() const { return m_lastError; }
+    int64_t packetsWritten() const { return m_packetsWritten; }
+
+    // One datagram given as header and payload parts. A 'source' of another
+    // family than 'dest' (or unset) is written as the unspecified address.
+    bool writeDatagram(const struct sockaddr_storage& source, const struct sockaddr_storage& dest,
+                       const uint8_t* part1, size_t length1, const uint8_t* part2, size_t length2,
+                       double timestamp);
+
+private:
+    std::string m_path;
+    std::string m_lastError;
+    FILE* m_file;
+    int64_t m_packetsWritten;
+    std::vector<uint8_t> m_scratch;
+};
+
+}
+
+#endif
@@ -0,0 +1,570 @@
+#include "DDPPixelConvert.h"
+#include "DDPCalibration.h"
+#include "DDPLayout.h"
+#include "DDPPower.h"
+#include <cctype>
+#include <cstring>
+
+namespace ddp
+{
+
+namespace
+{
+    // Multipliers of the 0-255 level: bytes store it as is, dither levels
+    // times 256 (so their high byte is the byte), 16-bit output times 257 (full
+    // scale 65535)
+    const float kByteScale = 1.0f;
+    const float kLevelScale = 256.0f;
+    const float kWideScale = 257.0f;
+    
+    template<typename Out>
+    void convertLevels(const float* src, size_t count, const ConvertSettings& settings, float scale, Out* dst)
+    {
+        const float brightness = settings.brightness;
+        const bool normalized = settings.normalizedInput;
+        const float range = (normalized ? 255.0f : 1.0f) * scale;
+        const float upper = normalized ? 1.0f : 255.0f;
+        
+        if (settings.gamma == 1.0f)
+        {
+            // No gamma: a branch-free scale/clamp loop the compiler can vectorize
+            for (size_t i = 0; i < count; i++)
+            {
+                float value = src[i] * brightness;
+                value = std::max(0.0f, std::min(upper, value));
+                dst[i] = static_cast<Out>(value * range);
+            }
+            return;
+        }
+        
+        for (size_t i = 0; i < count; i++)
+        {
+            float value = applyGamma(src[i] * brightness, settings.gamma, normalized);
+            value = std::max(0.0f, std::min(upper, value));
+            dst[i] = static_cast<Out>(value * range);
+        }
+    }
+}
+
+void convertSamples(const float* src, size_t count, const ConvertSettings& settings, uint8_t* dst)
+{
+    convertLevels(src, count, settings, kByteScale, dst);
+}
+
+void convertSamples16(const float* src, size_t count, const ConvertSettings& settings, uint16_t* dst)
+{
+    convertLevels(src, count, settings, kLevelScale, dst);
+}
+
+void storeBE16(const uint16_t* values, size_t count, uint8_t* dst)
+{
+    for (size_t i = 0; i < count; i++)
+    {
+        dst[2 * i] = static_cast<uint8_t>(values[i] >> 8);
+        dst[2 * i + 1] = static_cast<uint8_t>(values[i]);
+    }
+}
+
+void ditherLevels(const uint16_t* levels, size_t count, uint8_t* error, uint8_t* dst)
+{
+    // Levels top out at 255 * 256 and the carried error below 256, so the sum fits 16 bits
+    for (size_t i = 0; i < count; i++)
+    {
+        uint32_t value = static_cast<uint32_t>(levels[i]) + error[i];
+        dst[i] = static_cast<uint8_t>(value >> 8);
+        error[i] = static_cast<uint8_t>(value);
+    }
+}
+
+void seedDitherError(uint8_t* error, size_t count)
+{
+    // Golden ratio steps spread the phases, so neighbours with the same level
+    // do not all step up on the same frame
+    for (size_t i = 0; i < count; i++)
+        error[i] = static_cast<uint8_t>((static_cast<uint32_t>(i) * 2654435761u) >> 24);
+}
+
+bool parseColorOrder(const char* text, int channelsPerPixel, ColorOrder& order, std::string& error)
+{
+    static const char letters[] = "RGBW";
+    order = ColorOrder();
+    bool used[4] = { false, false, false, false };
+    int length = 0;
+    for (const char* p = text ? text : ""; *p; p++)
+    {
+        if (*p == ' ' || *p == '\t')
+            continue;
+        const char* letter = strchr(letters, toupper(static_cast<unsigned char>(*p)));
+        int channel = letter ? static_cast<int>(letter - letters) : -1;
+        if (channel < 0 || used[channel])
+        {
+            error = std::string("Color order '") + text + "' must use each of R, G, B, W at most once";
+            return false;
+        }
+        if (channel >= channelsPerPixel || length >= channelsPerPixel)
+        {
+            error = std::string("Color order '") + text + "' needs more than " +
+                    std::to_string(channelsPerPixel) + " channels per pixel";
+            return false;
+        }
+        used[channel] = true;
+        order.map[length++] = static_cast<uint8_t>(channel);
+    }
+    
+    // N letters rearrange the first N channels, so none of those may be missing
+    for (int channel = 0; channel < length && channel < 4; channel++)
+    {
+        if (!used[channel])
+        {
+            error = std::string("Color order '") + text + "' leaves out " + letters[channel];
+            return false;
+        }
+    }
+    return true;
+}
+
+namespace
+{
+    // Samples converted in one block before they are flipped, permuted or
+    // dithered, small enough that the second touch stays in L1
+    const size_t kBlockSamples = 4096;
+    
+    const ColorOrder kInputOrder;
+    
+    // One pixel per iteration; Channels > 0 fixes the stride at compile time
+    // so the common RGB/RGBW layouts unroll into straight-line code
+    template<int Channels, bool Gamma, typename Out>
+    void gatherPixels(const float* src, const uint32_t* indices, size_t pixels, size_t stride,
+                      const ConvertSettings& settings, float scale, const uint8_t* map, Out* dst)
+    {
+        if (Channels > 0)
+            stride = static_cast<size_t>(Channels);
+        const float brightness = settings.brightness;
+        const bool normalized = settings.normalizedInput;
+        const float range = (normalized ? 255.0f : 1.0f) * scale;
+        const float upper = normalized ? 1.0f : 255.0f;
+        
+        for (size_t i = 0; i < pixels; i++, dst += stride)
+        {
+            const uint32_t index = indices[i];
+            if (index == DDP_LAYOUT_BLANK)
+            {
+                memset(dst, 0, stride * sizeof(Out));
+                continue;
+            }
+            const float* in = src + static_cast<size_t>(index) * stride;
+            for (size_t c = 0; c < stride; c++)
+            {
+                float value = in[map[c]] * brightness;
+                if (Gamma)
+                    value = applyGamma(value, settings.gamma, normalized);
+                value = std::max(0.0f, std::min(upper, value));
+                dst[c] = static_cast<Out>(value * range);
+            }
+        }
+    }
+    
+    template<typename Out>
+    void gatherDispatch(const float* src, const uint32_t* indices, size_t pixels, int channelsPerPixel,
+                        const ConvertSettings& settings, float scale, const uint8_t* map, Out* dst)
+    {
+        const size_t stride = static_cast<size_t>(channelsPerPixel);
+        const bool gamma = settings.gamma != 1.0f;
+        switch (channelsPerPixel)
+        {
+            case 3:
+                if (gamma) gatherPixels<3, true>(src, indices, pixels, stride, settings, scale, map, dst);
+                else       gatherPixels<3, false>(src, indices, pixels, stride, settings, scale, map, dst);
+                break;
+            case 4:
+                if (gamma) gatherPixels<4, true>(src, indices, pixels, stride, settings, scale, map, dst);
+                else       gatherPixels<4, false>(src, indices, pixels, stride, settings, scale, map, dst);
+                break;
+            default:
+                if (gamma) gatherPixels<0, true>(src, indices, pixels, stride, settings, scale, map, dst);
+                else       gatherPixels<0, false>(src, indices, pixels, stride, settings, scale, map, dst);
+                break;
+        }
+    }
+    
+    // Converted values of a block -> wire order: last pixel first for a
+    // reversed run, then each pixel's channels through the color order
+    // (nullptr = as is)
+    template<int Channels, typename T>
+    void arrangePixels(T* pixels, size_t count, size_t stride, bool reverse, const uint8_t* map)
+    {
+        if (Channels > 0)
+            stride = static_cast<size_t>(Channels);
+        if (reverse && count > 1)
+        {
+            T* front = pixels;
+            T* back = pixels + (count - 1) * stride;
+            for (; front < back; front += stride, back -= stride)
+            {
+                for (size_t c = 0; c < stride; c++)
+                    std::swap(front[c], back[c]);
+            }
+        }
+        if (map)
+        {
+            // Local copy of the map: it could alias the pixels as far as the compiler knows
+            uint8_t order[DDP_MAX_ORDER_CHANNELS];
+            T in[DDP_MAX_ORDER_CHANNELS];
+            memcpy(order, map, stride);
+            for (size_t i = 0; i < count; i++, pixels += stride)
+            {
+                memcpy(in, pixels, stride * sizeof(T));
+                for (size_t c = 0; c < stride; c++)
+                    pixels[c] = in[order[c]];
+            }
+        }
+    }
+    
+    template<typename T>
+    void arrangeDispatch(T* pixels, size_t count, int channelsPerPixel, bool reverse, const uint8_t* map)
+    {
+        const size_t stride = static_cast<size_t>(channelsPerPixel);
+        switch (channelsPerPixel)
+        {
+            case 3:  arrangePixels<3>(pixels, count, stride, reverse, map); break;
+            case 4:  arrangePixels<4>(pixels, count, stride, reverse, map); break;
+            default: arrangePixels<0>(pixels, count, stride, reverse, map); break;
+        }
+    }
+    
+    size_t blockPixels(int channelsPerPixel)
+    {
+        return std::max<size_t>(1, kBlockSamples / static_cast<size_t>(channelsPerPixel));
+    }
+    
+    // Calibrated pixels as linear 0-1 values: the folded matrix, offsets and
+    // white extraction. Channels > 0 fixes the output stride (3 or 4) at
+    // compile time.
+    template<int Channels>
+    void calibratePixels(const float* src, size_t count, size_t inStride, size_t outStride,
+                         const CalibrationKernel& kernel, float* dst)
+    {
+        if (Channels > 0)
+            outStride = static_cast<size_t>(Channels);
+        const bool inputWhite = inStride >= 4;
+        float m[3][3];
+        memcpy(m, kernel.matrix, sizeof(m));
+        const float o0 = kernel.offset[0], o1 = kernel.offset[1], o2 = kernel.offset[2], o3 = kernel.offset[3];
+        const float whiteGain = kernel.whiteGain, white = kernel.white, extraScale = kernel.extraScale;
+        
+        for (size_t i = 0; i < count; i++, src += inStride, dst += outStride)
+        {
+            const float in0 = src[0], in1 = src[1], in2 = src[2];
+            float r = m[0][0] * in0 + m[0][1] * in1 + m[0][2] * in2 + o0;
+            float g = m[1][0] * in0 + m[1][1] * in1 + m[1][2] * in2 + o1;
+            float b = m[2][0] * in0 + m[2][1] * in1 + m[2][2] * in2 + o2;
+            if (outStride < 4)
+            {
+                dst[0] = r;
+                dst[1] = g;
+                dst[2] = b;
+                continue;
+            }
+            
+            float shared = std::max(0.0f, std::min(r, std::min(g, b))) * white;
+            dst[0] = r - shared;
+            dst[1] = g - shared;
+            dst[2] = b - shared;
+            dst[3] = (inputWhite ? whiteGain * src[3] : 0.0f) + o3 + shared;
+            for (size_t c = 4; c < outStride; c++)
+                dst[c] = c < inStride ? src[c] * extraScale : 0.0f;
+        }
+    }
+    
+    // A block of pixels (at most kBlockSamples values out) through the kernel,
+    // then gamma and quantizing with the same vectorized loop as uncalibrated
+    // samples (brightness is already in the kernel)
+    template<typename Out>
+    void calibrateDispatch(const float* src, size_t count, size_t inStride, int channelsPerPixel,
+                           const CalibrationKernel& kernel, const ConvertSettings& settings, float scale, Out* dst)
+    {
+        const size_t outStride = static_cast<size_t>(channelsPerPixel);
+        float linear[kBlockSamples + DDP_MAX_ORDER_CHANNELS];
+        switch (channelsPerPixel)
+        {
+            case 3:  calibratePixels<3>(src, count, inStride, outStride, kernel, linear); break;
+            case 4:  calibratePixels<4>(src, count, inStride, outStride, kernel, linear); break;
+            default: calibratePixels<0>(src, count, inStride, outStride, kernel, linear); break;
+        }
+        ConvertSettings curve = settings;
+        curve.brightness = 1.0f;
+        curve.normalizedInput = true;
+        convertLevels(linear, count * outStride, curve, scale, dst);
+    }
+}
+
+void convertSamplesBE16(const float* src, size_t count, const ConvertSettings& settings, uint8_t* dst)
+{
+    uint16_t values[kBlockSamples];
+    for (size_t done = 0; done < count; done += kBlockSamples)
+    {
+        size_t n = std::min(kBlockSamples, count - done);
+        convertLevels(src + done, n, settings, kWideScale, values);
+        storeBE16(values, n, dst + 2 * done);
+    }
+}
+
+void convertGathered(const float* src, const uint32_t* indices, size_t pixels, int channelsPerPixel,
+                     const ConvertSettings& settings, uint8_t* dst, const ColorOrder* order, uint8_t* ditherError,
+                     const CalibrationKernel* calibration, RangePower* power)
+{
+    // Same arithmetic as convertSamples(), so a layout only changes the order
+    const uint8_t* map = (order ? order : &kInputOrder)->map;
+    if (calibration && !calibration->active)
+        calibration = nullptr;
+    if (!ditherError && !settings.wideOutput && !calibration && !power)
+    {
+        gatherDispatch(src, indices, pixels, channelsPerPixel, settings, kByteScale, map, dst);
+        return;
+    }
+    
+    const bool wide = settings.wideOutput;
+    const size_t stride = static_cast<size_t>(channelsPerPixel);
+    const size_t inStride = calibration ? static_cast<size_t>(calibration->inputChannels) : stride;
+    const size_t block = blockPixels(static_cast<int>(std::max(stride, inStride)));
+    const float scale = wide ? kWideScale : ditherError ? kLevelScale : kByteScale;
+    const uint8_t* permute = order && channelsPerPixel <= DDP_MAX_ORDER_CHANNELS &&
+                             !order->isIdentity(channelsPerPixel) ? order->map : nullptr;
+    uint16_t levels[kBlockSamples + DDP_MAX_ORDER_CHANNELS];
+    float gathered[kBlockSamples + DDP_MAX_ORDER_CHANNELS];
+    for (size_t done = 0; done < pixels; done += block)
+    {
+        size_t count = std::min(block, pixels - done);
+        uint8_t* out = dst + done * stride * (wide ? 2 : 1);
+        bool toBytes = !wide && !ditherError;
+        
+        if (calibration)
+        {
+            // Gather the input pixels, calibrate them as a run, then black out the blanks
+            for (size_t i = 0; i < count; i++)
+            {
+                uint32_t index = indices[done + i];
+                if (index == DDP_LAYOUT_BLANK)
+                    memset(gathered + i * inStride, 0, inStride * sizeof(float));
+                else
+                    memcpy(gathered + i * inStride, src + static_cast<size_t>(index) * inStride, inStride * sizeof(float));
+            }
+            if (toBytes)
+                calibrateDispatch(gathered, count, inStride, channelsPerPixel, *calibration, settings, scale, out);
+            else
+                calibrateDispatch(gathered, count, inStride, channelsPerPixel, *calibration, settings, scale, levels);
+            for (size_t i = 0; i < count; i++)
+            {
+                if (indices[done + i] != DDP_LAYOUT_BLANK)
+                    continue;
+                if (toBytes)
+                    memset(out + i * stride, 0, stride);
+                else
+                    memset(levels + i * stride, 0, stride * sizeof(uint16_t));
+            }
+            if (toBytes)
+            {
+                arrangeDispatch(out, count, channelsPerPixel, false, permute);
+                if (power)
+                    meterPixels(out, count, channelsPerPixel, *power);
+                continue;
+            }
+            arrangeDispatch(levels, count, channelsPerPixel, false, permute);
+        }
+        else if (toBytes)
+        {
+            gatherDispatch(src, indices + done, count, channelsPerPixel, settings, scale, map, out);
+            meterPixels(out, count, channelsPerPixel, *power);
+            continue;
+        }
+        else
+        {
+            gatherDispatch(src, indices + done, count, channelsPerPixel, settings, scale, map, levels);
+        }
+        
+        if (power)
+            meterPixels(levels, count, channelsPerPixel, *power);
+        if (wide)
+            storeBE16(levels, count * stride, out);
+        else
+            ditherLevels(levels, count * stride, ditherError + done * stride, out);
+    }
+}
+
+void convertRuns(const float* src, const LayoutRun* runs, size_t runCount, int channelsPerPixel,
+                 const ConvertSettings& settings, uint8_t* dst, const ColorOrder* orders, uint8_t* ditherError,
+                 const CalibrationKernel* calibrations, RangePower* power)
+{
+    const size_t stride = static_cast<size_t>(channelsPerPixel);
+    const size_t inStride = calibrations ? static_cast<size_t>(calibrations[0].inputChannels) : stride;
+    const size_t block = blockPixels(static_cast<int>(std::max(stride, inStride)));
+    const bool canPermute = channelsPerPixel <= DDP_MAX_ORDER_CHANNELS;
+    const bool wide = settings.wideOutput;
+    if (wide)
+        ditherError = nullptr;
+    const size_t valueBytes = wide ? 2 : 1;
+    const float scale = wide ? kWideScale : kLevelScale;
+    uint16_t levels[kBlockSamples + DDP_MAX_ORDER_CHANNELS];
+    for (size_t r = 0; r < runCount; r++)
+    {
+        const LayoutRun& run = runs[r];
+        const size_t values = static_cast<size_t>(run.count) * stride;
+        const uint8_t* map = nullptr;
+        if (orders && canPermute && !orders[run.order].isIdentity(channelsPerPixel))
+            map = orders[run.order].map;
+        const CalibrationKernel* kernel = nullptr;
+        if (calibrations && calibrations[run.order].active)
+            kernel = &calibrations[run.order];
+        RangePower* meter = power ? &power[run.order] : nullptr;
+        
+        if (run.step == 0)
+        {
+            memset(dst, 0, values * valueBytes);
+        }
+        else if (run.step > 0 && !map && !ditherError && !kernel && !meter)
+        {
+            const float* in = src + static_cast<size_t>(run.source) * stride;
+            if (wide)
+                convertSamplesBE16(in, values, settings, dst);
+            else
+                convertSamples(in, values, settings, dst);
+        }
+        else
+        {
+            // Block by block; a reversed run reads its source from the end
+            const bool reverse = run.step < 0;
+            for (size_t done = 0; done < run.count; done += block)
+            {
+                size_t count = std::min<size_t>(block, run.count - done);
+                size_t first = reverse ? run.source + run.count - done - count : run.source + done;
+                uint8_t* out = dst + done * stride * valueBytes;
+                if (wide || ditherError)
+                {
+                    if (kernel)
+                        calibrateDispatch(src + first * inStride, count, inStride, channelsPerPixel, *kernel,
+                                          settings, scale, levels);
+                    else
+                        convertLevels(src + first * stride, count * stride, settings, scale, levels);
+                    arrangeDispatch(levels, count, channelsPerPixel, reverse, map);
+                    if (meter)
+                        meterPixels(levels, count, channelsPerPixel, *meter);
+                    if (wide)
+                        storeBE16(levels, count * stride, out);
+                    else
+                        ditherLevels(levels, count * stride, ditherError + done * stride, out);
+                }
+                else
+                {
+                    if (kernel)
+                        calibrateDispatch(src + first * inStride, count, inStride, channelsPerPixel, *kernel,
+                                          settings, kByteScale, out);
+                    else
+                        convertSamples(src + first * stride, count * stride, settings, out);
+                    arrangeDispatch(out, count, channelsPerPixel, reverse, map);
+                    if (meter)
+                        meterPixels(out, count, channelsPerPixel, *meter);
+                }
+            }
+        }
+        dst += values * valueBytes;
+        if (ditherError)
+            ditherError += values;
+    }
+}
+
+void reorderChannels(uint8_t* pixels, size_t count, int channelsPerPixel, const ColorOrder& order)
+{
+    if (channelsPerPixel <= DDP_MAX_ORDER_CHANNELS && !order.isIdentity(channelsPerPixel))
+        arrangeDispatch(pixels, count, channelsPerPixel, false, order.map);
+}
+
+void reorderChannels(uint16_t* pixels, size_t count, int channelsPerPixel, const ColorOrder& order)
+{
+    if (channelsPerPixel <= DDP_MAX_ORDER_CHANNELS && !order.isIdentity(channelsPerPixel))
+        arrangeDispatch(pixels, count, channelsPerPixel, false, order.map);
+}
+
+void convertPlanar(const float* const* channels, int numChannels, size_t numSamples,
+                   const ConvertSettings& settings, uint8_t* dst)
+{
+    for (size_t sample = 0; sample < numSamples; sample++)
+    {
+        for (int channel = 0; channel < numChannels; channel++)
+        {
+            float value = applyGamma(channels[channel][sample] * settings.brightness,
+                                     settings.gamma, settings.normalizedInput);
+            *dst++ = floatToUint8(value, settings.normalizedInput);
+        }
+    }
+}
+
+void buildByteLUT(const ConvertSettings& settings, uint8_t lut[256])
+{
+    float texels[256];
+    for (int i = 0; i < 256; i++)
+        texels[i] = i / 255.0f;
+    
+    ConvertSettings normalized = settings;
+    normalized.normalizedInput = true;
+    convertSamples(texels, 256, normalized, lut);
+}
+
+void buildLinearLUT(const ConvertSettings& settings, uint8_t lut[DDP_CAL_LUT_SIZE])
+{
+    float linear[DDP_CAL_LUT_SIZE];
+    for (int i = 0; i < DDP_CAL_LUT_SIZE; i++)
+        linear[i] = i / static_cast<float>(DDP_CAL_LINEAR_ONE);
+    
+    // Brightness is folded into the calibration kernel
+    ConvertSettings curve = settings;
+    curve.brightness = 1.0f;
+    curve.normalizedInput = true;
+    convertLevels(linear, DDP_CAL_LUT_SIZE, curve, kByteScale, lut);
+}
+
+void buildLinearLUT(const ConvertSettings& settings, uint16_t lut[DDP_CAL_LUT_SIZE])
+{
+    float linear[DDP_CAL_LUT_SIZE];
+    for (int i = 0; i < DDP_CAL_LUT_SIZE; i++)
+        linear[i] = i / static_cast<float>(DDP_CAL_LINEAR_ONE);
+    
+    ConvertSettings curve = settings;
+    curve.brightness = 1.0f;
+    curve.normalizedInput = true;
+    convertLevels(linear, DDP_CAL_LUT_SIZE, curve, settings.wideOutput ? kWideScale : kLevelScale, lut);
+}
+
+void buildLevelLUT(const ConvertSettings& settings, uint16_t lut[256])
+{
+    float texels[256];
+    for (int i = 0; i < 256; i++)
+        texels[i] = i / 255.0f;
+    
+    ConvertSettings normalized = settings;
+    normalized.normalizedInput = true;
+    convertLevels(texels, 256, normalized, settings.wideOutput ? kWideScale : kLevelScale, lut);
+}
+
+void convertBytesToSamples(const uint8_t* src, size_t count, bool normalizedOutput, float* dst)
+{
+    if (normalizedOutput)
+    {
+        for (size_t i = 0; i < count; i++)
+            dst[i] = src[i] / 255.0f;
+    }
+    else
+    {
+        for (size_t i = 0; i < count; i++)
+            dst[i] = static_cast<float>(src[i]);
+    }
+}
+
+void convertBE16ToSamples(const uint8_t* src, size_t count, bool normalizedOutput, float* dst)
+{
+    // 0-255 output keeps the fraction: 0xFFFF is 255.0, 0x8000 is 127.502
+    const float scale = normalizedOutput ? 1.0f / 65535.0f : 1.0f / 257.0f;
+    for (size_t i = 0; i < count; i++)
+        dst[i] = static_cast<float>((src[2 * i] << 8) | src[2 * i + 1]) * scale;
+}
+
+}
@@ -0,0 +1,166 @@
+#ifndef __DDPPixelConvert__
+#define __DDPPixelConvert__
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+// Channels a color order can rearrange (Channels Per Pixel goes up to 10)
+#define DDP_MAX_ORDER_CHANNELS 16
+
+namespace ddp
+{
+
+struct LayoutRun;
+struct CalibrationKernel;
+struct RangePower;
+
+// CHOP sample -> DDP byte conversion settings
+struct ConvertSettings
+{
+    float gamma = 1.0f;
+    float brightness = 1.0f;
+    bool normalizedInput = true;   // samples are 0-1 (otherwise 0-255)
+    bool wideOutput = false;       // convertRuns()/convertGathered()/buildLevelLUT(): 16 bits per value
+};
+
+inline uint8_t floatToUint8(float value, bool normalizedInput)
+{
+    if (normalizedInput)
+    {
+        // Input is 0-1 range, convert to 0-255
+        value = std::max(0.0f, std::min(1.0f, value));
+        return static_cast<uint8_t>(value * 255.0f);
+    }
+    
+    // Input is 0-255 range, just clamp and convert
+    value = std::max(0.0f, std::min(255.0f, value));
+    return static_cast<uint8_t>(value);
+}
+
+inline float applyGamma(float value, float gamma, bool normalizedInput)
+{
+    if (gamma == 1.0f)
+        return value;
+    
+    // Normalize to 0-1 for gamma calculation if input is 0-255
+    if (!normalizedInput)
+        value = value / 255.0f;
+    
+    value = std::max(0.0f, std::min(1.0f, value));
+    value = std::pow(value, 1.0f / gamma);
+    
+    if (!normalizedInput)
+        value = value * 255.0f;
+    
+    return value;
+}
+
+// Interleaved samples (r0,g0,b0,r1,...) -> bytes. 'dst' holds 'count' bytes.
+void convertSamples(const float* src, size_t count, const ConvertSettings& settings, uint8_t* dst);
+
+// The same at 16-bit precision: level * 256 (0-65280), so the high byte is
+// what convertSamples() gives and the low byte keeps the fraction it drops
+void convertSamples16(const float* src, size_t count, const ConvertSettings& settings, uint16_t* dst);
+
+// 16-bit output: samples -> big-endian values with full scale 65535, 2 * 'count' bytes
+void convertSamplesBE16(const float* src, size_t count, const ConvertSettings& settings, uint8_t* dst);
+void storeBE16(const uint16_t* values, size_t count, uint8_t* dst);
+
+// Temporal dithering: 16-bit levels -> bytes, carrying each byte's remainder
+// to the same byte of the next frame in 'error' (one per byte, kept between
+// frames), so over time every output averages its exact level.
+void ditherLevels(const uint16_t* levels, size_t count, uint8_t* error, uint8_t* dst);
+
+// Starting error for a new frame size, staggered so equal levels do not step together
+void seedDitherError(uint8_t* error, size_t count);
+
+// Output channel k of every pixel takes input channel map[k]
+struct ColorOrder
+{
+    uint8_t map[DDP_MAX_ORDER_CHANNELS];
+
+    ColorOrder()
+    {
+        for (int k = 0; k < DDP_MAX_ORDER_CHANNELS; k++)
+            map[k] = static_cast<uint8_t>(k);
+    }
+
+    bool isIdentity(int channels) const
+    {
+        for (int k = 0; k < channels && k < DDP_MAX_ORDER_CHANNELS; k++)
+        {
+            if (map[k] != k)
+                return false;
+        }
+        return true;
+    }
+};
+
+// "GRB", "grbw", "WRGB": the letters R, G, B and W name input channels 0-3 in
+// the order the controller wants them. N letters must rearrange the first N
+// channels; later channels stay in place and an empty string changes nothing.
+bool parseColorOrder(const char* text, int channelsPerPixel, ColorOrder& order, std::string& error);
+
+// Interleaved samples gathered through a pixel index table while converting:
+// pixel i of 'dst' is source pixel indices[i] ('channelsPerPixel' samples
+// each), or black for DDP_LAYOUT_BLANK. 'dst' holds pixels * channelsPerPixel bytes.
+// 'order' (nullptr = input order) rearranges the channels of every pixel.
+// With 'ditherError' (one byte per byte of 'dst') the pixels are converted at
+// 16 bits and dithered, see ditherLevels(). With settings.wideOutput 'dst'
+// gets big-endian 16-bit values instead (twice the bytes, no dithering).
+// An active 'calibration' replaces the plain conversion; the source then has
+// calibration->inputChannels per pixel. With 'power' each block is metered
+// and limited while it is in L1, see meterPixels().
+void convertGathered(const float* src, const uint32_t* indices, size_t pixels, int channelsPerPixel,
+                     const ConvertSettings& settings, uint8_t* dst, const ColorOrder* order = nullptr,
+                     uint8_t* ditherError = nullptr, const CalibrationKernel* calibration = nullptr,
+                     RangePower* power = nullptr);
+
+// The same through a run-length form of the table (see LedLayout::runs()):
+// forward runs convert as one block; reversed runs, and runs whose color order
+// (orders[run.order], nullptr = input order everywhere) is not the input
+// order, convert in blocks small enough to be flipped and permuted in L1.
+// Dithering and 16-bit output go through the same blocks at 16 bits.
+// 'calibrations' are indexed like 'orders' and share one input channel count,
+// and so is 'power'.
+void convertRuns(const float* src, const LayoutRun* runs, size_t runCount, int channelsPerPixel,
+                 const ConvertSettings& settings, uint8_t* dst, const ColorOrder* orders = nullptr,
+                 uint8_t* ditherError = nullptr, const CalibrationKernel* calibrations = nullptr,
+                 RangePower* power = nullptr);
+
+// Values already converted -> the same pixels with their channels rearranged, in place
+void reorderChannels(uint8_t* pixels, size_t count, int channelsPerPixel, const ColorOrder& order);
+void reorderChannels(uint16_t* pixels, size_t count, int channelsPerPixel, const ColorOrder& order);
+
+// One channel per component (all reds, all greens, ...) -> interleaved bytes.
+// 'dst' holds numChannels * numSamples bytes.
+void convertPlanar(const float* const* channels, int numChannels, size_t numSamples,
+                   const ConvertSettings& settings, uint8_t* dst);
+
+// Gamma/brightness table for 8-bit texels. Built with convertSamples() on
+// texel / 255 (the input range setting is ignored) so a TOP gives the same
+// bytes as the same image converted to a CHOP.
+void buildByteLUT(const ConvertSettings& settings, uint8_t lut[256]);
+
+// The same table at 16-bit precision: dither levels, or with
+// settings.wideOutput full-scale values for 16-bit output
+void buildLevelLUT(const ConvertSettings& settings, uint16_t lut[256]);
+
+// Gamma table over the linear values of calibrated TOP sampling (see
+// DDPCalibration.h): bytes, or 16-bit dither levels / wide output values.
+// Brightness is left to the calibration kernel.
+void buildLinearLUT(const ConvertSettings& settings, uint8_t lut[4096]);
+void buildLinearLUT(const ConvertSettings& settings, uint16_t lut[4096]);
+
+// Received bytes -> CHOP samples (0-1 or 0-255)
+void convertBytesToSamples(const uint8_t* src, size_t count, bool normalizedOutput, float* dst);
+
+// Received big-endian 16-bit values -> CHOP samples (0-1, or 0-255 with fractions)
+void convertBE16ToSamples(const uint8_t* src, size_t count, bool normalizedOutput, float* dst);
+
+}
+
+#endif
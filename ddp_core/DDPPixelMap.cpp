@@ -0,0 +1,294 @@
+#include "DDPPixelMap.h"
+#include "DDPCalibration.h"
+#include "DDPPower.h"
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <sstream>
+
+namespace ddp
+{
+
+namespace
+{
+    bool parseNumber(const char*& text, float& value)
+    {
+        while (*text == ' ' || *text == '\t' || *text == ',' || *text == ';')
+            text++;
+        char* end = nullptr;
+        value = strtof(text, &end);
+        if (end == text)
+            return false;
+        text = end;
+        return true;
+    }
+}
+
+bool parseMapCells(const char* x, const char* y, MapPoint& point)
+{
+    if (!x || !y)
+        return false;
+    return parseNumber(x, point.x) && parseNumber(y, point.y);
+}
+
+void parseMapText(const std::string& text, std::vector<MapPoint>& points)
+{
+    points.clear();
+    std::istringstream lines(text);
+    std::string line;
+    while (std::getline(lines, line))
+    {
+        const char* p = line.c_str();
+        MapPoint point;
+        if (parseNumber(p, point.x) && parseNumber(p, point.y))
+            points.push_back(point);
+    }
+}
+
+bool loadMapFile(const std::string& path, std::vector<MapPoint>& points, std::string& error)
+{
+    std::ifstream file(path, std::ios::binary);
+    if (!file)
+    {
+        error = "Cannot open " + path + ": " + strerror(errno);
+        return false;
+    }
+    std::stringstream contents;
+    contents << file.rdbuf();
+    parseMapText(contents.str(), points);
+    if (points.empty())
+    {
+        error = path + " has no map points";
+        return false;
+    }
+    return true;
+}
+
+PixelMap::PixelMap()
+{
+    m_units = MapUnits::Pixels;
+    m_width = 0;
+    m_height = 0;
+    m_outside = 0;
+    m_dirty = true;
+}
+
+void PixelMap::setPoints(const std::vector<MapPoint>& points, MapUnits units)
+{
+    m_points = points;
+    m_units = units;
+    m_dirty = true;
+}
+
+void PixelMap::compile(uint32_t width, uint32_t height)
+{
+    if (!m_dirty && width == m_width && height == m_height)
+        return;
+    m_width = width;
+    m_height = height;
+    m_dirty = false;
+
+    m_offsets.resize(m_points.size());
+    m_outside = 0;
+    for (size_t i = 0; i < m_points.size(); i++)
+    {
+        // UV picks the texel the coordinate falls in (1.0 is the last one);
+        // pixel coordinates round to the nearest texel
+        float x = m_points[i].x;
+        float y = m_points[i].y;
+        if (m_units == MapUnits::UV)
+        {
+            x = std::min(x * width, width - 0.5f);
+            y = std::min(y * height, height - 0.5f);
+        }
+        else
+        {
+            x += 0.5f;
+            y += 0.5f;
+        }
+
+        if (!(x >= 0.0f && y >= 0.0f && x < static_cast<float>(width) && y < static_cast<float>(height)))
+        {
+            m_offsets[i] = DDP_MAP_OUTSIDE;
+            m_outside++;
+            continue;
+        }
+        uint32_t column = static_cast<uint32_t>(x);
+        uint32_t row = static_cast<uint32_t>(y);
+        m_offsets[i] = (row * width + column) * 4;
+    }
+}
+
+namespace
+{
+    // Points sampled before they are metered, so the meter reads them from L1
+    const size_t kBlockSamples = 4096;
+    
+    const ColorOrder kInputOrder;
+    
+    // Wire channel k takes input channel map[k]; orders only rearrange the
+    // first four, which are all a texel has
+    const ColorOrder& wireOrder(const ColorOrder* order, int channelsPerLed)
+    {
+        return order && channelsPerLed <= DDP_MAX_ORDER_CHANNELS ? *order : kInputOrder;
+    }
+    
+    template<typename Out>
+    void sampleTexels(const uint32_t* offsets, size_t count, const uint8_t* texture, const Out* lut,
+                      int channelsPerLed, const uint8_t* map, Out* dst)
+    {
+        // Texel byte of each wire channel: BGRA -> R, G, B, A, through the order
+        static const int bgra[4] = { 2, 1, 0, 3 };
+        int bytes[4];
+        for (int c = 0; c < 4; c++)
+            bytes[c] = bgra[map[c]];
+        
+        // The common layouts get their own loops
+        if (channelsPerLed == 3)
+        {
+            const int b0 = bytes[0], b1 = bytes[1], b2 = bytes[2];
+            for (size_t i = 0; i < count; i++, dst += 3)
+            {
+                if (offsets[i] == DDP_MAP_OUTSIDE)
+                {
+                    dst[0] = dst[1] = dst[2] = 0;
+                    continue;
+                }
+                const uint8_t* texel = texture + offsets[i];
+                dst[0] = lut[texel[b0]];
+                dst[1] = lut[texel[b1]];
+                dst[2] = lut[texel[b2]];
+            }
+            return;
+        }
+        
+        const int sampled = std::min(channelsPerLed, 4);
+        for (size_t i = 0; i < count; i++, dst += channelsPerLed)
+        {
+            memset(dst, 0, static_cast<size_t>(channelsPerLed) * sizeof(Out));
+            if (offsets[i] == DDP_MAP_OUTSIDE)
+                continue;
+            const uint8_t* texel = texture + offsets[i];
+            for (int c = 0; c < sampled; c++)
+                dst[c] = lut[texel[bytes[c]]];
+        }
+    }
+}
+
+namespace
+{
+    inline int32_t clampLinear(int32_t value)
+    {
+        return std::max(0, std::min(DDP_CAL_LUT_SIZE - 1, value));
+    }
+    
+    // Integer-only calibration of 8-bit texels: the fixed-point matrix gives
+    // linear values, which index the gamma table
+    template<typename Out>
+    void sampleCalibratedTexels(const uint32_t* offsets, size_t count, const uint8_t* texture,
+                                const CalibrationKernel& kernel, const Out* lut, int channelsPerLed,
+                                const uint8_t* map, Out* dst)
+    {
+        const size_t stride = static_cast<size_t>(channelsPerLed);
+        const bool alphaWhite = kernel.inputChannels >= 4;
+        int32_t m[3][3];
+        memcpy(m, kernel.qMatrix, sizeof(m));
+        const int32_t o0 = kernel.qOffset[0], o1 = kernel.qOffset[1], o2 = kernel.qOffset[2], o3 = kernel.qOffset[3];
+        const int32_t whiteGain = alphaWhite ? kernel.qWhiteGain : 0, white = kernel.qWhite;
+        const int32_t half = 1 << (DDP_CAL_FRACTION_BITS - 1);
+        const uint8_t k0 = map[0], k1 = map[1], k2 = map[2], k3 = map[3];
+        for (size_t i = 0; i < count; i++, dst += stride)
+        {
+            if (offsets[i] == DDP_MAP_OUTSIDE)
+            {
+                memset(dst, 0, stride * sizeof(Out));
+                continue;
+            }
+            const uint8_t* texel = texture + offsets[i];
+            const int32_t red = texel[2], green = texel[1], blue = texel[0];
+            int32_t r = (m[0][0] * red + m[0][1] * green + m[0][2] * blue + o0 + half) >> DDP_CAL_FRACTION_BITS;
+            int32_t g = (m[1][0] * red + m[1][1] * green + m[1][2] * blue + o1 + half) >> DDP_CAL_FRACTION_BITS;
+            int32_t b = (m[2][0] * red + m[2][1] * green + m[2][2] * blue + o2 + half) >> DDP_CAL_FRACTION_BITS;
+            if (stride < 4)
+            {
+                const Out values[3] = { lut[clampLinear(r)], lut[clampLinear(g)], lut[clampLinear(b)] };
+                dst[0] = values[k0];
+                dst[1] = values[k1];
+                dst[2] = values[k2];
+                continue;
+            }
+            
+            int32_t w = (whiteGain * texel[3] + o3 + half) >> DDP_CAL_FRACTION_BITS;
+            int32_t shared = (std::max(0, std::min(r, std::min(g, b))) * white) >> DDP_CAL_FRACTION_BITS;
+            const Out values[4] = { lut[clampLinear(r - shared)], lut[clampLinear(g - shared)],
+                                    lut[clampLinear(b - shared)], lut[clampLinear(w + shared)] };
+            dst[0] = values[k0];
+            dst[1] = values[k1];
+            dst[2] = values[k2];
+            dst[3] = values[k3];
+            for (size_t c = 4; c < stride; c++)
+                dst[c] = 0;
+        }
+    }
+    
+    // Block by block, so 'power' meters and scales each block right after it
+    // is written, while it is still in L1
+    template<typename Out>
+    void sampleBlocks(const uint32_t* offsets, size_t count, const uint8_t* texture, const CalibrationKernel* kernel,
+                      const Out* lut, int channelsPerLed, const ColorOrder* order, RangePower* power, Out* dst)
+    {
+        const uint8_t* map = wireOrder(order, channelsPerLed).map;
+        const size_t stride = static_cast<size_t>(channelsPerLed);
+        const size_t block = power ? std::max<size_t>(1, kBlockSamples / stride) : std::max<size_t>(1, count);
+        for (size_t done = 0; done < count; done += block)
+        {
+            size_t points = std::min(block, count - done);
+            Out* out = dst + done * stride;
+            if (kernel)
+                sampleCalibratedTexels(offsets + done, points, texture, *kernel, lut, channelsPerLed, map, out);
+            else
+                sampleTexels(offsets + done, points, texture, lut, channelsPerLed, map, out);
+            if (power)
+                meterPixels(out, points, channelsPerLed, *power);
+        }
+    }
+}
+
+void PixelMap::sampleCalibrated(const uint8_t* texture, size_t first, size_t count, const CalibrationKernel& kernel,
+                                const uint8_t* lut, int channelsPerLed, uint8_t* dst, const ColorOrder* order,
+                                RangePower* power) const
+{
+    sampleBlocks(m_offsets.data() + first, count, texture, &kernel, lut, channelsPerLed, order, power, dst);
+}
+
+void PixelMap::sampleCalibrated(const uint8_t* texture, size_t first, size_t count, const CalibrationKernel& kernel,
+                                const uint16_t* lut, int channelsPerLed, uint16_t* dst, const ColorOrder* order,
+                                RangePower* power) const
+{
+    sampleBlocks(m_offsets.data() + first, count, texture, &kernel, lut, channelsPerLed, order, power, dst);
+}
+
+void PixelMap::sampleBGRA8(const uint8_t* texture, const uint8_t* lut, int channelsPerLed, uint8_t* dst) const
+{
+    sampleBGRA8(texture, 0, m_offsets.size(), lut, channelsPerLed, dst);
+}
+
+void PixelMap::sampleBGRA8(const uint8_t* texture, const uint16_t* lut, int channelsPerLed, uint16_t* dst) const
+{
+    sampleBGRA8(texture, 0, m_offsets.size(), lut, channelsPerLed, dst);
+}
+
+void PixelMap::sampleBGRA8(const uint8_t* texture, size_t first, size_t count, const uint8_t* lut, int channelsPerLed,
+                           uint8_t* dst, const ColorOrder* order, RangePower* power) const
+{
+    sampleBlocks(m_offsets.data() + first, count, texture, nullptr, lut, channelsPerLed, order, power, dst);
+}
+
+void PixelMap::sampleBGRA8(const uint8_t* texture, size_t first, size_t count, const uint16_t* lut, int channelsPerLed,
+                           uint16_t* dst, const ColorOrder* order, RangePower* power) const
+{
+    sampleBlocks(m_offsets.data() + first, count, texture, nullptr, lut, channelsPerLed, order, power, dst);
+}
+
+}
@@ -0,0 +1,89 @@
+#ifndef __DDPPixelMap__
+#define __DDPPixelMap__
+
+#include "DDPPixelConvert.h"
+
+#include <string>
+#include <vector>
+
+// Gather table entry for a point that falls outside the texture (sent black)
+#define DDP_MAP_OUTSIDE 0xFFFFFFFFu
+
+namespace ddp
+{
+
+// One LED's sample position. Pixel coordinates count from the bottom-left
+// texel like TouchDesigner's; UV runs 0-1 across the texture.
+struct MapPoint
+{
+    float x;
+    float y;
+};
+
+enum class MapUnits
+{
+    Pixels,
+    UV
+};
+
+// Points from text, one LED per line as "x y", "x,y" or tab separated.
+// Lines that do not start with two numbers (headers, '#' comments) are skipped.
+void parseMapText(const std::string& text, std::vector<MapPoint>& points);
+bool loadMapFile(const std::string& path, std::vector<MapPoint>& points, std::string& error);
+
+// A cell pair that should become a point; false for headers and blank rows
+bool parseMapCells(const char* x, const char* y, MapPoint& point);
+
+// Samples a downloaded texture straight into DDP bytes. The points are turned
+// into texel byte offsets once per texture size, so a frame is a single
+// gather through a 256-entry gamma/brightness table.
+class PixelMap
+{
+public:
+    PixelMap();
+
+    void setPoints(const std::vector<MapPoint>& points, MapUnits units);
+    size_t size() const { return m_points.size(); }
+
+    // Rebuild the gather table when the texture size differs from the last call
+    void compile(uint32_t width, uint32_t height);
+    size_t pointsOutside() const { return m_outside; }
+
+    // BGRA8 texture (width * height * 4 bytes) -> 'channelsPerLed' bytes per
+    // point: R, G, B, then A, then zeros. 'lut' maps each 8-bit texel value.
+    void sampleBGRA8(const uint8_t* texture, const uint8_t* lut, int channelsPerLed, uint8_t* dst) const;
+    // The same into 16-bit levels (see buildLevelLUT())
+    void sampleBGRA8(const uint8_t* texture, const uint16_t* lut, int channelsPerLed, uint16_t* dst) const;
+    
+    // Points [first, first + count) only, 'dst' starting at point 'first'.
+    // 'order' (nullptr = R, G, B, A) picks the texel channel each value is
+    // sampled from. With 'power' the points are metered and limited as they
+    // are written, a block at a time while it is in L1 (see meterPixels()).
+    void sampleBGRA8(const uint8_t* texture, size_t first, size_t count, const uint8_t* lut, int channelsPerLed,
+                     uint8_t* dst, const ColorOrder* order = nullptr, RangePower* power = nullptr) const;
+    void sampleBGRA8(const uint8_t* texture, size_t first, size_t count, const uint16_t* lut, int channelsPerLed,
+                     uint16_t* dst, const ColorOrder* order = nullptr, RangePower* power = nullptr) const;
+    
+    // Points [first, first + count) through a calibration kernel in fixed
+    // point; 'lut' is a buildLinearLUT() table and 'dst' starts at point 'first'.
+    // 'order' and 'power' work as for sampleBGRA8().
+    void sampleCalibrated(const uint8_t* texture, size_t first, size_t count, const CalibrationKernel& kernel,
+                          const uint8_t* lut, int channelsPerLed, uint8_t* dst, const ColorOrder* order = nullptr,
+                          RangePower* power = nullptr) const;
+    void sampleCalibrated(const uint8_t* texture, size_t first, size_t count, const CalibrationKernel& kernel,
+                          const uint16_t* lut, int channelsPerLed, uint16_t* dst, const ColorOrder* order = nullptr,
+                          RangePower* power = nullptr) const;
+
+private:
+    std::vector<MapPoint> m_points;
+    MapUnits m_units;
+    std::vector<uint32_t> m_offsets;    // texel byte offset per point
+    uint32_t m_width;
+    uint32_t m_height;
+    size_t m_outside;
+    bool m_dirty;
+};
+
+}
+
+#endif
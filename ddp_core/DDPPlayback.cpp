@@ -0,0 +1,281 @@
+#include "DDPPlayback.h"
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+
+#ifdef _WIN32
+    #ifndef WIN32_LEAN_AND_MEAN
+        #define WIN32_LEAN_AND_MEAN
+    #endif
+    #include <windows.h>
+#else
+    #include <fcntl.h>
+    #include <sys/mman.h>
+    #include <sys/stat.h>
+    #include <unistd.h>
+#endif
+
+#define DDP_NO_KEYFRAME 0xFFFFFFFFu
+
+namespace ddp
+{
+
+RecordingReader::RecordingReader()
+{
+    m_data = nullptr;
+    m_size = 0;
+    #ifdef _WIN32
+        m_fileHandle = nullptr;
+        m_mappingHandle = nullptr;
+    #else
+        m_fd = -1;
+    #endif
+    m_startTimeUs = 0;
+    m_frameRecords = 0;
+    m_decodedIndex = 0;
+    m_decodedValid = false;
+}
+
+RecordingReader::~RecordingReader()
+{
+    close();
+}
+
+bool RecordingReader::open(const std::string& path)
+{
+    close();
+    m_path = path;
+
+    #ifdef _WIN32
+        HANDLE file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_WRITE, nullptr,
+                                  OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+        if (file == INVALID_HANDLE_VALUE)
+        {
+            m_lastError = "Cannot open " + path + ": error " + std::to_string(GetLastError());
+            return false;
+        }
+        LARGE_INTEGER fileSize;
+        if (!GetFileSizeEx(file, &fileSize) || fileSize.QuadPart < DDP_REC_FILE_HEADER_SIZE)
+        {
+            CloseHandle(file);
+            m_lastError = path + " is not a DDP recording";
+            return false;
+        }
+        HANDLE mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+        const void* view = mapping ? MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0) : nullptr;
+        if (!view)
+        {
+            if (mapping)
+                CloseHandle(mapping);
+            CloseHandle(file);
+            m_lastError = "Cannot map " + path + ": error " + std::to_string(GetLastError());
+            return false;
+        }
+        m_fileHandle = file;
+        m_mappingHandle = mapping;
+        m_data = static_cast<const uint8_t*>(view);
+        m_size = static_cast<size_t>(fileSize.QuadPart);
+    #else
+        int fd = ::open(path.c_str(), O_RDONLY);
+        if (fd < 0)
+        {
+            m_lastError = "Cannot open " + path + ": " + strerror(errno);
+            return false;
+        }
+        struct stat info;
+        if (fstat(fd, &info) != 0 || info.st_size < DDP_REC_FILE_HEADER_SIZE)
+        {
+            ::close(fd);
+            m_lastError = path + " is not a DDP recording";
+            return false;
+        }
+        void* view = mmap(nullptr, static_cast<size_t>(info.st_size), PROT_READ, MAP_SHARED, fd, 0);
+        if (view == MAP_FAILED)
+        {
+            ::close(fd);
+            m_lastError = "Cannot map " + path + ": " + strerror(errno);
+            return false;
+        }
+        m_fd = fd;
+        m_data = static_cast<const uint8_t*>(view);
+        m_size = static_cast<size_t>(info.st_size);
+    #endif
+
+    if (!unpackFileHeader(m_data, m_size, m_startTimeUs) || !buildIndex())
+    {
+        std::string error = m_lastError.empty() ? path + " is not a DDP recording" : m_lastError;
+        close();
+        m_lastError = error;
+        return false;
+    }
+
+    m_lastError = "";
+    return true;
+}
+
+void RecordingReader::close()
+{
+    if (m_data)
+    {
+        #ifdef _WIN32
+            UnmapViewOfFile(m_data);
+        #else
+            munmap(const_cast<uint8_t*>(m_data), m_size);
+        #endif
+    }
+    #ifdef _WIN32
+        if (m_mappingHandle)
+            CloseHandle(static_cast<HANDLE>(m_mappingHandle));
+        if (m_fileHandle)
+            CloseHandle(static_cast<HANDLE>(m_fileHandle));
+        m_mappingHandle = nullptr;
+        m_fileHandle = nullptr;
+    #else
+        if (m_fd >= 0)
+            ::close(m_fd);
+        m_fd = -1;
+    #endif
+
+    m_data = nullptr;
+    m_size = 0;
+    m_index.clear();
+    m_frameRecords = 0;
+    m_decoded.clear();
+    m_decodedValid = false;
+}
+
+bool RecordingReader::buildIndex()
+{
+    // Only the 24-byte record headers are touched, payloads stay on disk
+    size_t offset = DDP_REC_FILE_HEADER_SIZE;
+    uint32_t lastKeyframe = DDP_NO_KEYFRAME;
+    while (offset + DDP_REC_HEADER_SIZE <= m_size)
+    {
+        RecordHeader header;
+        unpackRecordHeader(m_data + offset, header);
+        if (header.storedSize > m_size - offset - DDP_REC_HEADER_SIZE)
+            break; // truncated final record
+        if (header.type != DDP_REC_TYPE_PACKET && header.type != DDP_REC_TYPE_FRAME)
+            break; // not a record boundary, stop at the last good one
+        if (!m_index.empty() && header.timestampUs < m_index.back().timestampUs)
+            break;
+
+        IndexEntry entry;
+        entry.timestampUs = header.timestampUs;
+        entry.offset = offset;
+        entry.type = header.type;
+        entry.dataType = header.dataType;
+        entry.keyframe = DDP_NO_KEYFRAME;
+        if (header.type == DDP_REC_TYPE_FRAME)
+        {
+            if (header.isKeyframe())
+                lastKeyframe = static_cast<uint32_t>(m_index.size());
+            entry.keyframe = lastKeyframe;
+            m_frameRecords++;
+        }
+        m_index.push_back(entry);
+
+        offset += DDP_REC_HEADER_SIZE + header.storedSize;
+    }
+    return true;
+}
+
+bool RecordingReader::findRecord(uint64_t timeUs, size_t& index) const
+{
+    auto later = std::upper_bound(m_index.begin(), m_index.end(), timeUs,
+                                  [](uint64_t t, const IndexEntry& entry) { return t < entry.timestampUs; });
+    if (later == m_index.begin())
+        return false;
+    index = static_cast<size_t>(later - m_index.begin()) - 1;
+    return true;
+}
+
+bool RecordingReader::unpackPayload(const RecordHeader& header, const uint8_t* stored,
+                                    const uint8_t*& data, size_t& length)
+{
+    data = stored;
+    length = header.storedSize;
+    if ((header.encoding & DDP_REC_ENC_LZ4) == 0)
+        return true;
+
+    size_t capacity = (header.encoding & DDP_REC_ENC_DELTA) ? maxDeltaSize(header.rawSize) : header.rawSize;
+    if (m_scratch.size() < capacity)
+        m_scratch.resize(capacity);
+    if (!decompressLZ4(stored, header.storedSize, m_scratch.data(), capacity, length))
+    {
+        m_lastError = lz4Available() ? "Corrupt LZ4 record" : "Recording uses LZ4, rebuild with LZ4 support to play it";
+        return false;
+    }
+    data = m_scratch.data();
+    return true;
+}
+
+bool RecordingReader::applyFrame(size_t index, std::vector<uint8_t>& frame)
+{
+    RecordHeader header;
+    unpackRecordHeader(m_data + m_index[index].offset, header);
+    const uint8_t* stored = m_data + m_index[index].offset + DDP_REC_HEADER_SIZE;
+
+    const uint8_t* data = nullptr;
+    size_t length = 0;
+    if (!unpackPayload(header, stored, data, length))
+        return false;
+
+    if (header.isKeyframe())
+    {
+        if (length != header.rawSize)
+            return false;
+        frame.assign(data, data + length);
+        return true;
+    }
+
+    if (frame.size() != header.rawSize || !decodeDelta(data, length, frame.data(), frame.size()))
+    {
+        m_lastError = "Corrupt delta frame";
+        return false;
+    }
+    return true;
+}
+
+bool RecordingReader::readFrame(size_t index, std::vector<uint8_t>& frame)
+{
+    if (index >= m_index.size() || m_index[index].type != DDP_REC_TYPE_FRAME)
+        return false;
+
+    uint32_t keyframe = m_index[index].keyframe;
+    if (keyframe == DDP_NO_KEYFRAME)
+        return false;
+
+    // Continue from the last decoded frame when it lies between the keyframe and 'index'
+    size_t start = keyframe;
+    if (m_decodedValid && m_decodedIndex <= index && m_decodedIndex >= keyframe)
+        start = m_decodedIndex + 1;
+
+    for (size_t i = start; i <= index; i++)
+    {
+        if (m_index[i].type != DDP_REC_TYPE_FRAME)
+            continue;
+        if (!applyFrame(i, m_decoded))
+        {
+            m_decodedValid = false;
+            return false;
+        }
+        m_decodedIndex = i;
+        m_decodedValid = true;
+    }
+
+    frame.assign(m_decoded.begin(), m_decoded.end());
+    return true;
+}
+
+bool RecordingReader::readPacket(size_t index, const uint8_t*& packet, size_t& length)
+{
+    if (index >= m_index.size() || m_index[index].type != DDP_REC_TYPE_PACKET)
+        return false;
+
+    RecordHeader header;
+    unpackRecordHeader(m_data + m_index[index].offset, header);
+    return unpackPayload(header, m_data + m_index[index].offset + DDP_REC_HEADER_SIZE, packet, length);
+}
+
+}
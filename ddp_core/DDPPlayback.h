@@ -0,0 +1,87 @@
+#ifndef __DDPPlayback__
+#define __DDPPlayback__
+
+#include "DDPRecording.h"
+
+#include <string>
+#include <vector>
+
+namespace ddp
+{
+
+// Read-only view of a .ddpr recording. The file is memory-mapped, so only the
+// pages holding the records being played are ever read into RAM. Opening scans
+// the record headers once to build a seek index; a recording that was cut
+// short ends at its last complete record.
+class RecordingReader
+{
+public:
+    RecordingReader();
+    ~RecordingReader();
+
+    bool open(const std::string& path);
+    void close();
+
+    bool isOpen() const { return m_data != nullptr; }
+    const std::string& path() const { return m_path; }
+    const std::string& lastError() const { return m_lastError; }
+
+    size_t recordCount() const { return m_index.size(); }
+    bool hasFrames() const { return m_frameRecords > 0; }
+    uint64_t startTimeUs() const { return m_startTimeUs; }         // wall clock at record start
+    uint64_t durationUs() const { return m_index.empty() ? 0 : m_index.back().timestampUs; }
+    uint64_t timestampUs(size_t index) const { return m_index[index].timestampUs; }
+    uint8_t recordType(size_t index) const { return m_index[index].type; }
+    uint8_t dataType(size_t index) const { return m_index[index].dataType; }  // frames; 0 = not recorded
+
+    // Last record at or before 'timeUs' (binary search). Returns false when the
+    // recording is empty or 'timeUs' is before the first record.
+    bool findRecord(uint64_t timeUs, size_t& index) const;
+
+    // Decode frame record 'index' into 'frame'. Stepping forward reuses the
+    // previous decode; any other jump restarts from the nearest keyframe.
+    bool readFrame(size_t index, std::vector<uint8_t>& frame);
+
+    // Packet record 'index' as stored (decompressed when needed). The pointer
+    // stays valid until the next call or close().
+    bool readPacket(size_t index, const uint8_t*& packet, size_t& length);
+
+private:
+    struct IndexEntry
+    {
+        uint64_t timestampUs;
+        uint64_t offset;         // of the record header
+        uint32_t keyframe;       // index of the keyframe this frame decodes from
+        uint8_t type;
+        uint8_t dataType;
+    };
+
+    bool buildIndex();
+    bool unpackPayload(const RecordHeader& header, const uint8_t* stored, const uint8_t*& data, size_t& length);
+    bool applyFrame(size_t index, std::vector<uint8_t>& frame);
+
+    std::string m_path;
+    std::string m_lastError;
+    const uint8_t* m_data;
+    size_t m_size;
+    #ifdef _WIN32
+        void* m_fileHandle;
+        void* m_mappingHandle;
+    #else
+        int m_fd;
+    #endif
+
+    uint64_t m_startTimeUs;
+    std::vector<IndexEntry> m_index;
+    size_t m_frameRecords;
+
+    // Decoder state: 'm_decoded' holds frame 'm_decodedIndex'
+    std::vector<uint8_t> m_decoded;
+    size_t m_decodedIndex;
+    bool m_decodedValid;
+    std::vector<uint8_t> m_scratch;
+};
+
+}
+
+#endif
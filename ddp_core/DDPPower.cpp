@@ -0,0 +1,105 @@
+#include "DDPPower.h"
+#include <algorithm>
+#include <cmath>
+
+namespace ddp
+{
+
+namespace
+{
+    // Channels > 0 fixes the stride at compile time. Block sums stay in
+    // registers and are added to the range once.
+    template<int Channels, typename T>
+    void meterValues(T* values, size_t count, size_t stride, RangePower& power)
+    {
+        if (Channels > 0)
+            stride = static_cast<size_t>(Channels);
+        const size_t counted = std::min<size_t>(stride, DDP_POWER_CHANNELS);
+        uint64_t sums[DDP_POWER_CHANNELS] = { 0, 0, 0, 0 };
+        const uint32_t scale = power.scale;
+        if (scale >= DDP_POWER_SCALE_ONE)
+        {
+            for (size_t i = 0; i < count; i++, values += stride)
+            {
+                for (size_t c = 0; c < counted; c++)
+                    sums[c] += values[c];
+            }
+        }
+        else
+        {
+            // Values are at most 16 bits, so value * scale fits 32 bits
+            for (size_t i = 0; i < count; i++, values += stride)
+            {
+                for (size_t c = 0; c < counted; c++)
+                    sums[c] += values[c];
+                for (size_t c = 0; c < stride; c++)
+                    values[c] = static_cast<T>((static_cast<uint32_t>(values[c]) * scale) >> 16);
+            }
+        }
+        for (size_t c = 0; c < counted; c++)
+            power.sums[c] += sums[c];
+    }
+    
+    template<typename T>
+    void meterDispatch(T* values, size_t count, int channelsPerPixel, RangePower& power)
+    {
+        const size_t stride = static_cast<size_t>(channelsPerPixel);
+        switch (channelsPerPixel)
+        {
+            case 3:  meterValues<3>(values, count, stride, power); break;
+            case 4:  meterValues<4>(values, count, stride, power); break;
+            default: meterValues<0>(values, count, stride, power); break;
+        }
+    }
+}
+
+void RangePower::reset()
+{
+    std::fill(sums, sums + DDP_POWER_CHANNELS, 0);
+}
+
+void meterPixels(uint8_t* values, size_t count, int channelsPerPixel, RangePower& power)
+{
+    meterDispatch(values, count, channelsPerPixel, power);
+}
+
+void meterPixels(uint16_t* values, size_t count, int channelsPerPixel, RangePower& power)
+{
+    meterDispatch(values, count, channelsPerPixel, power);
+}
+
+double estimateAmps(const RangePower& power, const float milliamps[DDP_POWER_CHANNELS], double fullScale)
+{
+    double total = 0.0;
+    for (int c = 0; c < DDP_POWER_CHANNELS; c++)
+        total += static_cast<double>(power.sums[c]) * milliamps[c];
+    return total / fullScale / 1000.0;
+}
+
+PowerLimiter::PowerLimiter()
+{
+    m_scale = 1.0f;
+}
+
+void PowerLimiter::update(double estimatedAmps, double budgetAmps, double elapsedSeconds, double releaseSeconds)
+{
+    float target = 1.0f;
+    if (budgetAmps > 0.0 && estimatedAmps > budgetAmps)
+        target = static_cast<float>(budgetAmps / estimatedAmps);
+    
+    // A supply trips faster than it recovers, so only the release is smoothed
+    if (target <= m_scale || releaseSeconds <= 0.0)
+    {
+        m_scale = target;
+        return;
+    }
+    double blend = 1.0 - std::exp(-std::max(0.0, elapsedSeconds) / releaseSeconds);
+    m_scale += static_cast<float>((target - m_scale) * blend);
+}
+
+uint32_t PowerLimiter::fixedScale() const
+{
+    return static_cast<uint32_t>(std::lround(std::max(0.0f, std::min(1.0f, m_scale)) * DDP_POWER_SCALE_ONE));
+}
+
+}
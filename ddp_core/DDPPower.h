@@ -0,0 +1,57 @@
+#ifndef __DDPPower__
+#define __DDPPower__
+
+#include <cstddef>
+#include <cstdint>
+
+// Channels whose current is estimated: R, G, B, W in wire positions 0-3
+#define DDP_POWER_CHANNELS 4
+
+// Limiter scale of 1.0 in the 16-bit fixed point the metering pass applies
+#define DDP_POWER_SCALE_ONE 65536u
+
+namespace ddp
+{
+
+// Current metering of one range, filled in by the conversion pass (see
+// convertRuns()). 'sums' add up the values of each wire position before
+// 'scale' is applied, so they estimate what the range would draw unlimited.
+struct RangePower
+{
+    uint32_t scale = DDP_POWER_SCALE_ONE;
+    uint64_t sums[DDP_POWER_CHANNELS] = { 0, 0, 0, 0 };
+    
+    void reset();
+};
+
+// Adds converted values of 'count' pixels to power.sums and scales them by
+// power.scale, in place, in the same pass
+void meterPixels(uint8_t* values, size_t count, int channelsPerPixel, RangePower& power);
+void meterPixels(uint16_t* values, size_t count, int channelsPerPixel, RangePower& power);
+
+// Amps of the metered values. 'milliamps' is the draw of each wire position
+// at 'fullScale' (255 for bytes, 65280 for dither levels, 65535 for 16-bit).
+double estimateAmps(const RangePower& power, const float milliamps[DDP_POWER_CHANNELS], double fullScale);
+
+// Brightness scale that keeps a range within its budget. A frame over budget
+// pulls the scale down at once; it recovers with a 'releaseSeconds' time
+// constant so content hovering at the limit does not pump.
+class PowerLimiter
+{
+public:
+    PowerLimiter();
+    
+    // 'estimatedAmps' is the unlimited draw of the last frame, budget 0 = unlimited
+    void update(double estimatedAmps, double budgetAmps, double elapsedSeconds, double releaseSeconds);
+    
+    float scale() const { return m_scale; }
+    uint32_t fixedScale() const;
+    void reset() { m_scale = 1.0f; }
+
+private:
+    float m_scale;
+};
+
+}
+
+#endif
@@ -0,0 +1,227 @@
+#ifndef __DDPProtocol__
+#define __DDPProtocol__
+
+#include <cstddef>
+#include <cstdint>
+
+// DDP Protocol Constants (from official spec: http://www.3waylabs.com/ddp/)
+#define DDP_PORT 4048
+#define DDP_HEADER_SIZE 10
+#define DDP_MAX_DATALEN (480 * 3)  // 1440 bytes - official spec recommendation
+#define DDP_MAX_PIXELS_PER_PACKET 480
+
+// Jumbo frame support: the DDP length field is 16-bit, but a single UDP/IPv4
+// datagram can carry at most 65507 bytes, so that is the practical ceiling
+#define DDP_UDP_MAX_PAYLOAD   65507
+#define DDP_MAX_DATALEN_LIMIT (DDP_UDP_MAX_PAYLOAD - DDP_HEADER_SIZE)
+#define DDP_IPV4_UDP_OVERHEAD 28  // IPv4 (20) + UDP (8) header bytes
+#define DDP_IPV6_UDP_OVERHEAD 48  // IPv6 (40) + UDP (8) header bytes
+
+// Largest frame a receiver will assemble, guards against bogus offsets
+#define DDP_MAX_FRAME_BYTES (64 * 1024 * 1024)
+
+// Optional timecode appended to the header when DDP_FLAGS1_TIME is set.
+// 16.16 fixed point seconds (upper 16 bits seconds, lower 16 bits fraction)
+#define DDP_TIMECODE_SIZE 4
+#define DDP_MAX_HEADER_SIZE (DDP_HEADER_SIZE + DDP_TIMECODE_SIZE)
+
+// DDP Flags (Byte 0)
+#define DDP_FLAGS1_VER     0xC0  // Version mask
+#define DDP_FLAGS1_VER1    0x40  // Version 1
+#define DDP_FLAGS1_PUSH    0x01  // Push flag - display data now (sync)
+#define DDP_FLAGS1_QUERY   0x02  // Query request
+#define DDP_FLAGS1_REPLY   0x04  // Reply to query
+#define DDP_FLAGS1_STORAGE 0x08  // Use local storage
+#define DDP_FLAGS1_TIME    0x10  // Timecode field present
+
+// DDP IDs
+#define DDP_ID_DISPLAY  1    // Display data
+#define DDP_ID_CONFIG   250  // Configuration
+#define DDP_ID_STATUS   251  // Status/discovery
+
+// DDP Data Types (legacy values, 8 bits per element)
+#define DDP_DATA_TYPE_RGB  0x01
+#define DDP_DATA_TYPE_HSL  0x02
+#define DDP_DATA_TYPE_RGBW 0x03
+
+// Data type byte as laid out by the spec: C R TTT SSS (customer, reserved,
+// type, element size). Size 3 is 8 bits per element, 4 is 16 bits.
+#define DDP_TYPE_CUSTOM    0x80
+#define DDP_TYPE_KIND_MASK 0x38
+#define DDP_TYPE_SIZE_MASK 0x07
+#define DDP_TYPE_KIND_RGB  0x08
+#define DDP_TYPE_KIND_HSL  0x10
+#define DDP_TYPE_KIND_RGBW 0x18
+#define DDP_TYPE_KIND_GRAY 0x20
+#define DDP_TYPE_SIZE_8    0x03
+#define DDP_TYPE_SIZE_16   0x04
+#define DDP_DATA_TYPE_RGB16  (DDP_TYPE_KIND_RGB | DDP_TYPE_SIZE_16)    // 0x0C
+#define DDP_DATA_TYPE_RGBW16 (DDP_TYPE_KIND_RGBW | DDP_TYPE_SIZE_16)   // 0x1C
+
+namespace ddp
+{
+
+// Decoded view of a DDP header. 'payload' points into the packet buffer.
+struct PacketHeader
+{
+    uint8_t  flags = DDP_FLAGS1_VER1;
+    uint8_t  sequence = 0;
+    uint8_t  dataType = DDP_DATA_TYPE_RGB;
+    uint8_t  destId = DDP_ID_DISPLAY;
+    uint32_t offset = 0;
+    uint16_t length = 0;
+    uint32_t timecode = 0;
+
+    constexpr bool hasTimecode() const { return (flags & DDP_FLAGS1_TIME) != 0; }
+    constexpr bool isPush() const { return (flags & DDP_FLAGS1_PUSH) != 0; }
+    constexpr size_t size() const { return DDP_HEADER_SIZE + (hasTimecode() ? DDP_TIMECODE_SIZE : 0); }
+};
+
+constexpr size_t headerSize(bool withTimecode)
+{
+    return DDP_HEADER_SIZE + (withTimecode ? DDP_TIMECODE_SIZE : 0);
+}
+
+// Type byte for pixel data. 8-bit output keeps the legacy RGB value every
+// receiver accepts; 16-bit output names RGB or RGBW by the pixel size.
+constexpr uint8_t pixelDataType(int channelsPerPixel, int bitsPerElement)
+{
+    return bitsPerElement != 16 ? DDP_DATA_TYPE_RGB
+         : channelsPerPixel == 4 ? DDP_DATA_TYPE_RGBW16
+         : channelsPerPixel == 3 ? DDP_DATA_TYPE_RGB16
+         : DDP_TYPE_SIZE_16;
+}
+
+// Pixel data we can show: the legacy types and any 8 or 16-bit standard type
+constexpr bool isPixelDataType(uint8_t dataType)
+{
+    return dataType == DDP_DATA_TYPE_RGB || dataType == DDP_DATA_TYPE_RGBW ||
+           ((dataType & DDP_TYPE_CUSTOM) == 0 &&
+            ((dataType & DDP_TYPE_SIZE_MASK) == DDP_TYPE_SIZE_8 || (dataType & DDP_TYPE_SIZE_MASK) == DDP_TYPE_SIZE_16));
+}
+
+constexpr int bitsPerElement(uint8_t dataType)
+{
+    return (dataType & DDP_TYPE_CUSTOM) == 0 && (dataType & DDP_TYPE_SIZE_MASK) == DDP_TYPE_SIZE_16 ? 16 : 8;
+}
+
+// Elements per pixel named by a standard type byte, 0 when it does not say
+// (the legacy values, which our 8-bit output stamps whatever the pixel size)
+constexpr int elementsPerPixel(uint8_t dataType)
+{
+    return (dataType & DDP_TYPE_CUSTOM) != 0 || !isPixelDataType(dataType) ? 0
+         : (dataType & DDP_TYPE_KIND_MASK) == DDP_TYPE_KIND_RGBW ? 4
+         : (dataType & DDP_TYPE_KIND_MASK) == DDP_TYPE_KIND_RGB ? 3
+         : (dataType & DDP_TYPE_KIND_MASK) == DDP_TYPE_KIND_HSL ? 3
+         : (dataType & DDP_TYPE_KIND_MASK) == DDP_TYPE_KIND_GRAY ? 1
+         : 0;
+}
+
+constexpr uint16_t readBE16(const uint8_t* p)
+{
+    return static_cast<uint16_t>((static_cast<uint16_t>(p[0]) << 8) | p[1]);
+}
+
+constexpr uint32_t readBE32(const uint8_t* p)
+{
+    return (static_cast<uint32_t>(p[0]) << 24) |
+           (static_cast<uint32_t>(p[1]) << 16) |
+           (static_cast<uint32_t>(p[2]) << 8) |
+           static_cast<uint32_t>(p[3]);
+}
+
+constexpr void writeBE16(uint8_t* p, uint16_t v)
+{
+    p[0] = static_cast<uint8_t>(v >> 8);
+    p[1] = static_cast<uint8_t>(v);
+}
+
+constexpr void writeBE32(uint8_t* p, uint32_t v)
+{
+    p[0] = static_cast<uint8_t>(v >> 24);
+    p[1] = static_cast<uint8_t>(v >> 16);
+    p[2] = static_cast<uint8_t>(v >> 8);
+    p[3] = static_cast<uint8_t>(v);
+}
+
+// Pack 'h' into 'out' (at least h.size() bytes). Returns the number of bytes written.
+constexpr size_t packHeader(const PacketHeader& h, uint8_t* out)
+{
+    out[0] = h.flags;
+    out[1] = h.sequence & 0x0F;  // sequence lives in the lower 4 bits
+    out[2] = h.dataType;
+    out[3] = h.destId;
+    writeBE32(out + 4, h.offset);
+    writeBE16(out + 8, h.length);
+    if (h.hasTimecode())
+        writeBE32(out + DDP_HEADER_SIZE, h.timecode);
+    return h.size();
+}
+
+// Unpack and validate a received packet. On success 'payload' points at the
+// 'h.length' data bytes following the header.
+constexpr bool unpackHeader(const uint8_t* buffer, size_t length, PacketHeader& h, const uint8_t*& payload)
+{
+    if (length < DDP_HEADER_SIZE)
+        return false;
+
+    h.flags = buffer[0];
+    if ((h.flags & DDP_FLAGS1_VER) != DDP_FLAGS1_VER1)
+        return false;
+
+    h.sequence = buffer[1] & 0x0F;
+    h.dataType = buffer[2];
+    h.destId = buffer[3];
+    h.offset = readBE32(buffer + 4);
+    h.length = readBE16(buffer + 8);
+    h.timecode = 0;
+
+    if (h.hasTimecode())
+    {
+        if (length < DDP_HEADER_SIZE + DDP_TIMECODE_SIZE)
+            return false;
+        h.timecode = readBE32(buffer + DDP_HEADER_SIZE);
+    }
+
+    size_t dataStart = h.size();
+    if (h.length > length - dataStart || h.length > DDP_MAX_DATALEN_LIMIT)
+        return false;
+
+    payload = buffer + dataStart;
+    return true;
+}
+
+namespace detail
+{
+    // Compile-time round trip of a timecoded header
+    constexpr bool headerRoundTrip()
+    {
+        PacketHeader in;
+        in.flags = DDP_FLAGS1_VER1 | DDP_FLAGS1_PUSH | DDP_FLAGS1_TIME;
+        in.sequence = 0x1A;
+        in.offset = 0x01020304;
+        in.length = 3;
+        in.timecode = 0xA1B2C3D4;
+
+        uint8_t packet[DDP_MAX_HEADER_SIZE + 3] = {};
+        size_t written = packHeader(in, packet);
+
+        PacketHeader out;
+        const uint8_t* payload = nullptr;
+        return written == DDP_MAX_HEADER_SIZE &&
+               unpackHeader(packet, sizeof(packet), out, payload) &&
+               out.sequence == 0x0A && out.offset == in.offset && out.length == 3 &&
+               out.timecode == in.timecode && out.isPush() && payload == packet + DDP_MAX_HEADER_SIZE;
+    }
+    static_assert(headerRoundTrip(), "DDP header pack/unpack mismatch");
+    static_assert(pixelDataType(3, 16) == 0x0C && pixelDataType(4, 16) == 0x1C && pixelDataType(3, 8) == 0x01 &&
+                  bitsPerElement(0x0C) == 16 && bitsPerElement(0x0B) == 8 && bitsPerElement(DDP_DATA_TYPE_RGB) == 8 &&
+                  isPixelDataType(0x1C) && !isPixelDataType(0x8C) && !isPixelDataType(0x0E) &&
+                  elementsPerPixel(0x0C) == 3 && elementsPerPixel(0x1C) == 4 && elementsPerPixel(0x0B) == 3 &&
+                  elementsPerPixel(DDP_DATA_TYPE_RGB) == 0 && elementsPerPixel(DDP_TYPE_SIZE_16) == 0,
+                  "DDP data type byte mismatch");
+}
+
+}
+
+#endif
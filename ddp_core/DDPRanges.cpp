@@ -0,0 +1,178 @@
+#include "DDPRanges.h"
+#include <algorithm>
+#include <cctype>
+#include <cstdlib>
+
+namespace ddp
+{
+
+namespace
+{
+    std::string trimmedLower(const char* cell)
+    {
+        std::string text;
+        for (const char* p = cell ? cell : ""; *p; p++)
+        {
+            if (!isspace(static_cast<unsigned char>(*p)))
+                text += static_cast<char>(tolower(static_cast<unsigned char>(*p)));
+        }
+        return text;
+    }
+
+    bool parseCount(const char* cell, uint32_t& value)
+    {
+        if (!cell)
+            return false;
+        char* end = nullptr;
+        long number = strtol(cell, &end, 10);
+        if (end == cell || number < 0)
+            return false;
+        value = static_cast<uint32_t>(std::min<long>(number, DDP_LAYOUT_MAX_PIXELS));
+        return true;
+    }
+
+    size_t rangeEnd(const PixelRange& range, size_t totalPixels)
+    {
+        if (range.count == 0)
+            return std::max<size_t>(totalPixels, range.start);
+        return static_cast<size_t>(range.start) + range.count;
+    }
+}
+
+RangeTableParser::RangeTableParser()
+{
+    m_name = -1;
+    m_start = 0;
+    m_count = 1;
+    m_order = 2;
+    m_matrix = m_gain = m_offset = m_white = m_budget = -1;
+    m_protocol = m_address = m_universe = m_channels = -1;
+}
+
+bool RangeTableParser::parseRow(const char* const* cells, int numCells, PixelRange& range)
+{
+    // A row naming a "start" column is the header
+    for (int i = 0; i < numCells; i++)
+    {
+        if (trimmedLower(cells[i]) != "start")
+            continue;
+        m_name = m_start = m_count = m_order = -1;
+        m_matrix = m_gain = m_offset = m_white = m_budget = -1;
+        m_protocol = m_address = m_universe = m_channels = -1;
+        for (int j = 0; j < numCells; j++)
+        {
+            std::string name = trimmedLower(cells[j]);
+            if (name == "name")
+                m_name = j;
+            else if (name == "start")
+                m_start = j;
+            else if (name == "count")
+                m_count = j;
+            else if (name == "order")
+                m_order = j;
+            else if (name == "matrix")
+                m_matrix = j;
+            else if (name == "gain")
+                m_gain = j;
+            else if (name == "offset")
+                m_offset = j;
+            else if (name == "white")
+                m_white = j;
+            else if (name == "budget")
+                m_budget = j;
+            else if (name == "protocol")
+                m_protocol = j;
+            else if (name == "address")
+                m_address = j;
+            else if (name == "universe")
+                m_universe = j;
+            else if (name == "channels")
+                m_channels = j;
+        }
+        return false;
+    }
+
+    auto cell = [cells, numCells](int index) -> const char* {
+        return index >= 0 && index < numCells ? cells[index] : nullptr;
+    };
+    if (!parseCount(cell(m_start), range.start))
+        return false;
+    range.count = 0;
+    parseCount(cell(m_count), range.count);
+    range.name = cell(m_name) ? cell(m_name) : "";
+    range.order = cell(m_order) ? cell(m_order) : "";
+    range.matrix = cell(m_matrix) ? cell(m_matrix) : "";
+    range.gain = cell(m_gain) ? cell(m_gain) : "";
+    range.offset = cell(m_offset) ? cell(m_offset) : "";
+    range.white = cell(m_white) ? cell(m_white) : "";
+    range.budget = cell(m_budget) ? cell(m_budget) : "";
+    range.protocol = cell(m_protocol) ? cell(m_protocol) : "";
+    range.address = cell(m_address) ? cell(m_address) : "";
+    range.universe = cell(m_universe) ? cell(m_universe) : "";
+    range.channels = cell(m_channels) ? cell(m_channels) : "";
+    return true;
+}
+
+bool sortRanges(std::vector<PixelRange>& ranges, std::string& error)
+{
+    std::stable_sort(ranges.begin(), ranges.end(),
+                     [](const PixelRange& a, const PixelRange& b) { return a.start < b.start; });
+    for (size_t i = 1; i < ranges.size(); i++)
+    {
+        const PixelRange& previous = ranges[i - 1];
+        if (previous.count == 0 || previous.start + previous.count > ranges[i].start)
+        {
+            error = "Range starting at pixel " + std::to_string(ranges[i].start) +
+                    " overlaps the one starting at " + std::to_string(previous.start);
+            return false;
+        }
+    }
+    return true;
+}
+
+void splitRuns(const std::vector<LayoutRun>& runs, const std::vector<PixelRange>& ranges,
+               size_t totalPixels, std::vector<LayoutRun>& pieces)
+{
+    pieces.clear();
+    size_t wire = 0;
+    size_t next = 0;     // first range that does not end before the current pixel
+    for (const LayoutRun& run : runs)
+    {
+        size_t offset = 0;
+        while (offset < run.count)
+        {
+            size_t position = wire + offset;
+            while (next < ranges.size() && rangeEnd(ranges[next], totalPixels) <= position)
+                next++;
+
+            size_t length = run.count - offset;
+            uint16_t order = 0;
+            if (next < ranges.size())
+            {
+                if (position >= ranges[next].start)
+                {
+                    order = static_cast<uint16_t>(next + 1);
+                    length = std::min(length, rangeEnd(ranges[next], totalPixels) - position);
+                }
+                else
+                {
+                    length = std::min<size_t>(length, ranges[next].start - position);
+                }
+            }
+
+            // A piece of a reversed run reads the top end of what is left
+            LayoutRun piece = run;
+            piece.count = static_cast<uint32_t>(length);
+            piece.order = order;
+            if (run.step > 0)
+                piece.source = run.source + static_cast<uint32_t>(offset);
+            else if (run.step < 0)
+                piece.source = run.source + run.count - static_cast<uint32_t>(offset + length);
+            pieces.push_back(piece);
+            offset += length;
+        }
+        wire += run.count;
+    }
+}
+
+}
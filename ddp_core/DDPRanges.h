@@ -0,0 +1,76 @@
+#ifndef __DDPRanges__
+#define __DDPRanges__
+
+#include "DDPLayout.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace ddp
+{
+
+// A block of pixels on the wire with settings of its own, one row of a
+// Ranges DAT
+struct PixelRange
+{
+    std::string name;
+    uint32_t start = 0;     // first pixel on the wire
+    uint32_t count = 0;     // 0 = to the end of the frame
+    std::string order;      // color order, empty = the output's
+
+    // Calibration (see DDPCalibration.h), each empty = the output's
+    std::string matrix;
+    std::string gain;
+    std::string offset;
+    std::string white;
+    
+    std::string budget;     // power limit in amps, empty = the output's
+
+    // Transport (see DDPTransport.h), each empty = the output's DDP stream
+    std::string protocol;
+    std::string address;
+    std::string universe;
+    std::string channels;
+};
+
+// Reads the rows of a Ranges DAT. A header row naming the columns (name,
+// start, count, order, matrix, gain, offset, white, budget, protocol,
+// address, universe, channels, in any order) may come first; without one
+// the columns are start, count, order.
+class RangeTableParser
+{
+public:
+    RangeTableParser();
+
+    // False for the header and for rows without a start pixel
+    bool parseRow(const char* const* cells, int numCells, PixelRange& range);
+
+private:
+    int m_name;     // column indices, -1 = not in the table
+    int m_start;
+    int m_count;
+    int m_order;
+    int m_matrix;
+    int m_gain;
+    int m_offset;
+    int m_white;
+    int m_budget;
+    int m_protocol;
+    int m_address;
+    int m_universe;
+    int m_channels;
+};
+
+// Sorts by start pixel; ranges that overlap are an error
+bool sortRanges(std::vector<PixelRange>& ranges, std::string& error);
+
+// Splits runs (in wire order, 'totalPixels' in all) where ranges begin and
+// end. Pieces inside ranges[i] get order i + 1, everything else order 0.
+void splitRuns(const std::vector<LayoutRun>& runs, const std::vector<PixelRange>& ranges,
+               size_t totalPixels, std::vector<LayoutRun>& pieces);
+
+}
+
+#endif
@@ -0,0 +1,580 @@
+#include "DDPRecording.h"
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cstring>
+
+#ifdef DDP_HAVE_LZ4
+    #include <lz4.h>
+#endif
+
+// Unchanged gaps shorter than this are copied rather than skipped
+#define DDP_DELTA_MIN_SKIP 8
+
+// stdio buffer for the recording file
+#define DDP_REC_FILE_BUFFER (1024 * 1024)
+
+namespace ddp
+{
+
+namespace
+{
+    void writeLE16(uint8_t* p, uint16_t v)
+    {
+        p[0] = static_cast<uint8_t>(v);
+        p[1] = static_cast<uint8_t>(v >> 8);
+    }
+
+    void writeLE32(uint8_t* p, uint32_t v)
+    {
+        for (int i = 0; i < 4; i++)
+            p[i] = static_cast<uint8_t>(v >> (8 * i));
+    }
+
+    void writeLE64(uint8_t* p, uint64_t v)
+    {
+        for (int i = 0; i < 8; i++)
+            p[i] = static_cast<uint8_t>(v >> (8 * i));
+    }
+
+    uint16_t readLE16(const uint8_t* p)
+    {
+        return static_cast<uint16_t>(p[0] | (p[1] << 8));
+    }
+
+    uint32_t readLE32(const uint8_t* p)
+    {
+        uint32_t v = 0;
+        for (int i = 3; i >= 0; i--)
+            v = (v << 8) | p[i];
+        return v;
+    }
+
+    uint64_t readLE64(const uint8_t* p)
+    {
+        uint64_t v = 0;
+        for (int i = 7; i >= 0; i--)
+            v = (v << 8) | p[i];
+        return v;
+    }
+
+    void putVarint(std::vector<uint8_t>& out, size_t value)
+    {
+        while (value >= 0x80)
+        {
+            out.push_back(static_cast<uint8_t>(value | 0x80));
+            value >>= 7;
+        }
+        out.push_back(static_cast<uint8_t>(value));
+    }
+
+    bool getVarint(const uint8_t*& p, const uint8_t* end, size_t& value)
+    {
+        value = 0;
+        for (int shift = 0; shift < 64 && p < end; shift += 7)
+        {
+            uint8_t byte = *p++;
+            value |= static_cast<size_t>(byte & 0x7F) << shift;
+            if ((byte & 0x80) == 0)
+                return true;
+        }
+        return false;
+    }
+
+    // Length of the run of equal bytes starting at 'pos', compared 8 bytes at a time
+    size_t equalRun(const uint8_t* a, const uint8_t* b, size_t pos, size_t length)
+    {
+        size_t start = pos;
+        while (pos + 8 <= length)
+        {
+            uint64_t x, y;
+            memcpy(&x, a + pos, 8);
+            memcpy(&y, b + pos, 8);
+            if (x != y)
+                break;
+            pos += 8;
+        }
+        while (pos < length && a[pos] == b[pos])
+            pos++;
+        return pos - start;
+    }
+
+    double steadySeconds()
+    {
+        auto now = std::chrono::steady_clock::now().time_since_epoch();
+        return std::chrono::duration<double>(now).count();
+    }
+}
+
+RecordCompression recordCompressionFromName(const std::string& name)
+{
+    if (name == "delta")
+        return RecordCompression::Delta;
+    if (name == "lz4")
+        return RecordCompression::LZ4;
+    if (name == "deltalz4")
+        return RecordCompression::DeltaLZ4;
+    return RecordCompression::None;
+}
+
+void packRecordHeader(const RecordHeader& h, uint8_t* out)
+{
+    out[0] = h.type;
+    out[1] = h.encoding;
+    out[2] = h.flags;
+    out[3] = h.dataType;
+    writeLE32(out + 4, h.storedSize);
+    writeLE32(out + 8, h.rawSize);
+    writeLE32(out + 12, h.timecode);
+    writeLE64(out + 16, h.timestampUs);
+}
+
+void unpackRecordHeader(const uint8_t* in, RecordHeader& h)
+{
+    h.type = in[0];
+    h.encoding = in[1];
+    h.flags = in[2];
+    h.dataType = in[3];
+    h.storedSize = readLE32(in + 4);
+    h.rawSize = readLE32(in + 8);
+    h.timecode = readLE32(in + 12);
+    h.timestampUs = readLE64(in + 16);
+}
+
+void packFileHeader(uint64_t startTimeUs, uint8_t* out)
+{
+    memcpy(out, DDP_REC_MAGIC, 6);
+    out[6] = DDP_REC_VERSION;
+    out[7] = 0;
+    writeLE64(out + 8, startTimeUs);
+}
+
+bool unpackFileHeader(const uint8_t* in, size_t length, uint64_t& startTimeUs)
+{
+    if (length < DDP_REC_FILE_HEADER_SIZE || memcmp(in, DDP_REC_MAGIC, 6) != 0 ||
+        in[6] < DDP_REC_MIN_VERSION || in[6] > DDP_REC_VERSION)
+        return false;
+    startTimeUs = readLE64(in + 8);
+    return true;
+}
+
+void encodeDelta(const uint8_t* previous, const uint8_t* current, size_t length, std::vector<uint8_t>& out)
+{
+    out.clear();
+    size_t pos = 0;
+    while (pos < length)
+    {
+        size_t skip = equalRun(previous, current, pos, length);
+        pos += skip;
+        if (pos == length)
+            break; // trailing unchanged bytes need no op
+
+        // Extend the copy run until a long enough unchanged gap (or the end)
+        size_t copyStart = pos;
+        while (pos < length)
+        {
+            if (previous[pos] != current[pos])
+            {
+                pos++;
+                continue;
+            }
+            size_t gap = equalRun(previous, current, pos, std::min(length, pos + DDP_DELTA_MIN_SKIP));
+            if (gap >= DDP_DELTA_MIN_SKIP || pos + gap == length)
+                break;
+            pos += gap;
+        }
+
+        putVarint(out, skip);
+        putVarint(out, pos - copyStart);
+        out.insert(out.end(), current + copyStart, current + pos);
+    }
+}
+
+bool decodeDelta(const uint8_t* stream, size_t streamLength, uint8_t* frame, size_t frameLength)
+{
+    const uint8_t* p = stream;
+    const uint8_t* end = stream + streamLength;
+    size_t pos = 0;
+    while (p < end)
+    {
+        size_t skip = 0;
+        size_t copy = 0;
+        if (!getVarint(p, end, skip) || !getVarint(p, end, copy))
+            return false;
+        if (skip > frameLength - pos || copy > frameLength - pos - skip || copy > static_cast<size_t>(end - p))
+            return false;
+
+        pos += skip;
+        memcpy(frame + pos, p, copy);
+        pos += copy;
+        p += copy;
+    }
+    return true;
+}
+
+size_t maxDeltaSize(size_t frameLength)
+{
+    // Every op copies at least one byte and skips DDP_DELTA_MIN_SKIP (two varints of at most 10 bytes)
+    return frameLength + 20 * (frameLength / (DDP_DELTA_MIN_SKIP + 1) + 1);
+}
+
+bool lz4Available()
+{
+    #ifdef DDP_HAVE_LZ4
+        return true;
+    #else
+        return false;
+    #endif
+}
+
+bool compressLZ4(const uint8_t* src, size_t length, std::vector<uint8_t>& out)
+{
+    #ifdef DDP_HAVE_LZ4
+        if (length > static_cast<size_t>(LZ4_MAX_INPUT_SIZE))
+            return false;
+        out.resize(static_cast<size_t>(LZ4_compressBound(static_cast<int>(length))));
+        int written = LZ4_compress_default(reinterpret_cast<const char*>(src), reinterpret_cast<char*>(out.data()),
+                                           static_cast<int>(length), static_cast<int>(out.size()));
+        if (written <= 0)
+            return false;
+        out.resize(static_cast<size_t>(written));
+        return true;
+    #else
+        (void)src;
+        (void)length;
+        (void)out;
+        return false;
+    #endif
+}
+
+bool decompressLZ4(const uint8_t* src, size_t length, uint8_t* dst, size_t capacity, size_t& written)
+{
+    #ifdef DDP_HAVE_LZ4
+        int result = LZ4_decompress_safe(reinterpret_cast<const char*>(src), reinterpret_cast<char*>(dst),
+                                         static_cast<int>(length), static_cast<int>(std::min(capacity, size_t(0x7FFFFFFF))));
+        if (result < 0)
+            return false;
+        written = static_cast<size_t>(result);
+        return true;
+    #else
+        (void)src;
+        (void)length;
+        (void)dst;
+        (void)capacity;
+        written = 0;
+        return false;
+    #endif
+}
+
+RecordingWriter::RecordingWriter()
+{
+    m_file = nullptr;
+    m_compression = RecordCompression::None;
+    m_keyframeInterval = DDP_REC_KEYFRAME_INTERVAL;
+    m_startTime = 0.0;
+    m_queuedBytes = 0;
+    m_stop = false;
+    m_framesSinceKeyframe = 0;
+    m_recordsWritten = 0;
+    m_recordsDropped = 0;
+    m_rawBytes = 0;
+    m_fileBytes = 0;
+}
+
+RecordingWriter::~RecordingWriter()
+{
+    close();
+}
+
+bool RecordingWriter::open(const std::string& path, RecordCompression compression, int keyframeInterval)
+{
+    close();
+
+    FILE* file = fopen(path.c_str(), "wb");
+    if (!file)
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_lastError = "Cannot open recording file " + path + ": " + strerror(errno);
+        return false;
+    }
+    setvbuf(file, nullptr, _IOFBF, DDP_REC_FILE_BUFFER);
+
+    auto wallClock = std::chrono::system_clock::now().time_since_epoch();
+    uint8_t fileHeader[DDP_REC_FILE_HEADER_SIZE];
+    packFileHeader(static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::microseconds>(wallClock).count()), fileHeader);
+    if (fwrite(fileHeader, 1, sizeof(fileHeader), file) != sizeof(fileHeader))
+    {
+        fclose(file);
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_lastError = "Cannot write recording file " + path;
+        return false;
+    }
+
+    // LZ4 requested in a build without it falls back to what is available
+    if (!lz4Available())
+    {
+        if (compression == RecordCompression::LZ4)
+            compression = RecordCompression::None;
+        else if (compression == RecordCompression::DeltaLZ4)
+            compression = RecordCompression::Delta;
+    }
+
+    m_path = path;
+    m_file = file;
+    m_compression = compression;
+    m_keyframeInterval = std::max(1, keyframeInterval);
+    m_startTime = steadySeconds();
+    m_previousFrame.clear();
+    m_framesSinceKeyframe = 0;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stop = false;
+        m_recordsWritten = 0;
+        m_recordsDropped = 0;
+        m_rawBytes = 0;
+        m_fileBytes = DDP_REC_FILE_HEADER_SIZE;
+        m_lastError = "";
+    }
+
+    m_thread = std::thread(&RecordingWriter::writerLoop, this);
+    return true;
+}
+
+void RecordingWriter::close()
+{
+    if (!m_file)
+        return;
+
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stop = true;
+    }
+    m_wake.notify_all();
+    if (m_thread.joinable())
+        m_thread.join();
+
+    fclose(m_file);
+    m_file = nullptr;
+}
+
+bool RecordingWriter::writePacket(const uint8_t* header, size_t headerLength, const uint8_t* payload, size_t payloadLength)
+{
+    return enqueue(DDP_REC_TYPE_PACKET, 0, 0, 0, header, headerLength, payload, payloadLength);
+}
+
+bool RecordingWriter::writeFrame(const uint8_t* frame, size_t length, bool hasTimecode, uint32_t timecode,
+                                 uint8_t dataType)
+{
+    return enqueue(DDP_REC_TYPE_FRAME, hasTimecode ? DDP_REC_FLAG_TIMECODE : 0, dataType, timecode,
+                   frame, length, nullptr, 0);
+}
+
+uint64_t RecordingWriter::elapsedMicros() const
+{
+    return static_cast<uint64_t>((steadySeconds() - m_startTime) * 1e6);
+}
+
+bool RecordingWriter::enqueue(uint8_t type, uint8_t flags, uint8_t dataType, uint32_t timecode,
+                              const uint8_t* part1, size_t length1, const uint8_t* part2, size_t length2)
+{
+    if (!m_file)
+        return false;
+
+    size_t length = length1 + length2;
+    uint64_t timestamp = elapsedMicros();
+
+    std::unique_lock<std::mutex> lock(m_mutex);
+    if (m_queuedBytes + length > DDP_REC_MAX_QUEUED_BYTES || length > 0xFFFFFFFFu)
+    {
+        m_recordsDropped++;
+        return false;
+    }
+
+    Pending record;
+    record.type = type;
+    record.flags = flags;
+    record.dataType = dataType;
+    record.timecode = timecode;
+    record.timestampUs = timestamp;
+    if (!m_spareBuffers.empty())
+    {
+        record.data.swap(m_spareBuffers.back());
+        m_spareBuffers.pop_back();
+    }
+    m_queuedBytes += length;
+    lock.unlock();
+
+    // Copy outside the lock so the writer thread is never held up by a large frame
+    record.data.resize(length);
+    if (length1 > 0)
+        memcpy(record.data.data(), part1, length1);
+    if (length2 > 0)
+        memcpy(record.data.data() + length1, part2, length2);
+
+    lock.lock();
+    m_queue.push_back(std::move(record));
+    lock.unlock();
+    m_wake.notify_one();
+    return true;
+}
+
+void RecordingWriter::writerLoop()
+{
+    double lastFlush = steadySeconds();
+    std::unique_lock<std::mutex> lock(m_mutex);
+    while (true)
+    {
+        m_wake.wait_for(lock, std::chrono::milliseconds(DDP_REC_FLUSH_INTERVAL_MS),
+                        [this] { return m_stop || !m_queue.empty(); });
+
+        if (m_queue.empty())
+        {
+            if (m_stop)
+                break;
+            lock.unlock();
+            fflush(m_file);
+            lastFlush = steadySeconds();
+            lock.lock();
+            continue;
+        }
+
+        Pending record = std::move(m_queue.front());
+        m_queue.pop_front();
+        m_queuedBytes -= record.data.size();
+        lock.unlock();
+
+        writeRecord(record);
+
+        double now = steadySeconds();
+        if (now - lastFlush > DDP_REC_FLUSH_INTERVAL_MS / 1000.0)
+        {
+            fflush(m_file);
+            lastFlush = now;
+        }
+
+        lock.lock();
+        m_spareBuffers.push_back(std::move(record.data));
+    }
+    lock.unlock();
+    fflush(m_file);
+}
+
+bool RecordingWriter::writeRecord(Pending& record)
+{
+    RecordHeader header;
+    header.type = record.type;
+    header.flags = record.flags;
+    header.dataType = record.dataType;
+    header.timecode = record.timecode;
+    header.timestampUs = record.timestampUs;
+    header.rawSize = static_cast<uint32_t>(record.data.size());
+
+    const uint8_t* payload = record.data.data();
+    size_t payloadSize = record.data.size();
+    bool useDelta = (m_compression == RecordCompression::Delta || m_compression == RecordCompression::DeltaLZ4);
+    bool useLZ4 = (m_compression == RecordCompression::LZ4 || m_compression == RecordCompression::DeltaLZ4);
+
+    if (record.type == DDP_REC_TYPE_FRAME)
+    {
+        bool keyframe = !useDelta || m_previousFrame.size() != record.data.size() ||
+                        m_framesSinceKeyframe >= m_keyframeInterval - 1;
+        if (!keyframe)
+        {
+            encodeDelta(m_previousFrame.data(), record.data.data(), record.data.size(), m_deltaBuffer);
+            if (m_deltaBuffer.size() < record.data.size())
+            {
+                header.encoding |= DDP_REC_ENC_DELTA;
+                payload = m_deltaBuffer.data();
+                payloadSize = m_deltaBuffer.size();
+            }
+            else
+            {
+                keyframe = true; // everything changed, a plain frame is smaller
+            }
+        }
+
+        if (keyframe)
+        {
+            header.flags |= DDP_REC_FLAG_KEYFRAME;
+            m_framesSinceKeyframe = 0;
+        }
+        else
+        {
+            m_framesSinceKeyframe++;
+        }
+    }
+
+    if (useLZ4 && payloadSize > 0 && compressLZ4(payload, payloadSize, m_lz4Buffer) && m_lz4Buffer.size() < payloadSize)
+    {
+        header.encoding |= DDP_REC_ENC_LZ4;
+        payload = m_lz4Buffer.data();
+        payloadSize = m_lz4Buffer.size();
+    }
+    header.storedSize = static_cast<uint32_t>(payloadSize);
+
+    uint8_t packed[DDP_REC_HEADER_SIZE];
+    packRecordHeader(header, packed);
+    bool ok = fwrite(packed, 1, sizeof(packed), m_file) == sizeof(packed) &&
+              (payloadSize == 0 || fwrite(payload, 1, payloadSize, m_file) == payloadSize);
+
+    // The next delta is taken against this frame; hand the old buffer back for reuse
+    if (record.type == DDP_REC_TYPE_FRAME && useDelta)
+        m_previousFrame.swap(record.data);
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (ok)
+    {
+        m_recordsWritten++;
+        m_rawBytes += header.rawSize;
+        m_fileBytes += DDP_REC_HEADER_SIZE + payloadSize;
+    }
+    else
+    {
+        m_lastError = "Write to " + m_path + " failed: " + strerror(errno);
+        m_recordsDropped++;
+    }
+    return ok;
+}
+
+int64_t RecordingWriter::recordsWritten() const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_recordsWritten;
+}
+
+int64_t RecordingWriter::recordsDropped() const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_recordsDropped;
+}
+
+int64_t RecordingWriter::rawBytes() const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_rawBytes;
+}
+
+int64_t RecordingWriter::fileBytes() const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_fileBytes;
+}
+
+std::string RecordingWriter::lastError() const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_lastError;
+}
+
+
+std::string RecordingWriter::summary() const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    char text[160];
+    snprintf(text, sizeof(text), "%lld records, %.1f MB on disk (%.1f MB raw), %lld dropped",
+             static_cast<long long>(m_recordsWritten), m_fileBytes / (1024.0 * 1024.0),
+             m_rawBytes / (1024.0 * 1024.0), static_cast<long long>(m_recordsDropped));
+    return text;
+}
+
+}
@@ -0,0 +1,188 @@
+#ifndef __DDPRecording__
+#define __DDPRecording__
+
+#include "DDPProtocol.h"
+
+#include <condition_variable>
+#include <cstdio>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Recording file format (.ddpr), append-only so a recording cut short by a
+// crash or power loss is readable up to its last complete record.
+// All multi-byte fields are little-endian.
+//
+//   File header (16 bytes)
+//     0  char[6]  "DDPREC"
+//     6  uint8    format version (DDP_REC_VERSION)
+//     7  uint8    reserved
+//     8  uint64   wall clock start time, microseconds since the Unix epoch
+//
+//   Record header (24 bytes), followed by 'storedSize' bytes
+//     0  uint8    record type (DDP_REC_TYPE_*)
+//     1  uint8    encoding (DDP_REC_ENC_* bits)
+//     2  uint8    flags (DDP_REC_FLAG_*)
+//     3  uint8    DDP data type the frame was sent with (frame records;
+//                 0 = not recorded, as in version 1 files)
+//     4  uint32   stored size (bytes following this header)
+//     8  uint32   raw size (bytes after decoding)
+//    12  uint32   DDP timecode (valid with DDP_REC_FLAG_TIMECODE)
+//    16  uint64   microseconds since the recording started
+//
+// Packet records hold a complete DDP packet, header included. Frame records
+// hold an assembled frame; delta-encoded frames apply to the previous frame,
+// so playback seeks to the nearest keyframe and decodes forward.
+#define DDP_REC_MAGIC            "DDPREC"
+#define DDP_REC_VERSION          2
+#define DDP_REC_MIN_VERSION      1   // oldest version playback reads
+#define DDP_REC_FILE_HEADER_SIZE 16
+#define DDP_REC_HEADER_SIZE      24
+
+#define DDP_REC_TYPE_PACKET 1
+#define DDP_REC_TYPE_FRAME  2
+
+#define DDP_REC_ENC_RAW   0x00
+#define DDP_REC_ENC_DELTA 0x01  // skip/copy runs against the previous frame
+#define DDP_REC_ENC_LZ4   0x02  // LZ4 block (applied after delta when both are set)
+
+#define DDP_REC_FLAG_KEYFRAME 0x0001
+#define DDP_REC_FLAG_TIMECODE 0x0002
+
+#define DDP_REC_KEYFRAME_INTERVAL 120              // frames between forced keyframes
+#define DDP_REC_MAX_QUEUED_BYTES  (256 * 1024 * 1024) // writer backlog before records are dropped
+#define DDP_REC_FLUSH_INTERVAL_MS 250
+
+namespace ddp
+{
+
+enum class RecordCompression
+{
+    None,
+    Delta,
+    LZ4,
+    DeltaLZ4
+};
+
+// Parameter menu names: "none", "delta", "lz4", "deltalz4"
+RecordCompression recordCompressionFromName(const std::string& name);
+
+struct RecordHeader
+{
+    uint8_t  type = DDP_REC_TYPE_FRAME;
+    uint8_t  encoding = DDP_REC_ENC_RAW;
+    uint8_t  flags = 0;
+    uint8_t  dataType = 0;
+    uint32_t storedSize = 0;
+    uint32_t rawSize = 0;
+    uint32_t timecode = 0;
+    uint64_t timestampUs = 0;
+
+    bool isKeyframe() const { return (flags & DDP_REC_FLAG_KEYFRAME) != 0; }
+    bool hasTimecode() const { return (flags & DDP_REC_FLAG_TIMECODE) != 0; }
+};
+
+void packRecordHeader(const RecordHeader& h, uint8_t* out);
+void unpackRecordHeader(const uint8_t* in, RecordHeader& h);
+
+void packFileHeader(uint64_t startTimeUs, uint8_t* out);
+bool unpackFileHeader(const uint8_t* in, size_t length, uint64_t& startTimeUs);
+
+// Delta stream: repeated (varint skip, varint copy, copy bytes) against a
+// previous frame of the same size. Short unchanged gaps are folded into the
+// copy run so the stream never grows much past the raw frame.
+void encodeDelta(const uint8_t* previous, const uint8_t* current, size_t length, std::vector<uint8_t>& out);
+bool decodeDelta(const uint8_t* stream, size_t streamLength, uint8_t* frame, size_t frameLength);
+size_t maxDeltaSize(size_t frameLength);
+
+// LZ4 block compression, only available when built with DDP_HAVE_LZ4
+bool lz4Available();
+bool compressLZ4(const uint8_t* src, size_t length, std::vector<uint8_t>& out);
+bool decompressLZ4(const uint8_t* src, size_t length, uint8_t* dst, size_t capacity, size_t& written);
+
+// Streams records to disk from a background thread. The write* calls only copy
+// into recycled buffers and queue them, so they are safe to call from a cook;
+// encoding, compression and file I/O happen on the writer thread. When the
+// disk cannot keep up the backlog is capped and new records are dropped.
+class RecordingWriter
+{
+public:
+    RecordingWriter();
+    ~RecordingWriter();
+
+    // Create (or truncate) 'path' and start the writer thread
+    bool open(const std::string& path, RecordCompression compression,
+              int keyframeInterval = DDP_REC_KEYFRAME_INTERVAL);
+
+    // Drain the queue, flush and close the file
+    void close();
+
+    bool isOpen() const { return m_file != nullptr; }
+    const std::string& path() const { return m_path; }
+
+    // A complete DDP packet, given as header and payload parts
+    bool writePacket(const uint8_t* header, size_t headerLength, const uint8_t* payload, size_t payloadLength);
+
+    // An assembled frame, with the DDP data type it went out with (0 = unknown)
+    bool writeFrame(const uint8_t* frame, size_t length, bool hasTimecode = false, uint32_t timecode = 0,
+                    uint8_t dataType = 0);
+
+    int64_t recordsWritten() const;
+    int64_t recordsDropped() const;
+    int64_t rawBytes() const;
+    int64_t fileBytes() const;
+    std::string lastError() const;
+
+    // "N records, X MB on disk (Y MB raw), Z dropped" for the Info DATs
+    std::string summary() const;
+
+private:
+    struct Pending
+    {
+        uint8_t type;
+        uint8_t flags;
+        uint8_t dataType;
+        uint32_t timecode;
+        uint64_t timestampUs;
+        std::vector<uint8_t> data;
+    };
+
+    bool enqueue(uint8_t type, uint8_t flags, uint8_t dataType, uint32_t timecode,
+                 const uint8_t* part1, size_t length1, const uint8_t* part2, size_t length2);
+    uint64_t elapsedMicros() const;
+    void writerLoop();
+    bool writeRecord(Pending& record);
+
+    std::string m_path;
+    FILE* m_file;
+    RecordCompression m_compression;
+    int m_keyframeInterval;
+    double m_startTime;                           // steady clock seconds at open()
+
+    mutable std::mutex m_mutex;
+    std::condition_variable m_wake;
+    std::deque<Pending> m_queue;
+    std::vector<std::vector<uint8_t>> m_spareBuffers;
+    size_t m_queuedBytes;
+    bool m_stop;
+    std::thread m_thread;
+
+    // Writer thread state
+    std::vector<uint8_t> m_previousFrame;
+    std::vector<uint8_t> m_deltaBuffer;
+    std::vector<uint8_t> m_lz4Buffer;
+    int m_framesSinceKeyframe;
+
+    // Stats (guarded by m_mutex)
+    int64_t m_recordsWritten;
+    int64_t m_recordsDropped;
+    int64_t m_rawBytes;
+    int64_t m_fileBytes;
+    std::string m_lastError;
+};
+
+}
+
+#endif
@@ -0,0 +1,58 @@
+#include "DDPRedundancy.h"
+
+namespace ddp
+{
+
+Redundancy redundancyFromName(const std::string& name)
+{
+    if (name == "both")
+        return Redundancy::Both;
+    if (name == "standby")
+        return Redundancy::Standby;
+    return Redundancy::Off;
+}
+
+LegHealth::LegHealth()
+{
+    reset(0.0);
+}
+
+void LegHealth::reset(double now)
+{
+    m_lastReply = now;
+    m_lastQuery = -1.0;
+    m_queries = 0;
+    m_replies = 0;
+}
+
+bool LegHealth::queryDue(double now, double interval)
+{
+    if (m_lastQuery >= 0.0 && now - m_lastQuery < interval)
+        return false;
+    m_lastQuery = now;
+    m_queries++;
+    return true;
+}
+
+void LegHealth::replied(double now)
+{
+    m_lastReply = now;
+    m_replies++;
+}
+
+int LegSelector::select(bool primaryHealthy, bool secondaryHealthy)
+{
+    int leg = m_active;
+    if (primaryHealthy)
+        leg = 0;
+    else if (secondaryHealthy)
+        leg = 1;
+    if (leg != m_active)
+    {
+        m_active = leg;
+        m_failovers++;
+    }
+    return m_active;
+}
+
+}
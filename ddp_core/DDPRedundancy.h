@@ -0,0 +1,73 @@
+#ifndef __DDPRedundancy__
+#define __DDPRedundancy__
+
+#include <cstdint>
+#include <string>
+
+namespace ddp
+{
+
+// How DDP Out uses its secondary leg
+enum class Redundancy
+{
+    Off,
+    Both,       // every frame goes out on both legs
+    Standby     // frames go out on one leg, the other takes over when it fails
+};
+
+// Parameter menu names: "off", "both", "standby"
+Redundancy redundancyFromName(const std::string& name);
+
+// Health of one leg, judged by the replies to the STATUS queries sent to its
+// controller. Times are steady clock seconds. A leg starts healthy, as if it
+// had just replied, and fails once 'timeout' passes without a reply.
+class LegHealth
+{
+public:
+    LegHealth();
+
+    void reset(double now);
+
+    // True when a query is due, 'interval' after the last; counts it as sent
+    bool queryDue(double now, double interval);
+
+    void replied(double now);
+
+    bool healthy(double now, double timeout) const { return now - m_lastReply <= timeout; }
+    double sinceReply(double now) const { return now - m_lastReply; }
+    int64_t queries() const { return m_queries; }
+    int64_t replies() const { return m_replies; }
+
+private:
+    double m_lastReply;
+    double m_lastQuery;     // < 0 = none yet
+    int64_t m_queries;
+    int64_t m_replies;
+};
+
+// Picks the leg that carries the frames in Standby: the primary whenever it
+// is healthy, else the secondary when that is. With both down the active leg
+// stays where it is.
+class LegSelector
+{
+public:
+    LegSelector() : m_active(0), m_failovers(0) {}
+
+    void reset() { m_active = 0; m_failovers = 0; }
+
+    // Returns the active leg, 0 = primary, 1 = secondary
+    int select(bool primaryHealthy, bool secondaryHealthy);
+
+    int active() const { return m_active; }
+
+    // Switches either way, failing back to the primary included
+    int64_t failovers() const { return m_failovers; }
+
+private:
+    int m_active;
+    int64_t m_failovers;
+};
+
+}
+
+#endif
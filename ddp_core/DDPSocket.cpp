@@ -0,0 +1,768 @@
+#include "DDPSocket.h"
+#include <cstring>
+#include <cstdlib>
+#include <algorithm>
+#include <mutex>
+#include <errno.h>
+
+#ifndef _WIN32
+    #include <unistd.h>
+    #include <fcntl.h>
+    #include <poll.h>
+    #include <net/if.h>
+    #include <ifaddrs.h>
+    #include <sys/ioctl.h>
+    #include <sys/uio.h>
+#endif
+
+namespace ddp
+{
+
+namespace
+{
+    #ifdef _WIN32
+        // Winsock must be started once per process user; several plugin instances
+        // share it, so keep a count and only clean up with the last socket
+        std::mutex g_startupMutex;
+        int g_startupCount = 0;
+    #endif
+
+    std::string socketErrorText()
+    {
+        #ifdef _WIN32
+            return std::to_string(WSAGetLastError());
+        #else
+            int error = errno;
+            return "errno " + std::to_string(error) + ": " + strerror(error);
+        #endif
+    }
+
+    bool lastErrorWouldBlock()
+    {
+        #ifdef _WIN32
+            return WSAGetLastError() == WSAEWOULDBLOCK;
+        #else
+            return errno == EWOULDBLOCK || errno == EAGAIN;
+        #endif
+    }
+
+    unsigned int interfaceIndex(const std::string& name)
+    {
+        if (name.empty())
+            return 0;
+        unsigned int index = if_nametoindex(name.c_str());
+        return index != 0 ? index : static_cast<unsigned int>(atoi(name.c_str()));
+    }
+}
+
+bool parseAddress(const std::string& text, int port, struct sockaddr_storage& addr, socklen_t& addrLen)
+{
+    memset(&addr, 0, sizeof(addr));
+    addrLen = 0;
+    
+    // Accept "[v6addr]" and "v6addr%scope" forms
+    std::string host = text;
+    if (host.size() > 2 && host.front() == '[' && host.back() == ']')
+        host = host.substr(1, host.size() - 2);
+    
+    std::string scope;
+    size_t percent = host.find('%');
+    if (percent != std::string::npos)
+    {
+        scope = host.substr(percent + 1);
+        host = host.substr(0, percent);
+    }
+    
+    struct sockaddr_in* v4 = reinterpret_cast<struct sockaddr_in*>(&addr);
+    if (scope.empty() && inet_pton(AF_INET, host.c_str(), &v4->sin_addr) == 1)
+    {
+        v4->sin_family = AF_INET;
+        v4->sin_port = htons(static_cast<uint16_t>(port));
+        addrLen = sizeof(struct sockaddr_in);
+        return true;
+    }
+    
+    struct sockaddr_in6* v6 = reinterpret_cast<struct sockaddr_in6*>(&addr);
+    if (inet_pton(AF_INET6, host.c_str(), &v6->sin6_addr) == 1)
+    {
+        v6->sin6_family = AF_INET6;
+        v6->sin6_port = htons(static_cast<uint16_t>(port));
+        if (!scope.empty())
+            v6->sin6_scope_id = interfaceIndex(scope);
+        addrLen = sizeof(struct sockaddr_in6);
+        return true;
+    }
+    
+    return false;
+}
+
+std::string formatAddress(const struct sockaddr* addr, uint16_t* port)
+{
+    char text[INET6_ADDRSTRLEN] = {0};
+    
+    if (addr->sa_family == AF_INET6)
+    {
+        const struct sockaddr_in6* v6 = reinterpret_cast<const struct sockaddr_in6*>(addr);
+        if (port)
+            *port = ntohs(v6->sin6_port);
+        
+        // Show IPv4 peers of a dual-stack socket in dotted form
+        if (IN6_IS_ADDR_V4MAPPED(&v6->sin6_addr))
+            inet_ntop(AF_INET, &v6->sin6_addr.s6_addr[12], text, sizeof(text));
+        else
+            inet_ntop(AF_INET6, &v6->sin6_addr, text, sizeof(text));
+    }
+    else
+    {
+        const struct sockaddr_in* v4 = reinterpret_cast<const struct sockaddr_in*>(addr);
+        if (port)
+            *port = ntohs(v4->sin_port);
+        inet_ntop(AF_INET, &v4->sin_addr, text, sizeof(text));
+    }
+    
+    return std::string(text);
+}
+
+void setPort(struct sockaddr_storage& addr, int port)
+{
+    if (addr.ss_family == AF_INET6)
+        reinterpret_cast<struct sockaddr_in6*>(&addr)->sin6_port = htons(static_cast<uint16_t>(port));
+    else
+        reinterpret_cast<struct sockaddr_in*>(&addr)->sin_port = htons(static_cast<uint16_t>(port));
+}
+
+socklen_t addressLength(const struct sockaddr_storage& addr)
+{
+    return addr.ss_family == AF_INET6 ? sizeof(struct sockaddr_in6) : sizeof(struct sockaddr_in);
+}
+
+bool isMulticast(const struct sockaddr_storage& addr)
+{
+    if (addr.ss_family == AF_INET6)
+        return IN6_IS_ADDR_MULTICAST(&reinterpret_cast<const struct sockaddr_in6*>(&addr)->sin6_addr);
+    
+    return IN_MULTICAST(ntohl(reinterpret_cast<const struct sockaddr_in*>(&addr)->sin_addr.s_addr));
+}
+
+bool sameHost(const struct sockaddr_storage& a, const struct sockaddr_storage& b)
+{
+    if (a.ss_family != b.ss_family)
+        return false;
+    
+    if (a.ss_family == AF_INET6)
+        return memcmp(&reinterpret_cast<const struct sockaddr_in6*>(&a)->sin6_addr,
+                      &reinterpret_cast<const struct sockaddr_in6*>(&b)->sin6_addr, sizeof(struct in6_addr)) == 0;
+    
+    return reinterpret_cast<const struct sockaddr_in*>(&a)->sin_addr.s_addr ==
+           reinterpret_cast<const struct sockaddr_in*>(&b)->sin_addr.s_addr;
+}
+
+bool isBroadcast(const struct sockaddr_storage& addr)
+{
+    if (addr.ss_family != AF_INET)
+        return false;
+    uint32_t ip = reinterpret_cast<const struct sockaddr_in*>(&addr)->sin_addr.s_addr;
+    if (ip == htonl(INADDR_BROADCAST))
+        return true;
+    
+    #ifdef _WIN32
+        // Subnet broadcasts need the netmasks, which take iphlpapi here
+        return false;
+    #else
+        // A subnet broadcast is the broadcast address of one of our interfaces
+        struct ifaddrs* ifList = nullptr;
+        if (getifaddrs(&ifList) != 0)
+            return false;
+        bool broadcast = false;
+        for (struct ifaddrs* ifa = ifList; ifa != nullptr && !broadcast; ifa = ifa->ifa_next)
+        {
+            if (!ifa->ifa_addr || ifa->ifa_addr->sa_family != AF_INET || !(ifa->ifa_flags & IFF_BROADCAST) ||
+                !ifa->ifa_broadaddr)
+                continue;
+            broadcast = reinterpret_cast<const struct sockaddr_in*>(ifa->ifa_broadaddr)->sin_addr.s_addr == ip;
+        }
+        freeifaddrs(ifList);
+        return broadcast;
+    #endif
+}
+
+int queryInterfaceMTU(const struct sockaddr_storage& dest, const std::string& bindInterface)
+{
+    #ifdef _WIN32
+        // No portable per-route MTU query without iphlpapi, report unknown
+        (void)dest;
+        (void)bindInterface;
+        return 0;
+    #else
+        // Find the interface we send through (bound device/address, or the subnet
+        // that contains the destination) and ask for its MTU
+        struct ifaddrs* ifList = nullptr;
+        if (getifaddrs(&ifList) != 0)
+            return 0;
+        
+        int family = dest.ss_family;
+        const struct sockaddr_in* dest4 = reinterpret_cast<const struct sockaddr_in*>(&dest);
+        const struct sockaddr_in6* dest6 = reinterpret_cast<const struct sockaddr_in6*>(&dest);
+        bool isLoopback = (family == AF_INET6) ? IN6_IS_ADDR_LOOPBACK(&dest6->sin6_addr)
+                                               : (ntohl(dest4->sin_addr.s_addr) >> 24) == 127;
+        int mtu = 0;
+        
+        for (struct ifaddrs* ifa = ifList; ifa != nullptr; ifa = ifa->ifa_next)
+        {
+            if (!ifa->ifa_addr || !ifa->ifa_netmask || ifa->ifa_addr->sa_family != family)
+                continue;
+            
+            bool matches = false;
+            if (!bindInterface.empty())
+            {
+                matches = (bindInterface == ifa->ifa_name) || (bindInterface == formatAddress(ifa->ifa_addr));
+            }
+            else if (isLoopback)
+            {
+                matches = (ifa->ifa_flags & IFF_LOOPBACK) != 0;
+            }
+            else if (family == AF_INET6)
+            {
+                const uint8_t* ifIP = reinterpret_cast<const struct sockaddr_in6*>(ifa->ifa_addr)->sin6_addr.s6_addr;
+                const uint8_t* mask = reinterpret_cast<const struct sockaddr_in6*>(ifa->ifa_netmask)->sin6_addr.s6_addr;
+                matches = mask[0] != 0;
+                for (int b = 0; b < 16 && matches; b++)
+                    matches = (ifIP[b] & mask[b]) == (dest6->sin6_addr.s6_addr[b] & mask[b]);
+            }
+            else
+            {
+                uint32_t destIP = ntohl(dest4->sin_addr.s_addr);
+                uint32_t ifIP = ntohl(reinterpret_cast<struct sockaddr_in*>(ifa->ifa_addr)->sin_addr.s_addr);
+                uint32_t mask = ntohl(reinterpret_cast<struct sockaddr_in*>(ifa->ifa_netmask)->sin_addr.s_addr);
+                matches = mask != 0 && (ifIP & mask) == (destIP & mask);
+            }
+            if (!matches)
+                continue;
+            
+            int fd = socket(AF_INET, SOCK_DGRAM, 0);
+            if (fd >= 0)
+            {
+                struct ifreq ifr;
+                memset(&ifr, 0, sizeof(ifr));
+                strncpy(ifr.ifr_name, ifa->ifa_name, IFNAMSIZ - 1);
+                if (ioctl(fd, SIOCGIFMTU, &ifr) == 0)
+                    mtu = ifr.ifr_mtu;
+                ::close(fd);
+            }
+            break;
+        }
+        
+        freeifaddrs(ifList);
+        return mtu;
+    #endif
+}
+
+UdpSocket::UdpSocket()
+{
+    #ifdef _WIN32
+        m_socket = INVALID_SOCKET;
+    #else
+        m_socket = -1;
+    #endif
+    m_open = false;
+    m_started = false;
+    m_family = AF_INET;
+}
+
+UdpSocket::~UdpSocket()
+{
+    close();
+    if (m_started)
+        cleanup();
+}
+
+bool UdpSocket::startup(std::string& error)
+{
+    #ifdef _WIN32
+        std::lock_guard<std::mutex> lock(g_startupMutex);
+        if (g_startupCount == 0)
+        {
+            WSADATA wsaData;
+            int result = WSAStartup(MAKEWORD(2, 2), &wsaData);
+            if (result != 0)
+            {
+                error = "WSAStartup failed: " + std::to_string(result);
+                return false;
+            }
+        }
+        g_startupCount++;
+    #else
+        (void)error;
+    #endif
+    return true;
+}
+
+void UdpSocket::cleanup()
+{
+    #ifdef _WIN32
+        std::lock_guard<std::mutex> lock(g_startupMutex);
+        if (g_startupCount > 0 && --g_startupCount == 0)
+            WSACleanup();
+    #endif
+}
+
+void UdpSocket::setError(const std::string& what)
+{
+    m_lastError = what + " failed: " + socketErrorText();
+}
+
+bool UdpSocket::open(int family)
+{
+    close();
+    
+    if (!m_started)
+    {
+        if (!startup(m_lastError))
+            return false;
+        m_started = true;
+    }
+    
+    m_socket = socket(family, SOCK_DGRAM, IPPROTO_UDP);
+    #ifdef _WIN32
+        if (m_socket == INVALID_SOCKET)
+    #else
+        if (m_socket < 0)
+    #endif
+    {
+        setError("Socket creation");
+        return false;
+    }
+    
+    // IPv6 sockets also carry IPv4 traffic (as v4-mapped addresses)
+    if (family == AF_INET6)
+    {
+        int v6Only = 0;
+        setsockopt(m_socket, IPPROTO_IPV6, IPV6_V6ONLY, reinterpret_cast<const char*>(&v6Only), sizeof(v6Only));
+    }
+    
+    m_family = family;
+    m_open = true;
+    m_lastError.clear();
+    return true;
+}
+
+void UdpSocket::close()
+{
+    if (!m_open)
+        return;
+    
+    #ifdef _WIN32
+        closesocket(m_socket);
+        m_socket = INVALID_SOCKET;
+    #else
+        ::close(m_socket);
+        m_socket = -1;
+    #endif
+    m_open = false;
+}
+
+bool UdpSocket::setReuseAddress()
+{
+    // Allow several sockets on this host to share the port (needed for multicast)
+    int reuseAddr = 1;
+    if (setsockopt(m_socket, SOL_SOCKET, SO_REUSEADDR, reinterpret_cast<const char*>(&reuseAddr), sizeof(reuseAddr)) < 0)
+    {
+        setError("SO_REUSEADDR");
+        return false;
+    }
+    #ifdef SO_REUSEPORT
+        setsockopt(m_socket, SOL_SOCKET, SO_REUSEPORT, reinterpret_cast<const char*>(&reuseAddr), sizeof(reuseAddr));
+    #endif
+    return true;
+}
+
+bool UdpSocket::setBroadcast(bool enable)
+{
+    int broadcastEnable = enable ? 1 : 0;
+    if (setsockopt(m_socket, SOL_SOCKET, SO_BROADCAST, reinterpret_cast<const char*>(&broadcastEnable), sizeof(broadcastEnable)) < 0)
+    {
+        setError("SO_BROADCAST");
+        return false;
+    }
+    return true;
+}
+
+bool UdpSocket::setNonBlocking(bool enable)
+{
+    #ifdef _WIN32
+        u_long mode = enable ? 1 : 0;
+        if (ioctlsocket(m_socket, FIONBIO, &mode) != 0)
+    #else
+        int flags = fcntl(m_socket, F_GETFL, 0);
+        flags = enable ? (flags | O_NONBLOCK) : (flags & ~O_NONBLOCK);
+        if (fcntl(m_socket, F_SETFL, flags) < 0)
+    #endif
+    {
+        setError("Non-blocking mode");
+        return false;
+    }
+    return true;
+}
+
+bool UdpSocket::setReceiveBuffer(int bytes)
+{
+    if (setsockopt(m_socket, SOL_SOCKET, SO_RCVBUF, reinterpret_cast<const char*>(&bytes), sizeof(bytes)) < 0)
+    {
+        setError("SO_RCVBUF");
+        return false;
+    }
+    return true;
+}
+
+bool UdpSocket::setSendBuffer(int bytes)
+{
+    if (setsockopt(m_socket, SOL_SOCKET, SO_SNDBUF, reinterpret_cast<const char*>(&bytes), sizeof(bytes)) < 0)
+    {
+        setError("SO_SNDBUF");
+        return false;
+    }
+    return true;
+}
+
+bool UdpSocket::bindTo(const std::string& bindInterface, int port)
+{
+    struct sockaddr_storage localAddr;
+    socklen_t localAddrLen = 0;
+    
+    if (!bindInterface.empty() && parseAddress(bindInterface, port, localAddr, localAddrLen))
+    {
+        // Source address binding: traffic only uses the NIC that owns this address
+        if (localAddr.ss_family != m_family)
+        {
+            m_lastError = "Bind address " + bindInterface + " does not match the socket address family";
+            return false;
+        }
+    }
+    else
+    {
+        memset(&localAddr, 0, sizeof(localAddr));
+        localAddr.ss_family = static_cast<decltype(localAddr.ss_family)>(m_family);
+        if (m_family == AF_INET6)
+            reinterpret_cast<struct sockaddr_in6*>(&localAddr)->sin6_addr = in6addr_any;
+        else
+            reinterpret_cast<struct sockaddr_in*>(&localAddr)->sin_addr.s_addr = INADDR_ANY;
+        setPort(localAddr, port);
+        localAddrLen = addressLength(localAddr);
+        
+        // Device name binding: pin the socket to a NIC regardless of the routing table
+        if (!bindInterface.empty())
+        {
+            #if defined(SO_BINDTODEVICE)
+                if (setsockopt(m_socket, SOL_SOCKET, SO_BINDTODEVICE,
+                               bindInterface.c_str(), static_cast<socklen_t>(bindInterface.size())) < 0)
+                {
+                    setError("SO_BINDTODEVICE " + bindInterface);
+                    return false;
+                }
+            #elif defined(IP_BOUND_IF)
+                unsigned int ifIndex = if_nametoindex(bindInterface.c_str());
+                int result = -1;
+                if (ifIndex != 0)
+                {
+                    result = (m_family == AF_INET6)
+                        ? setsockopt(m_socket, IPPROTO_IPV6, IPV6_BOUND_IF, &ifIndex, sizeof(ifIndex))
+                        : setsockopt(m_socket, IPPROTO_IP, IP_BOUND_IF, &ifIndex, sizeof(ifIndex));
+                }
+                if (result < 0)
+                {
+                    m_lastError = "Cannot bind to interface " + bindInterface;
+                    return false;
+                }
+            #else
+                m_lastError = "Interface names are not supported on this platform, use the interface IP address";
+                return false;
+            #endif
+        }
+    }
+    
+    if (bind(m_socket, reinterpret_cast<struct sockaddr*>(&localAddr), localAddrLen) < 0)
+    {
+        setError("Socket bind");
+        return false;
+    }
+    
+    return true;
+}
+
+bool UdpSocket::configureMulticastSend(int ttl, bool loopback, const std::string& interfaceName)
+{
+    bool ok = true;
+    
+    if (m_family == AF_INET6)
+    {
+        // IPv6: hop limit, loopback and outgoing interface index (name or number)
+        int hops = ttl;
+        unsigned int loopValue = loopback ? 1 : 0;
+        unsigned int ifIndex = interfaceIndex(interfaceName);
+        
+        if (setsockopt(m_socket, IPPROTO_IPV6, IPV6_MULTICAST_HOPS,
+                       reinterpret_cast<const char*>(&hops), sizeof(hops)) < 0)
+        {
+            m_lastError = "Failed to set multicast hop limit";
+            ok = false;
+        }
+        
+        if (setsockopt(m_socket, IPPROTO_IPV6, IPV6_MULTICAST_LOOP,
+                       reinterpret_cast<const char*>(&loopValue), sizeof(loopValue)) < 0)
+        {
+            m_lastError = "Failed to set multicast loopback";
+            ok = false;
+        }
+        
+        if (ifIndex != 0 && setsockopt(m_socket, IPPROTO_IPV6, IPV6_MULTICAST_IF,
+                                       reinterpret_cast<const char*>(&ifIndex), sizeof(ifIndex)) < 0)
+        {
+            m_lastError = "Failed to set multicast interface: " + interfaceName;
+            ok = false;
+        }
+        return ok;
+    }
+    
+    #ifdef _WIN32
+        DWORD ttlValue = static_cast<DWORD>(ttl);
+        DWORD loopValue = loopback ? 1 : 0;
+    #else
+        unsigned char ttlValue = static_cast<unsigned char>(ttl);
+        unsigned char loopValue = loopback ? 1 : 0;
+    #endif
+    
+    if (setsockopt(m_socket, IPPROTO_IP, IP_MULTICAST_TTL,
+                   reinterpret_cast<const char*>(&ttlValue), sizeof(ttlValue)) < 0)
+    {
+        m_lastError = "Failed to set multicast TTL";
+        ok = false;
+    }
+    
+    if (setsockopt(m_socket, IPPROTO_IP, IP_MULTICAST_LOOP,
+                   reinterpret_cast<const char*>(&loopValue), sizeof(loopValue)) < 0)
+    {
+        m_lastError = "Failed to set multicast loopback";
+        ok = false;
+    }
+    
+    struct in_addr ifaceAddr;
+    ifaceAddr.s_addr = htonl(INADDR_ANY);
+    if (!interfaceName.empty() && inet_pton(AF_INET, interfaceName.c_str(), &ifaceAddr) != 1)
+    {
+        m_lastError = "Invalid multicast interface address: " + interfaceName;
+        return false;
+    }
+    
+    if (setsockopt(m_socket, IPPROTO_IP, IP_MULTICAST_IF,
+                   reinterpret_cast<const char*>(&ifaceAddr), sizeof(ifaceAddr)) < 0)
+    {
+        m_lastError = "Failed to set multicast interface: " + interfaceName;
+        ok = false;
+    }
+    return ok;
+}
+
+bool UdpSocket::joinGroup(const std::string& group, const std::string& interfaceName)
+{
+    if (m_family == AF_INET6)
+    {
+        // IPv6 groups are joined on an interface index (name or number)
+        struct ipv6_mreq mreq6;
+        memset(&mreq6, 0, sizeof(mreq6));
+        if (inet_pton(AF_INET6, group.c_str(), &mreq6.ipv6mr_multiaddr) != 1 ||
+            !IN6_IS_ADDR_MULTICAST(&mreq6.ipv6mr_multiaddr))
+        {
+            m_lastError = "Invalid multicast group: " + group;
+            return false;
+        }
+        
+        mreq6.ipv6mr_interface = interfaceIndex(interfaceName);
+        
+        if (setsockopt(m_socket, IPPROTO_IPV6, IPV6_JOIN_GROUP,
+                       reinterpret_cast<const char*>(&mreq6), sizeof(mreq6)) < 0)
+        {
+            setError("IPV6_JOIN_GROUP");
+            return false;
+        }
+        return true;
+    }
+    
+    struct ip_mreq mreq;
+    memset(&mreq, 0, sizeof(mreq));
+    
+    if (inet_pton(AF_INET, group.c_str(), &mreq.imr_multiaddr) != 1 ||
+        !IN_MULTICAST(ntohl(mreq.imr_multiaddr.s_addr)))
+    {
+        m_lastError = "Invalid multicast group: " + group;
+        return false;
+    }
+    
+    mreq.imr_interface.s_addr = htonl(INADDR_ANY);
+    if (!interfaceName.empty() && inet_pton(AF_INET, interfaceName.c_str(), &mreq.imr_interface) != 1)
+    {
+        m_lastError = "Invalid multicast interface address: " + interfaceName;
+        return false;
+    }
+    
+    if (setsockopt(m_socket, IPPROTO_IP, IP_ADD_MEMBERSHIP,
+                   reinterpret_cast<const char*>(&mreq), sizeof(mreq)) < 0)
+    {
+        setError("IP_ADD_MEMBERSHIP");
+        return false;
+    }
+    return true;
+}
+
+int UdpSocket::sendTo(const void* data, size_t length, const struct sockaddr_storage& dest, socklen_t destLength)
+{
+    int result = static_cast<int>(sendto(m_socket,
+                                         reinterpret_cast<const char*>(data),
+                                         static_cast<int>(length),
+                                         0,
+                                         reinterpret_cast<const struct sockaddr*>(&dest),
+                                         destLength));
+    if (result < 0)
+        setError("Send");
+    return result;
+}
+
+size_t UdpSocket::sendSlices(const SendSlice* slices, size_t count,
+                             const struct sockaddr_storage& dest, socklen_t destLength,
+                             int64_t& bytesSent)
+{
+    size_t sent = 0;
+    
+    #if defined(__linux__)
+        // One syscall per batch; header and payload go out as two iovecs so the
+        // pixel buffer is never copied into per-packet storage
+        const size_t batchSize = 64;
+        m_batchScratch.resize(batchSize * (sizeof(struct mmsghdr) + 2 * sizeof(struct iovec)));
+        struct mmsghdr* messages = reinterpret_cast<struct mmsghdr*>(m_batchScratch.data());
+        struct iovec* vectors = reinterpret_cast<struct iovec*>(messages + batchSize);
+        
+        while (sent < count)
+        {
+            size_t batch = std::min(batchSize, count - sent);
+            for (size_t i = 0; i < batch; i++)
+            {
+                const SendSlice& slice = slices[sent + i];
+                struct iovec* iov = vectors + i * 2;
+                iov[0].iov_base = const_cast<uint8_t*>(slice.header);
+                iov[0].iov_len = slice.headerLength;
+                iov[1].iov_base = const_cast<uint8_t*>(slice.payload);
+                iov[1].iov_len = slice.payloadLength;
+                
+                struct msghdr& msg = messages[i].msg_hdr;
+                memset(&msg, 0, sizeof(msg));
+                msg.msg_name = const_cast<struct sockaddr_storage*>(&dest);
+                msg.msg_namelen = destLength;
+                msg.msg_iov = iov;
+                msg.msg_iovlen = slice.payloadLength > 0 ? 2 : 1;
+                messages[i].msg_len = 0;
+            }
+            
+            int result = sendmmsg(m_socket, messages, static_cast<unsigned int>(batch), 0);
+            if (result <= 0)
+            {
+                setError("Send");
+                break;
+            }
+            
+            for (int i = 0; i < result; i++)
+                bytesSent += messages[i].msg_len;
+            sent += static_cast<size_t>(result);
+        }
+    #elif defined(_WIN32)
+        for (; sent < count; sent++)
+        {
+            const SendSlice& slice = slices[sent];
+            WSABUF buffers[2];
+            buffers[0].buf = reinterpret_cast<char*>(const_cast<uint8_t*>(slice.header));
+            buffers[0].len = static_cast<ULONG>(slice.headerLength);
+            buffers[1].buf = reinterpret_cast<char*>(const_cast<uint8_t*>(slice.payload));
+            buffers[1].len = static_cast<ULONG>(slice.payloadLength);
+            
+            DWORD written = 0;
+            if (WSASendTo(m_socket, buffers, slice.payloadLength > 0 ? 2 : 1, &written, 0,
+                          reinterpret_cast<const struct sockaddr*>(&dest), destLength, nullptr, nullptr) != 0)
+            {
+                setError("Send");
+                break;
+            }
+            bytesSent += written;
+        }
+    #else
+        for (; sent < count; sent++)
+        {
+            const SendSlice& slice = slices[sent];
+            struct iovec iov[2];
+            iov[0].iov_base = const_cast<uint8_t*>(slice.header);
+            iov[0].iov_len = slice.headerLength;
+            iov[1].iov_base = const_cast<uint8_t*>(slice.payload);
+            iov[1].iov_len = slice.payloadLength;
+            
+            struct msghdr msg;
+            memset(&msg, 0, sizeof(msg));
+            msg.msg_name = const_cast<struct sockaddr_storage*>(&dest);
+            msg.msg_namelen = destLength;
+            msg.msg_iov = iov;
+            msg.msg_iovlen = slice.payloadLength > 0 ? 2 : 1;
+            
+            ssize_t result = sendmsg(m_socket, &msg, 0);
+            if (result < 0)
+            {
+                setError("Send");
+                break;
+            }
+            bytesSent += result;
+        }
+    #endif
+    
+    return sent;
+}
+
+int UdpSocket::recvFrom(void* buffer, size_t length, struct sockaddr_storage& from, bool& wouldBlock)
+{
+    socklen_t fromLength = sizeof(from);
+    int result = static_cast<int>(recvfrom(m_socket, reinterpret_cast<char*>(buffer), static_cast<int>(length), 0,
+                                           reinterpret_cast<struct sockaddr*>(&from), &fromLength));
+    wouldBlock = false;
+    if (result < 0)
+    {
+        wouldBlock = lastErrorWouldBlock();
+        if (!wouldBlock)
+            setError("recvfrom");
+    }
+    return result;
+}
+
+bool UdpSocket::localAddress(struct sockaddr_storage& addr) const
+{
+    memset(&addr, 0, sizeof(addr));
+    if (!m_open)
+        return false;
+    socklen_t length = sizeof(addr);
+    return getsockname(m_socket, reinterpret_cast<struct sockaddr*>(&addr), &length) == 0;
+}
+
+bool UdpSocket::waitReadable(int timeoutMs)
+{
+    if (!m_open)
+        return false;
+    
+    #ifdef _WIN32
+        WSAPOLLFD pfd;
+        pfd.fd = m_socket;
+        pfd.events = POLLRDNORM;
+        pfd.revents = 0;
+        return WSAPoll(&pfd, 1, timeoutMs) > 0;
+    #else
+        struct pollfd pfd;
+        pfd.fd = m_socket;
+        pfd.events = POLLIN;
+        pfd.revents = 0;
+        return poll(&pfd, 1, timeoutMs) > 0;
+    #endif
+}
+
+}
@@ -0,0 +1,138 @@
+#ifndef __DDPSocket__
+#define __DDPSocket__
+
+// Must include winsock2 before Windows.h to avoid conflicts
+#ifdef _WIN32
+    #ifndef WIN32_LEAN_AND_MEAN
+        #define WIN32_LEAN_AND_MEAN
+    #endif
+    #ifndef NOMINMAX
+        #define NOMINMAX  // Prevent Windows from defining min/max macros
+    #endif
+    #include <winsock2.h>
+    #include <ws2tcpip.h>
+    #include <iphlpapi.h>  // if_nametoindex
+#else
+    #include <sys/socket.h>
+    #include <netinet/in.h>
+    #include <arpa/inet.h>
+#endif
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace ddp
+{
+
+// Address helpers (IPv4 and IPv6)
+
+// Parse a literal address ("10.0.0.5", "fe80::1%eth0", "[::1]"). Hostnames are
+// not looked up here, see HostResolver.
+bool parseAddress(const std::string& text, int port, struct sockaddr_storage& addr, socklen_t& addrLen);
+
+// Numeric form of an address; IPv4-mapped IPv6 addresses are shown dotted
+std::string formatAddress(const struct sockaddr* addr, uint16_t* port = nullptr);
+
+void setPort(struct sockaddr_storage& addr, int port);
+socklen_t addressLength(const struct sockaddr_storage& addr);
+bool isMulticast(const struct sockaddr_storage& addr);
+
+// IPv4 limited broadcast, or the subnet broadcast address of a local interface
+bool isBroadcast(const struct sockaddr_storage& addr);
+
+// True when both addresses name the same host (ports are ignored)
+bool sameHost(const struct sockaddr_storage& a, const struct sockaddr_storage& b);
+
+// MTU of the interface used to reach 'dest' (the bound device/address when
+// 'bindInterface' is set). Returns 0 when unknown.
+int queryInterfaceMTU(const struct sockaddr_storage& dest, const std::string& bindInterface);
+
+// One datagram described as header + payload, so frames can be sent
+// straight from the converted pixel buffer without copying
+struct SendSlice
+{
+    const uint8_t* header;
+    size_t headerLength;
+    const uint8_t* payload;
+    size_t payloadLength;
+};
+
+// Thin UDP socket wrapper shared by DDP Out and DDP In. Hides the Winsock /
+// BSD differences, keeps WSAStartup reference counted across instances and
+// reports failures through lastError() instead of exceptions.
+class UdpSocket
+{
+public:
+    UdpSocket();
+    ~UdpSocket();
+
+    UdpSocket(const UdpSocket&) = delete;
+    UdpSocket& operator=(const UdpSocket&) = delete;
+
+    // IPv6 sockets are opened dual-stack (IPV6_V6ONLY off)
+    bool open(int family);
+    void close();
+    bool isOpen() const { return m_open; }
+    int family() const { return m_family; }
+
+    bool setReuseAddress();
+    bool setBroadcast(bool enable);
+    bool setNonBlocking(bool enable);
+    bool setReceiveBuffer(int bytes);
+    bool setSendBuffer(int bytes);
+
+    // Bind to 'bindInterface' (local address, or device name via SO_BINDTODEVICE /
+    // IP_BOUND_IF; empty = any) on 'port' (0 = ephemeral)
+    bool bindTo(const std::string& bindInterface, int port);
+
+    // Sender side multicast options (TTL/hop limit, loopback, outgoing interface)
+    bool configureMulticastSend(int ttl, bool loopback, const std::string& interfaceName);
+
+    // Receiver side group membership
+    bool joinGroup(const std::string& group, const std::string& interfaceName);
+
+    // Returns bytes sent or -1 (see lastError())
+    int sendTo(const void* data, size_t length, const struct sockaddr_storage& dest, socklen_t destLength);
+
+    // Send a batch of datagrams to one destination (sendmmsg on Linux).
+    // Returns the number of datagrams sent and adds their size to 'bytesSent'.
+    size_t sendSlices(const SendSlice* slices, size_t count,
+                      const struct sockaddr_storage& dest, socklen_t destLength,
+                      int64_t& bytesSent);
+
+    // Returns bytes received, or -1 when nothing is pending ('wouldBlock') or on error
+    int recvFrom(void* buffer, size_t length, struct sockaddr_storage& from, bool& wouldBlock);
+
+    // Wait up to 'timeoutMs' for data. Returns true when readable.
+    bool waitReadable(int timeoutMs);
+
+    // Address and port the socket is bound to (getsockname)
+    bool localAddress(struct sockaddr_storage& addr) const;
+
+    const std::string& lastError() const { return m_lastError; }
+
+private:
+    void setError(const std::string& what);
+    static bool startup(std::string& error);
+    static void cleanup();
+
+    #ifdef _WIN32
+        SOCKET m_socket;
+    #else
+        int m_socket;
+    #endif
+
+    bool m_open;
+    bool m_started;
+    int m_family;
+    std::string m_lastError;
+
+    // Reused batch scratch space (no per-frame allocation)
+    std::vector<uint8_t> m_batchScratch;
+};
+
+}
+
+#endif
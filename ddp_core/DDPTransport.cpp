@@ -0,0 +1,186 @@
+#include "DDPTransport.h"
+#include <algorithm>
+#include <cctype>
+#include <cstdlib>
+
+namespace ddp
+{
+
+namespace
+{
+    std::string trimmedLower(const std::string& cell)
+    {
+        std::string text;
+        for (char c : cell)
+        {
+            if (!isspace(static_cast<unsigned char>(c)))
+                text += static_cast<char>(tolower(static_cast<unsigned char>(c)));
+        }
+        return text;
+    }
+
+    // Empty cells keep 'value'
+    bool parseNumber(const std::string& cell, long& value)
+    {
+        std::string text = trimmedLower(cell);
+        if (text.empty())
+            return true;
+        char* end = nullptr;
+        long number = strtol(text.c_str(), &end, 10);
+        if (end == text.c_str() || *end != '\0')
+            return false;
+        value = number;
+        return true;
+    }
+
+    // Takes a trailing ":port" off 'address'; a bare IPv6 address has none
+    bool splitPort(std::string& address, int& port)
+    {
+        size_t colon = address.rfind(':');
+        if (colon == std::string::npos)
+            return true;
+        bool bracketed = address[0] == '[';
+        if (bracketed ? colon == 0 || address[colon - 1] != ']' : address.find(':') != colon)
+            return true;
+        long number = 0;
+        std::string digits = address.substr(colon + 1);
+        if (digits.empty() || !parseNumber(digits, number) || number < 1 || number > 65535)
+            return false;
+        port = static_cast<int>(number);
+        address = bracketed ? address.substr(1, colon - 2) : address.substr(0, colon);
+        return true;
+    }
+
+    std::string rangeLabel(const PixelRange& range)
+    {
+        if (!range.name.empty())
+            return "Range '" + range.name + "'";
+        return "Range starting at pixel " + std::to_string(range.start);
+    }
+}
+
+bool parseTransport(const std::string& name, Transport& transport)
+{
+    std::string text = trimmedLower(name);
+    if (text.empty() || text == "ddp")
+        transport = Transport::Ddp;
+    else if (text == "sacn" || text == "e131" || text == "e1.31")
+        transport = Transport::Sacn;
+    else if (text == "artnet" || text == "art-net")
+        transport = Transport::ArtNet;
+    else
+        return false;
+    return true;
+}
+
+const char* transportName(Transport transport)
+{
+    switch (transport)
+    {
+        case Transport::Sacn:
+            return "sACN";
+        case Transport::ArtNet:
+            return "Art-Net";
+        default:
+            return "DDP";
+    }
+}
+
+bool planTransports(const std::vector<PixelRange>& ranges, size_t frameBytes, size_t bytesPerPixel,
+                    std::vector<TransportRoute>& routes, std::vector<ByteSpan>& ddpSpans, std::string& error)
+{
+    routes.clear();
+    ddpSpans.clear();
+    bytesPerPixel = std::max<size_t>(1, bytesPerPixel);
+
+    // Ranges are sorted and do not overlap, so the spans left to DDP are the gaps
+    size_t position = 0;
+    for (size_t i = 0; i < ranges.size(); i++)
+    {
+        const PixelRange& range = ranges[i];
+        TransportRoute route;
+        if (!parseTransport(range.protocol, route.transport))
+        {
+            error = rangeLabel(range) + ": protocol '" + range.protocol + "' is not ddp, sacn or artnet";
+            return false;
+        }
+        route.address = trimmedLower(range.address);
+        if (!splitPort(route.address, route.port))
+        {
+            error = rangeLabel(range) + ": address '" + range.address + "' has a bad port";
+            return false;
+        }
+        if (route.transport == Transport::Ddp && route.address.empty())
+            continue;
+
+        size_t start = std::min(frameBytes, static_cast<size_t>(range.start) * bytesPerPixel);
+        size_t end = range.count == 0 ? frameBytes
+                                      : std::min(frameBytes, (static_cast<size_t>(range.start) + range.count) * bytesPerPixel);
+        route.name = range.name.empty() ? std::to_string(i + 1) : range.name;
+        route.bytes.offset = start;
+        route.bytes.length = end - start;
+
+        if (route.transport != Transport::Ddp)
+        {
+            DmxProtocol protocol = route.transport == Transport::ArtNet ? DmxProtocol::ArtNet : DmxProtocol::Sacn;
+            long universe = protocol == DmxProtocol::ArtNet ? 0 : 1;
+            long channels = static_cast<long>(DDP_DMX_CHANNELS - DDP_DMX_CHANNELS % std::min<size_t>(bytesPerPixel, DDP_DMX_CHANNELS));
+            if (!parseNumber(range.universe, universe) || universe < 0 || universe > 0xFFFF)
+            {
+                error = rangeLabel(range) + ": universe '" + range.universe + "' is not a universe number";
+                return false;
+            }
+            if (!parseNumber(range.channels, channels) || channels < 1 || channels > DDP_DMX_CHANNELS)
+            {
+                error = rangeLabel(range) + ": channels '" + range.channels + "' is not between 1 and 512";
+                return false;
+            }
+            int count = static_cast<int>((route.bytes.length + channels - 1) / channels);
+            if (universe + count - 1 > 0xFFFF)
+            {
+                error = rangeLabel(range) + ": " + std::to_string(count) + " universes from " +
+                        std::to_string(universe) + " run past 65535";
+                return false;
+            }
+            consecutiveUniverses(static_cast<uint32_t>(start), static_cast<uint16_t>(universe), count,
+                                 static_cast<int>(channels), route.universes);
+
+            // The last universe only carries what is left of the range
+            if (!route.universes.empty())
+                route.universes.back().length = static_cast<uint32_t>(end - route.universes.back().offset);
+
+            std::vector<UniverseMap> sorted = route.universes;
+            if (!validateUniverses(sorted, protocol, error))
+            {
+                error = rangeLabel(range) + ": " + error;
+                return false;
+            }
+
+            // The same universe twice at one address would mix two ranges
+            for (const TransportRoute& other : routes)
+            {
+                if (other.transport != route.transport || other.address != route.address || other.port != route.port ||
+                    other.universes.empty() || route.universes.empty())
+                    continue;
+                uint16_t first = route.universes.front().universe, last = route.universes.back().universe;
+                uint16_t otherFirst = other.universes.front().universe, otherLast = other.universes.back().universe;
+                if (first <= otherLast && otherFirst <= last)
+                {
+                    error = rangeLabel(range) + ": universe " + std::to_string(std::max(first, otherFirst)) +
+                            " is also sent by range '" + other.name + "'";
+                    return false;
+                }
+            }
+        }
+
+        if (start > position)
+            ddpSpans.push_back({ position, start - position });
+        position = std::max(position, end);
+        routes.push_back(route);
+    }
+    if (frameBytes > position)
+        ddpSpans.push_back({ position, frameBytes - position });
+    return true;
+}
+
+}
@@ -0,0 +1,58 @@
+#ifndef __DDPTransport__
+#define __DDPTransport__
+
+#include "DDPDmx.h"
+#include "DDPFrameSegmenter.h"
+#include "DDPRanges.h"
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+// Source name in the sACN packets of DDP Out's ranges
+#define DDP_TRANSPORT_SACN_NAME "TouchDesigner DDP Out"
+
+namespace ddp
+{
+
+// How a block of the converted frame goes on the wire
+enum class Transport
+{
+    Ddp,
+    Sacn,
+    ArtNet
+};
+
+// "ddp", "sacn" (or "e131", "e1.31") and "artnet" (or "art-net"), in any
+// case; empty is DDP
+bool parseTransport(const std::string& name, Transport& transport);
+
+// "DDP", "sACN", "Art-Net"
+const char* transportName(Transport transport);
+
+// A range sent somewhere other than the output's own DDP stream
+struct TransportRoute
+{
+    std::string name;                   // the range's name, or its number
+    Transport transport = Transport::Ddp;
+    std::string address;                // empty = sACN multicast / Art-Net broadcast
+    int port = 0;                       // 0 = the protocol's, for DDP the output's
+    ByteSpan bytes = { 0, 0 };          // the range's bytes in the frame
+    std::vector<UniverseMap> universes; // sACN and Art-Net, in frame offsets
+};
+
+// Splits a frame of 'frameBytes' between the output's own DDP stream and the
+// ranges with a protocol or an address of their own. Addresses may name a
+// port ("10.0.0.5:6455", "[fe80::1]:4048"). A DDP range with an address is
+// a frame of its own, starting at offset 0. sACN and Art-Net
+// ranges fill consecutive universes from 'universe' (default the protocol's
+// first), 'channels' each (default the whole pixels that fit in 512).
+// 'ddpSpans' gets the bytes the output still sends itself, in order.
+// Errors: an unknown protocol, a bad port, universe or channel count, or a
+// universe two ranges send to the same address.
+bool planTransports(const std::vector<PixelRange>& ranges, size_t frameBytes, size_t bytesPerPixel,
+                    std::vector<TransportRoute>& routes, std::vector<ByteSpan>& ddpSpans, std::string& error);
+
+}
+
+#endif
@@ -0,0 +1,197 @@
+#include "HostResolver.h"
+#include <chrono>
+#include <cstring>
+
+#ifndef _WIN32
+    #include <netdb.h>
+    #include <arpa/inet.h>
+#endif
+
+// Refresh interval for a good address, and retry interval after a failure
+#define RESOLVE_REFRESH_SEC 30.0
+#define RESOLVE_RETRY_SEC   2.0
+#define RESOLVE_CACHE_MAX   16
+
+namespace ddp
+{
+
+HostResolver::HostResolver() : m_stop(false)
+{
+    m_worker = std::thread(&HostResolver::workerLoop, this);
+}
+
+HostResolver::~HostResolver()
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stop = true;
+    }
+    m_wake.notify_all();
+    
+    // getaddrinfo cannot be cancelled, so this may wait for a lookup in flight
+    if (m_worker.joinable())
+        m_worker.join();
+}
+
+double HostResolver::nowSeconds()
+{
+    auto now = std::chrono::steady_clock::now().time_since_epoch();
+    return std::chrono::duration<double>(now).count();
+}
+
+bool HostResolver::lookup(const std::string& host, struct sockaddr_storage& addr, socklen_t& addrLen)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    
+    if (host != m_currentHost)
+    {
+        m_currentHost = host;
+        
+        // Keep the cache small, but keep recent hosts so switching back is instant
+        if (m_cache.size() >= RESOLVE_CACHE_MAX)
+            m_cache.clear();
+        
+        m_wake.notify_all();
+    }
+    
+    auto it = m_cache.find(host);
+    if (it == m_cache.end() || !it->second.valid)
+        return false;
+    
+    addr = it->second.addr;
+    addrLen = it->second.addrLen;
+    return true;
+}
+
+std::string HostResolver::getStatus() const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    
+    auto it = m_cache.find(m_currentHost);
+    if (it == m_cache.end() || it->second.lastAttempt < 0.0)
+        return "Resolving " + m_currentHost + "...";
+    if (!it->second.error.empty())
+        return it->second.error + (it->second.valid ? " (using cached address)" : "");
+    return "";
+}
+
+std::string HostResolver::getResolvedAddress() const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    
+    auto it = m_cache.find(m_currentHost);
+    if (it == m_cache.end() || !it->second.valid)
+        return "";
+    
+    return formatAddress(reinterpret_cast<const struct sockaddr*>(&it->second.addr));
+}
+
+double HostResolver::getLastLatencyMs() const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    
+    auto it = m_cache.find(m_currentHost);
+    return it != m_cache.end() ? it->second.latencyMs : 0.0;
+}
+
+bool HostResolver::resolveNow(const std::string& host, Entry& entry)
+{
+    struct addrinfo hints;
+    memset(&hints, 0, sizeof(hints));
+    hints.ai_family = AF_UNSPEC;       // A and AAAA
+    hints.ai_socktype = SOCK_DGRAM;
+    hints.ai_flags = AI_ADDRCONFIG;    // only families this host can actually use
+    
+    double start = nowSeconds();
+    struct addrinfo* results = nullptr;
+    int status = getaddrinfo(host.c_str(), nullptr, &hints, &results);
+    entry.latencyMs = (nowSeconds() - start) * 1000.0;
+    
+    if (status != 0 || !results)
+    {
+        #ifdef _WIN32
+            entry.error = "Cannot resolve " + host + ": error " + std::to_string(status);
+        #else
+            entry.error = "Cannot resolve " + host + ": " + gai_strerror(status);
+        #endif
+        return false;
+    }
+    
+    // Prefer IPv4 when both are offered, most LED controllers are IPv4 only
+    const struct addrinfo* chosen = results;
+    for (const struct addrinfo* ai = results; ai != nullptr; ai = ai->ai_next)
+    {
+        if (ai->ai_family == AF_INET)
+        {
+            chosen = ai;
+            break;
+        }
+    }
+    
+    memset(&entry.addr, 0, sizeof(entry.addr));
+    memcpy(&entry.addr, chosen->ai_addr, chosen->ai_addrlen);
+    entry.addrLen = static_cast<socklen_t>(chosen->ai_addrlen);
+    entry.valid = true;
+    entry.error.clear();
+    
+    freeaddrinfo(results);
+    return true;
+}
+
+void HostResolver::workerLoop()
+{
+    #ifdef _WIN32
+        WSADATA wsaData;
+        bool wsaStarted = (WSAStartup(MAKEWORD(2, 2), &wsaData) == 0);
+    #endif
+    
+    std::unique_lock<std::mutex> lock(m_mutex);
+    
+    while (!m_stop)
+    {
+        if (m_currentHost.empty())
+        {
+            m_wake.wait(lock);
+            continue;
+        }
+        
+        std::string host = m_currentHost;
+        Entry& cached = m_cache[host];
+        double now = nowSeconds();
+        double interval = cached.valid ? RESOLVE_REFRESH_SEC : RESOLVE_RETRY_SEC;
+        
+        if (cached.lastAttempt >= 0.0 && now - cached.lastAttempt < interval)
+        {
+            double waitSec = interval - (now - cached.lastAttempt);
+            m_wake.wait_for(lock, std::chrono::duration<double>(waitSec));
+            continue;
+        }
+        
+        // Resolve without holding the lock so cooks never wait on DNS
+        Entry result;
+        lock.unlock();
+        bool ok = resolveNow(host, result);
+        lock.lock();
+        
+        // The cache may have been cleared while unlocked, so look the entry up again
+        Entry& entry = m_cache[host];
+        entry.lastAttempt = nowSeconds();
+        entry.latencyMs = result.latencyMs;
+        entry.error = result.error;
+        if (ok)
+        {
+            entry.addr = result.addr;
+            entry.addrLen = result.addrLen;
+            entry.valid = true;
+        }
+    }
+    
+    lock.unlock();
+    
+    #ifdef _WIN32
+        if (wsaStarted)
+            WSACleanup();
+    #endif
+}
+
+}
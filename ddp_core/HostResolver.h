@@ -0,0 +1,59 @@
+#ifndef __HostResolver__
+#define __HostResolver__
+
+#include "DDPSocket.h"
+
+#include <condition_variable>
+#include <map>
+#include <mutex>
+#include <string>
+#include <thread>
+
+namespace ddp
+{
+
+// Background DNS / mDNS resolver.
+// Lookups run on a worker thread so a slow resolver (e.g. "wled-stage-left.local")
+// never blocks a cook. Results are cached per host and refreshed periodically;
+// a failed refresh keeps serving the last good address.
+class HostResolver
+{
+public:
+    HostResolver();
+    ~HostResolver();
+
+    // Ask for 'host' to be resolved (cheap, call every cook). Returns true and fills
+    // 'addr' once an address is cached. The port is left at 0.
+    bool lookup(const std::string& host, struct sockaddr_storage& addr, socklen_t& addrLen);
+
+    // Status of the most recently requested host, for the Info DAT
+    std::string getStatus() const;
+    std::string getResolvedAddress() const;
+    double getLastLatencyMs() const;
+
+private:
+    struct Entry
+    {
+        struct sockaddr_storage addr;
+        socklen_t addrLen = 0;
+        bool valid = false;
+        double lastAttempt = -1.0;   // steady clock seconds, < 0 = never tried
+        double latencyMs = 0.0;
+        std::string error;
+    };
+
+    void workerLoop();
+    bool resolveNow(const std::string& host, Entry& entry);
+    static double nowSeconds();
+
+    mutable std::mutex m_mutex;
+    std::condition_variable m_wake;
+    std::map<std::string, Entry> m_cache;
+    std::string m_currentHost;
+    bool m_stop;
+    std::thread m_worker;
+};
+
+}
+
+#endif
@@ -0,0 +1,156 @@
+#include "BenchHarness.h"
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <fstream>
+
+namespace bench
+{
+
+namespace
+{
+    double nowSeconds()
+    {
+        auto now = std::chrono::steady_clock::now().time_since_epoch();
+        return std::chrono::duration<double>(now).count();
+    }
+
+    std::string jsonEscape(const std::string& text)
+    {
+        std::string escaped;
+        for (char c : text)
+        {
+            if (c == '"' || c == '\\')
+                escaped += '\\';
+            escaped += c;
+        }
+        return escaped;
+    }
+}
+
+Runner::Runner()
+{
+    m_minTime = 0.2;
+    m_repetitions = 3;
+}
+
+bool Runner::parseArgs(int argc, char** argv)
+{
+    for (int i = 1; i < argc; i++)
+    {
+        std::string arg = argv[i];
+        bool hasValue = (i + 1 < argc);
+        
+        if (arg == "--json" && hasValue)
+            m_jsonPath = argv[++i];
+        else if (arg == "--filter" && hasValue)
+            m_filter = argv[++i];
+        else if (arg == "--min-time" && hasValue)
+            m_minTime = std::max(0.001, atof(argv[++i]));
+        else if (arg == "--repetitions" && hasValue)
+            m_repetitions = std::max(1, atoi(argv[++i]));
+        else
+        {
+            fprintf(stderr, "usage: %s [--json file] [--filter text] [--min-time seconds] [--repetitions n]\n", argv[0]);
+            return false;
+        }
+    }
+    
+    printf("%-36s %14s %12s %14s %12s\n", "benchmark", "ns/iter", "iterations", "Mpixels/s", "MB/s");
+    return true;
+}
+
+void Runner::run(const std::string& name, int64_t pixels, int64_t bytes, const std::function<void()>& fn)
+{
+    if (!m_filter.empty() && name.find(m_filter) == std::string::npos)
+        return;
+    
+    // Warm up caches and grow any lazily sized buffers
+    fn();
+    
+    double best = 0.0;
+    int64_t bestIterations = 0;
+    
+    for (int rep = 0; rep < m_repetitions; rep++)
+    {
+        // Double the batch until one batch runs for at least the minimum time
+        int64_t iterations = 1;
+        double elapsed = 0.0;
+        while (true)
+        {
+            double start = nowSeconds();
+            for (int64_t i = 0; i < iterations; i++)
+                fn();
+            elapsed = nowSeconds() - start;
+            
+            if (elapsed >= m_minTime || iterations >= (int64_t(1) << 40))
+                break;
+            iterations *= 2;
+        }
+        
+        double perIteration = elapsed / static_cast<double>(iterations);
+        if (rep == 0 || perIteration < best)
+        {
+            best = perIteration;
+            bestIterations = iterations;
+        }
+    }
+    
+    Result result;
+    result.name = name;
+    result.pixels = pixels;
+    result.bytes = bytes;
+    result.iterations = bestIterations;
+    result.nsPerIteration = best * 1e9;
+    m_results.push_back(result);
+    
+    printf("%-36s %14.0f %12lld %14.2f %12.1f\n", name.c_str(), result.nsPerIteration,
+           static_cast<long long>(bestIterations), pixels / best / 1e6, bytes / best / 1e6);
+    fflush(stdout);
+}
+
+int Runner::finish()
+{
+    if (m_jsonPath.empty())
+        return 0;
+    
+    std::ofstream out(m_jsonPath.c_str());
+    if (!out)
+    {
+        fprintf(stderr, "Cannot write %s\n", m_jsonPath.c_str());
+        return 1;
+    }
+    
+    char date[32] = {0};
+    time_t now = time(nullptr);
+    strftime(date, sizeof(date), "%Y-%m-%dT%H:%M:%SZ", gmtime(&now));
+    
+    out << "{\n  \"context\": {\n";
+    out << "    \"date\": \"" << date << "\",\n";
+    #ifdef NDEBUG
+        out << "    \"build_type\": \"release\",\n";
+    #else
+        out << "    \"build_type\": \"debug\",\n";
+    #endif
+    out << "    \"min_time_sec\": " << m_minTime << ",\n";
+    out << "    \"repetitions\": " << m_repetitions << "\n  },\n";
+    out << "  \"benchmarks\": [\n";
+    for (size_t i = 0; i < m_results.size(); i++)
+    {
+        const Result& r = m_results[i];
+        double seconds = r.nsPerIteration / 1e9;
+        out << "    {\"name\": \"" << jsonEscape(r.name) << "\""
+            << ", \"iterations\": " << r.iterations
+            << ", \"real_time_ns\": " << r.nsPerIteration
+            << ", \"pixels\": " << r.pixels
+            << ", \"pixels_per_second\": " << (r.pixels / seconds)
+            << ", \"bytes_per_second\": " << (r.bytes / seconds) << "}"
+            << (i + 1 < m_results.size() ? ",\n" : "\n");
+    }
+    out << "  ]\n}\n";
+    return 0;
+}
+
+}
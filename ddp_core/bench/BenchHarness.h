@@ -0,0 +1,62 @@
+#ifndef __BenchHarness__
+#define __BenchHarness__
+
+// Minimal in-tree benchmark harness: times a function until a minimum run time
+// is reached, repeats that a few times and keeps the fastest repetition.
+// Results are printed as a table and optionally written as JSON.
+
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <vector>
+
+namespace bench
+{
+
+// Keep the optimizer from discarding a computed value
+template <typename T>
+inline void doNotOptimize(const T& value)
+{
+    #if defined(__GNUC__) || defined(__clang__)
+        asm volatile("" : : "r,m"(value) : "memory");
+    #else
+        const volatile char* p = reinterpret_cast<const volatile char*>(&value);
+        (void)*p;
+    #endif
+}
+
+struct Result
+{
+    std::string name;
+    int64_t pixels;           // pixels processed per iteration
+    int64_t bytes;            // bytes produced/consumed per iteration
+    int64_t iterations;
+    double nsPerIteration;
+};
+
+class Runner
+{
+public:
+    Runner();
+
+    // Parse --json <file>, --filter <substring>, --min-time <seconds>, --repetitions <n>
+    bool parseArgs(int argc, char** argv);
+
+    // Time 'fn' (one call = one iteration over 'pixels' pixels / 'bytes' bytes)
+    void run(const std::string& name, int64_t pixels, int64_t bytes, const std::function<void()>& fn);
+
+    // Print the JSON report (when requested). Returns the process exit code.
+    int finish();
+
+private:
+    std::string m_jsonPath;
+    std::string m_filter;
+    double m_minTime;
+    int m_repetitions;
+    std::vector<Result> m_results;
+};
+
+}
+
+#endif
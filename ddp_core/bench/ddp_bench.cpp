@@ -0,0 +1,441 @@
+// ddp_bench: hot path benchmarks for the shared DDP core, runnable without TouchDesigner.
+//
+//   ddp_bench [--json results.json] [--filter convert] [--min-time 0.2] [--repetitions 3]
+
+#include "BenchHarness.h"
+#include "DDPProtocol.h"
+#include "DDPFrameSegmenter.h"
+#include "DDPFrameAssembler.h"
+#include "DDPFrameRing.h"
+#include "DDPFrameSmoother.h"
+#include "DDPPixelConvert.h"
+#include "DDPCalibration.h"
+#include "DDPPixelMap.h"
+#include "DDPLayout.h"
+#include "DDPPower.h"
+#include "DDPTransport.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+namespace
+{
+    const int64_t kPixelCounts[] = { 1000, 10000, 100000, 1000000 };
+    const int kChannelsPerPixel = 3;
+
+    // Deterministic test pattern in the 0-1 range (including out-of-range values to exercise clamping)
+    std::vector<float> makeSamples(size_t count)
+    {
+        std::vector<float> samples(count);
+        uint32_t state = 0x12345678u;
+        for (size_t i = 0; i < count; i++)
+        {
+            state = state * 1664525u + 1013904223u;
+            samples[i] = static_cast<float>(state >> 8) / static_cast<float>(1u << 24) * 1.1f - 0.05f;
+        }
+        return samples;
+    }
+
+    std::string label(const char* name, int64_t pixels)
+    {
+        return std::string(name) + "/" + std::to_string(pixels);
+    }
+
+    // CHOP samples -> DDP bytes, the DDP Out processInterleavedChannels() path
+    void benchConvert(bench::Runner& runner, int64_t pixels, float gamma, const char* name)
+    {
+        size_t count = static_cast<size_t>(pixels) * kChannelsPerPixel;
+        std::vector<float> samples = makeSamples(count);
+        std::vector<uint8_t> bytes(count);
+        
+        ddp::ConvertSettings settings;
+        settings.gamma = gamma;
+        settings.brightness = 0.8f;
+        settings.normalizedInput = true;
+        
+        runner.run(label(name, pixels), pixels, static_cast<int64_t>(count), [&]()
+        {
+            ddp::convertSamples(samples.data(), count, settings, bytes.data());
+            bench::doNotOptimize(bytes[count - 1]);
+        });
+    }
+
+    // CHOP samples -> big-endian 16-bit values (Bit Depth 16)
+    void benchWide(bench::Runner& runner, int64_t pixels, float gamma, const char* name)
+    {
+        size_t count = static_cast<size_t>(pixels) * kChannelsPerPixel;
+        std::vector<float> samples = makeSamples(count);
+        std::vector<uint8_t> bytes(count * 2);
+        
+        ddp::ConvertSettings settings;
+        settings.gamma = gamma;
+        settings.brightness = 0.8f;
+        
+        runner.run(label(name, pixels), pixels, static_cast<int64_t>(bytes.size()), [&]()
+        {
+            ddp::convertSamplesBE16(samples.data(), count, settings, bytes.data());
+            bench::doNotOptimize(bytes[bytes.size() - 1]);
+        });
+    }
+
+    // CHOP samples -> DDP bytes in wire order through a serpentine matrix layout,
+    // as runs or through the per-pixel index table
+    void benchLayout(bench::Runner& runner, int64_t pixels, float gamma, bool useRuns, const char* name)
+    {
+        size_t count = static_cast<size_t>(pixels) * kChannelsPerPixel;
+        std::vector<float> samples = makeSamples(count);
+        std::vector<uint8_t> bytes(count);
+        
+        ddp::LayoutSettings layoutSettings;
+        layoutSettings.width = 100;
+        layoutSettings.height = static_cast<uint32_t>(pixels / 100);
+        layoutSettings.serpentine = true;
+        layoutSettings.start = ddp::LayoutCorner::TopLeft;
+        ddp::LedLayout layout;
+        layout.compile(layoutSettings, static_cast<size_t>(pixels));
+        
+        ddp::ConvertSettings settings;
+        settings.gamma = gamma;
+        settings.brightness = 0.8f;
+        settings.normalizedInput = true;
+        
+        runner.run(label(name, pixels), pixels, static_cast<int64_t>(count), [&]()
+        {
+            if (useRuns)
+                ddp::convertRuns(samples.data(), layout.runs().data(), layout.runs().size(), kChannelsPerPixel,
+                                 settings, bytes.data());
+            else
+                ddp::convertGathered(samples.data(), layout.indices(), layout.size(), kChannelsPerPixel,
+                                     settings, bytes.data());
+            bench::doNotOptimize(bytes[count - 1]);
+        });
+    }
+
+    // CHOP samples -> DDP bytes with every pixel sent as GRB
+    void benchColorOrder(bench::Runner& runner, int64_t pixels, const char* name)
+    {
+        size_t count = static_cast<size_t>(pixels) * kChannelsPerPixel;
+        std::vector<float> samples = makeSamples(count);
+        std::vector<uint8_t> bytes(count);
+        
+        std::vector<ddp::ColorOrder> orders(1);
+        std::string error;
+        ddp::parseColorOrder("GRB", kChannelsPerPixel, orders[0], error);
+        ddp::LayoutRun all = { 0, static_cast<uint32_t>(pixels), 1, 0 };
+        
+        ddp::ConvertSettings settings;
+        settings.brightness = 0.8f;
+        
+        runner.run(label(name, pixels), pixels, static_cast<int64_t>(count), [&]()
+        {
+            ddp::convertRuns(samples.data(), &all, 1, kChannelsPerPixel, settings, bytes.data(), orders.data());
+            bench::doNotOptimize(bytes[count - 1]);
+        });
+    }
+
+    // Temporal dithering: 16-bit conversion + carried remainders in L1-sized blocks
+    void benchDither(bench::Runner& runner, int64_t pixels, float gamma, const char* name)
+    {
+        size_t count = static_cast<size_t>(pixels) * kChannelsPerPixel;
+        std::vector<float> samples = makeSamples(count);
+        std::vector<uint8_t> bytes(count);
+        std::vector<uint8_t> error(count);
+        ddp::seedDitherError(error.data(), count);
+        ddp::LayoutRun all = { 0, static_cast<uint32_t>(pixels), 1, 0 };
+        
+        ddp::ConvertSettings settings;
+        settings.gamma = gamma;
+        settings.brightness = 0.8f;
+        
+        runner.run(label(name, pixels), pixels, static_cast<int64_t>(count), [&]()
+        {
+            ddp::convertRuns(samples.data(), &all, 1, kChannelsPerPixel, settings, bytes.data(), nullptr, error.data());
+            bench::doNotOptimize(bytes[count - 1]);
+        });
+    }
+
+    // A warm-white fixture correction with half of the white moved to W
+    ddp::CalibrationSettings makeCalibration()
+    {
+        ddp::CalibrationSettings calibration;
+        const float matrix[9] = { 0.9f, 0.1f, 0.0f, 0.05f, 0.9f, 0.05f, 0.0f, 0.2f, 0.8f };
+        std::copy(matrix, matrix + 9, calibration.matrix);
+        calibration.gain[1] = 0.9f;
+        calibration.gain[2] = 0.8f;
+        calibration.white = 0.5f;
+        return calibration;
+    }
+    
+    // RGB samples -> calibrated RGBW bytes (Color Matrix / Gain / White Extraction)
+    void benchCalibrate(bench::Runner& runner, int64_t pixels, float gamma, const char* name)
+    {
+        std::vector<float> samples = makeSamples(static_cast<size_t>(pixels) * 3);
+        size_t count = static_cast<size_t>(pixels) * 4;
+        std::vector<uint8_t> bytes(count);
+        ddp::LayoutRun all = { 0, static_cast<uint32_t>(pixels), 1, 0 };
+        
+        ddp::ConvertSettings settings;
+        settings.gamma = gamma;
+        ddp::CalibrationKernel kernel;
+        ddp::compileCalibration(makeCalibration(), 0.8f, 1.0f, 3, 4, kernel);
+        
+        runner.run(label(name, pixels), pixels, static_cast<int64_t>(count), [&]()
+        {
+            ddp::convertRuns(samples.data(), &all, 1, 4, settings, bytes.data(), nullptr, nullptr, &kernel);
+            bench::doNotOptimize(bytes[count - 1]);
+        });
+    }
+
+    // CHOP samples -> DDP bytes metered and limited in the same blocks (Power Limit)
+    void benchPower(bench::Runner& runner, int64_t pixels, float gamma, const char* name)
+    {
+        size_t count = static_cast<size_t>(pixels) * kChannelsPerPixel;
+        std::vector<float> samples = makeSamples(count);
+        std::vector<uint8_t> bytes(count);
+        ddp::LayoutRun all = { 0, static_cast<uint32_t>(pixels), 1, 0 };
+        ddp::RangePower power;
+        power.scale = DDP_POWER_SCALE_ONE * 3 / 4;
+        
+        ddp::ConvertSettings settings;
+        settings.gamma = gamma;
+        settings.brightness = 0.8f;
+        
+        runner.run(label(name, pixels), pixels, static_cast<int64_t>(count), [&]()
+        {
+            power.reset();
+            ddp::convertRuns(samples.data(), &all, 1, kChannelsPerPixel, settings, bytes.data(), nullptr, nullptr,
+                             nullptr, &power);
+            bench::doNotOptimize(power.sums[0]);
+        });
+    }
+
+    // Frame -> packet headers + payload slices (the old createDDPPacket() loop)
+    void benchSegment(bench::Runner& runner, int64_t pixels, size_t maxPayload, const char* name)
+    {
+        size_t count = static_cast<size_t>(pixels) * kChannelsPerPixel;
+        std::vector<uint8_t> frame(count, 0x7F);
+        ddp::FrameSegmenter segmenter;
+        
+        ddp::SegmentOptions options;
+        options.maxPayload = maxPayload;
+        
+        runner.run(label(name, pixels), pixels, static_cast<int64_t>(count), [&]()
+        {
+            size_t packets = segmenter.segment(frame.data(), frame.size(), options);
+            bench::doNotOptimize(packets);
+            bench::doNotOptimize(segmenter.slices().back().header[1]);
+        });
+    }
+
+    // One converted frame -> the packets of one transport, the way DDP Out cuts
+    // a range: DDP at 1440 byte payloads, sACN and Art-Net at 510 channels per universe
+    void benchEncode(bench::Runner& runner, int64_t pixels, ddp::Transport transport, const char* name)
+    {
+        size_t count = static_cast<size_t>(pixels) * kChannelsPerPixel;
+        std::vector<uint8_t> frame(count, 0x5A);
+        
+        std::vector<ddp::PixelRange> ranges(1);
+        ranges[0].protocol = ddp::transportName(transport);
+        ranges[0].address = "10.0.0.2";
+        std::vector<ddp::TransportRoute> routes;
+        std::vector<ddp::ByteSpan> spans;
+        std::string error;
+        if (!ddp::planTransports(ranges, count, kChannelsPerPixel, routes, spans, error))
+        {
+            fprintf(stderr, "%s: %s\n", name, error.c_str());
+            return;
+        }
+        
+        ddp::FrameSegmenter segmenter;
+        ddp::SegmentOptions options;
+        ddp::DmxSegmenter dmx;
+        uint8_t cid[DDP_SACN_CID_SIZE] = {};
+        if (transport != ddp::Transport::Ddp)
+            dmx.setUniverses(transport == ddp::Transport::ArtNet ? ddp::DmxProtocol::ArtNet : ddp::DmxProtocol::Sacn,
+                             routes[0].universes, DDP_TRANSPORT_SACN_NAME, cid);
+        
+        runner.run(label(name, pixels), pixels, static_cast<int64_t>(count), [&]()
+        {
+            size_t packets = transport == ddp::Transport::Ddp ? segmenter.segment(frame.data(), frame.size(), options)
+                                                              : dmx.segment(frame.data(), frame.size());
+            bench::doNotOptimize(packets);
+            bench::doNotOptimize(transport == ddp::Transport::Ddp ? segmenter.slices().back().header[1]
+                                                                  : dmx.slices().back().header[1]);
+        });
+    }
+
+    // Received datagrams -> parsed header -> assembled frame (the DDP In receive loop)
+    void benchParseAssemble(bench::Runner& runner, int64_t pixels, const char* name)
+    {
+        size_t count = static_cast<size_t>(pixels) * kChannelsPerPixel;
+        std::vector<uint8_t> frame(count, 0x3C);
+        ddp::FrameSegmenter segmenter;
+        
+        ddp::SegmentOptions options;
+        options.timecode = true;
+        options.timecodeValue = 0x00010000;
+        size_t packetCount = segmenter.segment(frame.data(), frame.size(), options);
+        
+        std::vector<std::vector<uint8_t>> packets(packetCount);
+        for (size_t i = 0; i < packetCount; i++)
+            ddp::FrameSegmenter::flatten(segmenter.slices()[i], packets[i]);
+        
+        std::vector<uint8_t> assembled;
+        
+        runner.run(label(name, pixels), pixels, static_cast<int64_t>(count), [&]()
+        {
+            bool pushed = false;
+            for (const std::vector<uint8_t>& packet : packets)
+            {
+                ddp::PacketHeader header;
+                const uint8_t* payload = nullptr;
+                if (!ddp::unpackHeader(packet.data(), packet.size(), header, payload))
+                    continue;
+                ddp::assemblePayload(assembled, header.offset, payload, header.length);
+                pushed = header.isPush();
+            }
+            bench::doNotOptimize(pushed);
+            bench::doNotOptimize(assembled[count - 1]);
+        });
+    }
+
+    // BGRA8 texture -> DDP bytes through a pixel map (the DDP Out TOP path).
+    // LEDs are scattered over a square texture with one texel per LED.
+    // Calibrated: RGBW through the fixed-point kernel.
+    void benchPixelMap(bench::Runner& runner, int64_t pixels, bool calibrated, const char* name)
+    {
+        uint32_t side = 1;
+        while (static_cast<int64_t>(side) * side < pixels)
+            side++;
+        std::vector<uint8_t> texture(static_cast<size_t>(side) * side * 4, 0x55);
+        
+        std::vector<ddp::MapPoint> points(static_cast<size_t>(pixels));
+        uint32_t state = 0x9E3779B9u;
+        for (ddp::MapPoint& point : points)
+        {
+            state = state * 1664525u + 1013904223u;
+            point.x = static_cast<float>((state >> 8) % side);
+            point.y = static_cast<float>((state >> 20) % side);
+        }
+        ddp::PixelMap map;
+        map.setPoints(points, ddp::MapUnits::Pixels);
+        map.compile(side, side);
+        
+        ddp::ConvertSettings settings;
+        settings.gamma = 2.2f;
+        uint8_t lut[256];
+        ddp::buildByteLUT(settings, lut);
+        uint8_t linearLUT[DDP_CAL_LUT_SIZE];
+        ddp::buildLinearLUT(settings, linearLUT);
+        ddp::CalibrationKernel kernel;
+        ddp::compileCalibration(makeCalibration(), 1.0f, 1.0f / 255.0f, 3, 4, kernel);
+        
+        const int channels = calibrated ? 4 : kChannelsPerPixel;
+        size_t count = static_cast<size_t>(pixels) * channels;
+        std::vector<uint8_t> bytes(count);
+        runner.run(label(name, pixels), pixels, static_cast<int64_t>(count), [&]()
+        {
+            if (calibrated)
+                map.sampleCalibrated(texture.data(), 0, map.size(), kernel, linearLUT, channels, bytes.data());
+            else
+                map.sampleBGRA8(texture.data(), lut, channels, bytes.data());
+            bench::doNotOptimize(bytes[count - 1]);
+        });
+    }
+
+    // Received bytes -> CHOP samples (DDP In output channel)
+    void benchBytesToFloat(bench::Runner& runner, int64_t pixels, const char* name)
+    {
+        size_t count = static_cast<size_t>(pixels) * kChannelsPerPixel;
+        std::vector<uint8_t> bytes(count);
+        for (size_t i = 0; i < count; i++)
+            bytes[i] = static_cast<uint8_t>(i * 31);
+        std::vector<float> samples(count);
+        
+        runner.run(label(name, pixels), pixels, static_cast<int64_t>(count), [&]()
+        {
+            ddp::convertBytesToSamples(bytes.data(), count, true, samples.data());
+            bench::doNotOptimize(samples[count - 1]);
+        });
+    }
+
+    // Interpolated DDP In output: the last two received frames blended into CHOP samples
+    void benchBlend(bench::Runner& runner, int64_t pixels, const char* name)
+    {
+        size_t count = static_cast<size_t>(pixels) * kChannelsPerPixel;
+        std::vector<uint8_t> previous(count);
+        std::vector<uint8_t> current(count);
+        for (size_t i = 0; i < count; i++)
+        {
+            previous[i] = static_cast<uint8_t>(i * 31);
+            current[i] = static_cast<uint8_t>(i * 17);
+        }
+        std::vector<float> samples(count);
+        
+        runner.run(label(name, pixels), pixels, static_cast<int64_t>(count), [&]()
+        {
+            ddp::blendSamples(previous.data(), current.data(), count, 1, 0.25f / 255.0f, 0.75f / 255.0f,
+                              samples.data());
+            bench::doNotOptimize(samples[count - 1]);
+        });
+    }
+
+    // DDP In frame history: a complete frame copied into the preallocated ring
+    void benchFrameRing(bench::Runner& runner, int64_t pixels, const char* name)
+    {
+        size_t count = static_cast<size_t>(pixels) * kChannelsPerPixel;
+        std::vector<uint8_t> frame(count);
+        for (size_t i = 0; i < count; i++)
+            frame[i] = static_cast<uint8_t>(i * 31);
+        ddp::FrameRing ring;
+        ring.reset(8);
+        double time = 0.0;
+        
+        runner.run(label(name, pixels), pixels, static_cast<int64_t>(count), [&]()
+        {
+            ring.push(frame.data(), frame.size(), time);
+            time += 1.0 / 60.0;
+            bench::doNotOptimize(ring.frame(ring.size() - 1)[count - 1]);
+        });
+    }
+}
+
+int main(int argc, char** argv)
+{
+    bench::Runner runner;
+    if (!runner.parseArgs(argc, argv))
+        return 2;
+    
+    for (int64_t pixels : kPixelCounts)
+    {
+        benchConvert(runner, pixels, 1.0f, "convert_nogamma");
+        benchConvert(runner, pixels, 2.2f, "convert_gamma");
+        benchWide(runner, pixels, 1.0f, "convert16_nogamma");
+        benchWide(runner, pixels, 2.2f, "convert16_gamma");
+        benchLayout(runner, pixels, 1.0f, true, "layout_nogamma");
+        benchLayout(runner, pixels, 2.2f, true, "layout_gamma");
+        benchLayout(runner, pixels, 1.0f, false, "layout_gather_nogamma");
+        benchColorOrder(runner, pixels, "order_grb_nogamma");
+        benchDither(runner, pixels, 1.0f, "dither_nogamma");
+        benchDither(runner, pixels, 2.2f, "dither_gamma");
+        benchSegment(runner, pixels, DDP_MAX_DATALEN, "segment_1440");
+        benchSegment(runner, pixels, 8958, "segment_jumbo");
+        benchEncode(runner, pixels, ddp::Transport::Ddp, "encode_ddp");
+        benchEncode(runner, pixels, ddp::Transport::Sacn, "encode_sacn");
+        benchEncode(runner, pixels, ddp::Transport::ArtNet, "encode_artnet");
+        benchPower(runner, pixels, 1.0f, "power_nogamma");
+        benchPower(runner, pixels, 2.2f, "power_gamma");
+        benchCalibrate(runner, pixels, 1.0f, "calibrate_nogamma");
+        benchCalibrate(runner, pixels, 2.2f, "calibrate_gamma");
+        benchPixelMap(runner, pixels, false, "pixel_map_gamma");
+        benchPixelMap(runner, pixels, true, "pixel_map_calibrated");
+        benchParseAssemble(runner, pixels, "parse_assemble");
+        benchBytesToFloat(runner, pixels, "bytes_to_float");
+        benchBlend(runner, pixels, "blend_to_float");
+        benchFrameRing(runner, pixels, "frame_ring_push");
+    }
+    
+    return runner.finish();
+}
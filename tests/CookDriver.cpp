@@ -0,0 +1,80 @@
+#include "CookDriver.h"
+#include <thread>
+
+namespace mock
+{
+
+CookDriver::CookDriver(double rate, bool paced)
+{
+    m_rate = (rate > 0.0) ? rate : 60.0;
+    m_paced = paced;
+    m_frame = 0;
+    m_lateFrames = 0;
+    m_period = std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(1.0 / m_rate));
+}
+
+void CookDriver::add(MockCHOPNode* node)
+{
+    m_nodes.push_back(node);
+}
+
+void CookDriver::step()
+{
+    Clock::time_point now = Clock::now();
+    if (m_frame == 0)
+    {
+        m_start = now;
+        m_nextFrame = now;
+        m_lastFrame = now;
+    }
+    
+    if (m_paced)
+    {
+        if (now > m_nextFrame + m_period)
+        {
+            // Fell behind, drop the backlog instead of cooking a burst to catch up
+            m_lateFrames++;
+            m_nextFrame = now;
+        }
+        else
+        {
+            std::this_thread::sleep_until(m_nextFrame);
+            now = Clock::now();
+        }
+        m_nextFrame += m_period;
+    }
+    
+    double deltaMS = (m_frame == 0) ? 0.0 :
+        (m_paced ? std::chrono::duration<double, std::milli>(now - m_lastFrame).count() : 1000.0 / m_rate);
+    m_lastFrame = now;
+    
+    for (MockCHOPNode* node : m_nodes)
+    {
+        OP_TimeInfo& time = node->inputs().timeInfo;
+        time.absFrame = m_frame;
+        time.frame = static_cast<double>(m_frame + 1);
+        time.rootFrame = time.frame;
+        time.rate = m_rate;
+        time.rootRate = m_rate;
+        time.deltaFrames = (m_frame == 0) ? 0.0 : 1.0;
+        time.deltaMS = deltaMS;
+        node->cook();
+    }
+    
+    m_frame++;
+}
+
+void CookDriver::run(int64_t frames)
+{
+    for (int64_t i = 0; i < frames; i++)
+        step();
+}
+
+double CookDriver::elapsedSeconds() const
+{
+    if (m_frame == 0)
+        return 0.0;
+    return std::chrono::duration<double>(Clock::now() - m_start).count();
+}
+
+}
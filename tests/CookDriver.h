@@ -0,0 +1,59 @@
+#ifndef __CookDriver__
+#define __CookDriver__
+
+// Advances a timeline and cooks mock nodes once per frame, the way a
+// TouchDesigner project cooks cookEveryFrame CHOPs.
+
+#include "MockHost.h"
+
+#include <chrono>
+#include <cstdint>
+#include <vector>
+
+namespace mock
+{
+
+class CookDriver
+{
+public:
+    typedef std::chrono::steady_clock Clock;
+
+    // 'rate' is the timeline rate the plugins see in OP_TimeInfo. When paced,
+    // step() sleeps so frames start 1/rate apart; otherwise it runs flat out.
+    explicit CookDriver(double rate = 60.0, bool paced = true);
+
+    // Nodes cook in the order they were added (upstream first)
+    void add(MockCHOPNode* node);
+
+    // Advance one frame and cook every node
+    void step();
+    void run(int64_t frames);
+
+    double rate() const { return m_rate; }
+    bool paced() const { return m_paced; }
+    int64_t frame() const { return m_frame; }
+
+    // Frames that started more than one period behind schedule (paced only)
+    int64_t lateFrames() const { return m_lateFrames; }
+
+    // When the last step() started cooking its nodes
+    Clock::time_point frameStartTime() const { return m_lastFrame; }
+
+    // Wall time since the first step()
+    double elapsedSeconds() const;
+
+private:
+    std::vector<MockCHOPNode*> m_nodes;
+    double m_rate;
+    bool m_paced;
+    int64_t m_frame;
+    int64_t m_lateFrames;
+    Clock::duration m_period;
+    Clock::time_point m_start;
+    Clock::time_point m_nextFrame;
+    Clock::time_point m_lastFrame;
+};
+
+}
+
+#endif
@@ -0,0 +1,566 @@
+#include "MockHost.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+#ifdef _WIN32
+    #include <windows.h>
+#else
+    #include <dlfcn.h>
+#endif
+
+namespace mock
+{
+
+MockCHOPInput::MockCHOPInput()
+{
+    memset(&m_input, 0, sizeof(m_input));
+    m_input.opPath = "/mock/input";
+    m_input.sampleRate = 60.0;
+    resize(1, 1);
+}
+
+void MockCHOPInput::resize(int32_t numChannels, int32_t numSamples)
+{
+    m_channels.assign(static_cast<size_t>(numChannels), std::vector<float>(static_cast<size_t>(numSamples), 0.0f));
+    m_names.resize(static_cast<size_t>(numChannels));
+    for (int32_t i = 0; i < numChannels; i++)
+        m_names[i] = "chan" + std::to_string(i + 1);
+    refresh();
+    m_input.numChannels = numChannels;
+    m_input.numSamples = numSamples;
+}
+
+void MockCHOPInput::refresh()
+{
+    m_channelPointers.clear();
+    m_namePointers.clear();
+    for (size_t i = 0; i < m_channels.size(); i++)
+    {
+        m_channelPointers.push_back(m_channels[i].data());
+        m_namePointers.push_back(m_names[i].c_str());
+    }
+    m_input.channelData = m_channelPointers.data();
+    m_input.nameData = m_namePointers.data();
+}
+
+MockTOPInput::MockTOPInput()
+{
+    opPath = "/mock/top";
+    opId = 0;
+    totalCooks = 0;
+    customOP = nullptr;
+    memset(reserved, 0, sizeof(reserved));
+    m_latency = 0.0;
+    m_downloads = 0;
+}
+
+namespace
+{
+    size_t bytesPerTexel(OP_PixelFormat format)
+    {
+        return format == OP_PixelFormat::RGBA32Float ? 16 : 4;
+    }
+
+    void decodeTexel(OP_PixelFormat format, const uint8_t* in, float rgba[4])
+    {
+        if (format == OP_PixelFormat::RGBA32Float)
+        {
+            memcpy(rgba, in, 16);
+            return;
+        }
+        bool bgra = format == OP_PixelFormat::BGRA8Fixed;
+        rgba[0] = in[bgra ? 2 : 0] / 255.0f;
+        rgba[1] = in[1] / 255.0f;
+        rgba[2] = in[bgra ? 0 : 2] / 255.0f;
+        rgba[3] = in[3] / 255.0f;
+    }
+
+    void encodeTexel(OP_PixelFormat format, const float rgba[4], uint8_t* out)
+    {
+        if (format == OP_PixelFormat::RGBA32Float)
+        {
+            memcpy(out, rgba, 16);
+            return;
+        }
+        uint8_t bytes[4];
+        for (int c = 0; c < 4; c++)
+            bytes[c] = static_cast<uint8_t>(std::lround(std::max(0.0f, std::min(1.0f, rgba[c])) * 255.0f));
+        bool bgra = format == OP_PixelFormat::BGRA8Fixed;
+        out[0] = bytes[bgra ? 2 : 0];
+        out[1] = bytes[1];
+        out[2] = bytes[bgra ? 0 : 2];
+        out[3] = bytes[3];
+    }
+}
+
+void MockTOPInput::setImage(uint32_t width, uint32_t height, OP_PixelFormat format, const void* pixels)
+{
+    textureDesc.width = width;
+    textureDesc.height = height;
+    textureDesc.depth = 1;
+    textureDesc.texDim = OP_TexDim::e2D;
+    textureDesc.pixelFormat = format;
+    const uint8_t* bytes = static_cast<const uint8_t*>(pixels);
+    m_pixels.assign(bytes, bytes + static_cast<size_t>(width) * height * bytesPerTexel(format));
+    totalCooks++;
+}
+
+OP_SmartRef<OP_TOPDownloadResult> MockTOPInput::downloadTexture(const OP_TOPInputDownloadOptions& opts, void* reserved1) const
+{
+    m_downloads++;
+    MockDownloadResult* result = new MockDownloadResult();
+    result->textureDesc = textureDesc;
+    result->readyAt = std::chrono::steady_clock::now() +
+        std::chrono::duration_cast<std::chrono::steady_clock::duration>(std::chrono::duration<double>(m_latency));
+
+    OP_PixelFormat format = opts.pixelFormat == OP_PixelFormat::Invalid ? textureDesc.pixelFormat : opts.pixelFormat;
+    result->textureDesc.pixelFormat = format;
+    size_t inBytes = bytesPerTexel(textureDesc.pixelFormat);
+    size_t outBytes = bytesPerTexel(format);
+    result->data.resize(static_cast<size_t>(textureDesc.width) * textureDesc.height * outBytes);
+    result->size = result->data.size();
+
+    for (uint32_t row = 0; row < textureDesc.height; row++)
+    {
+        uint32_t sourceRow = opts.verticalFlip ? textureDesc.height - 1 - row : row;
+        for (uint32_t column = 0; column < textureDesc.width; column++)
+        {
+            float rgba[4];
+            decodeTexel(textureDesc.pixelFormat, &m_pixels[(static_cast<size_t>(sourceRow) * textureDesc.width + column) * inBytes], rgba);
+            encodeTexel(format, rgba, &result->data[(static_cast<size_t>(row) * textureDesc.width + column) * outBytes]);
+        }
+    }
+    return OP_SmartRef<OP_TOPDownloadResult>(result);
+}
+
+MockDATInput::MockDATInput()
+{
+    memset(&m_input, 0, sizeof(m_input));
+    m_input.opPath = "/mock/dat";
+    m_input.isTable = true;
+}
+
+void MockDATInput::setTable(const std::vector<std::vector<std::string>>& rows)
+{
+    size_t numCols = 0;
+    for (const std::vector<std::string>& row : rows)
+        numCols = std::max(numCols, row.size());
+
+    m_cells.assign(rows.size() * numCols, std::string());
+    for (size_t r = 0; r < rows.size(); r++)
+        for (size_t c = 0; c < rows[r].size(); c++)
+            m_cells[r * numCols + c] = rows[r][c];
+
+    m_cellPointers.clear();
+    for (const std::string& cell : m_cells)
+        m_cellPointers.push_back(cell.c_str());
+    m_input.cellData = m_cellPointers.data();
+    m_input.numRows = static_cast<int32_t>(rows.size());
+    m_input.numCols = static_cast<int32_t>(numCols);
+    m_input.totalCooks++;
+}
+
+OP_ParAppendResult MockParameterManager::add(const char* name, MockParameter& parameter)
+{
+    if (!name || name[0] < 'A' || name[0] > 'Z' || m_parameters.count(name))
+        return OP_ParAppendResult::InvalidName;
+    m_parameters[name] = parameter;
+    return OP_ParAppendResult::Success;
+}
+
+OP_ParAppendResult MockParameterManager::addNumeric(const OP_NumericParameter& np, int32_t size)
+{
+    if (size < 1 || size > 4)
+        return OP_ParAppendResult::InvalidSize;
+    
+    MockParameter parameter;
+    for (int32_t i = 0; i < size; i++)
+        parameter.values[i] = np.defaultValues[i];
+    return add(np.name, parameter);
+}
+
+OP_ParAppendResult MockParameterManager::addPulse(const OP_NumericParameter& np)
+{
+    MockParameter parameter;
+    parameter.isPulse = true;
+    return add(np.name, parameter);
+}
+
+OP_ParAppendResult MockParameterManager::addString(const OP_StringParameter& sp)
+{
+    MockParameter parameter;
+    parameter.isString = true;
+    parameter.text = sp.defaultValue ? sp.defaultValue : "";
+    return add(sp.name, parameter);
+}
+
+OP_ParAppendResult MockParameterManager::addMenu(const OP_StringParameter& sp, int32_t nitems, const char** names)
+{
+    MockParameter parameter;
+    parameter.isString = true;
+    parameter.text = sp.defaultValue ? sp.defaultValue : "";
+    for (int32_t i = 0; i < nitems; i++)
+        parameter.menuNames.push_back(names[i]);
+    return add(sp.name, parameter);
+}
+
+MockInputs::MockInputs()
+{
+    memset(&timeInfo, 0, sizeof(timeInfo));
+    timeInfo.frame = 1.0;
+    timeInfo.rootFrame = 1.0;
+    timeInfo.rate = 60.0;
+    timeInfo.rootRate = 60.0;
+}
+
+const MockParameter* MockInputs::find(const char* name) const
+{
+    auto it = parameters.find(name);
+    return it != parameters.end() ? &it->second : nullptr;
+}
+
+const OP_DATInput* MockInputs::getParDAT(const char* name) const
+{
+    auto it = parDATs.find(name);
+    return it != parDATs.end() ? it->second : nullptr;
+}
+
+const OP_TOPInput* MockInputs::getParTOP(const char* name) const
+{
+    auto it = parTOPs.find(name);
+    return it != parTOPs.end() ? it->second : nullptr;
+}
+
+const OP_CHOPInput* MockInputs::getInputCHOP(int32_t index) const
+{
+    if (index < 0 || index >= static_cast<int32_t>(chopInputs.size()))
+        return nullptr;
+    return chopInputs[index];
+}
+
+double MockInputs::getParDouble(const char* name, int32_t index) const
+{
+    const MockParameter* parameter = find(name);
+    if (!parameter || index < 0 || index > 3)
+        return 0.0;
+    return parameter->values[index];
+}
+
+bool MockInputs::getParDouble2(const char* name, double& v0, double& v1) const
+{
+    v0 = getParDouble(name, 0);
+    v1 = getParDouble(name, 1);
+    return find(name) != nullptr;
+}
+
+bool MockInputs::getParDouble3(const char* name, double& v0, double& v1, double& v2) const
+{
+    v2 = getParDouble(name, 2);
+    return getParDouble2(name, v0, v1);
+}
+
+bool MockInputs::getParDouble4(const char* name, double& v0, double& v1, double& v2, double& v3) const
+{
+    v3 = getParDouble(name, 3);
+    return getParDouble3(name, v0, v1, v2);
+}
+
+int32_t MockInputs::getParInt(const char* name, int32_t index) const
+{
+    // Menus report the index of the selected entry
+    const MockParameter* parameter = find(name);
+    if (parameter && !parameter->menuNames.empty())
+    {
+        for (size_t i = 0; i < parameter->menuNames.size(); i++)
+        {
+            if (parameter->menuNames[i] == parameter->text)
+                return static_cast<int32_t>(i);
+        }
+        return 0;
+    }
+    return static_cast<int32_t>(std::lround(getParDouble(name, index)));
+}
+
+bool MockInputs::getParInt2(const char* name, int32_t& v0, int32_t& v1) const
+{
+    v0 = getParInt(name, 0);
+    v1 = getParInt(name, 1);
+    return find(name) != nullptr;
+}
+
+bool MockInputs::getParInt3(const char* name, int32_t& v0, int32_t& v1, int32_t& v2) const
+{
+    v2 = getParInt(name, 2);
+    return getParInt2(name, v0, v1);
+}
+
+bool MockInputs::getParInt4(const char* name, int32_t& v0, int32_t& v1, int32_t& v2, int32_t& v3) const
+{
+    v3 = getParInt(name, 3);
+    return getParInt3(name, v0, v1, v2);
+}
+
+const char* MockInputs::getParString(const char* name) const
+{
+    const MockParameter* parameter = find(name);
+    return parameter ? parameter->text.c_str() : "";
+}
+
+PluginModule::PluginModule()
+{
+    m_handle = nullptr;
+    m_fill = nullptr;
+    m_create = nullptr;
+    m_destroy = nullptr;
+}
+
+PluginModule::~PluginModule()
+{
+    if (!m_handle)
+        return;
+    
+    #ifdef _WIN32
+        FreeLibrary(static_cast<HMODULE>(m_handle));
+    #else
+        dlclose(m_handle);
+    #endif
+}
+
+bool PluginModule::load(const std::string& path)
+{
+    #ifdef _WIN32
+        HMODULE module = LoadLibraryA(path.c_str());
+        if (!module)
+        {
+            m_lastError = "LoadLibrary failed for " + path + ": " + std::to_string(GetLastError());
+            return false;
+        }
+        m_handle = module;
+        m_fill = reinterpret_cast<FILLCHOPPLUGININFO>(GetProcAddress(module, "FillCHOPPluginInfo"));
+        m_create = reinterpret_cast<CREATECHOPINSTANCE>(GetProcAddress(module, "CreateCHOPInstance"));
+        m_destroy = reinterpret_cast<DESTROYCHOPINSTANCE>(GetProcAddress(module, "DestroyCHOPInstance"));
+    #else
+        // RTLD_LOCAL: DDP Out and DDP In export the same entry point names
+        m_handle = dlopen(path.c_str(), RTLD_NOW | RTLD_LOCAL);
+        if (!m_handle)
+        {
+            m_lastError = "dlopen failed: " + std::string(dlerror());
+            return false;
+        }
+        m_fill = reinterpret_cast<FILLCHOPPLUGININFO>(dlsym(m_handle, "FillCHOPPluginInfo"));
+        m_create = reinterpret_cast<CREATECHOPINSTANCE>(dlsym(m_handle, "CreateCHOPInstance"));
+        m_destroy = reinterpret_cast<DESTROYCHOPINSTANCE>(dlsym(m_handle, "DestroyCHOPInstance"));
+    #endif
+    
+    if (!m_fill || !m_create || !m_destroy)
+    {
+        m_lastError = path + " does not export the CHOP plugin entry points";
+        return false;
+    }
+    return true;
+}
+
+MockCHOPNode::MockCHOPNode()
+{
+    m_instance = nullptr;
+    m_numSamples = 0;
+    memset(&m_nodeInfo, 0, sizeof(m_nodeInfo));
+}
+
+MockCHOPNode::~MockCHOPNode()
+{
+    if (m_instance)
+        m_module.destroy(m_instance);
+}
+
+bool MockCHOPNode::create(const std::string& pluginPath, const std::string& opPath)
+{
+    if (!m_module.load(pluginPath))
+    {
+        m_lastError = m_module.lastError();
+        return false;
+    }
+    
+    m_pluginInfo.customOPInfo.opType = &m_infoStrings[0];
+    m_pluginInfo.customOPInfo.opLabel = &m_infoStrings[1];
+    m_pluginInfo.customOPInfo.opIcon = &m_infoStrings[2];
+    m_pluginInfo.customOPInfo.authorName = &m_infoStrings[3];
+    m_pluginInfo.customOPInfo.authorEmail = &m_infoStrings[4];
+    m_pluginInfo.customOPInfo.pythonVersion = &m_infoStrings[5];
+    m_module.fillInfo(&m_pluginInfo);
+    
+    if (m_pluginInfo.apiVersion != CHOPCPlusPlusAPIVersion)
+    {
+        m_lastError = "Plugin API version " + std::to_string(m_pluginInfo.apiVersion) +
+                      " does not match " + std::to_string(CHOPCPlusPlusAPIVersion);
+        return false;
+    }
+    
+    static uint32_t nextOpId = 1;
+    m_opPath = opPath;
+    m_pluginPath = pluginPath;
+    m_nodeInfo.opPath = m_opPath.c_str();
+    m_nodeInfo.opId = nextOpId++;
+    m_nodeInfo.pluginPath = m_pluginPath.c_str();
+    
+    m_instance = m_module.create(&m_nodeInfo);
+    if (!m_instance)
+    {
+        m_lastError = "CreateCHOPInstance returned null";
+        return false;
+    }
+    
+    MockParameterManager manager(m_inputs.parameters);
+    m_instance->setupParameters(&manager, nullptr);
+    return true;
+}
+
+void MockCHOPNode::setPar(const std::string& name, double value, int index)
+{
+    MockParameter& parameter = m_inputs.parameters[name];
+    parameter.values[index] = value;
+}
+
+void MockCHOPNode::setPar(const std::string& name, const std::string& value)
+{
+    MockParameter& parameter = m_inputs.parameters[name];
+    parameter.isString = true;
+    parameter.text = value;
+}
+
+void MockCHOPNode::pulse(const std::string& name)
+{
+    if (m_instance)
+        m_instance->pulsePressed(name.c_str(), nullptr);
+}
+
+void MockCHOPNode::connectInput(const MockCHOPInput* input)
+{
+    m_inputs.chopInputs.push_back(input->get());
+}
+
+void MockCHOPNode::setParTOP(const std::string& name, const MockTOPInput* top)
+{
+    if (top)
+        m_inputs.parTOPs[name] = top;
+    else
+        m_inputs.parTOPs.erase(name);
+    setPar(name, std::string(top ? top->opPath : ""));
+}
+
+void MockCHOPNode::setParDAT(const std::string& name, const MockDATInput* dat)
+{
+    if (dat)
+        m_inputs.parDATs[name] = dat->get();
+    else
+        m_inputs.parDATs.erase(name);
+    setPar(name, std::string(dat ? dat->get()->opPath : ""));
+}
+
+void MockCHOPNode::cook()
+{
+    if (!m_instance)
+        return;
+    
+    // Time only moves when a CookDriver advances it
+    m_nodeInfo.cookCount++;
+    
+    CHOP_GeneralInfo generalInfo;
+    memset(&generalInfo, 0, sizeof(generalInfo));
+    m_instance->getGeneralInfo(&generalInfo, &m_inputs, nullptr);
+    
+    CHOP_OutputInfo outputInfo;
+    memset(&outputInfo, 0, sizeof(outputInfo));
+    outputInfo.sampleRate = static_cast<float>(m_inputs.timeInfo.rate);
+    
+    m_channelNames.clear();
+    if (m_instance->getOutputInfo(&outputInfo, &m_inputs, nullptr))
+    {
+        for (int32_t i = 0; i < outputInfo.numChannels; i++)
+        {
+            MockString name;
+            m_instance->getChannelName(i, &name, &m_inputs, nullptr);
+            m_channelNames.push_back(name.value);
+        }
+    }
+    else
+    {
+        // Match the input selected by inputMatchIndex
+        const OP_CHOPInput* match = m_inputs.getInputCHOP(generalInfo.inputMatchIndex);
+        outputInfo.numChannels = match ? match->numChannels : 0;
+        outputInfo.numSamples = match ? match->numSamples : 0;
+        for (int32_t i = 0; i < outputInfo.numChannels; i++)
+            m_channelNames.push_back(match->getChannelName(i));
+    }
+    
+    m_numSamples = outputInfo.numSamples;
+    m_channels.resize(static_cast<size_t>(outputInfo.numChannels));
+    std::vector<float*> channelPointers;
+    std::vector<const char*> namePointers;
+    for (int32_t i = 0; i < outputInfo.numChannels; i++)
+    {
+        m_channels[i].assign(static_cast<size_t>(m_numSamples), 0.0f);
+        channelPointers.push_back(m_channels[i].data());
+        namePointers.push_back(m_channelNames[i].c_str());
+    }
+    
+    CHOP_Output output(outputInfo.numChannels, outputInfo.numSamples, outputInfo.sampleRate,
+                       outputInfo.startIndex, channelPointers.data(), namePointers.data());
+    m_instance->execute(&output, &m_inputs, nullptr);
+    
+    // Info CHOP
+    m_infoChannels.clear();
+    int32_t numInfoChannels = m_instance->getNumInfoCHOPChans(nullptr);
+    for (int32_t i = 0; i < numInfoChannels; i++)
+    {
+        MockString name;
+        OP_InfoCHOPChan chan;
+        memset(&chan, 0, sizeof(chan));
+        chan.name = &name;
+        m_instance->getInfoCHOPChan(i, &chan, nullptr);
+        m_infoChannels[name.value] = chan.value;
+    }
+    
+    // Info DAT (row by row, name in column 0)
+    m_infoEntries.clear();
+    OP_InfoDATSize size;
+    memset(&size, 0, sizeof(size));
+    if (m_instance->getInfoDATSize(&size, nullptr) && size.cols > 0 && !size.byColumn)
+    {
+        std::vector<MockString> cells(static_cast<size_t>(size.cols));
+        std::vector<OP_String*> cellPointers;
+        for (MockString& cell : cells)
+            cellPointers.push_back(&cell);
+        
+        for (int32_t row = 0; row < size.rows; row++)
+        {
+            for (MockString& cell : cells)
+                cell.value.clear();
+            
+            OP_InfoDATEntries entries;
+            memset(&entries, 0, sizeof(entries));
+            entries.values = cellPointers.data();
+            m_instance->getInfoDATEntries(row, size.cols, &entries, nullptr);
+            m_infoEntries.push_back(std::make_pair(cells[0].value, size.cols > 1 ? cells[1].value : std::string()));
+        }
+    }
+}
+
+float MockCHOPNode::infoChannel(const std::string& name) const
+{
+    auto it = m_infoChannels.find(name);
+    return it != m_infoChannels.end() ? it->second : 0.0f;
+}
+
+std::string MockCHOPNode::infoEntry(const std::string& name) const
+{
+    for (const auto& entry : m_infoEntries)
+    {
+        if (entry.first == name)
+            return entry.second;
+    }
+    return "";
+}
+
+}
@@ -0,0 +1,329 @@
+#ifndef __MockHost__
+#define __MockHost__
+
+// Headless stand-in for the TouchDesigner side of the CHOP C++ API.
+// Loads a plugin module through FillCHOPPluginInfo/CreateCHOPInstance and
+// cooks it with the same call order TouchDesigner uses, so the plugins can be
+// exercised and measured on a build machine without TD.
+
+// The SDK headers rely on these being included first
+#include <cstdint>
+#include <cstddef>
+
+#include "CHOP_CPlusPlusBase.h"
+
+#include <chrono>
+#include <map>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace TD;
+
+namespace mock
+{
+
+class MockString : public OP_String
+{
+public:
+    MockString() {}
+    virtual ~MockString() {}
+
+    virtual void setString(const char* val) override { value = val ? val : ""; }
+
+    std::string value;
+};
+
+// A CHOP wired into an input, channels are owned here
+class MockCHOPInput
+{
+public:
+    MockCHOPInput();
+
+    void resize(int32_t numChannels, int32_t numSamples);
+    float* channel(int32_t index) { return m_channels[index].data(); }
+    const OP_CHOPInput* get() const { return &m_input; }
+
+private:
+    void refresh();
+
+    OP_CHOPInput m_input;
+    std::vector<std::vector<float>> m_channels;
+    std::vector<const float*> m_channelPointers;
+    std::vector<std::string> m_names;
+    std::vector<const char*> m_namePointers;
+};
+
+// Result of MockTOPInput::downloadTexture(), reference counted like TD's
+class MockDownloadResult : public OP_TOPDownloadResult
+{
+public:
+    MockDownloadResult() : m_refCount(0) {}
+
+    // Blocks until 'readyAt' like a readback the GPU has not finished
+    virtual void* getData() override
+    {
+        std::this_thread::sleep_until(readyAt);
+        return data.data();
+    }
+
+    std::vector<uint8_t> data;
+    std::chrono::steady_clock::time_point readyAt;
+
+protected:
+    virtual void acquire() override { m_refCount++; }
+    virtual void release() override { if (--m_refCount == 0) delete this; }
+    virtual void reserved0() override {}
+    virtual void reserved1() override {}
+    virtual void reserved2() override {}
+    virtual void reserved3() override {}
+    virtual void reserved4() override {}
+
+private:
+    int m_refCount;
+};
+
+// A TOP referenced by a TOP parameter. The image is kept in CPU memory in its
+// "native" format (BGRA8Fixed, RGBA8Fixed or RGBA32Float) with rows bottom-up
+// like TD; downloads convert to the requested format.
+class MockTOPInput : public OP_TOPInput
+{
+public:
+    MockTOPInput();
+    virtual ~MockTOPInput() {}
+
+    void setImage(uint32_t width, uint32_t height, OP_PixelFormat format, const void* pixels);
+    int64_t downloads() const { return m_downloads; }
+
+    // Time from downloadTexture() until the result's getData() stops blocking
+    void setDownloadLatency(double seconds) { m_latency = seconds; }
+
+    virtual OP_SmartRef<OP_TOPDownloadResult> downloadTexture(const OP_TOPInputDownloadOptions& opts, void* reserved1) const override;
+    virtual const OP_CUDAArrayInfo* getCUDAArray(const OP_CUDAAcquireInfo& info, void* reserved2) const override { return nullptr; }
+
+protected:
+    virtual void* reserved0() override { return nullptr; }
+    virtual void* reserved1() override { return nullptr; }
+    virtual void* reserved2() override { return nullptr; }
+    virtual void* reserved3() override { return nullptr; }
+    virtual void* reserved4() override { return nullptr; }
+
+private:
+    std::vector<uint8_t> m_pixels;
+    double m_latency;
+    mutable int64_t m_downloads;
+};
+
+// A table DAT referenced by a DAT parameter
+class MockDATInput
+{
+public:
+    MockDATInput();
+
+    // Replaces the contents and counts as a cook of the DAT
+    void setTable(const std::vector<std::vector<std::string>>& rows);
+    const OP_DATInput* get() const { return &m_input; }
+
+private:
+    OP_DATInput m_input;
+    std::vector<std::string> m_cells;
+    std::vector<const char*> m_cellPointers;
+};
+
+// Parameter values as the plugin sees them. Values declared in setupParameters()
+// act as defaults until a test overrides them.
+struct MockParameter
+{
+    double values[4] = { 0.0, 0.0, 0.0, 0.0 };
+    std::string text;
+    std::vector<std::string> menuNames;
+    bool isString = false;
+    bool isPulse = false;
+};
+
+class MockParameterManager : public OP_ParameterManager
+{
+public:
+    explicit MockParameterManager(std::map<std::string, MockParameter>& parameters) : m_parameters(parameters) {}
+
+    virtual OP_ParAppendResult appendFloat(const OP_NumericParameter& np, int32_t size = 1) override { return addNumeric(np, size); }
+    virtual OP_ParAppendResult appendInt(const OP_NumericParameter& np, int32_t size = 1) override { return addNumeric(np, size); }
+    virtual OP_ParAppendResult appendXY(const OP_NumericParameter& np) override { return addNumeric(np, 2); }
+    virtual OP_ParAppendResult appendXYZ(const OP_NumericParameter& np) override { return addNumeric(np, 3); }
+    virtual OP_ParAppendResult appendUV(const OP_NumericParameter& np) override { return addNumeric(np, 2); }
+    virtual OP_ParAppendResult appendUVW(const OP_NumericParameter& np) override { return addNumeric(np, 3); }
+    virtual OP_ParAppendResult appendRGB(const OP_NumericParameter& np) override { return addNumeric(np, 3); }
+    virtual OP_ParAppendResult appendRGBA(const OP_NumericParameter& np) override { return addNumeric(np, 4); }
+    virtual OP_ParAppendResult appendToggle(const OP_NumericParameter& np) override { return addNumeric(np, 1); }
+    virtual OP_ParAppendResult appendPulse(const OP_NumericParameter& np) override { return addPulse(np); }
+    virtual OP_ParAppendResult appendString(const OP_StringParameter& sp) override { return addString(sp); }
+    virtual OP_ParAppendResult appendFile(const OP_StringParameter& sp) override { return addString(sp); }
+    virtual OP_ParAppendResult appendFolder(const OP_StringParameter& sp) override { return addString(sp); }
+    virtual OP_ParAppendResult appendDAT(const OP_StringParameter& sp) override { return addString(sp); }
+    virtual OP_ParAppendResult appendCHOP(const OP_StringParameter& sp) override { return addString(sp); }
+    virtual OP_ParAppendResult appendTOP(const OP_StringParameter& sp) override { return addString(sp); }
+    virtual OP_ParAppendResult appendObject(const OP_StringParameter& sp) override { return addString(sp); }
+    virtual OP_ParAppendResult appendMenu(const OP_StringParameter& sp, int32_t nitems,
+                                          const char** names, const char** labels) override { return addMenu(sp, nitems, names); }
+    virtual OP_ParAppendResult appendStringMenu(const OP_StringParameter& sp, int32_t nitems,
+                                                const char** names, const char** labels) override { return addMenu(sp, nitems, names); }
+    virtual OP_ParAppendResult appendSOP(const OP_StringParameter& sp) override { return addString(sp); }
+    virtual OP_ParAppendResult appendPython(const OP_StringParameter& sp) override { return addString(sp); }
+    virtual OP_ParAppendResult appendOP(const OP_StringParameter& sp) override { return addString(sp); }
+    virtual OP_ParAppendResult appendCOMP(const OP_StringParameter& sp) override { return addString(sp); }
+    virtual OP_ParAppendResult appendMAT(const OP_StringParameter& sp) override { return addString(sp); }
+    virtual OP_ParAppendResult appendPanelCOMP(const OP_StringParameter& sp) override { return addString(sp); }
+    virtual OP_ParAppendResult appendHeader(const OP_StringParameter& sp) override { return addString(sp); }
+    virtual OP_ParAppendResult appendMomentary(const OP_NumericParameter& np) override { return addNumeric(np, 1); }
+    virtual OP_ParAppendResult appendWH(const OP_NumericParameter& np) override { return addNumeric(np, 2); }
+    virtual OP_ParAppendResult appendDynamicStringMenu(const OP_StringParameter& sp) override { return addString(sp); }
+    virtual OP_ParAppendResult appendDynamicMenu(const OP_NumericParameter& np) override { return addNumeric(np, 1); }
+
+private:
+    OP_ParAppendResult add(const char* name, MockParameter& parameter);
+    OP_ParAppendResult addNumeric(const OP_NumericParameter& np, int32_t size);
+    OP_ParAppendResult addPulse(const OP_NumericParameter& np);
+    OP_ParAppendResult addString(const OP_StringParameter& sp);
+    OP_ParAppendResult addMenu(const OP_StringParameter& sp, int32_t nitems, const char** names);
+
+    std::map<std::string, MockParameter>& m_parameters;
+};
+
+class MockInputs : public OP_Inputs
+{
+public:
+    MockInputs();
+
+    std::map<std::string, MockParameter> parameters;
+    std::vector<const OP_CHOPInput*> chopInputs;
+    std::map<std::string, const OP_TOPInput*> parTOPs;    // by parameter name
+    std::map<std::string, const OP_DATInput*> parDATs;
+    OP_TimeInfo timeInfo;
+
+    virtual int32_t getNumInputs() const override { return static_cast<int32_t>(chopInputs.size()); }
+    virtual const OP_CHOPInput* getInputCHOP(int32_t index) const override;
+    virtual const OP_DATInput* getParDAT(const char* name) const override;
+    virtual const OP_CHOPInput* getParCHOP(const char* name) const override { return nullptr; }
+    virtual const OP_ObjectInput* getParObject(const char* name) const override { return nullptr; }
+
+    virtual double getParDouble(const char* name, int32_t index = 0) const override;
+    virtual bool getParDouble2(const char* name, double& v0, double& v1) const override;
+    virtual bool getParDouble3(const char* name, double& v0, double& v1, double& v2) const override;
+    virtual bool getParDouble4(const char* name, double& v0, double& v1, double& v2, double& v3) const override;
+    virtual int32_t getParInt(const char* name, int32_t index = 0) const override;
+    virtual bool getParInt2(const char* name, int32_t& v0, int32_t& v1) const override;
+    virtual bool getParInt3(const char* name, int32_t& v0, int32_t& v1, int32_t& v2) const override;
+    virtual bool getParInt4(const char* name, int32_t& v0, int32_t& v1, int32_t& v2, int32_t& v3) const override;
+    virtual const char* getParString(const char* name) const override;
+    virtual const char* getParFilePath(const char* name) const override { return getParString(name); }
+    virtual bool getRelativeTransform(const char* from_name, const char* to_name, double matrix[4][4]) const override { return false; }
+    virtual void enablePar(const char* name, bool onoff) const override {}
+
+    virtual const OP_DATInput* getDAT(const char* path) const override { return nullptr; }
+    virtual const OP_CHOPInput* getCHOP(const char* path) const override { return nullptr; }
+    virtual const OP_ObjectInput* getObject(const char* path) const override { return nullptr; }
+    virtual const OP_SOPInput* getParSOP(const char* name) const override { return nullptr; }
+    virtual const OP_SOPInput* getInputSOP(int32_t index) const override { return nullptr; }
+    virtual const OP_SOPInput* getSOP(const char* path) const override { return nullptr; }
+    virtual const OP_DATInput* getInputDAT(int32_t index) const override { return nullptr; }
+    virtual PyObject* getParPython(const char* name) const override { return nullptr; }
+    virtual const OP_TimeInfo* getTimeInfo() const override { return &timeInfo; }
+    virtual const OP_TOPInput* getTOP(const char* path) const override { return nullptr; }
+    virtual const OP_TOPInput* getInputTOP(int32_t index) const override { return nullptr; }
+    virtual const OP_TOPInput* getParTOP(const char* name) const override;
+
+private:
+    virtual const OP_TOPInputOpenGL* getInputTOPOpenGL(int32_t index) const override { return nullptr; }
+    virtual const OP_TOPInputOpenGL* getParTOPOpenGL(const char* name) const override { return nullptr; }
+    virtual const OP_TOPInputOpenGL* getTOPOpenGL(const char* path) const override { return nullptr; }
+    virtual void* getTOPDataInCPUMemory(const OP_TOPInputOpenGL* top,
+                                        const OP_TOPInputDownloadOptionsOpenGL* options) const override { return nullptr; }
+
+    const MockParameter* find(const char* name) const;
+};
+
+// One loaded plugin module (.so/.dylib/.dll)
+class PluginModule
+{
+public:
+    PluginModule();
+    ~PluginModule();
+
+    bool load(const std::string& path);
+    const std::string& lastError() const { return m_lastError; }
+
+    void fillInfo(CHOP_PluginInfo* info) const { m_fill(info); }
+    CHOP_CPlusPlusBase* create(const OP_NodeInfo* info) const { return m_create(info); }
+    void destroy(CHOP_CPlusPlusBase* instance) const { m_destroy(instance); }
+
+private:
+    void* m_handle;
+    FILLCHOPPLUGININFO m_fill;
+    CREATECHOPINSTANCE m_create;
+    DESTROYCHOPINSTANCE m_destroy;
+    std::string m_lastError;
+};
+
+// A plugin instance plus everything TD would provide around it
+class MockCHOPNode
+{
+public:
+    MockCHOPNode();
+    ~MockCHOPNode();
+
+    // Load the module, create the instance and run setupParameters()
+    bool create(const std::string& pluginPath, const std::string& opPath);
+    const std::string& lastError() const { return m_lastError; }
+
+    void setPar(const std::string& name, double value, int index = 0);
+    void setPar(const std::string& name, const std::string& value);
+    void pulse(const std::string& name);
+
+    void connectInput(const MockCHOPInput* input);
+
+    // Point a TOP or DAT parameter at a mock operator (nullptr clears it)
+    void setParTOP(const std::string& name, const MockTOPInput* top);
+    void setParDAT(const std::string& name, const MockDATInput* dat);
+
+    // One cook in TouchDesigner's call order (general info, output info,
+    // channel names, execute, Info CHOP, Info DAT). Does not advance time,
+    // use a CookDriver for that.
+    void cook();
+    uint32_t cookCount() const { return m_nodeInfo.cookCount; }
+
+    // Output of the last cook
+    int32_t numChannels() const { return static_cast<int32_t>(m_channels.size()); }
+    int32_t numSamples() const { return m_numSamples; }
+    const float* channel(int32_t index) const { return m_channels[index].data(); }
+    const std::string& channelName(int32_t index) const { return m_channelNames[index]; }
+
+    // Info CHOP / Info DAT of the last cook (info DAT column 1 by row name)
+    float infoChannel(const std::string& name) const;
+    std::string infoEntry(const std::string& name) const;
+
+    const CHOP_PluginInfo& pluginInfo() const { return m_pluginInfo; }
+    MockInputs& inputs() { return m_inputs; }
+    CHOP_CPlusPlusBase* instance() { return m_instance; }
+
+private:
+    PluginModule m_module;
+    CHOP_CPlusPlusBase* m_instance;
+    CHOP_PluginInfo m_pluginInfo;
+    MockString m_infoStrings[6];
+    OP_NodeInfo m_nodeInfo;
+    std::string m_opPath;
+    std::string m_pluginPath;
+    MockInputs m_inputs;
+
+    int32_t m_numSamples;
+    std::vector<std::vector<float>> m_channels;
+    std::vector<std::string> m_channelNames;
+    std::map<std::string, float> m_infoChannels;
+    std::vector<std::pair<std::string, std::string>> m_infoEntries;
+    std::string m_lastError;
+};
+
+}
+
+#endif
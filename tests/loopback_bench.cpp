@@ -0,0 +1,317 @@
+// End-to-end loopback benchmark: DDP Out -> 127.0.0.1 -> DDP In, both plugins
+// loaded and cooked through the mock host. Each frame carries its id in the
+// first and last pixel so the receiving side can tell when it is complete.
+
+#include "CookDriver.h"
+#include "MockHost.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#ifndef DDP_OUT_PLUGIN_PATH
+    #define DDP_OUT_PLUGIN_PATH "DDPOutputCHOP.so"
+#endif
+#ifndef DDP_IN_PLUGIN_PATH
+    #define DDP_IN_PLUGIN_PATH "DDPInputCHOP.so"
+#endif
+
+namespace
+{
+
+typedef mock::CookDriver::Clock Clock;
+
+struct Options
+{
+    std::vector<int> pixelCounts = { 1000, 10000, 100000 };
+    std::vector<double> frameRates = { 60.0, 0.0 };
+    int frames = 600;
+    int warmupFrames = 10;
+    int port = 14048;
+    int maxPayload = 1440;
+    double timeoutMs = 100.0;
+    std::string jsonPath;
+    std::string outPlugin = DDP_OUT_PLUGIN_PATH;
+    std::string inPlugin = DDP_IN_PLUGIN_PATH;
+};
+
+struct Result
+{
+    int pixels = 0;
+    double targetFPS = 0.0;
+    int frames = 0;
+    int framesLost = 0;
+    double sustainedFPS = 0.0;
+    double packetsPerSecond = 0.0;
+    double packetsSent = 0.0;
+    double packetsReceived = 0.0;
+    double p50Ms = 0.0;
+    double p99Ms = 0.0;
+    double p999Ms = 0.0;
+};
+
+template<typename T>
+std::vector<T> parseList(const char* text)
+{
+    std::vector<T> values;
+    std::stringstream stream(text);
+    std::string item;
+    while (std::getline(stream, item, ','))
+    {
+        if (!item.empty())
+            values.push_back(static_cast<T>(atof(item.c_str())));
+    }
+    return values;
+}
+
+bool parseArgs(int argc, char** argv, Options& options)
+{
+    for (int i = 1; i < argc; i++)
+    {
+        std::string arg = argv[i];
+        bool hasValue = (i + 1 < argc);
+
+        if (arg == "--pixels" && hasValue)
+            options.pixelCounts = parseList<int>(argv[++i]);
+        else if (arg == "--fps" && hasValue)
+            options.frameRates = parseList<double>(argv[++i]);
+        else if (arg == "--frames" && hasValue)
+            options.frames = std::max(1, atoi(argv[++i]));
+        else if (arg == "--port" && hasValue)
+            options.port = atoi(argv[++i]);
+        else if (arg == "--payload" && hasValue)
+            options.maxPayload = atoi(argv[++i]);
+        else if (arg == "--timeout-ms" && hasValue)
+            options.timeoutMs = std::max(1.0, atof(argv[++i]));
+        else if (arg == "--json" && hasValue)
+            options.jsonPath = argv[++i];
+        else if (arg == "--out-plugin" && hasValue)
+            options.outPlugin = argv[++i];
+        else if (arg == "--in-plugin" && hasValue)
+            options.inPlugin = argv[++i];
+        else
+        {
+            fprintf(stderr, "usage: %s [--pixels 1000,10000] [--fps 60,0] [--frames n] [--port n] [--payload bytes]\n"
+                            "       [--timeout-ms ms] [--json file] [--out-plugin path] [--in-plugin path]\n"
+                            "  --fps 0 sends as fast as the loop allows\n", argv[0]);
+            return false;
+        }
+    }
+    return !options.pixelCounts.empty() && !options.frameRates.empty();
+}
+
+double percentile(std::vector<double>& sorted, double fraction)
+{
+    if (sorted.empty())
+        return 0.0;
+    size_t index = static_cast<size_t>(fraction * static_cast<double>(sorted.size() - 1) + 0.5);
+    return sorted[std::min(index, sorted.size() - 1)];
+}
+
+// 24-bit frame id spread over one RGB pixel, as 0-255 sample values
+void writeMarker(float* samples, uint32_t frameId)
+{
+    samples[0] = static_cast<float>((frameId >> 16) & 0xFF);
+    samples[1] = static_cast<float>((frameId >> 8) & 0xFF);
+    samples[2] = static_cast<float>(frameId & 0xFF);
+}
+
+bool hasMarker(const float* samples, uint32_t frameId)
+{
+    return static_cast<uint32_t>(samples[0]) == ((frameId >> 16) & 0xFF) &&
+           static_cast<uint32_t>(samples[1]) == ((frameId >> 8) & 0xFF) &&
+           static_cast<uint32_t>(samples[2]) == (frameId & 0xFF);
+}
+
+// True once DDP In outputs every pixel of 'frameId'
+bool frameArrived(const mock::MockCHOPNode& receiver, int32_t sampleCount, uint32_t frameId)
+{
+    if (receiver.numChannels() < 5 || receiver.numSamples() < sampleCount)
+        return false;
+
+    const float* data = receiver.channel(4);
+    return hasMarker(data, frameId) && hasMarker(data + sampleCount - 3, frameId);
+}
+
+bool runCase(const Options& options, int pixels, double targetFPS, Result& result)
+{
+    mock::MockCHOPNode sender;
+    mock::MockCHOPNode receiver;
+    if (!sender.create(options.outPlugin, "/project1/ddpout1"))
+    {
+        fprintf(stderr, "DDP Out: %s\n", sender.lastError().c_str());
+        return false;
+    }
+    if (!receiver.create(options.inPlugin, "/project1/ddpin1"))
+    {
+        fprintf(stderr, "DDP In: %s\n", receiver.lastError().c_str());
+        return false;
+    }
+
+    sender.setPar("Ipaddress", std::string("127.0.0.1"));
+    sender.setPar("Port", options.port);
+    sender.setPar("Maxpayload", options.maxPayload);
+    sender.setPar("Valuerange", std::string("0-255"));
+    sender.setPar("Showstats", 1);
+
+    receiver.setPar("Port", options.port);
+    receiver.setPar("Bindinterface", std::string("127.0.0.1"));
+    receiver.setPar("Valuerange", std::string("0-255"));
+    receiver.setPar("Showstats", 1);
+
+    int32_t sampleCount = pixels * 3;
+    mock::MockCHOPInput input;
+    input.resize(1, sampleCount);
+    sender.connectInput(&input);
+
+    // Open the listener before anything is sent
+    receiver.cook();
+
+    // DDP Out runs on the timeline, DDP In is polled until each frame lands
+    mock::CookDriver driver(targetFPS > 0.0 ? targetFPS : 60.0, targetFPS > 0.0);
+    driver.add(&sender);
+
+    std::vector<double> latencies;
+    latencies.reserve(static_cast<size_t>(options.frames));
+    int framesLost = 0;
+    double packetsSentStart = 0.0;
+    double packetsReceivedStart = 0.0;
+    Clock::time_point runStart;
+
+    // Warmup frames let DDP In grow its output to the full frame (the sample
+    // count it reports is decided before execute() sees the first packets)
+    int totalFrames = options.warmupFrames + options.frames;
+    for (int frame = 0; frame < totalFrames; frame++)
+    {
+        bool measured = frame >= options.warmupFrames;
+        if (frame == options.warmupFrames)
+        {
+            runStart = Clock::now();
+            packetsSentStart = sender.infoChannel("packets_sent");
+            packetsReceivedStart = receiver.infoChannel("packets_received");
+        }
+
+        uint32_t frameId = static_cast<uint32_t>(frame + 1) & 0xFFFFFF;
+        writeMarker(input.channel(0), frameId);
+        writeMarker(input.channel(0) + sampleCount - 3, frameId);
+
+        driver.step();
+        Clock::time_point sent = driver.frameStartTime();
+
+        // Cook DDP In until the frame shows up in its output
+        bool arrived = false;
+        while (true)
+        {
+            receiver.cook();
+            if (frameArrived(receiver, sampleCount, frameId))
+            {
+                arrived = true;
+                break;
+            }
+
+            std::chrono::duration<double, std::milli> waited = Clock::now() - sent;
+            if (waited.count() > options.timeoutMs)
+                break;
+        }
+
+        if (!measured)
+            continue;
+
+        if (arrived)
+            latencies.push_back(std::chrono::duration<double, std::milli>(Clock::now() - sent).count());
+        else
+            framesLost++;
+    }
+
+    double elapsed = std::chrono::duration<double>(Clock::now() - runStart).count();
+
+    result.pixels = pixels;
+    result.targetFPS = targetFPS;
+    result.frames = options.frames;
+    result.framesLost = framesLost;
+    result.sustainedFPS = options.frames / elapsed;
+    result.packetsSent = sender.infoChannel("packets_sent") - packetsSentStart;
+    result.packetsReceived = receiver.infoChannel("packets_received") - packetsReceivedStart;
+    result.packetsPerSecond = result.packetsSent / elapsed;
+
+    std::sort(latencies.begin(), latencies.end());
+    result.p50Ms = percentile(latencies, 0.50);
+    result.p99Ms = percentile(latencies, 0.99);
+    result.p999Ms = percentile(latencies, 0.999);
+    return true;
+}
+
+bool writeJSON(const std::string& path, const Options& options, const std::vector<Result>& results)
+{
+    std::ofstream out(path.c_str());
+    if (!out)
+    {
+        fprintf(stderr, "Cannot write %s\n", path.c_str());
+        return false;
+    }
+
+    out << "{\n  \"context\": {\n";
+    out << "    \"frames\": " << options.frames << ",\n";
+    out << "    \"max_payload\": " << options.maxPayload << ",\n";
+    out << "    \"timeout_ms\": " << options.timeoutMs << "\n  },\n";
+    out << "  \"benchmarks\": [\n";
+    for (size_t i = 0; i < results.size(); i++)
+    {
+        const Result& r = results[i];
+        out << "    {\"pixels\": " << r.pixels
+            << ", \"target_fps\": " << r.targetFPS
+            << ", \"sustained_fps\": " << r.sustainedFPS
+            << ", \"packets_per_second\": " << r.packetsPerSecond
+            << ", \"latency_p50_ms\": " << r.p50Ms
+            << ", \"latency_p99_ms\": " << r.p99Ms
+            << ", \"latency_p999_ms\": " << r.p999Ms
+            << ", \"frames_lost\": " << r.framesLost
+            << ", \"packets_sent\": " << r.packetsSent
+            << ", \"packets_received\": " << r.packetsReceived << "}"
+            << (i + 1 < results.size() ? ",\n" : "\n");
+    }
+    out << "  ]\n}\n";
+    return true;
+}
+
+}
+
+int main(int argc, char** argv)
+{
+    Options options;
+    if (!parseArgs(argc, argv, options))
+        return 2;
+
+    printf("%10s %8s %12s %12s %10s %10s %10s %8s %9s\n",
+           "pixels", "fps", "sustained", "packets/s", "p50 ms", "p99 ms", "p99.9 ms", "lost", "pkt loss");
+
+    std::vector<Result> results;
+    for (int pixels : options.pixelCounts)
+    {
+        for (double fps : options.frameRates)
+        {
+            Result result;
+            if (!runCase(options, pixels, fps, result))
+                return 1;
+            results.push_back(result);
+
+            double packetLoss = (result.packetsSent > 0.0) ?
+                100.0 * (1.0 - result.packetsReceived / result.packetsSent) : 0.0;
+            char target[16];
+            snprintf(target, sizeof(target), fps > 0.0 ? "%.0f" : "max", fps);
+            printf("%10d %8s %12.1f %12.0f %10.3f %10.3f %10.3f %8d %8.2f%%\n",
+                   pixels, target, result.sustainedFPS, result.packetsPerSecond,
+                   result.p50Ms, result.p99Ms, result.p999Ms, result.framesLost, std::max(0.0, packetLoss));
+            fflush(stdout);
+        }
+    }
+
+    if (!options.jsonPath.empty() && !writeJSON(options.jsonPath, options, results))
+        return 1;
+    return 0;
+}
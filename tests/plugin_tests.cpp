@@ -0,0 +1,2407 @@
+// Regression tests for DDP Out and DDP In, run against the built plugin
+// modules through the mock host. Each test is registered with CTest by name:
+//   plugin_tests <name>    run one test
+//   plugin_tests           run all of them
+
+#include "CookDriver.h"
+#include "DDPCalibration.h"
+#include "DDPDmx.h"
+#include "DDPFrameRing.h"
+#include "DDPFrameSmoother.h"
+#include "DDPLayout.h"
+#include "DDPPcap.h"
+#include "DDPPixelMap.h"
+#include "DDPPlayback.h"
+#include "DDPPower.h"
+#include "DDPProtocol.h"
+#include "DDPRanges.h"
+#include "DDPRecording.h"
+#include "DDPRedundancy.h"
+#include "DDPSocket.h"
+#include "DDPTransport.h"
+#include "MockHost.h"
+
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <functional>
+#include <iterator>
+#include <map>
+#include <string>
+#include <thread>
+#include <vector>
+
+#ifndef DDP_OUT_PLUGIN_PATH
+    #define DDP_OUT_PLUGIN_PATH "DDPOutputCHOP.so"
+#endif
+#ifndef DDP_IN_PLUGIN_PATH
+    #define DDP_IN_PLUGIN_PATH "DDPInputCHOP.so"
+#endif
+
+namespace
+{
+
+int g_failures = 0;
+
+#define CHECK(condition) \
+    do { \
+        if (!(condition)) { \
+            fprintf(stderr, "%s:%d: CHECK failed: %s\n", __FILE__, __LINE__, #condition); \
+            g_failures++; \
+            return; \
+        } \
+    } while (0)
+
+struct TestCase
+{
+    const char* name;
+    std::function<void()> run;
+};
+
+std::vector<TestCase>& registry()
+{
+    static std::vector<TestCase> tests;
+    return tests;
+}
+
+struct Register
+{
+    Register(const char* name, std::function<void()> run) { registry().push_back({ name, run }); }
+};
+
+#define TEST(name) \
+    void test_##name(); \
+    Register register_##name(#name, test_##name); \
+    void test_##name()
+
+// Ports above the DDP default so a running controller or TD session is not disturbed
+const int kTestPort = 14148;
+const int kGatewayTestPort = 16454;
+
+bool createNode(mock::MockCHOPNode& node, const char* pluginPath, const char* opPath)
+{
+    if (node.create(pluginPath, opPath))
+        return true;
+    fprintf(stderr, "%s: %s\n", opPath, node.lastError().c_str());
+    return false;
+}
+
+}
+
+TEST(out_plugin_info)
+{
+    mock::MockCHOPNode out;
+    CHECK(createNode(out, DDP_OUT_PLUGIN_PATH, "/test/ddpout1"));
+    CHECK(out.pluginInfo().apiVersion == CHOPCPlusPlusAPIVersion);
+    CHECK(out.pluginInfo().customOPInfo.minInputs == 0);
+    CHECK(out.pluginInfo().customOPInfo.maxInputs == 1);
+
+    CHECK(out.inputs().getParInt("Port") == DDP_PORT);
+    CHECK(out.inputs().getParInt("Maxpayload") == 1440);
+    CHECK(std::string(out.inputs().getParString("Valuerange")) == "0-1");
+    CHECK(out.inputs().getParInt("Valuerange") == 0);
+}
+
+TEST(in_plugin_info)
+{
+    mock::MockCHOPNode in;
+    CHECK(createNode(in, DDP_IN_PLUGIN_PATH, "/test/ddpin1"));
+    CHECK(in.pluginInfo().apiVersion == CHOPCPlusPlusAPIVersion);
+    CHECK(in.pluginInfo().customOPInfo.minInputs == 0);
+    CHECK(in.inputs().getParInt("Port") == DDP_PORT);
+    CHECK(in.inputs().getParInt("Enable") == 1);
+}
+
+TEST(out_disabled_outputs_status)
+{
+    mock::MockCHOPNode out;
+    CHECK(createNode(out, DDP_OUT_PLUGIN_PATH, "/test/ddpout1"));
+    out.setPar("Enable", 0);
+
+    mock::MockCHOPInput input;
+    input.resize(1, 30);
+    out.connectInput(&input);
+    out.cook();
+
+    CHECK(out.numChannels() == 5);
+    CHECK(out.numSamples() == 1);
+    CHECK(out.channelName(0) == "enabled");
+    CHECK(out.channel(0)[0] == 0.0f);
+    CHECK(out.infoChannel("packets_sent") == 0.0f);
+}
+
+TEST(cook_driver_timeline)
+{
+    mock::MockCHOPNode out;
+    CHECK(createNode(out, DDP_OUT_PLUGIN_PATH, "/test/ddpout1"));
+    out.setPar("Enable", 0);
+
+    mock::CookDriver driver(120.0, true);
+    driver.add(&out);
+    driver.run(12);
+
+    const OP_TimeInfo& time = out.inputs().timeInfo;
+    CHECK(out.cookCount() == 12);
+    CHECK(time.absFrame == 11);
+    CHECK(time.frame == 12.0);
+    CHECK(time.rate == 120.0);
+    CHECK(time.deltaFrames == 1.0);
+
+    // 11 periods of 1/120 s between the first and last cook
+    CHECK(driver.elapsedSeconds() >= 11.0 / 120.0 - 0.002);
+}
+
+TEST(loopback_round_trip)
+{
+    mock::MockCHOPNode out;
+    mock::MockCHOPNode in;
+    CHECK(createNode(out, DDP_OUT_PLUGIN_PATH, "/test/ddpout1"));
+    CHECK(createNode(in, DDP_IN_PLUGIN_PATH, "/test/ddpin1"));
+
+    out.setPar("Ipaddress", std::string("127.0.0.1"));
+    out.setPar("Port", kTestPort);
+    out.setPar("Showstats", 1);
+    in.setPar("Port", kTestPort);
+    in.setPar("Bindinterface", std::string("127.0.0.1"));
+
+    // 1000 RGB pixels spans several 1440 byte packets
+    const int32_t numSamples = 3000;
+    mock::MockCHOPInput input;
+    input.resize(1, numSamples);
+    for (int32_t i = 0; i < numSamples; i++)
+        input.channel(0)[i] = static_cast<float>(i % 256) / 255.0f;
+    out.connectInput(&input);
+
+    mock::CookDriver driver(60.0, false);
+    driver.add(&in);
+    driver.add(&out);
+
+    // DDP In sizes its output from the previous cook, so the frame shows up
+    // on the cook after the one that received it
+    bool matched = false;
+    for (int attempt = 0; attempt < 200 && !matched; attempt++)
+    {
+        driver.step();
+        in.cook();
+        matched = in.numSamples() == numSamples;
+        for (int32_t i = 0; matched && i < numSamples; i++)
+            matched = std::fabs(in.channel(4)[i] - input.channel(0)[i]) <= 1.0f / 255.0f + 1e-6f;
+    }
+    CHECK(matched);
+    CHECK(in.channel(3)[0] == numSamples / 3.0f);
+    CHECK(out.infoChannel("packets_sent") >= 3.0f);
+    CHECK(in.infoEntry("Listen Port") == std::to_string(kTestPort));
+}
+
+TEST(out_records_delta_frames)
+{
+    const char* path = "plugin_tests_out.ddpr";
+    const int32_t numSamples = 300;
+    const int frames = 10;
+
+    mock::MockCHOPInput input;
+    input.resize(1, numSamples);
+    {
+        mock::MockCHOPNode out;
+        CHECK(createNode(out, DDP_OUT_PLUGIN_PATH, "/test/ddpout1"));
+        out.setPar("Ipaddress", std::string("127.0.0.1"));
+        out.setPar("Port", kTestPort);
+        out.setPar("Valuerange", std::string("0-255"));
+        out.setPar("Record", 1);
+        out.setPar("Recordfile", std::string(path));
+        out.setPar("Recordcompression", std::string("delta"));
+        out.connectInput(&input);
+
+        // One pixel changes per frame, everything else stays put
+        for (int frame = 0; frame < frames; frame++)
+        {
+            input.channel(0)[frame * 3] = static_cast<float>(10 + frame);
+            out.cook();
+        }
+        out.setPar("Record", 0);
+        out.cook();
+    }
+
+    std::ifstream file(path, std::ios::binary);
+    std::vector<uint8_t> data((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+    uint64_t startTime = 0;
+    CHECK(ddp::unpackFileHeader(data.data(), data.size(), startTime));
+
+    // Decode every record on top of the previous frame
+    std::vector<uint8_t> frame;
+    size_t offset = DDP_REC_FILE_HEADER_SIZE;
+    int records = 0;
+    int deltas = 0;
+    while (offset + DDP_REC_HEADER_SIZE <= data.size())
+    {
+        ddp::RecordHeader header;
+        ddp::unpackRecordHeader(data.data() + offset, header);
+        offset += DDP_REC_HEADER_SIZE;
+        CHECK(header.type == DDP_REC_TYPE_FRAME && header.dataType == DDP_DATA_TYPE_RGB);
+        CHECK(offset + header.storedSize <= data.size());
+        if (header.isKeyframe())
+        {
+            CHECK(header.encoding == DDP_REC_ENC_RAW);
+            frame.assign(data.begin() + offset, data.begin() + offset + header.storedSize);
+        }
+        else
+        {
+            CHECK(header.encoding == DDP_REC_ENC_DELTA);
+            CHECK(header.storedSize < header.rawSize);
+            CHECK(ddp::decodeDelta(data.data() + offset, header.storedSize, frame.data(), frame.size()));
+            deltas++;
+        }
+        offset += header.storedSize;
+        records++;
+    }
+    CHECK(offset == data.size());
+    CHECK(records == frames);
+    CHECK(deltas == frames - 1);
+    CHECK(frame.size() == static_cast<size_t>(numSamples));
+    for (int32_t i = 0; i < numSamples; i++)
+        CHECK(frame[i] == static_cast<uint8_t>(input.channel(0)[i]));
+    remove(path);
+}
+
+TEST(delta_codec_round_trip)
+{
+    std::vector<uint8_t> previous(4096), current(4096), decoded, stream;
+    for (size_t i = 0; i < previous.size(); i++)
+        previous[i] = static_cast<uint8_t>(i * 7);
+    current = previous;
+    // Scattered single bytes, a short gap that is cheaper to copy, and the final byte
+    current[0] ^= 1;
+    current[100] ^= 1;
+    current[103] ^= 1;
+    for (size_t i = 2000; i < 2500; i++)
+        current[i] = 0;
+    current.back() ^= 0xFF;
+
+    ddp::encodeDelta(previous.data(), current.data(), current.size(), stream);
+    CHECK(stream.size() < 600);
+    CHECK(stream.size() <= ddp::maxDeltaSize(current.size()));
+
+    decoded = previous;
+    CHECK(ddp::decodeDelta(stream.data(), stream.size(), decoded.data(), decoded.size()));
+    CHECK(decoded == current);
+
+    // Identical frames encode to nothing, truncated streams are rejected
+    ddp::encodeDelta(current.data(), current.data(), current.size(), stream);
+    CHECK(stream.empty());
+    ddp::encodeDelta(previous.data(), current.data(), current.size(), stream);
+    CHECK(!ddp::decodeDelta(stream.data(), stream.size() - 1, decoded.data(), decoded.size()));
+}
+
+TEST(playback_reader_seek)
+{
+    const char* path = "plugin_tests_seek.ddpr";
+    const int frames = 300;
+    const size_t frameSize = 600;
+
+    // Frame n has byte n % 256 at position n, everything else static
+    {
+        ddp::RecordingWriter writer;
+        CHECK(writer.open(path, ddp::RecordCompression::Delta, 50));
+        std::vector<uint8_t> frame(frameSize, 7);
+        for (int n = 0; n < frames; n++)
+        {
+            frame[n % frameSize] = static_cast<uint8_t>(n);
+            CHECK(writer.writeFrame(frame.data(), frame.size()));
+        }
+        writer.close();
+        CHECK(writer.recordsWritten() == frames);
+    }
+
+    ddp::RecordingReader reader;
+    CHECK(reader.open(path));
+    CHECK(reader.recordCount() == static_cast<size_t>(frames));
+    CHECK(reader.hasFrames());
+
+    // Random access in both directions, across keyframe boundaries
+    const int order[] = { 299, 0, 149, 150, 151, 49, 50, 51, 298, 10 };
+    std::vector<uint8_t> frame;
+    for (int n : order)
+    {
+        size_t index = 0;
+        CHECK(reader.findRecord(reader.timestampUs(n), index));
+        CHECK(reader.timestampUs(index) == reader.timestampUs(n));
+        CHECK(reader.readFrame(static_cast<size_t>(n), frame));
+        CHECK(frame.size() == frameSize);
+        for (int k = 0; k <= n; k++)
+            CHECK(frame[k] == static_cast<uint8_t>(k));
+        for (size_t k = static_cast<size_t>(n) + 1; k < frameSize; k++)
+            CHECK(frame[k] == 7);
+    }
+
+    size_t index = 0;
+    CHECK(reader.findRecord(reader.durationUs() + 1000000, index) && index == static_cast<size_t>(frames - 1));
+    reader.close();
+    remove(path);
+}
+
+TEST(out_plays_back_recording)
+{
+    const char* path = "plugin_tests_playback.ddpr";
+    const size_t frameSize = 900;
+    {
+        ddp::RecordingWriter writer;
+        CHECK(writer.open(path, ddp::RecordCompression::Delta));
+        std::vector<uint8_t> frame(frameSize);
+        for (size_t i = 0; i < frameSize; i++)
+            frame[i] = static_cast<uint8_t>(i * 3);
+        CHECK(writer.writeFrame(frame.data(), frame.size()));
+    }
+
+    // Play back with no input CHOP connected
+    mock::MockCHOPNode out;
+    mock::MockCHOPNode in;
+    CHECK(createNode(out, DDP_OUT_PLUGIN_PATH, "/test/ddpout1"));
+    CHECK(createNode(in, DDP_IN_PLUGIN_PATH, "/test/ddpin1"));
+    out.setPar("Ipaddress", std::string("127.0.0.1"));
+    out.setPar("Port", kTestPort);
+    out.setPar("Playback", 1);
+    out.setPar("Playbackfile", std::string(path));
+    out.setPar("Channelsperpixel", 4);
+    in.setPar("Port", kTestPort);
+    in.setPar("Bindinterface", std::string("127.0.0.1"));
+    in.setPar("Valuerange", std::string("0-255"));
+
+    in.cook();
+    out.cook();
+    bool matched = false;
+    for (int attempt = 0; attempt < 200 && !matched; attempt++)
+    {
+        in.cook();
+        matched = in.numSamples() == static_cast<int32_t>(frameSize);
+        for (size_t i = 0; matched && i < frameSize; i++)
+            matched = in.channel(4)[i] == static_cast<float>(static_cast<uint8_t>(i * 3));
+    }
+    CHECK(matched);
+    CHECK(out.infoChannel("pixel_count") == frameSize / 4);
+    remove(path);
+}
+
+TEST(out_stamps_played_frames)
+{
+    const char* path = "plugin_tests_timecode.ddpr";
+    {
+        ddp::RecordingWriter writer;
+        CHECK(writer.open(path, ddp::RecordCompression::None));
+        std::vector<uint8_t> frame(30, 9);
+        CHECK(writer.writeFrame(frame.data(), frame.size()));
+    }
+    
+    // Played frames get this cook's timecode, not one left from a live frame
+    mock::MockCHOPNode out;
+    CHECK(createNode(out, DDP_OUT_PLUGIN_PATH, "/test/ddpout1"));
+    out.setPar("Ipaddress", std::string("127.0.0.1"));
+    out.setPar("Port", kTestPort);
+    out.setPar("Playback", 1);
+    out.setPar("Playbackfile", std::string(path));
+    out.setPar("Timecode", std::string("clock"));
+    ddp::UdpSocket receiver;
+    CHECK(receiver.open(AF_INET) && receiver.bindTo("127.0.0.1", kTestPort));
+    
+    double before = std::chrono::duration<double>(std::chrono::steady_clock::now().time_since_epoch()).count();
+    out.cook();
+    uint8_t buffer[1500];
+    struct sockaddr_storage from;
+    bool wouldBlock = false;
+    CHECK(receiver.waitReadable(500));
+    int length = receiver.recvFrom(buffer, sizeof(buffer), from, wouldBlock);
+    ddp::PacketHeader header;
+    const uint8_t* payload = nullptr;
+    CHECK(length > 0 && ddp::unpackHeader(buffer, static_cast<size_t>(length), header, payload));
+    CHECK(header.hasTimecode() && header.length == 30);
+    uint32_t expected = static_cast<uint32_t>(static_cast<uint64_t>(before * 65536.0) & 0xFFFFFFFFu);
+    CHECK(header.timecode - expected < 65536u);
+    remove(path);
+}
+
+TEST(out_plays_recorded_data_type)
+{
+    const char* path = "plugin_tests_datatype.ddpr";
+    const size_t frameSize = 600;
+    {
+        ddp::RecordingWriter writer;
+        CHECK(writer.open(path, ddp::RecordCompression::None));
+        std::vector<uint8_t> frame(frameSize, 5);
+        CHECK(writer.writeFrame(frame.data(), frame.size(), false, 0, DDP_DATA_TYPE_RGB16));
+    }
+    
+    // A 16-bit RGB recording on a node left at 8-bit goes out as recorded, in whole 6-byte pixels
+    mock::MockCHOPNode out;
+    CHECK(createNode(out, DDP_OUT_PLUGIN_PATH, "/test/ddpout1"));
+    out.setPar("Ipaddress", std::string("127.0.0.1"));
+    out.setPar("Port", kTestPort);
+    out.setPar("Playback", 1);
+    out.setPar("Playbackfile", std::string(path));
+    out.setPar("Maxpayload", 100);
+    ddp::UdpSocket receiver;
+    CHECK(receiver.open(AF_INET) && receiver.bindTo("127.0.0.1", kTestPort));
+    
+    out.cook();
+    size_t received = 0;
+    uint8_t buffer[1500];
+    struct sockaddr_storage from;
+    bool wouldBlock = false;
+    while (received < frameSize && receiver.waitReadable(500))
+    {
+        int length = receiver.recvFrom(buffer, sizeof(buffer), from, wouldBlock);
+        ddp::PacketHeader header;
+        const uint8_t* payload = nullptr;
+        CHECK(length > 0 && ddp::unpackHeader(buffer, static_cast<size_t>(length), header, payload));
+        CHECK(header.dataType == DDP_DATA_TYPE_RGB16);
+        CHECK(header.length % 6 == 0 && header.offset == received);
+        received += header.length;
+    }
+    CHECK(received == frameSize);
+    CHECK(out.infoChannel("pixel_count") == frameSize / 6);
+    remove(path);
+}
+
+// Little-endian pcapng block: type, length, body padded to 32 bits, length
+void appendPcapNgBlock(std::vector<uint8_t>& file, uint32_t type, const std::vector<uint8_t>& body)
+{
+    auto put32 = [&file](uint32_t v) { for (int i = 0; i < 4; i++) file.push_back(static_cast<uint8_t>(v >> (8 * i))); };
+    uint32_t padded = (static_cast<uint32_t>(body.size()) + 3u) & ~3u;
+    put32(type);
+    put32(12 + padded);
+    file.insert(file.end(), body.begin(), body.end());
+    file.resize(file.size() + padded - body.size(), 0);
+    put32(12 + padded);
+}
+
+TEST(pcap_reader_formats)
+{
+    const char* path = "plugin_tests_formats.pcapng";
+    const uint8_t ddp[] = { 0x41, 0x01, 0x01, 0x01, 0, 0, 0, 0, 0, 3, 10, 20, 30 };
+
+    // Ethernet + VLAN tag + IPv4 + UDP 5000 -> 4048, carrying 'ddp'
+    std::vector<uint8_t> udpFrame = { 0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 0x81, 0x00, 0x00, 0x05, 0x08, 0x00,
+                                      0x45, 0, 0, 20 + 8 + sizeof(ddp), 0, 0, 0x40, 0, 64, 17, 0, 0,
+                                      10, 0, 0, 7, 10, 0, 0, 1,
+                                      0x13, 0x88, 0x0F, 0xD0, 0, 8 + sizeof(ddp), 0, 0 };
+    udpFrame.insert(udpFrame.end(), ddp, ddp + sizeof(ddp));
+    // The same packet as a later IPv4 fragment, and as TCP: both skipped
+    std::vector<uint8_t> fragment = udpFrame;
+    fragment[24] = 0x00;
+    fragment[25] = 0x10;
+    std::vector<uint8_t> tcp = udpFrame;
+    tcp[27] = 6;
+
+    auto packetBlock = [](const std::vector<uint8_t>& frame, uint64_t ticks) {
+        std::vector<uint8_t> body(20, 0);
+        for (int i = 0; i < 4; i++)
+        {
+            body[4 + i] = static_cast<uint8_t>((ticks >> 32) >> (8 * i));
+            body[8 + i] = static_cast<uint8_t>(ticks >> (8 * i));
+            body[12 + i] = body[16 + i] = static_cast<uint8_t>(frame.size() >> (8 * i));
+        }
+        body.insert(body.end(), frame.begin(), frame.end());
+        return body;
+    };
+
+    std::vector<uint8_t> file;
+    appendPcapNgBlock(file, DDP_PCAPNG_SHB, { 0x4D, 0x3C, 0x2B, 0x1A, 1, 0, 0, 0, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF });
+    // Ethernet, nanosecond timestamps (if_tsresol = 9)
+    appendPcapNgBlock(file, 1, { 1, 0, 0, 0, 0, 0, 0, 0, 9, 0, 1, 0, 9, 0, 0, 0, 0, 0, 0, 0 });
+    appendPcapNgBlock(file, 6, packetBlock(tcp, 1000000000ull));
+    appendPcapNgBlock(file, 6, packetBlock(fragment, 1000000000ull));
+    appendPcapNgBlock(file, 6, packetBlock(udpFrame, 1500000000ull));
+    {
+        std::ofstream out(path, std::ios::binary);
+        out.write(reinterpret_cast<const char*>(file.data()), static_cast<std::streamsize>(file.size()));
+    }
+
+    ddp::PcapReader reader;
+    CHECK(reader.open(path));
+    CHECK(reader.isPcapNg());
+    ddp::CapturedPacket packet;
+    CHECK(reader.next(packet, DDP_PORT));
+    CHECK(packet.length == sizeof(ddp) && memcmp(packet.payload, ddp, sizeof(ddp)) == 0);
+    CHECK(std::fabs(packet.timestamp - 1.5) < 1e-9);
+    CHECK(packet.destPort == DDP_PORT);
+    uint16_t sourcePort = 0;
+    CHECK(ddp::formatAddress(reinterpret_cast<const struct sockaddr*>(&packet.source), &sourcePort) == "10.0.0.7");
+    CHECK(sourcePort == 5000);
+    CHECK(!reader.next(packet, DDP_PORT));
+    CHECK(reader.packetsSkipped() == 2);
+    CHECK(reader.rewind() && reader.next(packet, 0) && packet.length == sizeof(ddp));
+    reader.close();
+
+    // Written IPv6 packets (with a UDP checksum) read back unchanged
+    const char* written = "plugin_tests_formats.pcap";
+    struct sockaddr_storage source, dest;
+    socklen_t length = 0;
+    CHECK(ddp::parseAddress("fe80::1", 6000, source, length));
+    CHECK(ddp::parseAddress("fe80::2", DDP_PORT, dest, length));
+    {
+        ddp::PcapWriter writer;
+        CHECK(writer.open(written));
+        CHECK(writer.writeDatagram(source, dest, ddp, 10, ddp + 10, sizeof(ddp) - 10, 2.25));
+        CHECK(writer.writeDatagram(source, dest, ddp, 3, ddp + 3, sizeof(ddp) - 3, 2.5));
+    }
+    CHECK(reader.open(written));
+    CHECK(!reader.isPcapNg());
+    for (double timestamp : { 2.25, 2.5 })
+    {
+        CHECK(reader.next(packet, DDP_PORT));
+        CHECK(packet.length == sizeof(ddp) && memcmp(packet.payload, ddp, sizeof(ddp)) == 0);
+        CHECK(std::fabs(packet.timestamp - timestamp) < 1e-6);
+        CHECK(ddp::formatAddress(reinterpret_cast<const struct sockaddr*>(&packet.source), &sourcePort) == "fe80::1");
+        CHECK(sourcePort == 6000);
+    }
+    CHECK(!reader.next(packet));
+    reader.close();
+    remove(path);
+    remove(written);
+}
+
+TEST(out_pcap_mirror_replays_into_in)
+{
+    const char* path = "plugin_tests_mirror.pcap";
+    const int32_t numSamples = 3000;    // several packets per frame
+    const int frames = 3;
+    {
+        mock::MockCHOPNode out;
+        CHECK(createNode(out, DDP_OUT_PLUGIN_PATH, "/test/ddpout1"));
+        out.setPar("Ipaddress", std::string("127.0.0.1"));
+        out.setPar("Port", kTestPort);
+        out.setPar("Valuerange", std::string("0-255"));
+        out.setPar("Pcapmirror", 1);
+        out.setPar("Pcapfile", std::string(path));
+
+        mock::MockCHOPInput input;
+        input.resize(1, numSamples);
+        out.connectInput(&input);
+        for (int frame = 0; frame < frames; frame++)
+        {
+            for (int32_t i = 0; i < numSamples; i++)
+                input.channel(0)[i] = static_cast<float>((i + frame) % 256);
+            out.cook();
+        }
+        CHECK(out.infoEntry("PCAP Mirror").find("(9 packets)") != std::string::npos);
+    }
+
+    // As fast as possible replays one frame per cook; the output lags a cook behind
+    mock::MockCHOPNode in;
+    CHECK(createNode(in, DDP_IN_PLUGIN_PATH, "/test/ddpin1"));
+    in.setPar("Port", kTestPort);
+    in.setPar("Source", std::string("pcap"));
+    in.setPar("Pcapfile", std::string(path));
+    in.setPar("Pcapreplay", std::string("fast"));
+    in.setPar("Pcaploop", 0);
+    in.setPar("Valuerange", std::string("0-255"));
+    in.setPar("Showstats", 1);
+    for (int cook = 0; cook <= frames; cook++)
+        in.cook();
+
+    CHECK(in.numSamples() == numSamples);
+    for (int32_t i = 0; i < numSamples; i++)
+        CHECK(in.channel(4)[i] == static_cast<float>((i + frames - 1) % 256));
+    CHECK(in.infoChannel("packets_received") == 9.0f);
+    CHECK(in.infoEntry("Last Source").find(":") != std::string::npos);    // the unbound sender shows as 0.0.0.0
+    CHECK(in.infoEntry("Capture Replay").find("9 packets (0 skipped)") == 0);
+    remove(path);
+}
+
+TEST(pixel_map_sampling)
+{
+    // 4x2 BGRA texture, texel (x, y) holds R = 10x + y, G = 100 + x, B = 200 + y, A = 50
+    const uint32_t width = 4, height = 2;
+    std::vector<uint8_t> texture(width * height * 4);
+    for (uint32_t y = 0; y < height; y++)
+    {
+        for (uint32_t x = 0; x < width; x++)
+        {
+            uint8_t* texel = &texture[(y * width + x) * 4];
+            texel[0] = static_cast<uint8_t>(200 + y);
+            texel[1] = static_cast<uint8_t>(100 + x);
+            texel[2] = static_cast<uint8_t>(10 * x + y);
+            texel[3] = 50;
+        }
+    }
+    uint8_t identity[256];
+    ddp::buildByteLUT(ddp::ConvertSettings(), identity);
+    for (int i = 0; i < 256; i++)
+        CHECK(identity[i] == i);
+
+    std::vector<ddp::MapPoint> points;
+    ddp::parseMapText("x y\n# comment\n0 0\n3,1\n1.4\t0.6\n-1 0\n4 0\n", points);
+    CHECK(points.size() == 5);
+
+    ddp::PixelMap map;
+    map.setPoints(points, ddp::MapUnits::Pixels);
+    map.compile(width, height);
+    CHECK(map.pointsOutside() == 2);
+    std::vector<uint8_t> rgb(points.size() * 3);
+    map.sampleBGRA8(texture.data(), identity, 3, rgb.data());
+    const uint8_t expected[] = { 0, 100, 200,  31, 103, 201,  11, 101, 201,  0, 0, 0,  0, 0, 0 };
+    CHECK(memcmp(rgb.data(), expected, sizeof(expected)) == 0);
+
+    // UV: 1.0 lands on the last texel; RGBW takes alpha as the fourth byte
+    const std::vector<ddp::MapPoint> uv = { { 0.0f, 0.0f }, { 1.0f, 1.0f }, { 0.5f, 0.49f } };
+    map.setPoints(uv, ddp::MapUnits::UV);
+    map.compile(width, height);
+    CHECK(map.pointsOutside() == 0);
+    std::vector<uint8_t> rgbw(uv.size() * 4);
+    map.sampleBGRA8(texture.data(), identity, 4, rgbw.data());
+    const uint8_t expectedRGBW[] = { 0, 100, 200, 50,  31, 103, 201, 50,  20, 102, 200, 50 };
+    CHECK(memcmp(rgbw.data(), expectedRGBW, sizeof(expectedRGBW)) == 0);
+
+    // A color order and the power meter in the same pass as the sampling:
+    // the same bytes and sums as reordering and metering afterwards
+    ddp::ColorOrder order;
+    std::string error;
+    CHECK(ddp::parseColorOrder("GRBW", 4, order, error));
+    ddp::RangePower fused, separate;
+    fused.scale = separate.scale = DDP_POWER_SCALE_ONE / 2;
+    std::vector<uint8_t> ordered(2 * 4);
+    map.sampleBGRA8(texture.data(), 1, 2, identity, 4, ordered.data(), &order, &fused);
+    std::vector<uint8_t> reference(rgbw.begin() + 4, rgbw.end());
+    ddp::reorderChannels(reference.data(), 2, 4, order);
+    ddp::meterPixels(reference.data(), 2, 4, separate);
+    CHECK(ordered == reference);
+    CHECK(ordered[0] == 103 / 2 && ordered[1] == 31 / 2);
+    for (int c = 0; c < DDP_POWER_CHANNELS; c++)
+        CHECK(fused.sums[c] == separate.sums[c]);
+}
+
+TEST(out_samples_top_through_pixel_map)
+{
+    // 16x8 RGBA8 TOP with a distinct colour per texel
+    const uint32_t width = 16, height = 8;
+    std::vector<uint8_t> image(width * height * 4);
+    for (size_t i = 0; i < width * height; i++)
+    {
+        image[i * 4 + 0] = static_cast<uint8_t>(i);
+        image[i * 4 + 1] = static_cast<uint8_t>(255 - i);
+        image[i * 4 + 2] = static_cast<uint8_t>(i * 7);
+        image[i * 4 + 3] = 255;
+    }
+    mock::MockTOPInput top;
+    top.setImage(width, height, OP_PixelFormat::RGBA8Fixed, image.data());
+
+    // A diagonal of LEDs plus one off the texture
+    std::vector<std::vector<std::string>> rows = { { "x", "y" } };
+    std::vector<size_t> texels;
+    for (uint32_t i = 0; i < height; i++)
+    {
+        rows.push_back({ std::to_string(i * 2), std::to_string(i) });
+        texels.push_back(i * width + i * 2);
+    }
+    rows.push_back({ "100", "0" });
+    mock::MockDATInput map;
+    map.setTable(rows);
+
+    mock::MockCHOPNode out;
+    mock::MockCHOPNode in;
+    CHECK(createNode(out, DDP_OUT_PLUGIN_PATH, "/test/ddpout1"));
+    CHECK(createNode(in, DDP_IN_PLUGIN_PATH, "/test/ddpin1"));
+    out.setPar("Ipaddress", std::string("127.0.0.1"));
+    out.setPar("Port", kTestPort);
+    out.setPar("Gamma", 2.2);
+    out.setParTOP("Top", &top);
+    out.setParDAT("Pixelmapdat", &map);
+    in.setPar("Port", kTestPort);
+    in.setPar("Bindinterface", std::string("127.0.0.1"));
+    in.setPar("Valuerange", std::string("0-255"));
+
+    // Same bytes as the TOP converted to a CHOP (texel / 255) and sent with the same gamma
+    ddp::ConvertSettings settings;
+    settings.gamma = 2.2f;
+    std::vector<uint8_t> expected;
+    for (size_t texel : texels)
+    {
+        for (int c = 0; c < 3; c++)
+        {
+            float sample = image[texel * 4 + c] / 255.0f;
+            uint8_t byte = 0;
+            ddp::convertSamples(&sample, 1, settings, &byte);
+            expected.push_back(byte);
+        }
+    }
+    expected.insert(expected.end(), 3, 0);
+
+    in.cook();
+    bool matched = false;
+    for (int attempt = 0; attempt < 200 && !matched; attempt++)
+    {
+        out.cook();
+        in.cook();
+        matched = in.numSamples() == static_cast<int32_t>(expected.size());
+        for (size_t i = 0; matched && i < expected.size(); i++)
+            matched = in.channel(4)[i] == static_cast<float>(expected[i]);
+    }
+    CHECK(matched);
+    CHECK(top.downloads() > 0);
+    CHECK(out.infoChannel("pixel_count") == static_cast<float>(texels.size() + 1));
+    CHECK(out.infoEntry("Pixel Map") == "9 points, 1 outside the TOP");
+}
+
+TEST(out_pipelines_top_downloads)
+{
+    const char* path = "plugin_tests_top.ddpr";
+    const double latency = 0.02;
+
+    // One texel whose red value tags the frame it was set for
+    mock::MockTOPInput top;
+    top.setDownloadLatency(latency);
+    auto setFrame = [&top](uint8_t tag) {
+        const uint8_t texel[4] = { tag, 0, 0, 255 };
+        top.setImage(1, 1, OP_PixelFormat::RGBA8Fixed, texel);
+    };
+    mock::MockDATInput map;
+    map.setTable({ { "0", "0" } });
+
+    {
+        mock::MockCHOPNode out;
+        CHECK(createNode(out, DDP_OUT_PLUGIN_PATH, "/test/ddpout1"));
+        out.setPar("Ipaddress", std::string("127.0.0.1"));
+        out.setPar("Port", kTestPort);
+        out.setPar("Record", 1);
+        out.setPar("Recordfile", std::string(path));
+        out.setParTOP("Top", &top);
+        out.setParDAT("Pixelmapdat", &map);
+
+        // Pipelined (default): frame N goes out on cook N + 1, by which time
+        // its readback has finished
+        setFrame(10);
+        out.cook();
+        CHECK(out.infoChannel("packets_sent") == 0.0f);
+        for (uint8_t tag : { 20, 30 })
+        {
+            std::this_thread::sleep_for(std::chrono::duration<double>(latency * 2));
+            setFrame(tag);
+            out.cook();
+            CHECK(out.infoChannel("download_wait_ms") < latency * 1000 / 2);
+        }
+
+        // Immediate: the frame of this cook, after blocking on its readback
+        out.setPar("Toplatency", std::string("immediate"));
+        setFrame(40);
+        out.cook();
+        CHECK(out.infoChannel("download_wait_ms") >= latency * 1000 * 0.9);
+
+        out.setPar("Record", 0);
+        out.cook();
+        CHECK(top.downloads() == 5);
+    }
+
+    // The download started for 30 was dropped on the switch
+    ddp::RecordingReader reader;
+    CHECK(reader.open(path));
+    const uint8_t expected[] = { 10, 20, 40 };
+    CHECK(reader.recordCount() == 3);
+    std::vector<uint8_t> frame;
+    for (size_t i = 0; i < 3 && i < reader.recordCount(); i++)
+    {
+        CHECK(reader.readFrame(i, frame));
+        CHECK(frame.size() == 3 && frame[0] == expected[i]);
+    }
+    reader.close();
+    remove(path);
+}
+
+TEST(led_layout_tables)
+{
+    const uint32_t B = DDP_LAYOUT_BLANK;
+    auto compiled = [](const ddp::LayoutSettings& settings, size_t source) {
+        ddp::LedLayout layout;
+        layout.compile(settings, source);
+        return std::vector<uint32_t>(layout.indices(), layout.indices() + layout.size());
+    };
+
+    // 3x2 matrix, source pixels numbered 0 1 2 (bottom row), 3 4 5 (top row)
+    ddp::LayoutSettings settings;
+    settings.width = 3;
+    settings.height = 2;
+    settings.serpentine = true;
+    CHECK(compiled(settings, 6) == std::vector<uint32_t>({ 0, 1, 2, 5, 4, 3 }));
+    settings.start = ddp::LayoutCorner::TopLeft;
+    CHECK(compiled(settings, 6) == std::vector<uint32_t>({ 3, 4, 5, 2, 1, 0 }));
+    settings.start = ddp::LayoutCorner::BottomRight;
+    settings.columns = true;
+    CHECK(compiled(settings, 6) == std::vector<uint32_t>({ 2, 5, 4, 1, 0, 3 }));
+
+    // Cells past the end of the source are blank, source past the matrix follows on
+    settings = ddp::LayoutSettings();
+    settings.width = 3;
+    settings.height = 2;
+    CHECK(compiled(settings, 4) == std::vector<uint32_t>({ 0, 1, 2, 3, B, B }));
+    CHECK(compiled(settings, 8) == std::vector<uint32_t>({ 0, 1, 2, 3, 4, 5, 6, 7 }));
+
+    // Segments: 2 dummies, 2 forward, 1 unwired, 2 reversed, then the rest
+    const char* rows[][2] = { { "mode", "count" }, { "dummy", "2" }, { "forward", "2" },
+                              { "skip", "1" }, { "reverse", "2" }, { "", "" } };
+    settings = ddp::LayoutSettings();
+    ddp::LayoutSegment segment;
+    for (auto& row : rows)
+    {
+        if (ddp::parseLayoutSegment(row[0], row[1], segment))
+            settings.segments.push_back(segment);
+    }
+    CHECK(settings.segments.size() == 4);
+    ddp::LedLayout layout;
+    layout.compile(settings, 6);
+    CHECK(std::vector<uint32_t>(layout.indices(), layout.indices() + layout.size()) ==
+          std::vector<uint32_t>({ B, B, 0, 1, 4, 3, 5 }));
+    CHECK(layout.blanks() == 2 && layout.skipped() == 1);
+
+    // Gathering through the identity gives convertSamples()'s bytes; blanks are black
+    std::vector<float> samples(6 * 3);
+    for (size_t i = 0; i < samples.size(); i++)
+        samples[i] = static_cast<float>(i) / samples.size();
+    ddp::ConvertSettings convert;
+    convert.gamma = 2.2f;
+    std::vector<uint8_t> direct(samples.size()), gathered(layout.size() * 3);
+    ddp::convertSamples(samples.data(), samples.size(), convert, direct.data());
+    ddp::convertGathered(samples.data(), layout.indices(), layout.size(), 3, convert, gathered.data());
+    for (size_t i = 0; i < layout.size(); i++)
+    {
+        for (size_t c = 0; c < 3; c++)
+        {
+            uint32_t index = layout.indices()[i];
+            CHECK(gathered[i * 3 + c] == (index == B ? 0 : direct[index * 3 + c]));
+        }
+    }
+
+    // Rows of a serpentine matrix become runs with the same bytes, reversed
+    // ones included, and a dummy and skip in the middle split them
+    settings = ddp::LayoutSettings();
+    settings.width = 16;
+    settings.height = 16;
+    settings.serpentine = true;
+    settings.segments = { { ddp::LayoutSegment::Kind::Forward, 40 }, { ddp::LayoutSegment::Kind::Dummy, 3 },
+                          { ddp::LayoutSegment::Kind::Skip, 5 } };
+    layout.compile(settings, 256);
+    CHECK(!layout.runs().empty());
+    samples.resize(256 * 4);
+    for (size_t i = 0; i < samples.size(); i++)
+        samples[i] = static_cast<float>(i % 97) / 96.0f;
+    std::vector<uint8_t> viaRuns(layout.size() * 4), viaIndices(layout.size() * 4);
+    ddp::convertRuns(samples.data(), layout.runs().data(), layout.runs().size(), 4, convert, viaRuns.data());
+    ddp::convertGathered(samples.data(), layout.indices(), layout.size(), 4, convert, viaIndices.data());
+    CHECK(viaRuns == viaIndices);
+}
+
+TEST(out_applies_layout)
+{
+    const char* path = "plugin_tests_layout.ddpr";
+
+    // 4x2 RGB pixels whose red byte is the pixel number
+    mock::MockCHOPInput input;
+    input.resize(1, 8 * 3);
+    for (int i = 0; i < 8; i++)
+        input.channel(0)[i * 3] = static_cast<float>(i);
+    mock::MockDATInput segments;
+    segments.setTable({ { "dummy", "1" } });
+
+    {
+        mock::MockCHOPNode out;
+        CHECK(createNode(out, DDP_OUT_PLUGIN_PATH, "/test/ddpout1"));
+        out.setPar("Ipaddress", std::string("127.0.0.1"));
+        out.setPar("Port", kTestPort);
+        out.setPar("Valuerange", std::string("0-255"));
+        out.setPar("Record", 1);
+        out.setPar("Recordfile", std::string(path));
+        out.setPar("Layoutsize", 4, 0);
+        out.setPar("Layoutsize", 2, 1);
+        out.setPar("Layoutserpentine", 1);
+        out.setPar("Layoutstart", std::string("topright"));
+        out.setParDAT("Layoutsegments", &segments);
+        out.connectInput(&input);
+        out.cook();
+        CHECK(out.infoEntry("Layout") == "9 pixels (1 blank, 0 skipped)");
+        CHECK(out.infoChannel("pixel_count") == 9.0f);
+        out.setPar("Record", 0);
+        out.cook();
+    }
+
+    ddp::RecordingReader reader;
+    CHECK(reader.open(path));
+    std::vector<uint8_t> frame;
+    CHECK(reader.recordCount() == 1 && reader.readFrame(0, frame));
+    const uint8_t expected[] = { 0, 7, 6, 5, 4, 0, 1, 2, 3 };
+    CHECK(frame.size() == 9 * 3);
+    for (size_t i = 0; i < 9 && i * 3 < frame.size(); i++)
+        CHECK(frame[i * 3] == expected[i]);
+    reader.close();
+    remove(path);
+}
+
+TEST(color_order_ranges)
+{
+    ddp::ColorOrder order;
+    std::string error;
+    CHECK(ddp::parseColorOrder("GRB", 3, order, error) && order.map[0] == 1 && order.map[1] == 0 && order.map[2] == 2);
+    CHECK(ddp::parseColorOrder("wrgb", 4, order, error) && order.map[0] == 3 && order.map[3] == 2);
+    CHECK(ddp::parseColorOrder("GRB", 4, order, error) && order.map[3] == 3);
+    CHECK(ddp::parseColorOrder("", 3, order, error) && order.isIdentity(3));
+    CHECK(!ddp::parseColorOrder("WRGB", 3, order, error));
+    CHECK(!ddp::parseColorOrder("GB", 3, order, error));
+    CHECK(!ddp::parseColorOrder("RRB", 3, order, error));
+
+    // Header in any column order; rows without a start are skipped
+    const char* table[][4] = { { "Name", "Order", "Start", "Count" }, { "right", "BGR", "10", "" },
+                               { "left", "GRB", "0", "4" }, { "mid", "", "4", "2" }, { "", "", "", "" } };
+    ddp::RangeTableParser parser;
+    std::vector<ddp::PixelRange> ranges;
+    ddp::PixelRange range;
+    for (auto& row : table)
+    {
+        if (parser.parseRow(row, 4, range))
+            ranges.push_back(range);
+    }
+    CHECK(ranges.size() == 3);
+    CHECK(ddp::sortRanges(ranges, error));
+    CHECK(ranges[0].name == "left" && ranges[0].order == "GRB" && ranges[0].count == 4);
+    CHECK(ranges[2].name == "right" && ranges[2].start == 10 && ranges[2].count == 0);
+    std::vector<ddp::PixelRange> overlapping = { ranges[0], ranges[1] };
+    overlapping[0].count = 5;
+    CHECK(!ddp::sortRanges(overlapping, error));
+
+    // A forward and a reversed run split at the edges of pixels 3-7
+    std::vector<ddp::LayoutRun> runs = { { 0, 6, 1, 0 }, { 6, 6, -1, 0 } };
+    std::vector<ddp::PixelRange> middle(1);
+    middle[0].start = 3;
+    middle[0].count = 5;
+    std::vector<ddp::LayoutRun> pieces;
+    ddp::splitRuns(runs, middle, 12, pieces);
+    CHECK(pieces.size() == 4);
+    if (pieces.size() == 4)
+    {
+        CHECK(pieces[0].source == 0 && pieces[0].count == 3 && pieces[0].order == 0);
+        CHECK(pieces[1].source == 3 && pieces[1].count == 3 && pieces[1].order == 1);
+        CHECK(pieces[2].source == 10 && pieces[2].count == 2 && pieces[2].step == -1 && pieces[2].order == 1);
+        CHECK(pieces[3].source == 6 && pieces[3].count == 4 && pieces[3].order == 0);
+    }
+
+    // Runs longer than a conversion block, reversed and permuted, against a per-pixel reference
+    const int channels = 4;
+    const uint32_t half = 1500;
+    std::vector<float> samples(half * 2 * channels);
+    for (size_t i = 0; i < samples.size(); i++)
+        samples[i] = static_cast<float>(i % 251);
+    runs = { { 0, half, 1, 0 }, { half, half, -1, 0 } };
+    middle[0].start = 1000;
+    middle[0].count = 1000;
+    ddp::splitRuns(runs, middle, half * 2, pieces);
+    std::vector<ddp::ColorOrder> orders(2);
+    CHECK(ddp::parseColorOrder("WBGR", channels, orders[1], error));
+    ddp::ConvertSettings settings;
+    settings.normalizedInput = false;
+    std::vector<uint8_t> bytes(samples.size());
+    ddp::convertRuns(samples.data(), pieces.data(), pieces.size(), channels, settings, bytes.data(), orders.data());
+    bool matches = true;
+    for (uint32_t wire = 0; wire < half * 2; wire++)
+    {
+        uint32_t source = wire < half ? wire : half * 3 - 1 - wire;
+        const ddp::ColorOrder& expected = orders[wire >= 1000 && wire < 2000 ? 1 : 0];
+        for (int c = 0; c < channels; c++)
+            matches = matches && bytes[wire * channels + c] == static_cast<uint8_t>(samples[source * channels + expected.map[c]]);
+    }
+    CHECK(matches);
+}
+
+TEST(out_applies_color_order_ranges)
+{
+    const char* path = "plugin_tests_ranges.ddpr";
+
+    // Pixel p is (10p + 1, 10p + 2, 10p + 3)
+    mock::MockCHOPInput input;
+    input.resize(1, 4 * 3);
+    for (int i = 0; i < 4 * 3; i++)
+        input.channel(0)[i] = static_cast<float>((i / 3) * 10 + i % 3 + 1);
+    mock::MockDATInput ranges;
+    ranges.setTable({ { "start", "count", "order" }, { "2", "1", "BGR" } });
+
+    {
+        mock::MockCHOPNode out;
+        CHECK(createNode(out, DDP_OUT_PLUGIN_PATH, "/test/ddpout1"));
+        out.setPar("Ipaddress", std::string("127.0.0.1"));
+        out.setPar("Port", kTestPort);
+        out.setPar("Valuerange", std::string("0-255"));
+        out.setPar("Record", 1);
+        out.setPar("Recordfile", std::string(path));
+        out.setPar("Colororder", std::string("GRB"));
+        out.setParDAT("Rangesdat", &ranges);
+        out.connectInput(&input);
+        out.cook();
+        CHECK(out.infoEntry("Ranges") == "1 range");
+
+        // A range order the pixels cannot have is reported and falls back to input order
+        ranges.setTable({ { "start", "count", "order" }, { "2", "1", "RGBW" } });
+        out.cook();
+        CHECK(out.infoEntry("Last Error").find("RGBW") != std::string::npos);
+        CHECK(out.infoEntry("Ranges") == "off");
+        out.setPar("Record", 0);
+        out.cook();
+    }
+
+    ddp::RecordingReader reader;
+    CHECK(reader.open(path));
+    std::vector<uint8_t> frame;
+    CHECK(reader.recordCount() == 2);
+    CHECK(reader.readFrame(0, frame));
+    const uint8_t ordered[] = { 2, 1, 3,  12, 11, 13,  23, 22, 21,  32, 31, 33 };
+    CHECK(frame.size() == sizeof(ordered) && memcmp(frame.data(), ordered, sizeof(ordered)) == 0);
+    CHECK(reader.readFrame(1, frame));
+    const uint8_t unchanged[] = { 1, 2, 3,  11, 12, 13,  21, 22, 23,  31, 32, 33 };
+    CHECK(frame.size() == sizeof(unchanged) && memcmp(frame.data(), unchanged, sizeof(unchanged)) == 0);
+    reader.close();
+    remove(path);
+}
+
+TEST(temporal_dither)
+{
+    // The high byte of a 16-bit level is the 8-bit conversion
+    std::vector<float> samples;
+    for (int i = 0; i <= 1000; i++)
+        samples.push_back(i / 1000.0f * 1.1f - 0.05f);
+    std::vector<uint8_t> bytes(samples.size());
+    std::vector<uint16_t> levels(samples.size());
+    for (float gamma : { 1.0f, 2.2f })
+    {
+        ddp::ConvertSettings settings;
+        settings.gamma = gamma;
+        settings.brightness = 0.8f;
+        ddp::convertSamples(samples.data(), samples.size(), settings, bytes.data());
+        ddp::convertSamples16(samples.data(), samples.size(), settings, levels.data());
+        bool same = true;
+        for (size_t i = 0; i < samples.size(); i++)
+            same = same && (levels[i] >> 8) == bytes[i];
+        CHECK(same);
+    }
+    
+    // Over 256 frames every byte averages its level exactly; black and full never flicker
+    const uint16_t frameLevels[] = { 0, 255 * 256, 10 * 256 + 64, 10 * 256 + 64, 100 * 256 + 255 };
+    const size_t count = sizeof(frameLevels) / sizeof(frameLevels[0]);
+    uint8_t error[count];
+    ddp::seedDitherError(error, count);
+    CHECK(error[2] != error[3]);
+    uint32_t sums[count] = {};
+    bool steady = true;
+    for (int frame = 0; frame < 256; frame++)
+    {
+        uint8_t out[count];
+        ddp::ditherLevels(frameLevels, count, error, out);
+        steady = steady && out[0] == 0 && out[1] == 255 && (out[2] == 10 || out[2] == 11);
+        for (size_t i = 0; i < count; i++)
+            sums[i] += out[i];
+    }
+    CHECK(steady);
+    for (size_t i = 0; i < count; i++)
+        CHECK(sums[i] == frameLevels[i]);
+    
+    // Whole levels come out of the dithered runs exactly as without dithering,
+    // flipped and reordered the same way
+    ddp::ConvertSettings whole;
+    whole.normalizedInput = false;
+    std::vector<float> pixels;
+    for (int i = 0; i < 6 * 3; i++)
+        pixels.push_back(static_cast<float>(i * 7));
+    ddp::ColorOrder orders[2];
+    std::string message;
+    CHECK(ddp::parseColorOrder("GRB", 3, orders[1], message));
+    const ddp::LayoutRun runs[] = { { 0, 3, 1, 0 }, { 0, 2, 0, 0 }, { 3, 3, -1, 1 } };
+    std::vector<uint8_t> plain(8 * 3), dithered(8 * 3);
+    std::vector<uint8_t> state(dithered.size());
+    ddp::seedDitherError(state.data(), state.size());
+    std::vector<uint8_t> seeded = state;
+    ddp::convertRuns(pixels.data(), runs, 3, 3, whole, plain.data(), orders);
+    ddp::convertRuns(pixels.data(), runs, 3, 3, whole, dithered.data(), orders, state.data());
+    CHECK(plain == dithered && state == seeded);
+    const uint32_t indices[] = { 5, DDP_LAYOUT_BLANK, 0 };
+    ddp::convertGathered(pixels.data(), indices, 3, 3, whole, plain.data(), &orders[1]);
+    ddp::convertGathered(pixels.data(), indices, 3, 3, whole, dithered.data(), &orders[1], state.data());
+    CHECK(plain == dithered && state == seeded);
+    
+    // A fraction is carried in the state the runs are given
+    const float quarter[] = { 10.25f, 10.25f, 10.25f };
+    const ddp::LayoutRun single[] = { { 0, 1, 1, 0 } };
+    uint8_t carried[3] = { 0, 0, 0 };
+    uint8_t out[3];
+    ddp::convertRuns(quarter, single, 1, 3, whole, out, nullptr, carried);
+    CHECK(out[0] == 10 && carried[0] == 64);
+    carried[1] = 200;
+    ddp::convertRuns(quarter, single, 1, 3, whole, out, nullptr, carried);
+    CHECK(out[0] == 10 && carried[0] == 128 && out[1] == 11 && carried[1] == 8);
+}
+
+TEST(out_dithers_temporally)
+{
+    const char* path = "plugin_tests_dither.ddpr";
+    const int frames = 64;
+    
+    // 51 * 0.25 = 12.75: a steady output would send 12 for ever
+    mock::MockCHOPInput input;
+    input.resize(1, 2 * 3);
+    for (int i = 0; i < 2 * 3; i++)
+        input.channel(0)[i] = i < 3 ? 51.0f : 0.0f;
+    
+    {
+        mock::MockCHOPNode out;
+        CHECK(createNode(out, DDP_OUT_PLUGIN_PATH, "/test/ddpout1"));
+        out.setPar("Ipaddress", std::string("127.0.0.1"));
+        out.setPar("Port", kTestPort);
+        out.setPar("Valuerange", std::string("0-255"));
+        out.setPar("Brightness", 0.25);
+        out.setPar("Dither", std::string("temporal"));
+        out.setPar("Record", 1);
+        out.setPar("Recordfile", std::string(path));
+        out.connectInput(&input);
+        for (int i = 0; i < frames; i++)
+            out.cook();
+        out.setPar("Record", 0);
+        out.cook();
+    }
+    
+    ddp::RecordingReader reader;
+    CHECK(reader.open(path));
+    CHECK(reader.recordCount() == static_cast<size_t>(frames));
+    uint32_t sums[3] = {};
+    bool steady = true;
+    std::vector<uint8_t> frame;
+    for (int i = 0; i < frames && reader.readFrame(static_cast<size_t>(i), frame); i++)
+    {
+        for (int c = 0; c < 3; c++)
+        {
+            steady = steady && (frame[c] == 12 || frame[c] == 13);
+            sums[c] += frame[c];
+        }
+        steady = steady && frame[3] == 0 && frame[4] == 0 && frame[5] == 0;
+    }
+    CHECK(steady);
+    for (int c = 0; c < 3; c++)
+        CHECK(sums[c] == 12 * frames + frames * 3 / 4);
+    reader.close();
+    remove(path);
+}
+
+TEST(wide_output)
+{
+    // Full scale is 65535, written big-endian
+    const float samples[] = { 0.0f, 1.0f, 0.5f, 2.0f, -1.0f, 128.0f / 255.0f };
+    uint8_t wide[12];
+    ddp::ConvertSettings settings;
+    ddp::convertSamplesBE16(samples, 6, settings, wide);
+    const uint8_t expected[] = { 0x00, 0x00, 0xFF, 0xFF, 0x7F, 0xFF, 0xFF, 0xFF, 0x00, 0x00, 0x80, 0x80 };
+    CHECK(memcmp(wide, expected, sizeof(expected)) == 0);
+    float back[6];
+    ddp::convertBE16ToSamples(wide, 6, false, back);
+    CHECK(back[1] == 255.0f && back[5] == 128.0f);
+    ddp::convertBE16ToSamples(wide, 6, true, back);
+    CHECK(back[0] == 0.0f && back[1] == 1.0f);
+    
+    // Runs flip and reorder 16-bit pixels the same way as bytes
+    ddp::ConvertSettings whole;
+    whole.normalizedInput = false;
+    std::vector<float> pixels;
+    for (int i = 0; i < 4 * 3; i++)
+        pixels.push_back(static_cast<float>(i * 10));
+    ddp::ColorOrder orders[2];
+    std::string error;
+    CHECK(ddp::parseColorOrder("GRB", 3, orders[1], error));
+    const ddp::LayoutRun runs[] = { { 0, 1, 1, 0 }, { 0, 1, 0, 0 }, { 1, 3, -1, 1 } };
+    std::vector<uint8_t> bytes(5 * 3), words(5 * 3 * 2);
+    ddp::convertRuns(pixels.data(), runs, 3, 3, whole, bytes.data(), orders);
+    whole.wideOutput = true;
+    ddp::convertRuns(pixels.data(), runs, 3, 3, whole, words.data(), orders);
+    bool same = true;
+    for (size_t i = 0; i < bytes.size(); i++)
+        same = same && words[2 * i] == bytes[i] && words[2 * i + 1] == bytes[i];
+    CHECK(same);
+    const uint32_t indices[] = { 3, DDP_LAYOUT_BLANK, 0 };
+    ddp::convertGathered(pixels.data(), indices, 3, 3, whole, words.data(), &orders[1]);
+    CHECK(ddp::readBE16(&words[0]) == 100 * 257 && ddp::readBE16(&words[2]) == 90 * 257 && ddp::readBE16(&words[6]) == 0);
+}
+
+TEST(loopback_16bit)
+{
+    const char* path = "plugin_tests_wide.ddpr";
+    mock::MockCHOPNode out;
+    mock::MockCHOPNode in;
+    CHECK(createNode(out, DDP_OUT_PLUGIN_PATH, "/test/ddpout1"));
+    CHECK(createNode(in, DDP_IN_PLUGIN_PATH, "/test/ddpin1"));
+    
+    out.setPar("Ipaddress", std::string("127.0.0.1"));
+    out.setPar("Port", kTestPort);
+    out.setPar("Bitdepth", std::string("16"));
+    out.setPar("Maxpayload", 1000);
+    out.setPar("Record", 1);
+    out.setPar("Recordmode", std::string("packets"));
+    out.setPar("Recordfile", std::string(path));
+    in.setPar("Port", kTestPort);
+    in.setPar("Bindinterface", std::string("127.0.0.1"));
+    
+    // 500 RGB pixels at 6 bytes each: 996-byte packets keep pixels whole
+    const int32_t numSamples = 1500;
+    mock::MockCHOPInput input;
+    input.resize(1, numSamples);
+    for (int32_t i = 0; i < numSamples; i++)
+        input.channel(0)[i] = static_cast<float>(i) / (numSamples - 1);
+    out.connectInput(&input);
+    
+    mock::CookDriver driver(60.0, false);
+    driver.add(&in);
+    driver.add(&out);
+    
+    bool matched = false;
+    for (int attempt = 0; attempt < 200 && !matched; attempt++)
+    {
+        driver.step();
+        in.cook();
+        matched = in.numSamples() == numSamples;
+        for (int32_t i = 0; matched && i < numSamples; i++)
+            matched = std::fabs(in.channel(4)[i] - input.channel(0)[i]) <= 1.0f / 65535.0f + 1e-6f;
+    }
+    CHECK(matched);
+    CHECK(in.channel(3)[0] == numSamples / 3.0f);
+    CHECK(in.infoEntry("Bit Depth") == "16-bit");
+    CHECK(out.infoEntry("Data Type") == "0x0C (16-bit)");
+    out.setPar("Record", 0);
+    out.cook();
+    
+    ddp::RecordingReader reader;
+    CHECK(reader.open(path));
+    CHECK(reader.recordCount() >= 4);
+    bool whole = true;
+    for (size_t i = 0; i < 4 && i < reader.recordCount(); i++)
+    {
+        const uint8_t* packet = nullptr;
+        size_t length = 0;
+        ddp::PacketHeader header;
+        const uint8_t* payload = nullptr;
+        whole = whole && reader.readPacket(i, packet, length) && ddp::unpackHeader(packet, length, header, payload) &&
+                header.dataType == DDP_DATA_TYPE_RGB16 && header.length % 6 == 0 && header.offset % 6 == 0;
+    }
+    CHECK(whole);
+    reader.close();
+    remove(path);
+}
+
+TEST(color_calibration)
+{
+    float values[9] = { 0 };
+    std::string error;
+    CHECK(ddp::parseCalibrationValues("1 0 0, 0 1 0; 0 0 1", values, 9, false, error) && values[4] == 1.0f);
+    CHECK(ddp::parseCalibrationValues("0.5", values, 4, true, error) && values[0] == 0.5f && values[3] == 0.5f);
+    CHECK(ddp::parseCalibrationValues("", values, 4, true, error) && values[0] == 0.5f);
+    CHECK(!ddp::parseCalibrationValues("1 2", values, 4, true, error));
+    CHECK(!ddp::parseCalibrationValues("0.5", values, 9, false, error));
+    CHECK(!ddp::parseCalibrationValues("1 0 x", values, 3, false, error));
+    ddp::CalibrationSettings calibration;
+    CHECK(calibration.isIdentity() && ddp::validateCalibration(calibration, error));
+    calibration.matrix[1] = 5.0f;
+    CHECK(!ddp::validateCalibration(calibration, error));
+    calibration = ddp::CalibrationSettings();
+    calibration.white = 1.5f;
+    CHECK(!ddp::validateCalibration(calibration, error));
+    
+    auto near = [](const uint8_t* bytes, std::initializer_list<int> expected) {
+        for (int value : expected)
+        {
+            if (std::abs(*bytes++ - value) > 1)
+                return false;
+        }
+        return true;
+    };
+    
+    // R and B swapped, G at half gain, R lifted by 0.1; only the second range is calibrated
+    std::vector<ddp::CalibrationSettings> settings(2);
+    CHECK(ddp::parseCalibrationValues("0 0 1 0 1 0 1 0 0", settings[1].matrix, 9, false, error));
+    settings[1].gain[1] = 0.5f;
+    settings[1].offset[0] = 0.1f;
+    std::vector<ddp::CalibrationKernel> kernels(2);
+    for (size_t i = 0; i < 2; i++)
+        ddp::compileCalibration(settings[i], 1.0f, 1.0f / 255.0f, 3, 3, kernels[i]);
+    CHECK(!kernels[0].active && kernels[1].active);
+    const float rgb[] = { 255, 200, 0,  255, 200, 0 };
+    const std::vector<ddp::LayoutRun> runs = { { 0, 1, 1, 0 }, { 1, 1, 1, 1 } };
+    ddp::ConvertSettings convert;
+    convert.normalizedInput = false;
+    uint8_t bytes[6];
+    ddp::convertRuns(rgb, runs.data(), runs.size(), 3, convert, bytes, nullptr, nullptr, kernels.data());
+    CHECK(bytes[0] == 255 && bytes[1] == 200 && bytes[2] == 0);
+    CHECK(near(bytes + 3, { 25, 100, 255 }));
+    
+    // White extraction: RGB in, RGBW out, min(R, G, B) moves to W
+    settings[0].white = 1.0f;
+    ddp::compileCalibration(settings[0], 1.0f, 1.0f, 3, 4, kernels[0]);
+    CHECK(kernels[0].active);
+    const float white[] = { 1.0f, 0.5f, 0.25f };
+    const uint32_t index = 0;
+    convert.normalizedInput = true;
+    ddp::convertGathered(white, &index, 1, 4, convert, bytes, nullptr, nullptr, &kernels[0]);
+    CHECK(near(bytes, { 191, 63, 0, 63 }));
+    
+    // Fixed-point TOP sampling against the float path over random texels
+    const uint32_t width = 64, height = 64;
+    std::vector<uint8_t> texture(width * height * 4);
+    uint32_t seed = 12345;
+    for (uint8_t& byte : texture)
+    {
+        seed = seed * 1664525u + 1013904223u;
+        byte = static_cast<uint8_t>(seed >> 24);
+    }
+    std::vector<ddp::MapPoint> points;
+    std::vector<float> samples;
+    for (uint32_t i = 0; i < width * height; i++)
+    {
+        points.push_back({ static_cast<float>(i % width), static_cast<float>(i / width) });
+        for (int c : { 2, 1, 0 })
+            samples.push_back(texture[i * 4 + c] / 255.0f);
+    }
+    ddp::PixelMap map;
+    map.setPoints(points, ddp::MapUnits::Pixels);
+    map.compile(width, height);
+    
+    ddp::CalibrationSettings warm;
+    CHECK(ddp::parseCalibrationValues("0.9 0.1 0  0.05 0.9 0.05  0 0.2 0.8", warm.matrix, 9, false, error));
+    CHECK(ddp::parseCalibrationValues("1 0.9 0.8 1", warm.gain, 4, false, error));
+    CHECK(ddp::parseCalibrationValues("0.01", warm.offset, 4, true, error));
+    warm.white = 0.5f;
+    for (float gamma : { 1.0f, 2.2f })
+    {
+        convert.gamma = gamma;
+        uint8_t lut[DDP_CAL_LUT_SIZE];
+        ddp::buildLinearLUT(convert, lut);
+        ddp::CalibrationKernel kernel;
+        ddp::compileCalibration(warm, 0.8f, 1.0f, 3, 4, kernel);
+        std::vector<uint8_t> reference(points.size() * 4);
+        std::vector<uint8_t> fixed(points.size() * 4);
+        const ddp::LayoutRun all = { 0, static_cast<uint32_t>(points.size()), 1, 0 };
+        ddp::convertRuns(samples.data(), &all, 1, 4, convert, reference.data(), nullptr, nullptr, &kernel);
+        map.sampleCalibrated(texture.data(), 0, points.size(), kernel, lut, 4, fixed.data());
+        
+        // 1/16 of a texel step is below a level except on the steep start of the gamma curve
+        int worst = 0;
+        for (size_t i = 0; i < fixed.size(); i++)
+        {
+            if (gamma == 1.0f || reference[i] >= 32)
+                worst = std::max(worst, std::abs(fixed[i] - reference[i]));
+        }
+        CHECK(worst <= 1);
+        
+        // Uncalibrated texels land exactly on the plain table, alpha as W
+        uint8_t byteLUT[256];
+        ddp::buildByteLUT(convert, byteLUT);
+        ddp::compileCalibration(ddp::CalibrationSettings(), 1.0f, 1.0f, 4, 4, kernel);
+        map.sampleBGRA8(texture.data(), byteLUT, 4, reference.data());
+        map.sampleCalibrated(texture.data(), 0, points.size(), kernel, lut, 4, fixed.data());
+        CHECK(fixed == reference);
+        
+        // A color order is applied as the values are written
+        ddp::ColorOrder order;
+        CHECK(ddp::parseColorOrder("WBGR", 4, order, error));
+        ddp::reorderChannels(reference.data(), points.size(), 4, order);
+        map.sampleCalibrated(texture.data(), 0, points.size(), kernel, lut, 4, fixed.data(), &order);
+        CHECK(fixed == reference);
+    }
+}
+
+TEST(out_applies_calibration)
+{
+    const char* path = "plugin_tests_calibration.ddpr";
+    
+    // RGB in, RGBW out: pixel 0 through the output's calibration, pixel 1 through its range's
+    mock::MockCHOPInput input;
+    input.resize(1, 2 * 3);
+    const float rgb[] = { 200, 100, 50,  10, 20, 30 };
+    memcpy(input.channel(0), rgb, sizeof(rgb));
+    mock::MockDATInput ranges;
+    ranges.setTable({ { "start", "count", "gain", "white" }, { "1", "1", "2", "0" } });
+    
+    {
+        mock::MockCHOPNode out;
+        CHECK(createNode(out, DDP_OUT_PLUGIN_PATH, "/test/ddpout1"));
+        out.setPar("Ipaddress", std::string("127.0.0.1"));
+        out.setPar("Port", kTestPort);
+        out.setPar("Valuerange", std::string("0-255"));
+        out.setPar("Channelsperpixel", 4);
+        out.setPar("Whiteextraction", 1.0);
+        out.setPar("Offset", 4.0 / 255.0, 3);
+        out.setPar("Record", 1);
+        out.setPar("Recordfile", std::string(path));
+        out.setParDAT("Rangesdat", &ranges);
+        out.connectInput(&input);
+        out.cook();
+        CHECK(out.infoEntry("Calibration") == "output + 1 range, white from RGB");
+        
+        // White extraction needs a W channel to extract into
+        out.setPar("Channelsperpixel", 3);
+        out.cook();
+        CHECK(out.infoEntry("Last Error").find("White Extraction") != std::string::npos);
+        CHECK(out.infoEntry("Calibration") == "off");
+        out.setPar("Record", 0);
+        out.cook();
+    }
+    
+    ddp::RecordingReader reader;
+    CHECK(reader.open(path));
+    std::vector<uint8_t> frame;
+    CHECK(reader.recordCount() == 2);
+    CHECK(reader.readFrame(0, frame));
+    const uint8_t calibrated[] = { 150, 50, 0, 54,  20, 40, 60, 4 };
+    CHECK(frame.size() == sizeof(calibrated));
+    bool matches = true;
+    for (size_t i = 0; i < sizeof(calibrated); i++)
+        matches = matches && std::abs(frame[i] - calibrated[i]) <= 1;
+    CHECK(matches);
+    CHECK(reader.readFrame(1, frame));
+    const uint8_t unchanged[] = { 200, 100, 50,  10, 20, 30 };
+    CHECK(frame.size() == sizeof(unchanged) && memcmp(frame.data(), unchanged, sizeof(unchanged)) == 0);
+    reader.close();
+    remove(path);
+}
+
+TEST(power_limiter)
+{
+    // Sums are per wire position and taken before the scale
+    uint8_t bytes[] = { 200, 100, 50, 10,  100, 50, 0, 255 };
+    ddp::RangePower power;
+    power.scale = DDP_POWER_SCALE_ONE / 2;
+    ddp::meterPixels(bytes, 2, 4, power);
+    CHECK(power.sums[0] == 300 && power.sums[1] == 150 && power.sums[2] == 50 && power.sums[3] == 265);
+    const uint8_t halved[] = { 100, 50, 25, 5,  50, 25, 0, 127 };
+    CHECK(memcmp(bytes, halved, sizeof(halved)) == 0);
+    const float milliamps[DDP_POWER_CHANNELS] = { 20.0f, 20.0f, 20.0f, 0.0f };
+    CHECK(std::fabs(ddp::estimateAmps(power, milliamps, 255.0) - 500.0 * 20.0 / 255.0 / 1000.0) < 1e-9);
+    
+    // Attack at once, release with the time constant
+    ddp::PowerLimiter limiter;
+    limiter.update(10.0, 5.0, 0.016, 1.0);
+    CHECK(limiter.scale() == 0.5f);
+    limiter.update(2.0, 5.0, 1.0, 1.0);
+    CHECK(std::fabs(limiter.scale() - (0.5f + 0.5f * (1.0f - std::exp(-1.0f)))) < 1e-5f);
+    limiter.update(2.0, 0.0, 0.0, 0.0);
+    CHECK(limiter.scale() == 1.0f && limiter.fixedScale() == DDP_POWER_SCALE_ONE);
+    
+    // Metered in the conversion pass: the second range is limited, the first is not, at 8 and 16 bits
+    const std::vector<ddp::LayoutRun> runs = { { 0, 1000, 1, 0 }, { 1000, 1000, 1, 1 } };
+    std::vector<float> samples(2000 * 3, 1.0f);
+    for (bool wide : { false, true })
+    {
+        ddp::ConvertSettings settings;
+        settings.wideOutput = wide;
+        std::vector<ddp::RangePower> ranges(2);
+        ranges[1].scale = DDP_POWER_SCALE_ONE / 4;
+        std::vector<uint8_t> frame(samples.size() * (wide ? 2 : 1));
+        ddp::convertRuns(samples.data(), runs.data(), runs.size(), 3, settings, frame.data(), nullptr, nullptr,
+                         nullptr, ranges.data());
+        const uint64_t full = wide ? 65535 : 255;
+        CHECK(ranges[0].sums[0] == 1000 * full && ranges[1].sums[2] == 1000 * full && ranges[1].sums[3] == 0);
+        if (wide)
+            CHECK(frame[0] == 0xFF && frame[1] == 0xFF && frame[6000] == 0x3F && frame[6001] == 0xFF);
+        else
+            CHECK(frame[0] == 255 && frame[3000] == 63);
+    }
+}
+
+TEST(out_limits_power)
+{
+    const char* path = "plugin_tests_power.ddpr";
+    
+    // 10 white RGB pixels at 60 mA each; the first 4 are a range without a limit
+    mock::MockCHOPInput input;
+    input.resize(1, 10 * 3);
+    for (int i = 0; i < 10 * 3; i++)
+        input.channel(0)[i] = 1.0f;
+    mock::MockDATInput ranges;
+    ranges.setTable({ { "name", "start", "count", "budget" }, { "left", "0", "4", "0" } });
+    
+    {
+        mock::MockCHOPNode out;
+        CHECK(createNode(out, DDP_OUT_PLUGIN_PATH, "/test/ddpout1"));
+        out.setPar("Ipaddress", std::string("127.0.0.1"));
+        out.setPar("Port", kTestPort);
+        out.setPar("Powerlimit", 1);
+        out.setPar("Powerbudget", 0.18);
+        out.setPar("Limiterrelease", 10.0);
+        out.setPar("Record", 1);
+        out.setPar("Recordfile", std::string(path));
+        out.setParDAT("Rangesdat", &ranges);
+        out.connectInput(&input);
+        
+        // The limiter acts on the frame after the one that went over
+        out.cook();
+        CHECK(std::fabs(out.infoChannel("power_amps") - 0.36f) < 1e-4f);
+        CHECK(std::fabs(out.infoChannel("power_limited_amps") - 0.36f) < 1e-4f);
+        CHECK(std::fabs(out.infoChannel("power_left_amps") - 0.24f) < 1e-4f);
+        out.cook();
+        CHECK(std::fabs(out.infoChannel("power_limited_amps") - 0.18f) < 1e-4f);
+        CHECK(std::fabs(out.infoChannel("power_left_limited_amps") - 0.24f) < 1e-4f);
+        CHECK(out.infoEntry("Power") == "0.60 A estimated, 0.42 A sent");
+        out.setPar("Record", 0);
+        out.cook();
+    }
+    
+    ddp::RecordingReader reader;
+    CHECK(reader.open(path));
+    std::vector<uint8_t> frame;
+    CHECK(reader.recordCount() == 2);
+    CHECK(reader.readFrame(0, frame) && frame.size() == 30 && frame[29] == 255);
+    CHECK(reader.readFrame(1, frame) && frame.size() == 30);
+    CHECK(frame[0] == 255 && frame[11] == 255 && frame[12] == 127 && frame[29] == 127);
+    reader.close();
+    remove(path);
+}
+
+TEST(frame_smoothing)
+{
+    // Frames 40 ms apart, blended one period behind, 8-bit values
+    std::vector<uint8_t> a(3, 0);
+    std::vector<uint8_t> b(3, 200);
+    ddp::FrameSmoother smoother;
+    ddp::SmoothSettings settings;
+    settings.interpolate = true;
+    smoother.push(a, 10.0, true);
+    CHECK(!smoother.weights(10.02, settings).blended);
+    smoother.push(b, 10.04, true);
+    CHECK(std::fabs(smoother.period() - 0.04) < 1e-9);
+    ddp::SmoothWeights weights = smoother.weights(10.05, settings);
+    CHECK(weights.blended && std::fabs(weights.previous - 0.75f) < 1e-5f && std::fabs(weights.current - 0.25f) < 1e-5f);
+    CHECK(std::fabs(weights.age - 0.01) < 1e-9);
+    float samples[3];
+    ddp::blendSamples(smoother.previousFrame().data(), smoother.currentFrame().data(), 3, 1, weights.previous,
+                      weights.current, samples);
+    CHECK(std::fabs(samples[2] - 50.0f) < 1e-3f);
+    CHECK(smoother.weights(10.2, settings).current == 1.0f);
+    
+    // A second frame in the same read replaces the newest; the period follows the intervals
+    smoother.push(a, 10.08, true);
+    smoother.push(b, 10.0805, true);
+    CHECK(smoother.currentFrame()[0] == 200 && smoother.previousFrame()[0] == 200);
+    CHECK(std::fabs(smoother.period() - 0.04) < 1e-9);
+    
+    // Frames that were not kept, a size change or a long gap are not blended
+    smoother.push(a, 10.12, false);
+    CHECK(!smoother.weights(10.13, settings).blended);
+    smoother.push(b, 10.16, true);
+    CHECK(!smoother.weights(10.17, settings).blended);
+    smoother.push(std::vector<uint8_t>(6, 0), 10.2, true);
+    CHECK(!smoother.weights(10.21, settings).blended);
+    smoother.push(a, 12.0, true);
+    smoother.push(b, 12.04, true);
+    CHECK(smoother.weights(12.05, settings).blended);
+    smoother.push(a, 14.0, true);
+    CHECK(smoother.period() == 0.0 && !smoother.weights(14.01, settings).blended);
+    
+    // Hold, then a linear fade to black
+    settings.interpolate = false;
+    settings.holdTime = 1.0;
+    settings.fadeTime = 0.5;
+    CHECK(smoother.weights(14.9, settings).fade == 1.0f);
+    weights = smoother.weights(15.25, settings);
+    CHECK(std::fabs(weights.fade - 0.5f) < 1e-5f && weights.current == weights.fade && weights.previous == 0.0f);
+    CHECK(smoother.weights(15.6, settings).fade == 0.0f);
+    settings.fadeTime = 0.0;
+    CHECK(smoother.weights(15.01, settings).fade == 0.0f);
+    
+    // Big-endian 16-bit values
+    const uint8_t wide[] = { 0xFF, 0xFF, 0x80, 0x00 };
+    ddp::blendSamples(nullptr, wide, 2, 2, 0.0f, 1.0f / 65535.0f, samples);
+    CHECK(samples[0] == 1.0f && std::fabs(samples[1] - 32768.0f / 65535.0f) < 1e-6f);
+}
+
+TEST(in_smooths_frames)
+{
+    mock::MockCHOPNode out;
+    mock::MockCHOPNode in;
+    CHECK(createNode(out, DDP_OUT_PLUGIN_PATH, "/test/ddpout1"));
+    CHECK(createNode(in, DDP_IN_PLUGIN_PATH, "/test/ddpin1"));
+    out.setPar("Ipaddress", std::string("127.0.0.1"));
+    out.setPar("Port", kTestPort);
+    in.setPar("Port", kTestPort);
+    in.setPar("Bindinterface", std::string("127.0.0.1"));
+    in.setPar("Interpolate", 1);
+    in.setPar("Holdtime", 0.3);
+    in.setPar("Fadetime", 0.2);
+    
+    mock::MockCHOPInput input;
+    input.resize(1, 30);
+    std::fill(input.channel(0), input.channel(0) + 30, 0.2f);
+    out.connectInput(&input);
+    
+    // The first frame (sent until the address has resolved), once DDP In has sized its output for it
+    bool received = false;
+    for (int attempt = 0; attempt < 200 && !received; attempt++)
+    {
+        out.cook();
+        in.cook();
+        received = in.numSamples() == 30 && std::fabs(in.channel(4)[0] - 0.2f) < 1e-3f;
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    CHECK(received);
+    
+    // The second frame starts from the first and reaches itself one frame period later
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    std::fill(input.channel(0), input.channel(0) + 30, 0.8f);
+    out.cook();
+    received = false;
+    for (int attempt = 0; attempt < 200 && !received; attempt++)
+    {
+        in.cook();
+        received = in.channel(5)[0] < 0.02f;
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    CHECK(received);
+    CHECK(in.channel(4)[0] < 0.5f);
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    in.cook();
+    CHECK(std::fabs(in.channel(4)[29] - 0.8f) < 1e-3f);
+    CHECK(in.channel(5)[0] >= 0.1f && in.infoChannel("frame_age") == in.channel(5)[0]);
+    
+    // Packets stopped: held for 0.3 s, black 0.2 s after that
+    std::this_thread::sleep_for(std::chrono::milliseconds(450));
+    in.cook();
+    CHECK(in.channel(4)[0] == 0.0f && in.channel(4)[29] == 0.0f);
+    CHECK(in.infoEntry("Smoothing").find("(black)") != std::string::npos);
+    
+    // A new frame brings the output back at once
+    out.cook();
+    received = false;
+    for (int attempt = 0; attempt < 200 && !received; attempt++)
+    {
+        in.cook();
+        received = in.channel(5)[0] < 0.1f;
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    CHECK(received);
+    CHECK(in.channel(4)[0] > 0.0f);
+}
+
+TEST(frame_ring)
+{
+    ddp::FrameRing ring;
+    ring.reset(3);
+    CHECK(ring.capacity() == 3 && ring.size() == 0);
+    for (uint8_t i = 1; i <= 5; i++)
+    {
+        const uint8_t frame[] = { i, static_cast<uint8_t>(i * 10) };
+        ring.push(frame, sizeof(frame), i * 0.5);
+    }
+    
+    // Oldest first, the first two were overwritten
+    CHECK(ring.size() == 3 && ring.pushed() == 5);
+    CHECK(ring.frame(0)[0] == 3 && ring.frame(2)[1] == 50 && ring.arrivalTime(2) == 2.5);
+    const uint8_t* storage = ring.frame(0);
+    
+    // Smaller frames reuse the slots, a bigger one starts over
+    const uint8_t small[] = { 7 };
+    ring.push(small, 1, 3.0);
+    CHECK(ring.frameBytes(2) == 1 && ring.frame(2)[0] == 7 && ring.frame(2) == storage);
+    const uint8_t big[] = { 1, 2, 3, 4 };
+    ring.push(big, 4, 3.5);
+    CHECK(ring.size() == 1 && ring.frameBytes(0) == 4 && ring.frame(0)[3] == 4);
+    
+    ring.reset(1000);
+    CHECK(ring.capacity() == DDP_HISTORY_MAX_FRAMES && ring.size() == 0 && ring.pushed() == 0);
+}
+
+TEST(in_outputs_frame_history)
+{
+    mock::MockCHOPNode out;
+    mock::MockCHOPNode in;
+    CHECK(createNode(out, DDP_OUT_PLUGIN_PATH, "/test/ddpout1"));
+    CHECK(createNode(in, DDP_IN_PLUGIN_PATH, "/test/ddpin1"));
+    out.setPar("Ipaddress", std::string("127.0.0.1"));
+    out.setPar("Port", kTestPort);
+    in.setPar("Port", kTestPort);
+    in.setPar("Bindinterface", std::string("127.0.0.1"));
+    in.setPar("History", std::string("cook"));
+    in.setPar("Historyframes", 4);
+    
+    mock::MockCHOPInput input;
+    input.resize(1, 30);
+    out.connectInput(&input);
+    auto send = [&](float value) {
+        std::fill(input.channel(0), input.channel(0) + 30, value);
+        out.cook();
+    };
+    
+    // Until the address has resolved and DDP In is sized for the frame
+    bool received = false;
+    for (int attempt = 0; attempt < 200 && !received; attempt++)
+    {
+        send(0.0f);
+        in.cook();
+        received = in.numSamples() == 30 && in.numChannels() == 6 + 1 + 4;
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    CHECK(received);
+    std::this_thread::sleep_for(std::chrono::milliseconds(5));
+    in.cook();
+    
+    // Three frames between two cooks all come out, oldest first
+    send(0.2f);
+    send(0.4f);
+    send(0.6f);
+    std::this_thread::sleep_for(std::chrono::milliseconds(5));
+    in.cook();
+    CHECK(in.channel(6)[0] == 3.0f && in.channelName(7) == "history_0");
+    CHECK(std::fabs(in.channel(7)[0] - 0.2f) < 1e-3f && std::fabs(in.channel(9)[29] - 0.6f) < 1e-3f);
+    CHECK(in.channel(10)[0] == 0.0f && std::fabs(in.channel(4)[0] - 0.6f) < 1e-3f);
+    in.cook();
+    CHECK(in.channel(6)[0] == 0.0f && in.channel(7)[0] == 0.0f);
+    
+    // More than the ring holds: the oldest are dropped and counted
+    for (int i = 1; i <= 6; i++)
+        send(i * 0.1f);
+    std::this_thread::sleep_for(std::chrono::milliseconds(5));
+    in.cook();
+    CHECK(in.channel(6)[0] == 4.0f && in.infoChannel("history_dropped") == 2.0f);
+    CHECK(std::fabs(in.channel(7)[0] - 0.3f) < 1.0f / 255.0f && std::fabs(in.channel(10)[0] - 0.6f) < 1.0f / 255.0f);
+    
+    // Last N frames stay until newer ones replace them
+    in.setPar("History", std::string("ring"));
+    in.setPar("Historyframes", 2);
+    send(0.8f);
+    std::this_thread::sleep_for(std::chrono::milliseconds(5));
+    in.cook();
+    send(0.9f);
+    std::this_thread::sleep_for(std::chrono::milliseconds(5));
+    in.cook();
+    in.cook();
+    CHECK(in.numChannels() == 6 + 1 + 2 && in.channel(6)[0] == 2.0f);
+    CHECK(std::fabs(in.channel(7)[0] - 0.8f) < 1.0f / 255.0f && std::fabs(in.channel(8)[0] - 0.9f) < 1.0f / 255.0f);
+    CHECK(in.infoEntry("History") == "last 2 frames: 2 held");
+    
+    // Frames held by the jitter buffer (20 ms) come due together; all of them reach the history
+    in.setPar("History", std::string("cook"));
+    in.setPar("Historyframes", 4);
+    in.setPar("Jitterbuffer", 1);
+    in.cook();
+    send(0.2f);
+    send(0.4f);
+    send(0.6f);
+    std::this_thread::sleep_for(std::chrono::milliseconds(5));
+    in.cook();
+    CHECK(in.channel(6)[0] == 0.0f && in.infoChannel("jitter_queue") == 3.0f);
+    std::this_thread::sleep_for(std::chrono::milliseconds(30));
+    in.cook();
+    CHECK(in.channel(6)[0] == 3.0f && in.infoChannel("history_dropped") == 0.0f);
+    CHECK(std::fabs(in.channel(7)[0] - 0.2f) < 1e-3f && std::fabs(in.channel(9)[0] - 0.6f) < 1e-3f);
+    CHECK(std::fabs(in.channel(4)[0] - 0.6f) < 1e-3f && in.infoChannel("frames_skipped") == 2.0f);
+}
+
+TEST(dmx_encoders)
+{
+    uint8_t header[DDP_SACN_HEADER_SIZE];
+    CHECK(ddp::writeArtDmxHeader(header, 0x1234, 7, 512) == DDP_ARTNET_HEADER_SIZE);
+    const uint8_t artDmx[] = { 'A', 'r', 't', '-', 'N', 'e', 't', 0, 0x00, 0x50, 0, 14, 7, 0, 0x34, 0x12, 0x02, 0x00 };
+    CHECK(memcmp(header, artDmx, sizeof(artDmx)) == 0);
+    
+    uint8_t cid[DDP_SACN_CID_SIZE];
+    ddp::makeSacnCid(cid);
+    CHECK((cid[6] & 0xF0) == 0x40 && (cid[8] & 0xC0) == 0x80);
+    CHECK(ddp::writeSacnHeader(header, cid, "ddp", 100, 513, 9, 510) == DDP_SACN_HEADER_SIZE);
+    CHECK(header[1] == 0x10 && memcmp(header + 4, "ASC-E1.17", 9) == 0 && header[21] == 0x04);
+    CHECK(header[16] == 0x72 && header[17] == 0x6C);        // 126 + 510 - 16 = 620
+    CHECK(header[38] == 0x72 && header[39] == 0x56 && header[43] == 0x02);
+    CHECK(memcmp(header + 22, cid, DDP_SACN_CID_SIZE) == 0 && strcmp(reinterpret_cast<char*>(header + 44), "ddp") == 0);
+    CHECK(header[108] == 100 && header[111] == 9 && header[113] == 0x02 && header[114] == 0x01);
+    CHECK(header[115] == 0x72 && header[116] == 0x09 && header[117] == 0x02 && header[118] == 0xA1);
+    CHECK(header[122] == 0x01 && header[123] == 0x01 && header[124] == 0xFF && header[125] == 0x00);
+    CHECK(ddp::sacnMulticastGroup(513) == "239.255.2.1");
+    CHECK(ddp::dmxSlotCount(ddp::DmxProtocol::ArtNet, 5) == 6 && ddp::dmxSlotCount(ddp::DmxProtocol::ArtNet, 1) == 2);
+    CHECK(ddp::dmxSlotCount(ddp::DmxProtocol::Sacn, 5) == 5);
+    
+    // Tables with or without a header, then validation
+    ddp::UniverseTableParser parser;
+    ddp::UniverseMap map;
+    const char* plain[] = { "30", "12", "4" };
+    CHECK(parser.parseRow(plain, 3, map) && map.offset == 30 && map.length == 12 && map.universe == 4 && map.channel == 1);
+    const char* names[] = { "universe", "channel", "offset", "length" };
+    CHECK(!parser.parseRow(names, 4, map));
+    const char* row[] = { "2", "7", "100", "3" };
+    CHECK(parser.parseRow(row, 4, map) && map.universe == 2 && map.channel == 7 && map.offset == 100);
+    
+    std::vector<ddp::UniverseMap> universes;
+    ddp::consecutiveUniverses(6, 3, 2, 510, universes);
+    universes.push_back(map);
+    std::string error;
+    CHECK(ddp::validateUniverses(universes, ddp::DmxProtocol::Sacn, error));
+    CHECK(universes[0].universe == 2 && universes[2].universe == 4 && universes[2].offset == 516);
+    universes[0].universe = 3;
+    CHECK(!ddp::validateUniverses(universes, ddp::DmxProtocol::Sacn, error) && error == "Universe 3 is mapped twice");
+    universes[0].universe = 0;
+    CHECK(!ddp::validateUniverses(universes, ddp::DmxProtocol::Sacn, error));
+    CHECK(ddp::validateUniverses(universes, ddp::DmxProtocol::ArtNet, error));
+    universes[1].channel = 4;
+    CHECK(!ddp::validateUniverses(universes, ddp::DmxProtocol::ArtNet, error));
+}
+
+TEST(in_forwards_dmx)
+{
+    mock::MockCHOPNode out;
+    mock::MockCHOPNode in;
+    CHECK(createNode(out, DDP_OUT_PLUGIN_PATH, "/test/ddpout1"));
+    CHECK(createNode(in, DDP_IN_PLUGIN_PATH, "/test/ddpin1"));
+    out.setPar("Ipaddress", std::string("127.0.0.1"));
+    out.setPar("Port", kTestPort);
+    in.setPar("Port", kTestPort);
+    in.setPar("Bindinterface", std::string("127.0.0.1"));
+    
+    ddp::UdpSocket receiver;
+    CHECK(receiver.open(AF_INET) && receiver.bindTo("127.0.0.1", kGatewayTestPort));
+    
+    // Aligned, offset by two channels (odd for Art-Net), and cut short by the 30-byte frame
+    mock::MockDATInput map;
+    map.setTable({ { "offset", "length", "universe", "channel" }, { "0", "6", "1", "1" }, { "6", "3", "2", "3" },
+                   { "24", "12", "3", "" } });
+    in.setPar("Gateway", std::string("artnet"));
+    in.setPar("Gatewayaddress", std::string("127.0.0.1"));
+    in.setPar("Gatewayport", kGatewayTestPort);
+    in.setParDAT("Gatewaydat", &map);
+    
+    mock::MockCHOPInput input;
+    input.resize(1, 30);
+    for (int i = 0; i < 30; i++)
+        input.channel(0)[i] = (i + 1) / 255.0f;
+    out.connectInput(&input);
+    
+    // The latest packet of each universe, keyed by the universe number
+    auto receive = [&](size_t headerSize, std::map<int, std::vector<uint8_t>>& packets) {
+        std::vector<uint8_t> buffer(1500);
+        struct sockaddr_storage from;
+        bool wouldBlock = false;
+        while (packets.size() < 3 && receiver.waitReadable(200))
+        {
+            int length = receiver.recvFrom(buffer.data(), buffer.size(), from, wouldBlock);
+            if (length < static_cast<int>(headerSize))
+                break;
+            int universe = headerSize == DDP_ARTNET_HEADER_SIZE ? buffer[14] | (buffer[15] << 8) :
+                           (buffer[113] << 8) | buffer[114];
+            packets[universe].assign(buffer.begin(), buffer.begin() + length);
+        }
+    };
+    
+    bool forwarded = false;
+    for (int attempt = 0; attempt < 200 && !forwarded; attempt++)
+    {
+        out.cook();
+        in.cook();
+        forwarded = in.infoChannel("gateway_frames") >= 1.0f;
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    CHECK(forwarded);
+    std::map<int, std::vector<uint8_t>> packets;
+    receive(DDP_ARTNET_HEADER_SIZE, packets);
+    CHECK(packets.size() == 3);
+    const std::vector<uint8_t> first = { 1, 2, 3, 4, 5, 6 };
+    const std::vector<uint8_t> second = { 0, 0, 7, 8, 9, 0 };
+    const std::vector<uint8_t> third = { 25, 26, 27, 28, 29, 30, 0, 0, 0, 0, 0, 0 };
+    CHECK(packets[1].size() == 18 + 6 && packets[1][17] == 6 && std::vector<uint8_t>(packets[1].begin() + 18, packets[1].end()) == first);
+    CHECK(packets[2].size() == 18 + 6 && std::vector<uint8_t>(packets[2].begin() + 18, packets[2].end()) == second);
+    CHECK(packets[3].size() == 18 + 12 && std::vector<uint8_t>(packets[3].begin() + 18, packets[3].end()) == third);
+    CHECK(packets[1][12] != 0 && memcmp(packets[1].data(), "Art-Net", 8) == 0);
+    in.cook();
+    CHECK(in.infoEntry("Gateway").find("Art-Net to 127.0.0.1, 3 universes") == 0);
+    
+    // sACN, two consecutive universes from byte 3 without a DAT
+    in.setParDAT("Gatewaydat", nullptr);
+    in.setPar("Gateway", std::string("sacn"));
+    in.setPar("Gatewayuniverse", 7);
+    in.setPar("Gatewayuniverses", 2);
+    in.setPar("Gatewaychannels", 9);
+    in.setPar("Gatewayoffset", 3);
+    in.cook();
+    while (receiver.waitReadable(50))
+    {
+        std::vector<uint8_t> buffer(1500);
+        struct sockaddr_storage from;
+        bool wouldBlock = false;
+        receiver.recvFrom(buffer.data(), buffer.size(), from, wouldBlock);
+    }
+    out.cook();
+    std::this_thread::sleep_for(std::chrono::milliseconds(5));
+    in.cook();
+    packets.clear();
+    receive(DDP_SACN_HEADER_SIZE, packets);
+    CHECK(packets.size() == 2 && packets[7].size() == DDP_SACN_HEADER_SIZE + 9 && packets[8].size() == DDP_SACN_HEADER_SIZE + 9);
+    CHECK(packets[7][125] == 0 && packets[7][126] == 4 && packets[8][126] == 13 && packets[8][134] == 21);
+    CHECK(in.infoChannel("gateway_packets") == 2.0f);
+    
+    in.setPar("Gatewayuniverse", 0);
+    in.cook();
+    CHECK(in.infoEntry("Gateway") == "failed: Universe 0 is outside 1-63999");
+}
+
+TEST(range_transports)
+{
+    // 10 RGB pixels: an Art-Net range, a color order range that stays in the
+    // output's stream, and a DDP range with an address of its own
+    std::vector<ddp::PixelRange> ranges(3);
+    ranges[0].name = "dmx";
+    ranges[0].start = 2;
+    ranges[0].count = 3;
+    ranges[0].protocol = "Art-Net";
+    ranges[0].universe = "5";
+    ranges[0].channels = "6";
+    ranges[1].start = 5;
+    ranges[1].count = 1;
+    ranges[1].order = "GRB";
+    ranges[2].start = 8;
+    ranges[2].protocol = "ddp";
+    ranges[2].address = "10.0.0.9:4049";
+    std::vector<ddp::TransportRoute> routes;
+    std::vector<ddp::ByteSpan> spans;
+    std::string error;
+    CHECK(ddp::planTransports(ranges, 30, 3, routes, spans, error));
+    CHECK(routes.size() == 2 && spans.size() == 2);
+    CHECK(spans[0].offset == 0 && spans[0].length == 6 && spans[1].offset == 15 && spans[1].length == 9);
+    CHECK(routes[0].transport == ddp::Transport::ArtNet && routes[0].address.empty() && routes[0].universes.size() == 2);
+    CHECK(routes[0].universes[0].offset == 6 && routes[0].universes[1].universe == 6 && routes[0].universes[1].length == 3);
+    CHECK(routes[1].name == "3" && routes[1].address == "10.0.0.9" && routes[1].port == 4049);
+    CHECK(routes[1].bytes.offset == 24 && routes[1].bytes.length == 6);
+    
+    // By default universes hold whole pixels and start at the protocol's first
+    ranges.resize(1);
+    ranges[0].protocol = "e1.31";
+    ranges[0].universe = "";
+    ranges[0].channels = "";
+    ranges[0].count = 200;
+    CHECK(ddp::planTransports(ranges, 606, 3, routes, spans, error));
+    CHECK(routes[0].universes.size() == 2 && routes[0].universes[0].universe == 1);
+    CHECK(routes[0].universes[0].length == 510 && routes[0].universes[1].length == 90);
+    CHECK(spans.size() == 1 && spans[0].offset == 0 && spans[0].length == 6);
+    
+    ranges[0].protocol = "kinet";
+    CHECK(!ddp::planTransports(ranges, 606, 3, routes, spans, error) && error.find("'kinet'") != std::string::npos);
+    ranges[0].protocol = "artnet";
+    ranges[0].channels = "600";
+    CHECK(!ddp::planTransports(ranges, 606, 3, routes, spans, error) && error.find("'600'") != std::string::npos);
+    ranges[0].channels = "";
+    ranges[0].address = "10.0.0.9:99999";
+    CHECK(!ddp::planTransports(ranges, 606, 3, routes, spans, error) && error.find("port") != std::string::npos);
+    ranges[0].address = "10.0.0.9";
+    ranges.push_back(ranges[0]);
+    ranges[1].name = "overlap";
+    ranges[1].start = 300;
+    ranges[1].count = 0;
+    ranges[0].count = 10;
+    CHECK(!ddp::planTransports(ranges, 1200, 3, routes, spans, error) && error.find("also sent by") != std::string::npos);
+    ranges[1].address = "10.0.0.10";
+    CHECK(ddp::planTransports(ranges, 1200, 3, routes, spans, error) && routes.size() == 2);
+    
+    // Universes read the frame in place unless cut short or odd for Art-Net
+    std::vector<uint8_t> frame(30);
+    for (size_t i = 0; i < frame.size(); i++)
+        frame[i] = static_cast<uint8_t>(i + 1);
+    std::vector<ddp::UniverseMap> universes;
+    ddp::consecutiveUniverses(6, 5, 2, 6, universes);
+    universes[1].length = 3;
+    uint8_t cid[DDP_SACN_CID_SIZE] = {};
+    ddp::DmxSegmenter dmx;
+    dmx.setUniverses(ddp::DmxProtocol::ArtNet, universes, "", cid);
+    CHECK(dmx.segment(frame.data(), frame.size()) == 2 && dmx.padded() == 1 && dmx.extent() == 15);
+    const std::vector<ddp::SendSlice>& slices = dmx.slices();
+    CHECK(slices[0].payload == frame.data() + 6 && slices[0].payloadLength == 6 && slices[0].headerLength == 18);
+    CHECK(slices[0].header[12] == 1 && slices[0].header[14] == 5 && slices[0].header[17] == 6);
+    const uint8_t padded[] = { 13, 14, 15, 0 };
+    CHECK(!slices[1].payload && slices[1].headerLength == 18 + 4 && memcmp(slices[1].header + 18, padded, 4) == 0);
+    dmx.segment(frame.data(), frame.size());
+    CHECK(dmx.slices()[0].header[12] == 2 && dmx.slices()[1].header[12] == 2);
+    
+    // DDP spans keep their offsets, PUSH only goes on the very last packet
+    ddp::FrameSegmenter segmenter;
+    ddp::SegmentOptions options;
+    options.maxPayload = 6;
+    const ddp::ByteSpan parts[] = { { 0, 6 }, { 15, 9 } };
+    CHECK(segmenter.segment(frame.data(), parts, 2, options) == 3);
+    const uint32_t offsets[] = { 0, 15, 21 };
+    for (size_t i = 0; i < 3; i++)
+    {
+        const ddp::SendSlice& slice = segmenter.slices()[i];
+        std::vector<uint8_t> packet;
+        ddp::FrameSegmenter::flatten(slice, packet);
+        ddp::PacketHeader header;
+        const uint8_t* payload = nullptr;
+        CHECK(ddp::unpackHeader(packet.data(), packet.size(), header, payload));
+        CHECK(header.offset == offsets[i] && slice.payload == frame.data() + offsets[i]);
+        CHECK(((header.flags & DDP_FLAGS1_PUSH) != 0) == (i == 2));
+    }
+    CHECK(segmenter.slices()[2].payloadLength == 3);
+}
+
+TEST(out_sends_range_transports)
+{
+    mock::MockCHOPNode out;
+    mock::MockCHOPNode in;
+    CHECK(createNode(out, DDP_OUT_PLUGIN_PATH, "/test/ddpout1"));
+    CHECK(createNode(in, DDP_IN_PLUGIN_PATH, "/test/ddpin1"));
+    out.setPar("Ipaddress", std::string("127.0.0.1"));
+    out.setPar("Port", kTestPort);
+    in.setPar("Port", kTestPort);
+    in.setPar("Bindinterface", std::string("127.0.0.1"));
+    
+    ddp::UdpSocket receiver;
+    CHECK(receiver.open(AF_INET) && receiver.bindTo("127.0.0.1", kGatewayTestPort));
+    
+    // Pixels 2-4 go out as Art-Net, 8-9 as a DDP frame of their own, the rest to DDP In
+    std::string address = "127.0.0.1:" + std::to_string(kGatewayTestPort);
+    mock::MockDATInput ranges;
+    ranges.setTable({ { "name", "start", "count", "protocol", "address", "universe", "channels" },
+                      { "dmx", "2", "3", "artnet", address.c_str(), "5", "6" },
+                      { "side", "8", "0", "ddp", address.c_str(), "", "" } });
+    out.setParDAT("Rangesdat", &ranges);
+    
+    mock::MockCHOPInput input;
+    input.resize(1, 30);
+    for (int i = 0; i < 30; i++)
+        input.channel(0)[i] = (i + 1) / 255.0f;
+    out.connectInput(&input);
+    
+    bool received = false;
+    for (int attempt = 0; attempt < 200 && !received; attempt++)
+    {
+        out.cook();
+        in.cook();
+        received = in.numSamples() == 24;
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    CHECK(received);
+    bool matches = true;
+    for (int i = 0; i < 24; i++)
+    {
+        float expected = i < 6 || i >= 15 ? (i + 1) / 255.0f : 0.0f;
+        matches = matches && std::fabs(in.channel(4)[i] - expected) <= 1.0f / 255.0f + 1e-6f;
+    }
+    CHECK(matches);
+    
+    // Art-Net universes by number, the DDP range under -1
+    std::map<int, std::vector<uint8_t>> packets;
+    std::vector<uint8_t> buffer(1500);
+    struct sockaddr_storage from;
+    bool wouldBlock = false;
+    while (packets.size() < 3 && receiver.waitReadable(200))
+    {
+        int length = receiver.recvFrom(buffer.data(), buffer.size(), from, wouldBlock);
+        if (length <= 0)
+            break;
+        bool artNet = length >= DDP_ARTNET_HEADER_SIZE && memcmp(buffer.data(), "Art-Net", 8) == 0;
+        packets[artNet ? buffer[14] | (buffer[15] << 8) : -1].assign(buffer.begin(), buffer.begin() + length);
+    }
+    CHECK(packets.size() == 3);
+    const std::vector<uint8_t> first = { 7, 8, 9, 10, 11, 12 };
+    const std::vector<uint8_t> second = { 13, 14, 15, 0 };
+    CHECK(packets[5].size() == 18 + 6 && std::vector<uint8_t>(packets[5].begin() + 18, packets[5].end()) == first);
+    CHECK(packets[6].size() == 18 + 4 && std::vector<uint8_t>(packets[6].begin() + 18, packets[6].end()) == second);
+    ddp::PacketHeader header;
+    const uint8_t* payload = nullptr;
+    CHECK(ddp::unpackHeader(packets[-1].data(), packets[-1].size(), header, payload));
+    CHECK(header.offset == 0 && header.length == 6 && (header.flags & DDP_FLAGS1_PUSH) != 0 && payload[0] == 25 && payload[5] == 30);
+    CHECK(out.infoEntry("Transports") == "Art-Net 1 range (2 universes), DDP 1 range");
+    CHECK(out.infoChannel("artnet_packets") >= 2.0f && out.infoChannel("sacn_packets") == 0.0f);
+    
+    // A protocol nobody speaks sends the whole frame to the output again
+    ranges.setTable({ { "start", "protocol" }, { "2", "kinet" } });
+    out.cook();
+    CHECK(out.infoEntry("Last Error").find("'kinet'") != std::string::npos);
+    CHECK(out.infoEntry("Transports") == "off");
+}
+
+TEST(leg_failover)
+{
+    CHECK(ddp::redundancyFromName("both") == ddp::Redundancy::Both);
+    CHECK(ddp::redundancyFromName("standby") == ddp::Redundancy::Standby);
+    CHECK(ddp::redundancyFromName("") == ddp::Redundancy::Off);
+    
+    // Starts healthy, queries at the interval, fails after the timeout without replies
+    ddp::LegHealth health;
+    health.reset(10.0);
+    CHECK(health.queryDue(10.0, 1.0) && !health.queryDue(10.5, 1.0) && health.queryDue(11.0, 1.0));
+    CHECK(health.queries() == 2 && health.healthy(12.9, 3.0) && !health.healthy(13.1, 3.0));
+    health.replied(13.5);
+    CHECK(health.healthy(14.0, 3.0) && health.replies() == 1 && std::fabs(health.sinceReply(14.0) - 0.5) < 1e-9);
+    
+    // The primary carries the frames whenever it is healthy; with both down nothing moves
+    ddp::LegSelector selector;
+    CHECK(selector.select(true, true) == 0 && selector.failovers() == 0);
+    CHECK(selector.select(false, true) == 1 && selector.failovers() == 1);
+    CHECK(selector.select(false, false) == 1);
+    CHECK(selector.select(true, false) == 0 && selector.failovers() == 2);
+    CHECK(selector.select(false, false) == 0);
+    selector.reset();
+    CHECK(selector.active() == 0 && selector.failovers() == 0);
+}
+
+TEST(out_fails_over_to_secondary)
+{
+    mock::MockCHOPNode out;
+    CHECK(createNode(out, DDP_OUT_PLUGIN_PATH, "/test/ddpout1"));
+    out.setPar("Ipaddress", std::string("127.0.0.1"));
+    out.setPar("Port", kTestPort);
+    out.setPar("Redundancy", std::string("standby"));
+    out.setPar("Secondaryaddress", std::string("127.0.0.1"));
+    out.setPar("Secondaryport", kGatewayTestPort);
+    out.setPar("Healthinterval", 0.01);
+    out.setPar("Healthtimeout", 0.1);
+    
+    mock::MockCHOPInput input;
+    input.resize(1, 30);
+    for (int i = 0; i < 30; i++)
+        input.channel(0)[i] = (i + 1) / 255.0f;
+    out.connectInput(&input);
+    
+    // Two controllers on loopback: each answers STATUS queries while 'up' and
+    // counts the data packets that reach it
+    ddp::UdpSocket controllers[2];
+    CHECK(controllers[0].open(AF_INET) && controllers[0].bindTo("127.0.0.1", kTestPort));
+    CHECK(controllers[1].open(AF_INET) && controllers[1].bindTo("127.0.0.1", kGatewayTestPort));
+    bool up[2] = { true, true };
+    int dataPackets[2] = { 0, 0 };
+    auto service = [&]() {
+        for (int c = 0; c < 2; c++)
+        {
+            uint8_t buffer[1500];
+            while (controllers[c].waitReadable(0))
+            {
+                struct sockaddr_storage from;
+                bool wouldBlock = false;
+                int length = controllers[c].recvFrom(buffer, sizeof(buffer), from, wouldBlock);
+                ddp::PacketHeader header;
+                const uint8_t* payload = nullptr;
+                if (length <= 0 || !ddp::unpackHeader(buffer, static_cast<size_t>(length), header, payload))
+                    break;
+                if ((header.flags & DDP_FLAGS1_QUERY) == 0)
+                {
+                    dataPackets[c]++;
+                    continue;
+                }
+                if (!up[c])
+                    continue;
+                ddp::PacketHeader reply;
+                reply.flags = DDP_FLAGS1_VER1 | DDP_FLAGS1_REPLY;
+                reply.destId = DDP_ID_STATUS;
+                uint8_t packet[DDP_HEADER_SIZE];
+                controllers[c].sendTo(packet, ddp::packHeader(reply, packet), from, sizeof(struct sockaddr_in));
+            }
+        }
+    };
+    auto run = [&](int cooks) {
+        for (int i = 0; i < cooks; i++)
+        {
+            out.cook();
+            std::this_thread::sleep_for(std::chrono::milliseconds(2));
+            service();
+        }
+    };
+    
+    // Both healthy: frames only go to the primary, the secondary only gets queries
+    run(20);
+    CHECK(dataPackets[0] > 0 && dataPackets[1] == 0);
+    CHECK(out.infoChannel("active_leg") == 0.0f && out.infoChannel("primary_healthy") == 1.0f);
+    CHECK(out.infoChannel("secondary_healthy") == 1.0f && out.infoChannel("secondary_packets") == 0.0f);
+    
+    // The primary stops answering and the secondary takes over
+    up[0] = false;
+    for (int attempt = 0; attempt < 200 && out.infoChannel("active_leg") != 1.0f; attempt++)
+        run(1);
+    CHECK(out.infoChannel("active_leg") == 1.0f && out.infoChannel("failovers") == 1.0f);
+    int before = dataPackets[1];
+    run(5);
+    CHECK(dataPackets[1] > before && out.infoChannel("secondary_packets") > 0.0f);
+    CHECK(out.infoEntry("Redundancy") == "standby, secondary active, 1 failover");
+    CHECK(out.infoEntry("Primary Leg").find("127.0.0.1, failed") == 0);
+    
+    // It answers again and takes the frames back
+    up[0] = true;
+    for (int attempt = 0; attempt < 200 && out.infoChannel("active_leg") != 0.0f; attempt++)
+        run(1);
+    CHECK(out.infoChannel("active_leg") == 0.0f && out.infoChannel("failovers") == 2.0f);
+    
+    // Send to Both: the same packets go out on each leg
+    out.setPar("Redundancy", std::string("both"));
+    run(1);
+    int primaryBefore = dataPackets[0], secondaryBefore = dataPackets[1];
+    run(5);
+    CHECK(dataPackets[0] - primaryBefore == dataPackets[1] - secondaryBefore && dataPackets[0] > primaryBefore);
+    CHECK(out.infoChannel("primary_packets") == out.infoChannel("secondary_packets"));
+    CHECK(out.infoEntry("Secondary Leg").find("127.0.0.1, healthy") == 0);
+    
+    out.setPar("Secondaryaddress", std::string(""));
+    out.cook();
+    CHECK(out.infoEntry("Secondary Leg") == "no Secondary Address");
+}
+
+TEST(out_sends_ranges_on_legs)
+{
+    // Pixels 8-9 are a DDP frame of their own for a third controller
+    const int rangePort = kGatewayTestPort + 1;
+    mock::MockCHOPNode out;
+    CHECK(createNode(out, DDP_OUT_PLUGIN_PATH, "/test/ddpout1"));
+    out.setPar("Ipaddress", std::string("127.0.0.1"));
+    out.setPar("Port", kTestPort);
+    out.setPar("Redundancy", std::string("standby"));
+    out.setPar("Secondaryaddress", std::string("127.0.0.1"));
+    out.setPar("Secondaryport", kGatewayTestPort);
+    out.setPar("Healthinterval", 0.01);
+    out.setPar("Healthtimeout", 0.1);
+    std::string address = "127.0.0.1:" + std::to_string(rangePort);
+    mock::MockDATInput ranges;
+    ranges.setTable({ { "name", "start", "count", "protocol", "address" },
+                      { "side", "8", "0", "ddp", address.c_str() } });
+    out.setParDAT("Rangesdat", &ranges);
+    
+    mock::MockCHOPInput input;
+    input.resize(1, 30);
+    out.connectInput(&input);
+    
+    // The primary's controller never answers; the secondary's does, which
+    // also shows the port the secondary leg sends from
+    ddp::UdpSocket controllers[2], rangeController;
+    CHECK(controllers[0].open(AF_INET) && controllers[0].bindTo("127.0.0.1", kTestPort));
+    CHECK(controllers[1].open(AF_INET) && controllers[1].bindTo("127.0.0.1", kGatewayTestPort));
+    CHECK(rangeController.open(AF_INET) && rangeController.bindTo("127.0.0.1", rangePort));
+    uint16_t secondaryPort = 0;
+    std::map<uint16_t, int> rangePackets;
+    auto service = [&]() {
+        uint8_t buffer[1500];
+        struct sockaddr_storage from;
+        bool wouldBlock = false;
+        while (controllers[0].waitReadable(0) && controllers[0].recvFrom(buffer, sizeof(buffer), from, wouldBlock) > 0)
+            continue;
+        while (controllers[1].waitReadable(0))
+        {
+            int length = controllers[1].recvFrom(buffer, sizeof(buffer), from, wouldBlock);
+            ddp::PacketHeader header;
+            const uint8_t* payload = nullptr;
+            if (length <= 0 || !ddp::unpackHeader(buffer, static_cast<size_t>(length), header, payload))
+                break;
+            if ((header.flags & DDP_FLAGS1_QUERY) == 0)
+                continue;
+            ddp::formatAddress(reinterpret_cast<const struct sockaddr*>(&from), &secondaryPort);
+            ddp::PacketHeader reply;
+            reply.flags = DDP_FLAGS1_VER1 | DDP_FLAGS1_REPLY;
+            reply.destId = DDP_ID_STATUS;
+            uint8_t packet[DDP_HEADER_SIZE];
+            controllers[1].sendTo(packet, ddp::packHeader(reply, packet), from, sizeof(struct sockaddr_in));
+        }
+        while (rangeController.waitReadable(0) && rangeController.recvFrom(buffer, sizeof(buffer), from, wouldBlock) > 0)
+        {
+            uint16_t port = 0;
+            ddp::formatAddress(reinterpret_cast<const struct sockaddr*>(&from), &port);
+            rangePackets[port]++;
+        }
+    };
+    auto run = [&](int cooks) {
+        for (int i = 0; i < cooks; i++)
+        {
+            out.cook();
+            std::this_thread::sleep_for(std::chrono::milliseconds(2));
+            service();
+        }
+    };
+    
+    // Once the secondary takes over, the range goes out on it too
+    run(1);
+    for (int attempt = 0; attempt < 200 && out.infoChannel("active_leg") != 1.0f; attempt++)
+        run(1);
+    CHECK(out.infoChannel("active_leg") == 1.0f && secondaryPort != 0);
+    rangePackets.clear();
+    run(5);
+    CHECK(rangePackets.size() == 1 && rangePackets[secondaryPort] >= 5);
+    
+    // Send to Both: the range goes out once on each leg
+    out.setPar("Redundancy", std::string("both"));
+    run(1);
+    rangePackets.clear();
+    run(5);
+    CHECK(rangePackets.size() == 2 && rangePackets[secondaryPort] >= 5);
+    CHECK(rangePackets.begin()->second == rangePackets.rbegin()->second);
+}
+
+TEST(out_checks_leg_replies)
+{
+    // Secondary leg to a multicast group, sent out of loopback
+    mock::MockCHOPNode out;
+    CHECK(createNode(out, DDP_OUT_PLUGIN_PATH, "/test/ddpout1"));
+    out.setPar("Ipaddress", std::string("127.0.0.1"));
+    out.setPar("Port", kTestPort);
+    out.setPar("Redundancy", std::string("both"));
+    out.setPar("Secondaryaddress", std::string("239.255.77.1"));
+    out.setPar("Secondaryport", kGatewayTestPort);
+    out.setPar("Secondaryinterface", std::string("127.0.0.1"));
+    out.setPar("Multicastloop", 1);
+    out.setPar("Healthinterval", 0.01);
+    out.setPar("Healthtimeout", 0.1);
+    
+    mock::MockCHOPInput input;
+    input.resize(1, 30);
+    out.connectInput(&input);
+    
+    // The primary's controller answers queries with data, which is not a
+    // STATUS reply. The secondary's joined the group and answers from its own
+    // unicast address.
+    ddp::UdpSocket controllers[2];
+    CHECK(controllers[0].open(AF_INET) && controllers[0].bindTo("127.0.0.1", kTestPort));
+    CHECK(controllers[1].open(AF_INET) && controllers[1].bindTo("", kGatewayTestPort));
+    CHECK(controllers[1].joinGroup("239.255.77.1", "127.0.0.1"));
+    int dataPackets[2] = { 0, 0 };
+    auto service = [&]() {
+        for (int c = 0; c < 2; c++)
+        {
+            uint8_t buffer[1500];
+            while (controllers[c].waitReadable(0))
+            {
+                struct sockaddr_storage from;
+                bool wouldBlock = false;
+                int length = controllers[c].recvFrom(buffer, sizeof(buffer), from, wouldBlock);
+                ddp::PacketHeader header;
+                const uint8_t* payload = nullptr;
+                if (length <= 0 || !ddp::unpackHeader(buffer, static_cast<size_t>(length), header, payload))
+                    break;
+                if ((header.flags & DDP_FLAGS1_QUERY) == 0)
+                {
+                    dataPackets[c]++;
+                    continue;
+                }
+                ddp::PacketHeader reply;
+                reply.flags = c == 0 ? DDP_FLAGS1_VER1 | DDP_FLAGS1_PUSH : DDP_FLAGS1_VER1 | DDP_FLAGS1_REPLY;
+                reply.destId = c == 0 ? DDP_ID_DISPLAY : DDP_ID_STATUS;
+                uint8_t packet[DDP_HEADER_SIZE];
+                controllers[c].sendTo(packet, ddp::packHeader(reply, packet), from, sizeof(struct sockaddr_in));
+            }
+        }
+    };
+    
+    // Well past Health Timeout
+    for (int attempt = 0; attempt < 100; attempt++)
+    {
+        out.cook();
+        std::this_thread::sleep_for(std::chrono::milliseconds(3));
+        service();
+    }
+    CHECK(out.infoChannel("primary_healthy") == 0.0f);
+    CHECK(out.infoChannel("secondary_healthy") == 1.0f);
+    CHECK(out.infoEntry("Secondary Leg").find("239.255.77.1, healthy") == 0);
+    CHECK(dataPackets[0] > 0 && dataPackets[1] > 0);
+}
+
+int main(int argc, char** argv)
+{
+    int ran = 0;
+    for (const TestCase& test : registry())
+    {
+        if (argc > 1 && strcmp(argv[1], test.name) != 0)
+            continue;
+
+        int failuresBefore = g_failures;
+        test.run();
+        printf("[%s] %s\n", g_failures == failuresBefore ? "  OK  " : " FAIL ", test.name);
+        ran++;
+    }
+
+    if (ran == 0)
+    {
+        fprintf(stderr, "No test named '%s'\n", argc > 1 ? argv[1] : "");
+        return 1;
+    }
+    return g_failures == 0 ? 0 : 1;
+}